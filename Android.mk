@@ -26,6 +26,7 @@ LOCAL_SRC_FILES:= \
     src/amber.cc \
     src/amberscript/parser.cc \
     src/buffer.cc \
+    src/buffer_liveness.cc \
     src/command.cc \
     src/command_data.cc \
     src/descriptor_set_and_binding_parser.cc \
@@ -41,8 +42,11 @@ LOCAL_SRC_FILES:= \
     src/sampler.cc \
     src/script.cc \
     src/shader.cc \
+    src/shader_cache.cc \
+    src/shader_compile_memo.cc \
     src/shader_compiler.cc \
     src/tokenizer.cc \
+    src/trace_scope.cc \
     src/type.cc \
     src/type_parser.cc \
     src/value.cc \
@@ -59,19 +63,24 @@ LOCAL_SRC_FILES:= \
     src/vulkan/command_pool.cc \
     src/vulkan/compute_pipeline.cc \
     src/vulkan/descriptor.cc \
+    src/vulkan/descriptor_set_pool.cc \
     src/vulkan/device.cc \
     src/vulkan/engine_vulkan.cc \
     src/vulkan/frame_buffer.cc \
     src/vulkan/graphics_pipeline.cc \
     src/vulkan/image_descriptor.cc \
     src/vulkan/index_buffer.cc \
+    src/vulkan/memory_allocator.cc \
     src/vulkan/pipeline.cc \
     src/vulkan/push_constant.cc \
     src/vulkan/raytracing_pipeline.cc \
+    src/vulkan/resident_buffers.cc \
     src/vulkan/resource.cc \
     src/vulkan/sampler.cc \
     src/vulkan/sampler_descriptor.cc \
     src/vulkan/sbt.cc \
+    src/vulkan/staging_pool.cc \
+    src/vulkan/timestamp_query_pool.cc \
     src/vulkan/tlas.cc \
     src/vulkan/tlas_descriptor.cc \
     src/vulkan/transfer_buffer.cc \
@@ -17,7 +17,9 @@
 
 #include <stdint.h>
 
+#include <future>  // NOLINT(build/c++11)
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -27,6 +29,8 @@
 
 namespace amber {
 
+class Engine;
+
 /// The shader map is a map from the name of a shader to the spirv-binary
 /// which is the compiled representation of that named shader.
 typedef std::map<std::string, std::vector<uint32_t> > ShaderMap;
@@ -45,6 +49,17 @@ enum class ExecutionType {
   kPipelineCreateOnly
 };
 
+enum class RepeatMode {
+  /// Run the commands of a REPEAT body again for every iteration.
+  kExecute = 0,
+  /// Record the device work of a REPEAT body once and submit it again for
+  /// every iteration.
+  kReplay,
+  /// Record the device work of every iteration of a REPEAT body into a
+  /// single submission.
+  kUnroll
+};
+
 /// Override point of engines to add their own configuration.
 struct EngineConfig {
   virtual ~EngineConfig();
@@ -82,7 +97,61 @@ enum class BufferDataFileType : int8_t {
   kPng
 };
 
-/// Delegate class for various hook functions
+/// Counters describing how well the on-disk shader cache performed.
+struct ShaderCacheStats {
+  ShaderCacheStats();
+
+  /// Number of shaders loaded from the cache instead of being compiled.
+  uint64_t hits;
+  /// Number of shaders which had to be compiled.
+  uint64_t misses;
+  /// Size in bytes of the SPIR-V loaded from the cache.
+  uint64_t bytes_saved;
+};
+
+/// A phase of an execution, reported through Delegate::ReportTraceSpan().
+struct TraceSpan {
+  TraceSpan();
+  TraceSpan(const TraceSpan&);
+  ~TraceSpan();
+
+  TraceSpan& operator=(const TraceSpan&);
+
+  /// What the span measured, e.g. the command or shader name.
+  std::string name;
+  /// The kind of phase, e.g. "parse", "compile" or "command".
+  std::string category;
+  /// Start and end of the span, as returned by Delegate::GetTimestampNs().
+  uint64_t start_ns;
+  uint64_t end_ns;
+  /// The script line the span belongs to, or 0 if there is none.
+  uint32_t line;
+};
+
+/// Counts collected for a `RUN STATISTICS` command, reported through
+/// Delegate::ReportPipelineStatistics().
+struct PipelineStatistics {
+  PipelineStatistics();
+
+  /// False if the device does not support pipeline statistics queries, or
+  /// the script did not require the pipelineStatisticsQuery feature. All
+  /// counts are 0 then.
+  bool supported;
+  uint64_t input_assembly_vertices;
+  uint64_t input_assembly_primitives;
+  uint64_t vertex_shader_invocations;
+  uint64_t clipping_invocations;
+  uint64_t clipping_primitives;
+  uint64_t fragment_shader_invocations;
+  uint64_t compute_shader_invocations;
+};
+
+/// Delegate class for various hook functions.
+///
+/// Thread safety: the delegate methods are called on the thread executing
+/// the recipe. A delegate shared by several executions that may run at the
+/// same time, for example through Amber::ExecuteAsync(), must be safe to call
+/// from several threads at once.
 class Delegate {
  public:
   virtual ~Delegate();
@@ -107,6 +176,23 @@ class Delegate {
 
   /// Mechanism for gathering timing from 'TIME_EXECUTION'
   virtual void ReportExecutionTiming(double) {}
+  /// Mechanism for gathering the counts of 'STATISTICS', called once per
+  /// execution of the command.
+  virtual void ReportPipelineStatistics(
+      const PipelineStatistics& /* statistics */) {}
+
+  /// Tells whether to report trace spans through ReportTraceSpan().
+  virtual bool TraceEnabled() const { return false; }
+  /// Reports a finished phase of the parse or execution, if TraceEnabled().
+  /// Called on the thread which ran the phase. Spans on the same thread are
+  /// properly nested, and are reported innermost first.
+  virtual void ReportTraceSpan(const TraceSpan& /* span */) {}
+
+  /// Called when an execution started by Amber::ExecuteAsync() finishes,
+  /// with the same |result| its future will hold. Runs on the executing
+  /// thread, before the future becomes ready.
+  virtual void ReportExecutionComplete(const amber::Recipe* /* recipe */,
+                                       const amber::Result& /* result */) {}
 };
 
 /// Stores configuration options for Amber.
@@ -133,9 +219,35 @@ struct Options {
   /// The type of execution. For example, execute as normal or just create the
   /// piplines and exit.
   ExecutionType execution_type;
+  /// How REPEAT commands are run. Only bodies made of device work, which the
+  /// host does not look at, are recorded. Their first iteration always runs
+  /// the commands, and the engine may fall back to RepeatMode::kExecute for
+  /// the others. Default RepeatMode::kExecute.
+  RepeatMode repeat_mode;
   /// If true, disables SPIR-V validation. If false, SPIR-V shaders will be
   /// validated using the Validator component (spirv-val) from SPIRV-Tools.
   bool disable_spirv_validation;
+  /// Maximum number of threads used to compile the shaders of a recipe. A
+  /// value of 1 compiles every shader on the calling thread, a value of 0
+  /// uses one thread per hardware thread. Default 1.
+  uint32_t compile_threads;
+  /// If not empty, compiled shaders are cached in this directory, which must
+  /// already exist. A shader whose source, type, entry point, target
+  /// environment, compile options, optimizations, included virtual files and
+  /// compiler versions all match a cached entry is not compiled again.
+  std::string shader_cache_dir;
+  /// Maximum number of compiled shaders kept in memory. The in-memory cache
+  /// is on by default. Its entries are shared by every execution in the
+  /// process, so a shader used by several pipelines or recipes is only
+  /// compiled once. Each entry holds the full shader source as its key, and
+  /// the entries stay alive until the process exits. The first execution
+  /// with a non-zero value sets the size for the whole process, and later
+  /// values are ignored. A value of 0 disables the in-memory cache for this
+  /// execution. Default 1024.
+  uint32_t compile_memo_entries;
+  /// Statistics of the shader cache. Each execution adds its hits, misses and
+  /// saved bytes, so the totals accumulate over calls sharing these options.
+  ShaderCacheStats shader_cache_stats;
 };
 
 /// Main interface to the Amber environment.
@@ -166,6 +278,23 @@ class Amber {
                                       Options* opts,
                                       const ShaderMap& shader_data);
 
+  /// Starts executing the given |recipe| on a new thread and returns without
+  /// waiting for it. The future holds the result Execute() would have
+  /// returned. The |recipe|, |opts| and the engine config must stay alive,
+  /// and must not be used by anything else, until the future is ready.
+  /// Several executions may run at the same time as long as each one uses
+  /// its own recipe and options; see Delegate for the delegate's
+  /// requirements. Destroying the future waits for the execution to finish.
+  std::future<amber::Result> ExecuteAsync(const amber::Recipe* recipe,
+                                          Options* opts);
+
+  /// Asynchronous version of ExecuteWithShaderData(). The |shader_data| is
+  /// copied, so it can be destroyed once this returns.
+  std::future<amber::Result> ExecuteWithShaderDataAsync(
+      const amber::Recipe* recipe,
+      Options* opts,
+      const ShaderMap& shader_data);
+
   /// Returns the delegate object.
   Delegate* GetDelegate() const { return delegate_; }
 
@@ -173,6 +302,52 @@ class Amber {
   Delegate* delegate_;
 };
 
+/// Runs many recipes on a single engine. The Vulkan instance, device and
+/// queues are created once by Initialize() and reused by every Execute(),
+/// which saves the engine start up cost when running large test lists. Each
+/// recipe still gets fresh pipelines, buffers and shader modules.
+///
+/// Initialize() does not know the recipes yet, so it checks no
+/// requirements. A recipe that needs a feature, property or extension the
+/// shared device lacks only fails later, in AreAllRequirementsSupported() or
+/// Execute().
+class AmberSession {
+ public:
+  explicit AmberSession(Delegate* delegate);
+  ~AmberSession();
+
+  AmberSession(const AmberSession&) = delete;
+  AmberSession& operator=(const AmberSession&) = delete;
+
+  /// Creates and initializes the engine selected by |opts|, using
+  /// |opts->config|. The config must outlive the session.
+  amber::Result Initialize(Options* opts);
+
+  /// Determines whether the session's engine supports all features required
+  /// by the |recipe|.
+  amber::Result AreAllRequirementsSupported(const amber::Recipe* recipe,
+                                            Options* opts);
+
+  /// Executes the given |recipe| on the session's engine. The |opts| must
+  /// select the engine the session was initialized with; its config is
+  /// ignored.
+  amber::Result Execute(const amber::Recipe* recipe, Options* opts);
+
+  /// Executes the given |recipe| on the session's engine. Will use
+  /// |shader_map| to lookup shader data before attempting to compile the
+  /// shader if possible.
+  amber::Result ExecuteWithShaderData(const amber::Recipe* recipe,
+                                      Options* opts,
+                                      const ShaderMap& shader_data);
+
+ private:
+  amber::Result CheckRecipe(const amber::Recipe* recipe, Options* opts);
+
+  Delegate* delegate_;
+  EngineType engine_type_;
+  std::unique_ptr<Engine> engine_;
+};
+
 }  // namespace amber
 
 #endif  // AMBER_AMBER_H_
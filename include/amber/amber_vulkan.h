@@ -15,6 +15,7 @@
 #ifndef AMBER_AMBER_VULKAN_H_
 #define AMBER_AMBER_VULKAN_H_
 
+#include <cstdint>
 #include <limits>
 #include <string>
 #include <vector>
@@ -67,6 +68,11 @@ struct VulkanEngineConfig : public EngineConfig {
   /// Physical device extensions available for |physical_device|.
   std::vector<std::string> available_device_extensions;
 
+  /// True if VK_KHR_push_descriptor is enabled on |device|. The engine then
+  /// pushes the descriptors of one set of each pipeline while recording its
+  /// commands, instead of allocating and writing a descriptor set.
+  bool push_descriptor_enabled = false;
+
   /// The given queue family index to use.
   uint32_t queue_family_index;
 
@@ -75,6 +81,25 @@ struct VulkanEngineConfig : public EngineConfig {
 
   /// The VkQueue to use.
   VkQueue queue;
+
+  /// If true, the engine creates a VkPipelineCache which is used for every
+  /// pipeline it builds. The cache is seeded from |pipeline_cache_data| when
+  /// the engine is initialized and the updated cache contents are written back
+  /// to |pipeline_cache_data| when the engine is destroyed, so the same config
+  /// can share compiled pipelines between recipes. Data whose header does not
+  /// match the vendor, device and pipeline cache UUID of |physical_device| is
+  /// discarded.
+  bool enable_pipeline_cache = false;
+
+  /// Serialized VkPipelineCache contents, as returned by
+  /// vkGetPipelineCacheData. Only used if |enable_pipeline_cache| is true.
+  std::vector<uint8_t> pipeline_cache_data;
+
+  /// The number of bytes of image staging buffers the engine keeps for reuse
+  /// once they are no longer needed. Staging buffers still in use are not
+  /// limited by this, but when they exceed it the engine waits for the
+  /// submitted work to release some before creating more.
+  uint64_t staging_pool_max_bytes = 256 * 1024 * 1024;
 };
 
 }  // namespace amber
@@ -17,15 +17,23 @@
 #include <stdio.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstdio>
 #include <cstdlib>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <ostream>
 #include <set>
+#include <sstream>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 #include <utility>
 #include <vector>
 
@@ -43,6 +51,10 @@
 #include "samples/png.h"
 #endif  // AMBER_ENABLE_LODEPNG
 
+#if AMBER_ENGINE_VULKAN
+#include "amber/amber_vulkan.h"
+#endif  // AMBER_ENGINE_VULKAN
+
 namespace {
 
 const char* kGeneratedColorBuffer = "framebuffer";
@@ -58,6 +70,10 @@ struct Options {
   uint32_t engine_minor = 1;
   int32_t fence_timeout = -1;
   int32_t selected_device = -1;
+  int32_t staging_pool_mb = -1;
+  uint32_t jobs = 1;
+  uint32_t shard_index = 0;
+  uint32_t shard_count = 1;
   bool parse_only = false;
   bool pipeline_create_only = false;
   bool disable_validation_layer = false;
@@ -70,8 +86,13 @@ struct Options {
   bool log_execution_timing = false;
   bool disable_spirv_validation = false;
   bool enable_pipeline_runtime_layer = false;
+  bool reuse_engine = false;
   std::string shader_filename;
+  std::string pipeline_cache_filename;
+  std::string shader_cache_dir;
+  std::string trace_filename;
   amber::EngineType engine = amber::kEngineTypeVulkan;
+  amber::RepeatMode repeat_mode = amber::RepeatMode::kExecute;
   std::string spv_env;
 };
 
@@ -107,6 +128,28 @@ const char kUsage[] = R"(Usage: amber [options] SCRIPT [SCRIPTS...]
   --log-execution-timing    -- Log timing results from each command with the 'TIMED_EXECUTION' flag.
   --disable-spirv-val       -- Disable SPIR-V validation.
   --enable-runtime-layer    -- Enable pipeline runtime layer.
+  --pipeline-cache <file>   -- Load the Vulkan pipeline cache from <file> if it exists and
+                               write the updated cache back to <file> on exit (Vulkan only).
+                               With --jobs the caches of all workers are merged.
+  --shader-cache <dir>      -- Cache compiled shaders in the existing directory <dir>.
+  --trace <file>            -- Write a Chrome trace event JSON file with the time spent parsing,
+                               compiling, creating pipelines and running each command.
+  --repeat-mode <mode>      -- How REPEAT bodies without probes are run: execute runs their
+                               commands every iteration, replay records them once and submits
+                               them again, unroll records every iteration into one submission.
+                               Default is execute.
+  --staging-pool-mb <N>     -- Keep at most N MiB of image staging buffers for reuse (Vulkan only).
+                               Default is 256.
+  --jobs <N>                -- Run scripts on N worker threads, each with its own device.
+                               The workers split the hardware threads for compiling shaders.
+                               Default is 1.
+  --reuse-engine            -- Run all the scripts of a worker on one engine. Pipelines,
+                               descriptor pools and device copies of buffers then persist
+                               from one script to the next. By default each script gets a
+                               fresh engine.
+  --shard-index <I>         -- Only run the scripts of shard I, starting at 0. Default is 0.
+  --shard-count <N>         -- Split the scripts into N shards by their position on the
+                               command line. Default is 1.
   -h                        -- This help text.
 )";
 
@@ -288,6 +331,102 @@ bool ParseArgs(const std::vector<std::string>& args, Options* opts) {
       opts->disable_spirv_validation = true;
     } else if (arg == "--enable-runtime-layer") {
       opts->enable_pipeline_runtime_layer = true;
+    } else if (arg == "--reuse-engine") {
+      opts->reuse_engine = true;
+    } else if (arg == "--pipeline-cache") {
+      ++i;
+      if (i >= args.size()) {
+        std::cerr << "Missing value for --pipeline-cache argument."
+                  << std::endl;
+        return false;
+      }
+      opts->pipeline_cache_filename = args[i];
+    } else if (arg == "--shader-cache") {
+      ++i;
+      if (i >= args.size()) {
+        std::cerr << "Missing value for --shader-cache argument." << std::endl;
+        return false;
+      }
+      opts->shader_cache_dir = args[i];
+    } else if (arg == "--trace") {
+      ++i;
+      if (i >= args.size()) {
+        std::cerr << "Missing value for --trace argument." << std::endl;
+        return false;
+      }
+      opts->trace_filename = args[i];
+    } else if (arg == "--repeat-mode") {
+      ++i;
+      if (i >= args.size()) {
+        std::cerr << "Missing value for --repeat-mode argument." << std::endl;
+        return false;
+      }
+      const std::string& mode = args[i];
+      if (mode == "execute") {
+        opts->repeat_mode = amber::RepeatMode::kExecute;
+      } else if (mode == "replay") {
+        opts->repeat_mode = amber::RepeatMode::kReplay;
+      } else if (mode == "unroll") {
+        opts->repeat_mode = amber::RepeatMode::kUnroll;
+      } else {
+        std::cerr << "Invalid value for --repeat-mode argument. Must be one "
+                     "of: execute replay unroll"
+                  << std::endl;
+        return false;
+      }
+    } else if (arg == "--jobs") {
+      ++i;
+      if (i >= args.size()) {
+        std::cerr << "Missing value for --jobs argument." << std::endl;
+        return false;
+      }
+
+      int32_t val = 0;
+      if (!ParseOneInt(args[i].c_str(), &val) || val < 1) {
+        std::cerr << "Invalid job count: " << args[i] << std::endl;
+        return false;
+      }
+      opts->jobs = static_cast<uint32_t>(val);
+    } else if (arg == "--staging-pool-mb") {
+      ++i;
+      if (i >= args.size()) {
+        std::cerr << "Missing value for --staging-pool-mb argument."
+                  << std::endl;
+        return false;
+      }
+
+      int32_t val = 0;
+      if (!ParseOneInt(args[i].c_str(), &val) || val < 0) {
+        std::cerr << "Invalid staging pool size: " << args[i] << std::endl;
+        return false;
+      }
+      opts->staging_pool_mb = val;
+    } else if (arg == "--shard-index") {
+      ++i;
+      if (i >= args.size()) {
+        std::cerr << "Missing value for --shard-index argument." << std::endl;
+        return false;
+      }
+
+      int32_t val = 0;
+      if (!ParseOneInt(args[i].c_str(), &val) || val < 0) {
+        std::cerr << "Invalid shard index: " << args[i] << std::endl;
+        return false;
+      }
+      opts->shard_index = static_cast<uint32_t>(val);
+    } else if (arg == "--shard-count") {
+      ++i;
+      if (i >= args.size()) {
+        std::cerr << "Missing value for --shard-count argument." << std::endl;
+        return false;
+      }
+
+      int32_t val = 0;
+      if (!ParseOneInt(args[i].c_str(), &val) || val < 1) {
+        std::cerr << "Invalid shard count: " << args[i] << std::endl;
+        return false;
+      }
+      opts->shard_count = static_cast<uint32_t>(val);
     } else if (arg.size() > 0 && arg[0] == '-') {
       std::cerr << "Unrecognized option " << arg << std::endl;
       return false;
@@ -296,6 +435,22 @@ bool ParseArgs(const std::vector<std::string>& args, Options* opts) {
     }
   }
 
+  if (opts->shard_index >= opts->shard_count) {
+    std::cerr << "Shard index must be less than the shard count" << std::endl;
+    return false;
+  }
+
+  // Every shard_count-th script belongs to this shard, so the split only
+  // depends on the command line.
+  if (opts->shard_count > 1) {
+    std::vector<std::string> shard_filenames;
+    for (size_t i = opts->shard_index; i < opts->input_filenames.size();
+         i += opts->shard_count) {
+      shard_filenames.push_back(opts->input_filenames[i]);
+    }
+    opts->input_filenames = std::move(shard_filenames);
+  }
+
   return true;
 }
 
@@ -341,9 +496,12 @@ class SampleDelegate : public amber::Delegate {
   ~SampleDelegate() override = default;
 
   void Log(const std::string& message) override {
-    std::cout << message << std::endl;
+    *log_stream_ << message << std::endl;
   }
 
+  /// Sets the stream Log() writes to. Defaults to std::cout.
+  void SetLogStream(std::ostream* stream) { log_stream_ = stream; }
+
   bool LogGraphicsCalls() const override { return log_graphics_calls_; }
   void SetLogGraphicsCalls(bool log_graphics_calls) {
     log_graphics_calls_ = log_graphics_calls;
@@ -375,10 +533,40 @@ class SampleDelegate : public amber::Delegate {
     return returning;
   }
 
+  void ReportPipelineStatistics(
+      const amber::PipelineStatistics& statistics) override {
+    reported_pipeline_statistics_.push_back(statistics);
+  }
+
+  std::vector<amber::PipelineStatistics> GetAndClearPipelineStatistics() {
+    auto returning = reported_pipeline_statistics_;
+    reported_pipeline_statistics_.clear();
+    return returning;
+  }
+
   uint64_t GetTimestampNs() const override {
     return timestamp::SampleGetTimestampNs();
   }
 
+  bool TraceEnabled() const override { return trace_enabled_; }
+  void SetTraceEnabled(bool trace_enabled) { trace_enabled_ = trace_enabled; }
+
+  void ReportTraceSpan(const amber::TraceSpan& span) override {
+    // Shaders are compiled on several threads.
+    std::lock_guard<std::mutex> lock(trace_mutex_);
+    trace_spans_.push_back({span, std::this_thread::get_id()});
+  }
+
+  /// A reported span and the thread it ran on.
+  struct ThreadTraceSpan {
+    amber::TraceSpan span;
+    std::thread::id thread_id;
+  };
+  std::vector<ThreadTraceSpan> GetTraceSpans() {
+    std::lock_guard<std::mutex> lock(trace_mutex_);
+    return trace_spans_;
+  }
+
   void SetScriptPath(std::string path) { path_ = path; }
 
   amber::Result LoadBufferData(const std::string file_name,
@@ -423,8 +611,13 @@ class SampleDelegate : public amber::Delegate {
   bool log_graphics_calls_ = false;
   bool log_graphics_calls_time_ = false;
   bool log_execute_calls_ = false;
+  bool trace_enabled_ = false;
   std::string path_ = "";
+  std::ostream* log_stream_ = &std::cout;
   std::vector<double> reported_execution_timing;
+  std::vector<amber::PipelineStatistics> reported_pipeline_statistics_;
+  std::mutex trace_mutex_;
+  std::vector<ThreadTraceSpan> trace_spans_;
 };
 
 std::string disassemble(const std::string& env,
@@ -475,6 +668,329 @@ std::string disassemble(const std::string& env,
 #endif  // AMBER_ENABLE_SPIRV_TOOLS
 }
 
+std::string EscapeJson(const std::string& str) {
+  std::string ret;
+  for (char c : str) {
+    if (c == '"' || c == '\\') {
+      ret += '\\';
+      ret += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      std::ostringstream hex;
+      hex << "\\u" << std::setfill('0') << std::setw(4) << std::hex
+          << static_cast<int>(c);
+      ret += hex.str();
+    } else {
+      ret += c;
+    }
+  }
+  return ret;
+}
+
+// Writes the spans collected by |delegates| to |filename| in the Chrome
+// trace event format, which can be loaded in chrome://tracing or Perfetto.
+bool WriteTrace(const std::string& filename,
+                const std::vector<SampleDelegate*>& delegates) {
+  std::vector<SampleDelegate::ThreadTraceSpan> spans;
+  for (auto* delegate : delegates) {
+    auto delegate_spans = delegate->GetTraceSpans();
+    spans.insert(spans.end(), delegate_spans.begin(), delegate_spans.end());
+  }
+
+  uint64_t base_ns = std::numeric_limits<uint64_t>::max();
+  for (const auto& span : spans) {
+    base_ns = std::min(base_ns, span.span.start_ns);
+  }
+
+  std::ofstream file(filename, std::ios::out);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  // Threads are numbered in the order they first reported a span.
+  std::map<std::thread::id, size_t> thread_numbers;
+  file << "{\"traceEvents\":[";
+  for (size_t i = 0; i < spans.size(); ++i) {
+    const amber::TraceSpan& span = spans[i].span;
+    auto it = thread_numbers
+                  .emplace(spans[i].thread_id, thread_numbers.size() + 1)
+                  .first;
+
+    file << (i == 0 ? "\n" : ",\n");
+    file << "{\"name\":\"" << EscapeJson(span.name) << "\",\"cat\":\""
+         << EscapeJson(span.category) << "\",\"ph\":\"X\",\"ts\":"
+         << static_cast<double>(span.start_ns - base_ns) / 1000.0
+         << ",\"dur\":"
+         << static_cast<double>(span.end_ns - span.start_ns) / 1000.0
+         << ",\"pid\":1,\"tid\":" << it->second;
+    if (span.line > 0) {
+      file << ",\"args\":{\"line\":" << span.line << "}";
+    }
+    file << "}";
+  }
+  file << "\n]}\n";
+  return file.good();
+}
+
+struct RecipeData {
+  std::string file;
+  std::unique_ptr<amber::Recipe> recipe;
+};
+
+/// Everything needed to run recipes on one thread. Members are destroyed in
+/// reverse order, so the session goes away before the device it uses. The
+/// session is only created with --reuse-engine.
+struct Worker {
+  sample::ConfigHelper config_helper;
+  std::unique_ptr<amber::EngineConfig> config;
+  SampleDelegate delegate;
+  amber::Options amber_options;
+  std::unique_ptr<amber::AmberSession> session;
+};
+
+// Executes the recipe on |worker| and reports the execution timing. Output is
+// written to |out| and errors to |err|. Returns true if the recipe passed.
+bool ExecuteRecipe(const Options& options,
+                   const RecipeData& recipe_data,
+                   Worker* worker,
+                   std::ostream* out,
+                   std::ostream* err) {
+  const auto* recipe = recipe_data.recipe.get();
+  const auto& file = recipe_data.file;
+
+  amber::Result result;
+  if (worker->session) {
+    result = worker->session->Execute(recipe, &worker->amber_options);
+  } else {
+    amber::Amber am(&worker->delegate);
+    result = am.Execute(recipe, &worker->amber_options);
+  }
+  if (!result.IsSuccess()) {
+    *err << file << ": " << result.Error() << "\n";
+  }
+
+  auto execution_timing = worker->delegate.GetAndClearExecutionTiming();
+  if (result.IsSuccess() && options.log_execution_timing &&
+      !execution_timing.empty()) {
+    *out << "Execution timing (in script-order):" << "\n";
+    *out << "    ";
+    bool is_first_iter = true;
+    for (auto& timing : execution_timing) {
+      if (!is_first_iter) {
+        *out << ", ";
+      }
+      is_first_iter = false;
+      *out << timing;
+    }
+    *out << "\n";
+    std::sort(execution_timing.begin(), execution_timing.end());
+    auto report_median =
+        (execution_timing[execution_timing.size() / 2] +
+         execution_timing[(execution_timing.size() - 1) / 2]) /
+        2;
+    *out << "\n";
+    *out << "Execution time median = " << report_median << " ms" << "\n";
+  }
+
+  auto pipeline_statistics = worker->delegate.GetAndClearPipelineStatistics();
+  if (result.IsSuccess() && !pipeline_statistics.empty()) {
+    *out << "Pipeline statistics (in script-order):" << "\n";
+    for (const auto& statistics : pipeline_statistics) {
+      if (!statistics.supported) {
+        *out << "    unsupported (requires DEVICE_FEATURE "
+             << "pipelineStatisticsQuery)" << "\n";
+        continue;
+      }
+      *out << "    input assembly vertices "
+           << statistics.input_assembly_vertices << ", primitives "
+           << statistics.input_assembly_primitives << "; vertex invocations "
+           << statistics.vertex_shader_invocations
+           << "; clipping invocations " << statistics.clipping_invocations
+           << ", primitives " << statistics.clipping_primitives
+           << "; fragment invocations "
+           << statistics.fragment_shader_invocations
+           << "; compute invocations " << statistics.compute_shader_invocations
+           << "\n";
+    }
+  }
+
+  return result.IsSuccess();
+}
+
+// Writes the shader, image and buffer dumps requested in |options| for
+// |recipe|, using the data in |extractions|. We dump even when the recipe
+// failed as the buffers may give clues as to the failure.
+void DumpRecipeOutputs(const Options& options,
+                       const amber::Recipe* recipe,
+                       const std::vector<amber::BufferInfo>& extractions,
+                       std::ostream* err) {
+  amber::Result result;
+
+  // Dump the shader assembly
+  if (!options.shader_filename.empty()) {
+#if AMBER_ENABLE_SPIRV_TOOLS
+    std::ofstream shader_file;
+    shader_file.open(options.shader_filename, std::ios::out);
+    if (!shader_file.is_open()) {
+      *err << "Cannot open file for shader dump: ";
+      *err << options.shader_filename << std::endl;
+    } else {
+      auto info = recipe->GetShaderInfo();
+      for (const auto& sh : info) {
+        shader_file << ";;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;" << std::endl;
+        shader_file << "; " << sh.shader_name << std::endl << ";" << std::endl;
+        shader_file << disassemble(options.spv_env, sh.shader_data)
+                    << std::endl;
+      }
+      shader_file.close();
+    }
+#endif  // AMBER_ENABLE_SPIRV_TOOLS
+  }
+
+  for (size_t i = 0; i < options.image_filenames.size(); ++i) {
+    std::vector<uint8_t> out_buf;
+    auto image_filename = options.image_filenames[i];
+    auto pos = image_filename.find_last_of('.');
+    bool usePNG =
+        pos != std::string::npos && image_filename.substr(pos + 1) == "png";
+    for (const amber::BufferInfo& buffer_info : extractions) {
+      if (buffer_info.buffer_name == options.fb_names[i]) {
+        if (buffer_info.values.size() !=
+            (buffer_info.width * buffer_info.height)) {
+          result = amber::Result(
+              "Framebuffer (" + buffer_info.buffer_name + ") size (" +
+              std::to_string(buffer_info.values.size()) +
+              ") != " + "width * height (" +
+              std::to_string(buffer_info.width * buffer_info.height) + ")");
+          break;
+        }
+
+        if (buffer_info.values.empty()) {
+          result = amber::Result("Framebuffer (" + buffer_info.buffer_name +
+                                 ") empty or non-existent.");
+          break;
+        }
+
+        if (usePNG) {
+#if AMBER_ENABLE_LODEPNG
+          result = png::ConvertToPNG(buffer_info.width, buffer_info.height,
+                                     buffer_info.values, &out_buf);
+#else   // AMBER_ENABLE_LODEPNG
+          result = amber::Result("PNG support not enabled");
+#endif  // AMBER_ENABLE_LODEPNG
+        } else {
+          ppm::ConvertToPPM(buffer_info.width, buffer_info.height,
+                            buffer_info.values, &out_buf);
+          result = {};
+        }
+        break;
+      }
+    }
+    if (result.IsSuccess()) {
+      std::ofstream image_file;
+      image_file.open(image_filename, std::ios::out | std::ios::binary);
+      if (!image_file.is_open()) {
+        *err << "Cannot open file for image dump: ";
+        *err << image_filename << std::endl;
+        continue;
+      }
+      image_file << std::string(out_buf.begin(), out_buf.end());
+      image_file.close();
+    } else {
+      *err << result.Error() << std::endl;
+    }
+  }
+
+  if (!options.buffer_filename.empty()) {
+    std::ofstream buffer_file;
+    buffer_file.open(options.buffer_filename, std::ios::out);
+    if (!buffer_file.is_open()) {
+      *err << "Cannot open file for buffer dump: ";
+      *err << options.buffer_filename << std::endl;
+    } else {
+      for (const amber::BufferInfo& buffer_info : extractions) {
+        // Skip frame buffers.
+        if (std::any_of(options.fb_names.begin(), options.fb_names.end(),
+                        [&](std::string s) {
+                          return s == buffer_info.buffer_name;
+                        }) ||
+            buffer_info.buffer_name == kGeneratedColorBuffer) {
+          continue;
+        }
+
+        buffer_file << buffer_info.buffer_name << std::endl;
+        const auto& values = buffer_info.values;
+        for (size_t i = 0; i < values.size(); ++i) {
+          buffer_file << " " << std::setfill('0') << std::setw(2) << std::hex
+                      << values[i].AsUint32();
+          if (i % 16 == 15) {
+            buffer_file << std::endl;
+          }
+        }
+        buffer_file << std::endl;
+      }
+      buffer_file.close();
+    }
+  }
+}
+
+#if AMBER_ENGINE_VULKAN
+// Merges the pipeline caches the engines of |workers| wrote back into the
+// config of the first worker. All workers use the same physical device, so
+// every cache can be loaded on the first worker's device and merged there.
+amber::Result MergePipelineCaches(
+    const std::vector<std::unique_ptr<Worker>>& workers) {
+  auto* merged_config =
+      static_cast<amber::VulkanEngineConfig*>(workers[0]->config.get());
+  VkDevice device = merged_config->device;
+
+  amber::Result result;
+  std::vector<VkPipelineCache> caches;
+  for (const auto& worker : workers) {
+    const auto& data =
+        static_cast<amber::VulkanEngineConfig*>(worker->config.get())
+            ->pipeline_cache_data;
+    VkPipelineCacheCreateInfo info = VkPipelineCacheCreateInfo();
+    info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    info.initialDataSize = data.size();
+    info.pInitialData = data.data();
+    VkPipelineCache cache = VK_NULL_HANDLE;
+    if (vkCreatePipelineCache(device, &info, nullptr, &cache) != VK_SUCCESS) {
+      result = amber::Result("vkCreatePipelineCache failed");
+      break;
+    }
+    caches.push_back(cache);
+  }
+
+  if (result.IsSuccess() &&
+      vkMergePipelineCaches(device, caches[0],
+                            static_cast<uint32_t>(caches.size() - 1),
+                            caches.data() + 1) != VK_SUCCESS) {
+    result = amber::Result("vkMergePipelineCaches failed");
+  }
+
+  if (result.IsSuccess()) {
+    size_t size = 0;
+    std::vector<uint8_t> data;
+    if (vkGetPipelineCacheData(device, caches[0], &size, nullptr) ==
+        VK_SUCCESS) {
+      data.resize(size);
+    }
+    if (data.empty() || vkGetPipelineCacheData(device, caches[0], &size,
+                                               data.data()) != VK_SUCCESS) {
+      result = amber::Result("vkGetPipelineCacheData failed");
+    } else {
+      data.resize(size);
+      merged_config->pipeline_cache_data = std::move(data);
+    }
+  }
+
+  for (VkPipelineCache cache : caches) {
+    vkDestroyPipelineCache(device, cache, nullptr);
+  }
+  return result;
+}
+#endif  // AMBER_ENGINE_VULKAN
+
 }  // namespace
 
 #ifdef AMBER_ANDROID_MAIN
@@ -512,12 +1028,11 @@ int main(int argc, const char** argv) {
     return 0;
   }
 
+  const bool trace = !options.trace_filename.empty();
+  delegate.SetTraceEnabled(trace);
+
   amber::Result result;
   std::vector<std::string> failures;
-  struct RecipeData {
-    std::string file;
-    std::unique_ptr<amber::Recipe> recipe;
-  };
   std::vector<RecipeData> recipe_data;
   for (const auto& file : options.input_filenames) {
     auto char_data = ReadFile(file);
@@ -554,19 +1069,13 @@ int main(int argc, const char** argv) {
   }
 
   if (options.parse_only) {
+    if (trace && !WriteTrace(options.trace_filename, {&delegate})) {
+      std::cerr << "Cannot write trace file: " << options.trace_filename
+                << std::endl;
+    }
     return 0;
   }
 
-  if (options.log_graphics_calls) {
-    delegate.SetLogGraphicsCalls(true);
-  }
-  if (options.log_graphics_calls_time) {
-    delegate.SetLogGraphicsCallsTime(true);
-  }
-  if (options.log_execute_calls) {
-    delegate.SetLogExecuteCalls(true);
-  }
-
   amber::Options amber_options;
   amber_options.engine = options.engine;
   amber_options.spv_env = options.spv_env;
@@ -574,6 +1083,8 @@ int main(int argc, const char** argv) {
                                      ? amber::ExecutionType::kPipelineCreateOnly
                                      : amber::ExecutionType::kExecute;
   amber_options.disable_spirv_validation = options.disable_spirv_validation;
+  amber_options.repeat_mode = options.repeat_mode;
+  amber_options.shader_cache_dir = options.shader_cache_dir;
 
   std::set<std::string> required_features;
   std::set<std::string> required_device_extensions;
@@ -593,28 +1104,6 @@ int main(int argc, const char** argv) {
                                         inst_extensions.end());
   }
 
-  sample::ConfigHelper config_helper;
-  std::unique_ptr<amber::EngineConfig> config;
-
-  amber::Result r = config_helper.CreateConfig(
-      amber_options.engine, options.engine_major, options.engine_minor,
-      options.selected_device,
-      std::vector<std::string>(required_features.begin(),
-                               required_features.end()),
-      std::vector<std::string>(required_instance_extensions.begin(),
-                               required_instance_extensions.end()),
-      std::vector<std::string>(required_device_extensions.begin(),
-                               required_device_extensions.end()),
-      options.disable_validation_layer, options.enable_pipeline_runtime_layer,
-      options.show_version_info, &config);
-
-  if (!r.IsSuccess()) {
-    std::cout << r.Error() << std::endl;
-    return 1;
-  }
-
-  amber_options.config = config.get();
-
   if (!options.buffer_filename.empty()) {
     // Have a filename to dump, but no explicit buffer, set the default of 0:0.
     if (options.buffer_to_dump.empty()) {
@@ -646,149 +1135,151 @@ int main(int argc, const char** argv) {
     amber_options.extractions.push_back(buffer_info);
   }
 
-  for (const auto& recipe_data_elem : recipe_data) {
-    const auto* recipe = recipe_data_elem.recipe.get();
-    const auto& file = recipe_data_elem.file;
-
-    amber::Amber am(&delegate);
-    result = am.Execute(recipe, &amber_options);
-    if (!result.IsSuccess()) {
-      std::cerr << file << ": " << result.Error() << "\n";
-      failures.push_back(file);
-      // Note, we continue after failure to allow dumping the buffers which may
-      // give clues as to the failure.
-    }
-
-    auto execution_timing = delegate.GetAndClearExecutionTiming();
-    if (result.IsSuccess() && options.log_execution_timing &&
-        !execution_timing.empty()) {
-      std::cout << "Execution timing (in script-order):" << "\n";
-      std::cout << "    ";
-      bool is_first_iter = true;
-      for (auto& timing : execution_timing) {
-        if (!is_first_iter) {
-          std::cout << ", ";
-        }
-        is_first_iter = false;
-        std::cout << timing;
+#if AMBER_ENGINE_VULKAN
+  bool use_pipeline_cache = false;
+  std::vector<uint8_t> pipeline_cache_data;
+#endif  // AMBER_ENGINE_VULKAN
+  if (!options.pipeline_cache_filename.empty()) {
+#if AMBER_ENGINE_VULKAN
+    if (amber_options.engine == amber::kEngineTypeVulkan) {
+      use_pipeline_cache = true;
+
+      // A missing cache file is expected on the first run.
+      std::ifstream cache_file(options.pipeline_cache_filename,
+                               std::ios::in | std::ios::binary);
+      if (cache_file.is_open()) {
+        pipeline_cache_data.assign(std::istreambuf_iterator<char>(cache_file),
+                                   std::istreambuf_iterator<char>());
       }
-      std::cout << "\n";
-      std::sort(execution_timing.begin(), execution_timing.end());
-      auto report_median =
-          (execution_timing[execution_timing.size() / 2] +
-           execution_timing[(execution_timing.size() - 1) / 2]) /
-          2;
-      std::cout << "\n";
-      std::cout << "Execution time median = " << report_median << " ms" << "\n";
+    } else {
+      std::cerr << "--pipeline-cache is only supported with Vulkan"
+                << std::endl;
     }
+#else   // AMBER_ENGINE_VULKAN
+    std::cerr << "--pipeline-cache is only supported with Vulkan" << std::endl;
+#endif  // AMBER_ENGINE_VULKAN
+  }
 
-    // Dump the shader assembly
-    if (!options.shader_filename.empty()) {
-#if AMBER_ENABLE_SPIRV_TOOLS
-      std::ofstream shader_file;
-      shader_file.open(options.shader_filename, std::ios::out);
-      if (!shader_file.is_open()) {
-        std::cerr << "Cannot open file for shader dump: ";
-        std::cerr << options.shader_filename << std::endl;
-      } else {
-        auto info = recipe->GetShaderInfo();
-        for (const auto& sh : info) {
-          shader_file << ";;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;"
-                      << std::endl;
-          shader_file << "; " << sh.shader_name << std::endl
-                      << ";" << std::endl;
-          shader_file << disassemble(options.spv_env, sh.shader_data)
-                      << std::endl;
-        }
-        shader_file.close();
-      }
-#endif  // AMBER_ENABLE_SPIRV_TOOLS
+  // Each worker creates its own device, so recipes running on different
+  // workers never share a queue. With --reuse-engine a worker runs all of its
+  // recipes on a single engine.
+  const size_t worker_count = std::max<size_t>(
+      1, std::min<size_t>(options.jobs, recipe_data.size()));
+  std::vector<std::unique_ptr<Worker>> workers;
+  for (size_t i = 0; i < worker_count; ++i) {
+    auto worker = std::make_unique<Worker>();
+
+    amber::Result r = worker->config_helper.CreateConfig(
+        amber_options.engine, options.engine_major, options.engine_minor,
+        options.selected_device,
+        std::vector<std::string>(required_features.begin(),
+                                 required_features.end()),
+        std::vector<std::string>(required_instance_extensions.begin(),
+                                 required_instance_extensions.end()),
+        std::vector<std::string>(required_device_extensions.begin(),
+                                 required_device_extensions.end()),
+        options.disable_validation_layer, options.enable_pipeline_runtime_layer,
+        options.show_version_info && i == 0, &worker->config);
+    if (!r.IsSuccess()) {
+      std::cout << r.Error() << std::endl;
+      return 1;
     }
 
-    for (size_t i = 0; i < options.image_filenames.size(); ++i) {
-      std::vector<uint8_t> out_buf;
-      auto image_filename = options.image_filenames[i];
-      auto pos = image_filename.find_last_of('.');
-      bool usePNG =
-          pos != std::string::npos && image_filename.substr(pos + 1) == "png";
-      for (const amber::BufferInfo& buffer_info : amber_options.extractions) {
-        if (buffer_info.buffer_name == options.fb_names[i]) {
-          if (buffer_info.values.size() !=
-              (buffer_info.width * buffer_info.height)) {
-            result = amber::Result(
-                "Framebuffer (" + buffer_info.buffer_name + ") size (" +
-                std::to_string(buffer_info.values.size()) +
-                ") != " + "width * height (" +
-                std::to_string(buffer_info.width * buffer_info.height) + ")");
-            break;
-          }
+#if AMBER_ENGINE_VULKAN
+    if (use_pipeline_cache) {
+      auto* vk_config =
+          static_cast<amber::VulkanEngineConfig*>(worker->config.get());
+      vk_config->enable_pipeline_cache = true;
+      vk_config->pipeline_cache_data = pipeline_cache_data;
+    }
+    if (options.staging_pool_mb >= 0 &&
+        amber_options.engine == amber::kEngineTypeVulkan) {
+      auto* vk_config =
+          static_cast<amber::VulkanEngineConfig*>(worker->config.get());
+      vk_config->staging_pool_max_bytes =
+          static_cast<uint64_t>(options.staging_pool_mb) * 1024 * 1024;
+    }
+#endif  // AMBER_ENGINE_VULKAN
 
-          if (buffer_info.values.empty()) {
-            result = amber::Result("Framebuffer (" + buffer_info.buffer_name +
-                                   ") empty or non-existent.");
-            break;
-          }
+    if (options.log_graphics_calls) {
+      worker->delegate.SetLogGraphicsCalls(true);
+    }
+    if (options.log_graphics_calls_time) {
+      worker->delegate.SetLogGraphicsCallsTime(true);
+    }
+    if (options.log_execute_calls) {
+      worker->delegate.SetLogExecuteCalls(true);
+    }
+    worker->delegate.SetTraceEnabled(trace);
+
+    worker->amber_options = amber_options;
+    worker->amber_options.config = worker->config.get();
+    // The workers share the hardware threads for compiling shaders.
+    worker->amber_options.compile_threads = std::max<uint32_t>(
+        1, std::thread::hardware_concurrency() /
+               static_cast<uint32_t>(worker_count));
+
+    if (options.reuse_engine) {
+      worker->session =
+          std::make_unique<amber::AmberSession>(&worker->delegate);
+      r = worker->session->Initialize(&worker->amber_options);
+      if (!r.IsSuccess()) {
+        std::cerr << r.Error() << std::endl;
+        return 1;
+      }
+    }
 
-          if (usePNG) {
-#if AMBER_ENABLE_LODEPNG
-            result = png::ConvertToPNG(buffer_info.width, buffer_info.height,
-                                       buffer_info.values, &out_buf);
-#else   // AMBER_ENABLE_LODEPNG
-            result = amber::Result("PNG support not enabled");
-#endif  // AMBER_ENABLE_LODEPNG
-          } else {
-            ppm::ConvertToPPM(buffer_info.width, buffer_info.height,
-                              buffer_info.values, &out_buf);
-            result = {};
-          }
-          break;
-        }
+    workers.push_back(std::move(worker));
+  }
+
+  std::vector<uint8_t> passed(recipe_data.size(), 0);
+  std::atomic<size_t> next_recipe(0);
+  std::mutex output_mutex;
+  auto run_worker = [&](Worker* worker) {
+    for (size_t i = next_recipe++; i < recipe_data.size();
+         i = next_recipe++) {
+      const RecipeData& recipe_data_elem = recipe_data[i];
+
+      // With several workers the output of each recipe is buffered and
+      // printed in one piece, so the output of different recipes does not
+      // interleave.
+      std::ostringstream buffered_out;
+      std::ostringstream buffered_err;
+      std::ostream* out = &std::cout;
+      std::ostream* err = &std::cerr;
+      if (workers.size() > 1) {
+        out = &buffered_out;
+        err = &buffered_err;
       }
-      if (result.IsSuccess()) {
-        std::ofstream image_file;
-        image_file.open(image_filename, std::ios::out | std::ios::binary);
-        if (!image_file.is_open()) {
-          std::cerr << "Cannot open file for image dump: ";
-          std::cerr << image_filename << std::endl;
-          continue;
-        }
-        image_file << std::string(out_buf.begin(), out_buf.end());
-        image_file.close();
-      } else {
-        std::cerr << result.Error() << std::endl;
+      worker->delegate.SetLogStream(out);
+
+      passed[i] = ExecuteRecipe(options, recipe_data_elem, worker, out, err);
+
+      std::lock_guard<std::mutex> lock(output_mutex);
+      DumpRecipeOutputs(options, recipe_data_elem.recipe.get(),
+                        worker->amber_options.extractions, err);
+      if (workers.size() > 1) {
+        std::cout << buffered_out.str() << std::flush;
+        std::cerr << buffered_err.str() << std::flush;
       }
     }
+  };
 
-    if (!options.buffer_filename.empty()) {
-      std::ofstream buffer_file;
-      buffer_file.open(options.buffer_filename, std::ios::out);
-      if (!buffer_file.is_open()) {
-        std::cerr << "Cannot open file for buffer dump: ";
-        std::cerr << options.buffer_filename << std::endl;
-      } else {
-        for (const amber::BufferInfo& buffer_info : amber_options.extractions) {
-          // Skip frame buffers.
-          if (std::any_of(options.fb_names.begin(), options.fb_names.end(),
-                          [&](std::string s) {
-                            return s == buffer_info.buffer_name;
-                          }) ||
-              buffer_info.buffer_name == kGeneratedColorBuffer) {
-            continue;
-          }
+  if (workers.size() == 1) {
+    run_worker(workers[0].get());
+  } else {
+    std::vector<std::thread> threads;
+    for (auto& worker : workers) {
+      threads.emplace_back(run_worker, worker.get());
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
 
-          buffer_file << buffer_info.buffer_name << std::endl;
-          const auto& values = buffer_info.values;
-          for (size_t i = 0; i < values.size(); ++i) {
-            buffer_file << " " << std::setfill('0') << std::setw(2) << std::hex
-                        << values[i].AsUint32();
-            if (i % 16 == 15) {
-              buffer_file << std::endl;
-            }
-          }
-          buffer_file << std::endl;
-        }
-        buffer_file.close();
-      }
+  for (size_t i = 0; i < recipe_data.size(); ++i) {
+    if (!passed[i]) {
+      failures.push_back(recipe_data[i].file);
     }
   }
 
@@ -804,6 +1295,64 @@ int main(int argc, const char** argv) {
     std::cout << "\nSummary: "
               << (options.input_filenames.size() - failures.size()) << " pass, "
               << failures.size() << " fail" << std::endl;
+
+    if (!options.shader_cache_dir.empty()) {
+      amber::ShaderCacheStats stats;
+      for (const auto& worker : workers) {
+        const auto& worker_stats = worker->amber_options.shader_cache_stats;
+        stats.hits += worker_stats.hits;
+        stats.misses += worker_stats.misses;
+        stats.bytes_saved += worker_stats.bytes_saved;
+      }
+      std::cout << "Shader cache: " << stats.hits << " hits, " << stats.misses
+                << " misses, " << stats.bytes_saved << " bytes saved"
+                << std::endl;
+    }
+  }
+
+  // Destroying the engines stores the pipeline cache data in the configs.
+  for (auto& worker : workers) {
+    worker->session.reset();
+  }
+
+#if AMBER_ENGINE_VULKAN
+  // The caches of the other workers are merged into the first worker's
+  // cache. If that fails, only the first worker's cache is written.
+  if (use_pipeline_cache) {
+    if (workers.size() > 1) {
+      amber::Result r = MergePipelineCaches(workers);
+      if (!r.IsSuccess()) {
+        std::cerr << "Cannot merge pipeline caches: " << r.Error()
+                  << std::endl;
+      }
+    }
+
+    const auto& cache_data =
+        static_cast<amber::VulkanEngineConfig*>(workers[0]->config.get())
+            ->pipeline_cache_data;
+    if (!cache_data.empty()) {
+      std::ofstream cache_file(options.pipeline_cache_filename,
+                               std::ios::out | std::ios::binary);
+      if (!cache_file.is_open()) {
+        std::cerr << "Cannot open file for pipeline cache: ";
+        std::cerr << options.pipeline_cache_filename << std::endl;
+      } else {
+        cache_file.write(reinterpret_cast<const char*>(cache_data.data()),
+                         static_cast<std::streamsize>(cache_data.size()));
+      }
+    }
+  }
+#endif  // AMBER_ENGINE_VULKAN
+
+  if (trace) {
+    std::vector<SampleDelegate*> delegates = {&delegate};
+    for (auto& worker : workers) {
+      delegates.push_back(&worker->delegate);
+    }
+    if (!WriteTrace(options.trace_filename, delegates)) {
+      std::cerr << "Cannot write trace file: " << options.trace_filename
+                << std::endl;
+    }
   }
 
   return !failures.empty();
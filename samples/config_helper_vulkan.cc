@@ -936,6 +936,8 @@ amber::Result ConfigHelperVulkan::CheckVulkanPhysicalDeviceRequirements(
       supports_.vulkan_memory_model = true;
     } else if (ext == VK_KHR_ZERO_INITIALIZE_WORKGROUP_MEMORY_EXTENSION_NAME) {
       supports_.zero_initialize_workgroup_memory = true;
+    } else if (ext == VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME) {
+      supports_.push_descriptor = true;
 #ifdef VK_EXT_SHADER_LONG_VECTOR_EXTENSION_NAME
     } else if (ext == VK_EXT_SHADER_LONG_VECTOR_EXTENSION_NAME) {
       supports_.shader_long_vector = true;
@@ -1486,6 +1488,13 @@ amber::Result ConfigHelperVulkan::CreateDeviceWithFeatures2(
     exts.push_back(VK_KHR_SHADER_FLOAT_CONTROLS_EXTENSION_NAME);
   }
 
+  // Lets the engine push descriptors instead of writing descriptor sets.
+  if (supports_.push_descriptor &&
+      std::find(exts.begin(), exts.end(),
+                VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME) == exts.end()) {
+    exts.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+  }
+
   features_.features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
   features_.features2.pNext = pnext;
 
@@ -1675,6 +1684,8 @@ amber::Result ConfigHelperVulkan::CreateConfig(
   config->available_features2 = features_.features2;
   config->available_instance_extensions = vk_.available_instance_extensions;
   config->available_device_extensions = vk_.available_device_extensions;
+  config->push_descriptor_enabled =
+      supports_.get_physical_device_properties2 && supports_.push_descriptor;
   config->instance = vk_.instance;
   config->queue_family_index = vk_.queue_family_index;
   config->queue = vk_.queue;
@@ -134,6 +134,7 @@ class ConfigHelperVulkan : public ConfigHelperImpl {
     bool vulkan_memory_model = false;
     bool zero_initialize_workgroup_memory = false;
     bool shader_long_vector = false;
+    bool push_descriptor = false;
   } supports_;
 
   struct {
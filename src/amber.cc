@@ -17,6 +17,7 @@
 
 #include <cctype>
 #include <cstdlib>
+#include <future>  // NOLINT(build/c++11)
 #include <memory>
 #include <string>
 
@@ -25,6 +26,7 @@
 #include "src/engine.h"
 #include "src/executor.h"
 #include "src/parser.h"
+#include "src/trace_scope.h"
 #include "src/vkscript/parser.h"
 
 namespace amber {
@@ -32,7 +34,7 @@ namespace {
 
 const FormatType kDefaultFramebufferFormat = FormatType::kB8G8R8A8_UNORM;
 
-Result GetFrameBuffer(Buffer* buffer, std::vector<Value>* values) {
+Result GetFrameBuffer(const Buffer* buffer, std::vector<Value>* values) {
   values->clear();
 
   // TODO(jaebaek): Support other formats
@@ -70,10 +72,15 @@ Options::Options()
     : engine(amber::EngineType::kEngineTypeVulkan),
       config(nullptr),
       execution_type(ExecutionType::kExecute),
-      disable_spirv_validation(false) {}
+      repeat_mode(RepeatMode::kExecute),
+      disable_spirv_validation(false),
+      compile_threads(1),
+      compile_memo_entries(1024) {}
 
 Options::~Options() = default;
 
+ShaderCacheStats::ShaderCacheStats() : hits(0), misses(0), bytes_saved(0) {}
+
 BufferInfo::BufferInfo() : is_image_buffer(false), width(0), height(0) {}
 
 BufferInfo::BufferInfo(const BufferInfo&) = default;
@@ -82,6 +89,24 @@ BufferInfo::~BufferInfo() = default;
 
 BufferInfo& BufferInfo::operator=(const BufferInfo&) = default;
 
+TraceSpan::TraceSpan() : start_ns(0), end_ns(0), line(0) {}
+
+TraceSpan::TraceSpan(const TraceSpan&) = default;
+
+TraceSpan::~TraceSpan() = default;
+
+TraceSpan& TraceSpan::operator=(const TraceSpan&) = default;
+
+PipelineStatistics::PipelineStatistics()
+    : supported(false),
+      input_assembly_vertices(0),
+      input_assembly_primitives(0),
+      vertex_shader_invocations(0),
+      clipping_invocations(0),
+      clipping_primitives(0),
+      fragment_shader_invocations(0),
+      compute_shader_invocations(0) {}
+
 Delegate::~Delegate() = default;
 
 Amber::Amber(Delegate* delegate) : delegate_(delegate) {}
@@ -93,6 +118,8 @@ amber::Result Amber::Parse(const std::string& input, amber::Recipe* recipe) {
     return Result("Recipe must be provided to Parse.");
   }
 
+  TraceScope trace(GetDelegate(), "parse", "Parse", 0);
+
   std::unique_ptr<Parser> parser;
   if (input.substr(0, 7) == "#!amber") {
     parser = std::make_unique<amberscript::Parser>(GetDelegate());
@@ -151,37 +178,19 @@ Result CreateEngineAndCheckRequirements(const Recipe* recipe,
 
   return r;
 }
-}  // namespace
-
-amber::Result Amber::AreAllRequirementsSupported(const amber::Recipe* recipe,
-                                                 Options* opts) {
-  std::unique_ptr<Engine> engine;
-  Script* script = nullptr;
-
-  return CreateEngineAndCheckRequirements(recipe, opts, GetDelegate(), &engine,
-                                          &script);
-}
-
-amber::Result Amber::Execute(const amber::Recipe* recipe, Options* opts) {
-  ShaderMap map;
-  return ExecuteWithShaderData(recipe, opts, map);
-}
 
-amber::Result Amber::ExecuteWithShaderData(const amber::Recipe* recipe,
-                                           Options* opts,
-                                           const ShaderMap& shader_data) {
-  std::unique_ptr<Engine> engine;
-  Script* script = nullptr;
-  Result r = CreateEngineAndCheckRequirements(recipe, opts, GetDelegate(),
-                                              &engine, &script);
-  if (!r.IsSuccess()) {
-    return r;
-  }
+// Runs |script| on the already initialized |engine| and performs the
+// extractions requested in |opts|.
+Result ExecuteScript(Engine* engine,
+                     Script* script,
+                     Options* opts,
+                     const ShaderMap& shader_data,
+                     Delegate* delegate) {
   script->SetSpvTargetEnv(opts->spv_env);
 
   Executor executor;
   Result executor_result =
-      executor.Execute(engine.get(), script, shader_data, opts, GetDelegate());
+      executor.Execute(engine, script, shader_data, opts, delegate);
   // Hold the executor result until the extractions are complete. This will let
   // us dump any buffers requested even on failure.
 
@@ -192,6 +201,7 @@ amber::Result Amber::ExecuteWithShaderData(const amber::Recipe* recipe,
     return {};
   }
 
+  Result r;
   // Try to perform each extraction, copying the buffer data into |buffer_info|.
   // We do not overwrite |executor_result| if extraction fails.
   for (BufferInfo& buffer_info : opts->extractions) {
@@ -247,4 +257,137 @@ amber::Result Amber::ExecuteWithShaderData(const amber::Recipe* recipe,
   return {};
 }
 
+}  // namespace
+
+amber::Result Amber::AreAllRequirementsSupported(const amber::Recipe* recipe,
+                                                 Options* opts) {
+  std::unique_ptr<Engine> engine;
+  Script* script = nullptr;
+
+  return CreateEngineAndCheckRequirements(recipe, opts, GetDelegate(), &engine,
+                                          &script);
+}
+
+amber::Result Amber::Execute(const amber::Recipe* recipe, Options* opts) {
+  ShaderMap map;
+  return ExecuteWithShaderData(recipe, opts, map);
+}
+
+amber::Result Amber::ExecuteWithShaderData(const amber::Recipe* recipe,
+                                           Options* opts,
+                                           const ShaderMap& shader_data) {
+  std::unique_ptr<Engine> engine;
+  Script* script = nullptr;
+  Result r = CreateEngineAndCheckRequirements(recipe, opts, GetDelegate(),
+                                              &engine, &script);
+  if (!r.IsSuccess()) {
+    return r;
+  }
+
+  return ExecuteScript(engine.get(), script, opts, shader_data, GetDelegate());
+}
+
+std::future<amber::Result> Amber::ExecuteAsync(const amber::Recipe* recipe,
+                                               Options* opts) {
+  return ExecuteWithShaderDataAsync(recipe, opts, ShaderMap());
+}
+
+std::future<amber::Result> Amber::ExecuteWithShaderDataAsync(
+    const amber::Recipe* recipe,
+    Options* opts,
+    const ShaderMap& shader_data) {
+  // Only the delegate is captured, as this Amber may be destroyed before the
+  // execution finishes.
+  Delegate* delegate = GetDelegate();
+  auto execute = [recipe, opts, shader_data, delegate]() {
+    Amber amber(delegate);
+    Result r = amber.ExecuteWithShaderData(recipe, opts, shader_data);
+    if (delegate) {
+      delegate->ReportExecutionComplete(recipe, r);
+    }
+    return r;
+  };
+  return std::async(std::launch::async, execute);
+}
+
+AmberSession::AmberSession(Delegate* delegate)
+    : delegate_(delegate),
+      engine_type_(EngineType::kEngineTypeVulkan) {}
+
+AmberSession::~AmberSession() = default;
+
+amber::Result AmberSession::Initialize(Options* opts) {
+  if (engine_) {
+    return Result("AmberSession is already initialized");
+  }
+
+  auto engine = Engine::Create(opts->engine);
+  if (!engine) {
+    return Result("Failed to create engine");
+  }
+
+  // Requirements are checked per recipe, see CheckRecipe().
+  Result r = engine->Initialize(opts->config, delegate_, {}, {}, {}, {});
+  if (!r.IsSuccess()) {
+    return r;
+  }
+
+  engine_type_ = opts->engine;
+  engine_ = std::move(engine);
+  return {};
+}
+
+amber::Result AmberSession::CheckRecipe(const amber::Recipe* recipe,
+                                        Options* opts) {
+  if (!engine_) {
+    return Result("AmberSession is not initialized");
+  }
+  if (opts->engine != engine_type_) {
+    return Result("Options select a different engine than the session");
+  }
+  if (!recipe) {
+    return Result("Attempting to check an invalid recipe");
+  }
+
+  Script* script = static_cast<Script*>(recipe->GetImpl());
+  if (!script) {
+    return Result("Recipe must contain a parsed script");
+  }
+
+  return engine_->CheckRequirements(script->GetRequiredFeatures(),
+                                    script->GetRequiredProperties(),
+                                    script->GetRequiredInstanceExtensions(),
+                                    script->GetRequiredDeviceExtensions());
+}
+
+amber::Result AmberSession::AreAllRequirementsSupported(
+    const amber::Recipe* recipe,
+    Options* opts) {
+  return CheckRecipe(recipe, opts);
+}
+
+amber::Result AmberSession::Execute(const amber::Recipe* recipe,
+                                    Options* opts) {
+  ShaderMap map;
+  return ExecuteWithShaderData(recipe, opts, map);
+}
+
+amber::Result AmberSession::ExecuteWithShaderData(
+    const amber::Recipe* recipe,
+    Options* opts,
+    const ShaderMap& shader_data) {
+  Result r = CheckRecipe(recipe, opts);
+  if (!r.IsSuccess()) {
+    return r;
+  }
+
+  Script* script = static_cast<Script*>(recipe->GetImpl());
+  r = ExecuteScript(engine_.get(), script, opts, shader_data, delegate_);
+
+  // The pipelines reference the script, which the caller may destroy once
+  // we return.
+  engine_->ResetPipelines();
+  return r;
+}
+
 }  // namespace amber
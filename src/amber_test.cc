@@ -0,0 +1,119 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "amber/amber.h"
+
+#include <algorithm>
+#include <future>  // NOLINT(build/c++11)
+#include <mutex>   // NOLINT(build/c++11)
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace amber {
+namespace {
+
+class CompletionDelegate : public Delegate {
+ public:
+  CompletionDelegate() = default;
+  ~CompletionDelegate() override = default;
+
+  void Log(const std::string&) override {}
+  bool LogGraphicsCalls() const override { return false; }
+  bool LogGraphicsCallsTime() const override { return false; }
+  uint64_t GetTimestampNs() const override { return 0; }
+  bool LogExecuteCalls() const override { return false; }
+  Result LoadBufferData(const std::string,
+                        BufferDataFileType,
+                        BufferInfo*) const override {
+    return Result("CompletionDelegate::LoadBufferData not implemented");
+  }
+  Result LoadFile(const std::string, std::vector<char>*) const override {
+    return Result("CompletionDelegate::LoadFile not implemented");
+  }
+
+  void ReportExecutionComplete(const Recipe* recipe,
+                               const Result& result) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    completed_.push_back(recipe);
+    errors_.push_back(result.Error());
+  }
+
+  std::vector<const Recipe*> GetCompleted() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return completed_;
+  }
+  std::vector<std::string> GetErrors() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return errors_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<const Recipe*> completed_;
+  std::vector<std::string> errors_;
+};
+
+}  // namespace
+
+using AmberTest = testing::Test;
+
+TEST_F(AmberTest, ExecuteAsyncReportsResult) {
+  CompletionDelegate delegate;
+  Amber amber(&delegate);
+  Options opts;
+
+  std::future<Result> future = amber.ExecuteAsync(nullptr, &opts);
+  Result r = future.get();
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_EQ("Attempting to check an invalid recipe", r.Error());
+
+  ASSERT_EQ(1U, delegate.GetCompleted().size());
+  EXPECT_EQ(nullptr, delegate.GetCompleted()[0]);
+  EXPECT_EQ(r.Error(), delegate.GetErrors()[0]);
+}
+
+TEST_F(AmberTest, ExecuteAsyncRunsConcurrentRecipes) {
+  const std::string kScript = R"(#!amber
+BUFFER buf DATA_TYPE uint32 DATA 1 2 3 4 END
+)";
+
+  CompletionDelegate delegate;
+  Amber amber(&delegate);
+
+  // No engine config is provided, so every execution fails once it tries to
+  // initialize the engine.
+  const size_t kCount = 4;
+  std::vector<Recipe> recipes(kCount);
+  std::vector<Options> opts(kCount);
+  std::vector<std::future<Result>> futures;
+  for (size_t i = 0; i < kCount; ++i) {
+    Result r = amber.Parse(kScript, &recipes[i]);
+    ASSERT_TRUE(r.IsSuccess()) << r.Error();
+    futures.push_back(amber.ExecuteAsync(&recipes[i], &opts[i]));
+  }
+
+  for (auto& future : futures) {
+    EXPECT_FALSE(future.get().IsSuccess());
+  }
+
+  std::vector<const Recipe*> completed = delegate.GetCompleted();
+  ASSERT_EQ(kCount, completed.size());
+  for (const auto& recipe : recipes) {
+    EXPECT_EQ(1, std::count(completed.begin(), completed.end(), &recipe));
+  }
+}
+
+}  // namespace amber
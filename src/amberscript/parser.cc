@@ -314,6 +314,17 @@ bool IsValidSampleCount(uint32_t samples) {
                     samples) != std::end(valid_samples));
 }
 
+// Returns BufferPlacement::kDefault if |name| is not a buffer placement.
+BufferPlacement ToBufferPlacement(const std::string& name) {
+  if (name == "DEVICE_LOCAL") {
+    return BufferPlacement::kDeviceLocal;
+  }
+  if (name == "HOST_VISIBLE") {
+    return BufferPlacement::kHostVisible;
+  }
+  return BufferPlacement::kDefault;
+}
+
 }  // namespace
 
 Parser::Parser() : amber::Parser(nullptr) {}
@@ -418,7 +429,7 @@ Result Parser::Parse(const std::string& data) {
 bool Parser::IsRepeatable(const std::string& name) const {
   return name == "CLEAR" || name == "CLEAR_COLOR" || name == "CLEAR_DEPTH" ||
          name == "CLEAR_STENCIL" || name == "COPY" || name == "EXPECT" ||
-         name == "RUN";
+         name == "RUN" || name == "WAIT";
 }
 
 // The given |name| must be one of the repeatable commands or this method
@@ -445,6 +456,9 @@ Result Parser::ParseRepeatableCommand(const std::string& name) {
   if (name == "RUN") {
     return ParseRun();
   }
+  if (name == "WAIT") {
+    return ParseWait();
+  }
 
   return Result("invalid repeatable command: " + name);
 }
@@ -530,6 +544,7 @@ Result Parser::ValidateEndOfStatement(const std::string& name) {
 }
 
 Result Parser::ParseShaderBlock() {
+  size_t line = tokenizer_->GetCurrentLine();
   auto token = tokenizer_->NextToken();
   if (!token->IsIdentifier()) {
     return Result("invalid token when looking for shader type");
@@ -542,6 +557,7 @@ Result Parser::ParseShaderBlock() {
   }
 
   auto shader = std::make_unique<Shader>(type);
+  shader->SetLine(line);
 
   token = tokenizer_->NextToken();
   if (!token->IsIdentifier()) {
@@ -670,6 +686,7 @@ Result Parser::ParseShaderBlock() {
 }
 
 Result Parser::ParsePipelineBlock() {
+  size_t line = tokenizer_->GetCurrentLine();
   auto token = tokenizer_->NextToken();
   if (!token->IsIdentifier()) {
     return Result("invalid token when looking for pipeline type");
@@ -682,6 +699,7 @@ Result Parser::ParsePipelineBlock() {
   }
 
   auto pipeline = std::make_unique<Pipeline>(type);
+  pipeline->SetLine(line);
 
   token = tokenizer_->NextToken();
   if (!token->IsIdentifier()) {
@@ -2571,6 +2589,23 @@ Result Parser::ParseBuffer() {
     return Result("invalid BUFFER command provided");
   }
 
+  BufferPlacement placement = BufferPlacement::kDefault;
+  if (token->AsString() == "PLACEMENT") {
+    token = tokenizer_->NextToken();
+    if (!token->IsIdentifier()) {
+      return Result("missing BUFFER PLACEMENT value");
+    }
+    placement = ToBufferPlacement(token->AsString());
+    if (placement == BufferPlacement::kDefault) {
+      return Result("invalid BUFFER PLACEMENT value: " + token->AsString());
+    }
+
+    token = tokenizer_->NextToken();
+    if (!token->IsIdentifier()) {
+      return Result("invalid BUFFER command provided");
+    }
+  }
+
   std::unique_ptr<Buffer> buffer;
   auto& cmd = token->AsString();
   if (cmd == "DATA_TYPE") {
@@ -2637,6 +2672,7 @@ Result Parser::ParseBuffer() {
     return Result("unknown BUFFER command provided: " + cmd);
   }
   buffer->SetName(name);
+  buffer->SetPlacement(placement);
 
   Result r = script_->AddBuffer(std::move(buffer));
   if (!r.IsSuccess()) {
@@ -3114,11 +3150,26 @@ Result Parser::ParseBufferInitializerFile(Buffer* buffer) {
 Result Parser::ParseRun() {
   auto token = tokenizer_->NextToken();
 
-  // Timed execution option for this specific run.
+  // Asynchronous, timed execution and pipeline statistics options for this
+  // specific run.
+  bool is_async = false;
   bool is_timed_execution = false;
-  if (token->AsString() == "TIMED_EXECUTION") {
+  bool is_pipeline_statistics = false;
+  while (true) {
+    if (!is_async && token->AsString() == "ASYNC") {
+      is_async = true;
+    } else if (!is_timed_execution && token->AsString() == "TIMED_EXECUTION") {
+      is_timed_execution = true;
+    } else if (!is_pipeline_statistics && token->AsString() == "STATISTICS") {
+      is_pipeline_statistics = true;
+    } else {
+      break;
+    }
     token = tokenizer_->NextToken();
-    is_timed_execution = true;
+  }
+  // Reading the statistics waits for the command.
+  if (is_async && is_pipeline_statistics) {
+    return Result("STATISTICS can not be used with an ASYNC RUN command");
   }
 
   if (!token->IsIdentifier()) {
@@ -3138,6 +3189,12 @@ Result Parser::ParseRun() {
     if (is_timed_execution) {
       cmd->SetTimedExecution();
     }
+    if (is_pipeline_statistics) {
+      cmd->SetPipelineStatistics();
+    }
+    if (is_async) {
+      cmd->SetAsync();
+    }
 
     while (true) {
       if (tokenizer_->PeekNextToken()->IsInteger()) {
@@ -3227,6 +3284,12 @@ Result Parser::ParseRun() {
     if (is_timed_execution) {
       cmd->SetTimedExecution();
     }
+    if (is_pipeline_statistics) {
+      cmd->SetPipelineStatistics();
+    }
+    if (is_async) {
+      cmd->SetAsync();
+    }
 
     token = tokenizer_->NextToken();
     if (!token->IsInteger()) {
@@ -3283,6 +3346,12 @@ Result Parser::ParseRun() {
     if (is_timed_execution) {
       cmd->SetTimedExecution();
     }
+    if (is_pipeline_statistics) {
+      cmd->SetPipelineStatistics();
+    }
+    if (is_async) {
+      cmd->SetAsync();
+    }
 
     Result r = token->ConvertToDouble();
     if (!r.IsSuccess()) {
@@ -3365,6 +3434,12 @@ Result Parser::ParseRun() {
     if (is_timed_execution) {
       cmd->SetTimedExecution();
     }
+    if (is_pipeline_statistics) {
+      cmd->SetPipelineStatistics();
+    }
+    if (is_async) {
+      cmd->SetAsync();
+    }
 
     Result r = token->ConvertToDouble();
     if (!r.IsSuccess()) {
@@ -3561,6 +3636,12 @@ Result Parser::ParseRun() {
     if (is_timed_execution) {
       cmd->SetTimedExecution();
     }
+    if (is_pipeline_statistics) {
+      cmd->SetPipelineStatistics();
+    }
+    if (is_async) {
+      cmd->SetAsync();
+    }
 
     if (indexed) {
       cmd->EnableIndexed();
@@ -3596,6 +3677,34 @@ Result Parser::ParseClear() {
   return ValidateEndOfStatement("CLEAR command");
 }
 
+Result Parser::ParseWait() {
+  size_t line = tokenizer_->GetCurrentLine();
+
+  // A WAIT without a pipeline waits for all of them, like WAIT ALL.
+  Pipeline* pipeline = nullptr;
+  auto token = tokenizer_->PeekNextToken();
+  if (!token->IsEOL() && !token->IsEOS()) {
+    token = tokenizer_->NextToken();
+    if (!token->IsIdentifier()) {
+      return Result("invalid token in WAIT command: " +
+                    token->ToOriginalString());
+    }
+    if (token->AsString() != "ALL") {
+      pipeline = script_->GetPipeline(token->AsString());
+      if (!pipeline) {
+        return Result("unknown pipeline for WAIT command: " +
+                      token->AsString());
+      }
+    }
+  }
+
+  auto cmd = std::make_unique<WaitCommand>(pipeline);
+  cmd->SetLine(line);
+  command_list_.push_back(std::move(cmd));
+
+  return ValidateEndOfStatement("WAIT command");
+}
+
 Result Parser::ParseValues(const std::string& name,
                            Format* fmt,
                            std::vector<Value>* values) {
@@ -4242,6 +4351,7 @@ Result Parser::ParseRepeat() {
 }
 
 Result Parser::ParseDerivePipelineBlock() {
+  size_t line = tokenizer_->GetCurrentLine();
   auto token = tokenizer_->NextToken();
   if (!token->IsIdentifier() || token->AsString() == "FROM") {
     return Result("missing pipeline name for DERIVE_PIPELINE command");
@@ -4274,6 +4384,7 @@ Result Parser::ParseDerivePipelineBlock() {
 
   auto pipeline = parent->Clone();
   pipeline->SetName(name);
+  pipeline->SetLine(line);
 
   return ParsePipelineBody("DERIVE_PIPELINE", std::move(pipeline));
 }
@@ -4323,19 +4434,35 @@ Result Parser::ParseSet() {
     return Result("SET invalid variable to set: " + token->ToOriginalString());
   }
 
-  if (token->AsString() != "fence_timeout_ms") {
-    return Result("SET unknown variable provided: " + token->AsString());
-  }
+  if (token->AsString() == "fence_timeout_ms") {
+    token = tokenizer_->NextToken();
+    if (token->IsEOS() || token->IsEOL()) {
+      return Result("SET missing value for fence_timeout_ms");
+    }
+    if (!token->IsInteger()) {
+      return Result("SET invalid value for fence_timeout_ms, must be uint32");
+    }
 
-  token = tokenizer_->NextToken();
-  if (token->IsEOS() || token->IsEOL()) {
-    return Result("SET missing value for fence_timeout_ms");
-  }
-  if (!token->IsInteger()) {
-    return Result("SET invalid value for fence_timeout_ms, must be uint32");
-  }
+    script_->GetEngineData().fence_timeout_ms = token->AsUint32();
+  } else if (token->AsString() == "buffer_placement") {
+    token = tokenizer_->NextToken();
+    if (token->IsEOS() || token->IsEOL()) {
+      return Result("SET missing value for buffer_placement");
+    }
+    BufferPlacement placement = BufferPlacement::kDefault;
+    if (token->IsIdentifier()) {
+      placement = ToBufferPlacement(token->AsString());
+    }
+    if (placement == BufferPlacement::kDefault) {
+      return Result(
+          "SET invalid value for buffer_placement, must be DEVICE_LOCAL or "
+          "HOST_VISIBLE");
+    }
 
-  script_->GetEngineData().fence_timeout_ms = token->AsUint32();
+    script_->GetEngineData().buffer_placement = placement;
+  } else {
+    return Result("SET unknown variable provided: " + token->AsString());
+  }
 
   return ValidateEndOfStatement("SET command");
 }
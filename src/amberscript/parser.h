@@ -79,6 +79,7 @@ class Parser : public amber::Parser {
   Result ParsePipelineShaderGroup(Pipeline* pipeline);
   Result ParseRun();
   Result ParseClear();
+  Result ParseWait();
   Result ParseClearColor();
   Result ParseClearDepth();
   Result ParseClearStencil();
@@ -1365,5 +1365,44 @@ TEST_F(AmberScriptParserTest, BufferDataFileText) {
             buffers[0]->GetValues<uint8_t>()[0]);
 }
 
+TEST_F(AmberScriptParserTest, BufferPlacement) {
+  std::string in = R"(
+BUFFER default_buf DATA_TYPE uint32 SIZE 4 FILL 0
+BUFFER local_buf PLACEMENT DEVICE_LOCAL DATA_TYPE uint32 SIZE 4 FILL 0
+BUFFER visible_buf PLACEMENT HOST_VISIBLE FORMAT R8G8B8A8_UNORM
+)";
+
+  Parser parser;
+  Result r = parser.Parse(in);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  auto script = parser.GetScript();
+  const auto& buffers = script->GetBuffers();
+  ASSERT_EQ(3U, buffers.size());
+  EXPECT_EQ(BufferPlacement::kDefault, buffers[0]->GetPlacement());
+  EXPECT_EQ(BufferPlacement::kDeviceLocal, buffers[1]->GetPlacement());
+  EXPECT_EQ(4U, buffers[1]->ElementCount());
+  EXPECT_EQ(BufferPlacement::kHostVisible, buffers[2]->GetPlacement());
+}
+
+TEST_F(AmberScriptParserTest, BufferPlacementMissingValue) {
+  std::string in = "BUFFER my_buf PLACEMENT";
+
+  Parser parser;
+  Result r = parser.Parse(in);
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_EQ("1: missing BUFFER PLACEMENT value", r.Error());
+}
+
+TEST_F(AmberScriptParserTest, BufferPlacementInvalidValue) {
+  std::string in =
+      "BUFFER my_buf PLACEMENT VRAM DATA_TYPE uint32 SIZE 4 FILL 0";
+
+  Parser parser;
+  Result r = parser.Parse(in);
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_EQ("1: invalid BUFFER PLACEMENT value: VRAM", r.Error());
+}
+
 }  // namespace amberscript
 }  // namespace amber
@@ -46,6 +46,7 @@ END
   const auto* pipeline = pipelines[0].get();
   EXPECT_EQ("my_pipeline", pipeline->GetName());
   EXPECT_EQ(PipelineType::kGraphics, pipeline->GetType());
+  EXPECT_EQ(7U, pipeline->GetLine());
 
   const auto& shaders = pipeline->GetShaders();
   ASSERT_EQ(2U, shaders.size());
@@ -53,6 +54,8 @@ END
   ASSERT_TRUE(shaders[0].GetShader() != nullptr);
   EXPECT_EQ("my_shader", shaders[0].GetShader()->GetName());
   EXPECT_EQ(kShaderTypeVertex, shaders[0].GetShader()->GetType());
+  EXPECT_EQ(2U, shaders[0].GetShader()->GetLine());
+  EXPECT_EQ(3U, shaders[1].GetShader()->GetLine());
   EXPECT_EQ(static_cast<uint32_t>(0),
             shaders[0].GetShaderOptimizations().size());
 
@@ -364,6 +367,8 @@ END
   auto script = parser.GetScript();
   const auto& pipelines = script->GetPipelines();
   ASSERT_EQ(2U, pipelines.size());
+  EXPECT_EQ(12U, pipelines[0]->GetLine());
+  EXPECT_EQ(18U, pipelines[1]->GetLine());
 
   const auto* pipeline1 = pipelines[0].get();
   auto buffers1 = pipeline1->GetBuffers();
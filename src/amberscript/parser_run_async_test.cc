@@ -0,0 +1,146 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "gtest/gtest.h"
+#include "src/amberscript/parser.h"
+
+namespace amber {
+namespace amberscript {
+
+using AmberScriptParserTest = testing::Test;
+
+TEST_F(AmberScriptParserTest, RunComputeAsync) {
+  std::string in = R"(
+SHADER compute my_shader GLSL
+void main() {
+  gl_FragColor = vec3(2, 3, 4);
+}
+END
+
+PIPELINE compute my_pipeline
+  ATTACH my_shader
+END
+
+RUN ASYNC my_pipeline 2 4 5
+RUN my_pipeline 2 4 5
+)";
+
+  Parser parser;
+  Result r = parser.Parse(in);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  auto script = parser.GetScript();
+  const auto& commands = script->GetCommands();
+  ASSERT_EQ(2U, commands.size());
+
+  ASSERT_TRUE(commands[0]->IsCompute());
+  EXPECT_EQ(2U, commands[0]->AsCompute()->GetX());
+  EXPECT_TRUE(commands[0]->AsCompute()->IsAsync());
+  EXPECT_FALSE(commands[0]->AsCompute()->IsTimedExecution());
+
+  ASSERT_TRUE(commands[1]->IsCompute());
+  EXPECT_FALSE(commands[1]->AsCompute()->IsAsync());
+}
+
+TEST_F(AmberScriptParserTest, RunAsyncWithTimedExecutionInAnyOrder) {
+  std::string in = R"(
+SHADER vertex my_shader PASSTHROUGH
+SHADER fragment my_fragment GLSL
+# GLSL Shader
+END
+BUFFER vtex_buf DATA_TYPE vec3<float> DATA
+1 2 3
+4 5 6
+7 8 9
+END
+
+PIPELINE graphics pipe
+  ATTACH my_shader
+  ATTACH my_fragment
+END
+
+PIPELINE graphics vertex_pipe
+  ATTACH my_shader
+  ATTACH my_fragment
+  VERTEX_DATA vtex_buf LOCATION 0
+END
+
+RUN ASYNC TIMED_EXECUTION pipe DRAW_RECT POS 2 4 SIZE 10 20
+RUN TIMED_EXECUTION ASYNC pipe DRAW_GRID POS 2 4 SIZE 10 20 CELLS 4 5
+RUN ASYNC vertex_pipe DRAW_ARRAY AS TRIANGLE_LIST START_IDX 1 COUNT 2
+)";
+
+  Parser parser;
+  Result r = parser.Parse(in);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  auto script = parser.GetScript();
+  const auto& commands = script->GetCommands();
+  ASSERT_EQ(3U, commands.size());
+
+  ASSERT_TRUE(commands[0]->IsDrawRect());
+  EXPECT_TRUE(commands[0]->AsDrawRect()->IsAsync());
+  EXPECT_TRUE(commands[0]->AsDrawRect()->IsTimedExecution());
+
+  ASSERT_TRUE(commands[1]->IsDrawGrid());
+  EXPECT_TRUE(commands[1]->AsDrawGrid()->IsAsync());
+  EXPECT_TRUE(commands[1]->AsDrawGrid()->IsTimedExecution());
+
+  ASSERT_TRUE(commands[2]->IsDrawArrays());
+  EXPECT_TRUE(commands[2]->AsDrawArrays()->IsAsync());
+  EXPECT_FALSE(commands[2]->AsDrawArrays()->IsTimedExecution());
+}
+
+TEST_F(AmberScriptParserTest, RunAsyncWithStatistics) {
+  std::string in = R"(
+SHADER compute my_shader GLSL
+void main() {}
+END
+
+PIPELINE compute my_pipeline
+  ATTACH my_shader
+END
+
+RUN ASYNC STATISTICS my_pipeline 2 4 5
+)";
+
+  Parser parser;
+  Result r = parser.Parse(in);
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_EQ("10: STATISTICS can not be used with an ASYNC RUN command",
+            r.Error());
+}
+
+TEST_F(AmberScriptParserTest, RunAsyncTwice) {
+  std::string in = R"(
+SHADER compute my_shader GLSL
+void main() {}
+END
+
+PIPELINE compute my_pipeline
+  ATTACH my_shader
+END
+
+RUN ASYNC ASYNC my_pipeline 2 4 5
+)";
+
+  Parser parser;
+  Result r = parser.Parse(in);
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_EQ("10: unknown pipeline for RUN command: ASYNC", r.Error());
+}
+
+}  // namespace amberscript
+}  // namespace amber
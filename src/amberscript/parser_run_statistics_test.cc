@@ -0,0 +1,167 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gtest/gtest.h"
+#include "src/amberscript/parser.h"
+
+namespace amber {
+namespace amberscript {
+
+using AmberScriptParserTest = testing::Test;
+
+TEST_F(AmberScriptParserTest, RunComputeStatistics) {
+  std::string in = R"(
+SHADER compute my_shader GLSL
+void main() {
+  gl_FragColor = vec3(2, 3, 4);
+}
+END
+
+PIPELINE compute my_pipeline
+  ATTACH my_shader
+END
+
+RUN STATISTICS my_pipeline 2 4 5
+)";
+
+  Parser parser;
+  Result r = parser.Parse(in);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  auto script = parser.GetScript();
+  const auto& commands = script->GetCommands();
+  ASSERT_EQ(1U, commands.size());
+
+  auto* cmd = commands[0].get();
+  ASSERT_TRUE(cmd->IsCompute());
+  EXPECT_EQ(2U, cmd->AsCompute()->GetX());
+  EXPECT_TRUE(cmd->AsCompute()->IsPipelineStatistics());
+  EXPECT_FALSE(cmd->AsCompute()->IsTimedExecution());
+}
+
+TEST_F(AmberScriptParserTest, RunComputeNoStatistics) {
+  std::string in = R"(
+SHADER compute my_shader GLSL
+void main() {
+  gl_FragColor = vec3(2, 3, 4);
+}
+END
+
+PIPELINE compute my_pipeline
+  ATTACH my_shader
+END
+
+RUN TIMED_EXECUTION my_pipeline 2 4 5
+)";
+
+  Parser parser;
+  Result r = parser.Parse(in);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  auto script = parser.GetScript();
+  const auto& commands = script->GetCommands();
+  ASSERT_EQ(1U, commands.size());
+
+  auto* cmd = commands[0].get();
+  ASSERT_TRUE(cmd->IsCompute());
+  EXPECT_FALSE(cmd->AsCompute()->IsPipelineStatistics());
+}
+
+TEST_F(AmberScriptParserTest, RunStatisticsWithTimedExecutionInAnyOrder) {
+  std::string in = R"(
+SHADER vertex my_shader PASSTHROUGH
+SHADER fragment my_fragment GLSL
+# GLSL Shader
+END
+
+PIPELINE graphics pipe
+  ATTACH my_shader
+  ATTACH my_fragment
+END
+
+RUN STATISTICS TIMED_EXECUTION pipe DRAW_RECT POS 2 4 SIZE 10 20
+RUN TIMED_EXECUTION STATISTICS pipe DRAW_GRID POS 2 4 SIZE 10 20 CELLS 4 5
+)";
+
+  Parser parser;
+  Result r = parser.Parse(in);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  auto script = parser.GetScript();
+  const auto& commands = script->GetCommands();
+  ASSERT_EQ(2U, commands.size());
+
+  ASSERT_TRUE(commands[0]->IsDrawRect());
+  EXPECT_TRUE(commands[0]->AsDrawRect()->IsPipelineStatistics());
+  EXPECT_TRUE(commands[0]->AsDrawRect()->IsTimedExecution());
+
+  ASSERT_TRUE(commands[1]->IsDrawGrid());
+  EXPECT_TRUE(commands[1]->AsDrawGrid()->IsPipelineStatistics());
+  EXPECT_TRUE(commands[1]->AsDrawGrid()->IsTimedExecution());
+}
+
+TEST_F(AmberScriptParserTest, RunDrawArraysStatistics) {
+  std::string in = R"(
+SHADER vertex my_shader PASSTHROUGH
+SHADER fragment my_fragment GLSL
+# GLSL Shader
+END
+BUFFER vtex_buf DATA_TYPE vec3<float> DATA
+1 2 3
+4 5 6
+7 8 9
+END
+
+PIPELINE graphics my_pipeline
+  ATTACH my_shader
+  ATTACH my_fragment
+  VERTEX_DATA vtex_buf LOCATION 0
+END
+
+RUN STATISTICS my_pipeline DRAW_ARRAY AS TRIANGLE_LIST START_IDX 1 COUNT 2)";
+
+  Parser parser;
+  Result r = parser.Parse(in);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  auto script = parser.GetScript();
+  const auto& commands = script->GetCommands();
+  ASSERT_EQ(1U, commands.size());
+
+  auto* cmd = commands[0].get();
+  ASSERT_TRUE(cmd->IsDrawArrays());
+  EXPECT_TRUE(cmd->AsDrawArrays()->IsPipelineStatistics());
+}
+
+TEST_F(AmberScriptParserTest, RunStatisticsTwice) {
+  std::string in = R"(
+SHADER compute my_shader GLSL
+void main() {}
+END
+
+PIPELINE compute my_pipeline
+  ATTACH my_shader
+END
+
+RUN STATISTICS STATISTICS my_pipeline 2 4 5
+)";
+
+  Parser parser;
+  Result r = parser.Parse(in);
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_EQ("10: unknown pipeline for RUN command: STATISTICS", r.Error());
+}
+
+}  // namespace amberscript
+}  // namespace amber
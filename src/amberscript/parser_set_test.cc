@@ -97,5 +97,48 @@ TEST_F(AmberScriptParserTest, SetFenceTimeoutExtraParams) {
   EXPECT_EQ("1: extra parameters after SET command: EXTRA", r.Error());
 }
 
+TEST_F(AmberScriptParserTest, SetBufferPlacement) {
+  std::string in = "SET ENGINE_DATA buffer_placement DEVICE_LOCAL";
+
+  Parser parser;
+  Result r = parser.Parse(in);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  auto script = parser.GetScript();
+  EXPECT_EQ(BufferPlacement::kDeviceLocal,
+            script->GetEngineData().buffer_placement);
+}
+
+TEST_F(AmberScriptParserTest, SetBufferPlacementDefaultsToHostVisible) {
+  Parser parser;
+  Result r = parser.Parse("SET ENGINE_DATA fence_timeout_ms 125");
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  auto script = parser.GetScript();
+  EXPECT_EQ(BufferPlacement::kHostVisible,
+            script->GetEngineData().buffer_placement);
+}
+
+TEST_F(AmberScriptParserTest, SetBufferPlacementMissingValue) {
+  std::string in = "SET ENGINE_DATA buffer_placement";
+
+  Parser parser;
+  Result r = parser.Parse(in);
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_EQ("1: SET missing value for buffer_placement", r.Error());
+}
+
+TEST_F(AmberScriptParserTest, SetBufferPlacementInvalidValue) {
+  std::string in = "SET ENGINE_DATA buffer_placement 3";
+
+  Parser parser;
+  Result r = parser.Parse(in);
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_EQ(
+      "1: SET invalid value for buffer_placement, must be DEVICE_LOCAL or "
+      "HOST_VISIBLE",
+      r.Error());
+}
+
 }  // namespace amberscript
 }  // namespace amber
@@ -0,0 +1,132 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "gtest/gtest.h"
+#include "src/amberscript/parser.h"
+
+namespace amber {
+namespace amberscript {
+
+using AmberScriptParserTest = testing::Test;
+
+TEST_F(AmberScriptParserTest, Wait) {
+  std::string in = R"(
+SHADER compute my_shader GLSL
+void main() {}
+END
+
+PIPELINE compute my_pipeline
+  ATTACH my_shader
+END
+
+RUN ASYNC my_pipeline 2 4 5
+WAIT my_pipeline
+WAIT ALL
+WAIT
+)";
+
+  Parser parser;
+  Result r = parser.Parse(in);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  auto script = parser.GetScript();
+  const auto& commands = script->GetCommands();
+  ASSERT_EQ(4U, commands.size());
+
+  ASSERT_TRUE(commands[1]->IsWait());
+  EXPECT_EQ(script->GetPipeline("my_pipeline"),
+            commands[1]->AsWait()->GetPipeline());
+  EXPECT_EQ(11U, commands[1]->GetLine());
+
+  ASSERT_TRUE(commands[2]->IsWait());
+  EXPECT_EQ(nullptr, commands[2]->AsWait()->GetPipeline());
+
+  ASSERT_TRUE(commands[3]->IsWait());
+  EXPECT_EQ(nullptr, commands[3]->AsWait()->GetPipeline());
+}
+
+TEST_F(AmberScriptParserTest, WaitInRepeat) {
+  std::string in = R"(
+SHADER compute my_shader GLSL
+void main() {}
+END
+
+PIPELINE compute my_pipeline
+  ATTACH my_shader
+END
+
+REPEAT 4
+  RUN ASYNC my_pipeline 2 4 5
+  WAIT my_pipeline
+END
+)";
+
+  Parser parser;
+  Result r = parser.Parse(in);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  auto script = parser.GetScript();
+  const auto& commands = script->GetCommands();
+  ASSERT_EQ(1U, commands.size());
+  ASSERT_TRUE(commands[0]->IsRepeat());
+
+  const auto& body = commands[0]->AsRepeat()->GetCommands();
+  ASSERT_EQ(2U, body.size());
+  EXPECT_TRUE(body[1]->IsWait());
+}
+
+TEST_F(AmberScriptParserTest, WaitWithUnknownPipeline) {
+  std::string in = R"(
+WAIT my_pipeline
+)";
+
+  Parser parser;
+  Result r = parser.Parse(in);
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_EQ("2: unknown pipeline for WAIT command: my_pipeline", r.Error());
+}
+
+TEST_F(AmberScriptParserTest, WaitWithInvalidToken) {
+  std::string in = R"(
+WAIT 1
+)";
+
+  Parser parser;
+  Result r = parser.Parse(in);
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_EQ("2: invalid token in WAIT command: 1", r.Error());
+}
+
+TEST_F(AmberScriptParserTest, WaitWithExtraParams) {
+  std::string in = R"(
+SHADER compute my_shader GLSL
+void main() {}
+END
+
+PIPELINE compute my_pipeline
+  ATTACH my_shader
+END
+
+WAIT my_pipeline ALL
+)";
+
+  Parser parser;
+  Result r = parser.Parse(in);
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_EQ("10: extra parameters after WAIT command: ALL", r.Error());
+}
+
+}  // namespace amberscript
+}  // namespace amber
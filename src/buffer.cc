@@ -86,7 +86,7 @@ Buffer::Buffer() = default;
 
 Buffer::~Buffer() = default;
 
-Result Buffer::CopyTo(Buffer* buffer) const {
+Result Buffer::CanCopyTo(const Buffer* buffer) const {
   if (buffer->width_ != width_) {
     return Result("Buffer::CopyBaseFields() buffers have a different width");
   }
@@ -96,7 +96,16 @@ Result Buffer::CopyTo(Buffer* buffer) const {
   if (buffer->element_count_ != element_count_) {
     return Result("Buffer::CopyBaseFields() buffers have a different size");
   }
+  return {};
+}
+
+Result Buffer::CopyTo(Buffer* buffer) const {
+  Result r = CanCopyTo(buffer);
+  if (!r.IsSuccess()) {
+    return r;
+  }
   buffer->bytes_ = bytes_;
+  ++buffer->generation_;
   return {};
 }
 
@@ -312,6 +321,8 @@ Result Buffer::RecalculateMaxSizeInBytes(const std::vector<Value>& data,
 
 Result Buffer::SetDataWithOffset(const std::vector<Value>& data,
                                  uint32_t offset) {
+  ++generation_;
+
   // Multiply by the input needed because the value count will use the needed
   // input as the multiplier
   uint32_t value_count =
@@ -420,12 +431,14 @@ uint32_t Buffer::WriteValueFromComponent(const Value& value,
 void Buffer::SetSizeInElements(uint32_t element_count) {
   element_count_ = element_count;
   bytes_.resize(element_count * format_->SizeInBytes());
+  ++generation_;
 }
 
 void Buffer::SetSizeInBytes(uint32_t size_in_bytes) {
   assert(size_in_bytes % format_->SizeInBytes() == 0);
   element_count_ = size_in_bytes / format_->SizeInBytes();
   bytes_.resize(size_in_bytes);
+  ++generation_;
 }
 
 void Buffer::SetMaxSizeInBytes(uint32_t max_size_in_bytes) {
@@ -446,6 +459,7 @@ Result Buffer::SetDataFromBuffer(const Buffer* src, uint32_t offset) {
   }
 
   std::memcpy(bytes_.data() + offset, src->bytes_.data(), src->bytes_.size());
+  ++generation_;
   element_count_ =
       static_cast<uint32_t>(bytes_.size()) / format_->SizeInBytes();
   return {};
@@ -72,6 +72,19 @@ enum class InputRate : int8_t {
   kInstance,
 };
 
+/// Where the engine keeps the device copy of a buffer bound to a buffer
+/// descriptor.
+enum class BufferPlacement : int8_t {
+  /// Uses the placement of the engine, see EngineData::buffer_placement.
+  kDefault = 0,
+  /// Memory the host can map, which the device may have to read over the
+  /// bus.
+  kHostVisible,
+  /// Memory local to the device. The contents go through a host visible
+  /// staging buffer unless that memory can be mapped as well.
+  kDeviceLocal,
+};
+
 /// A buffer stores data. The buffer maybe provided from the input script, or
 /// maybe created as needed. A buffer must have a unique name.
 class Buffer {
@@ -169,10 +182,10 @@ class Buffer {
   }
 
   /// Returns the number of bytes for one element in the buffer.
-  uint32_t GetElementStride() { return format_->SizeInBytes(); }
+  uint32_t GetElementStride() const { return format_->SizeInBytes(); }
 
   /// Returns the number of bytes for one row of elements in the buffer.
-  uint32_t GetRowStride() { return GetElementStride() * GetWidth(); }
+  uint32_t GetRowStride() const { return GetElementStride() * GetWidth(); }
 
   /// Sets the data into the buffer.
   Result SetData(const std::vector<Value>& data);
@@ -221,17 +234,34 @@ class Buffer {
   /// Returns the number of samples.
   uint32_t GetSamples() const { return samples_; }
 
-  /// Returns a pointer to the internal storage of the buffer.
-  std::vector<uint8_t>* ValuePtr() { return &bytes_; }
+  /// Sets where the engine keeps the device copy of the buffer.
+  void SetPlacement(BufferPlacement placement) { placement_ = placement; }
+  /// Returns where the engine keeps the device copy of the buffer.
+  BufferPlacement GetPlacement() const { return placement_; }
+
+  /// Returns a pointer to the internal storage of the buffer. The caller may
+  /// write through it, so this counts as a change of the contents.
+  std::vector<uint8_t>* ValuePtr() {
+    ++generation_;
+    return &bytes_;
+  }
   /// Returns a pointer to the internal storage of the buffer.
   const std::vector<uint8_t>* ValuePtr() const { return &bytes_; }
 
+  /// Returns a number which changes whenever the contents of the buffer may
+  /// have changed. A copy of the buffer made at the same generation still
+  /// holds its contents.
+  uint64_t GetGeneration() const { return generation_; }
+
   /// Returns a casted pointer to the internal storage of the buffer.
   template <typename T>
   const T* GetValues() const {
     return reinterpret_cast<const T*>(bytes_.data());
   }
 
+  /// Succeeds if the buffer values can be copied to |buffer|.
+  Result CanCopyTo(const Buffer* buffer) const;
+
   /// Copies the buffer values to an other one
   Result CopyTo(Buffer* buffer) const;
 
@@ -273,8 +303,10 @@ class Buffer {
   uint32_t depth_ = 1;
   uint32_t mip_levels_ = 1;
   uint32_t samples_ = 1;
+  BufferPlacement placement_ = BufferPlacement::kDefault;
   bool format_is_default_ = false;
   std::vector<uint8_t> bytes_;
+  uint64_t generation_ = 0;
   Format* format_ = nullptr;
   Sampler* sampler_ = nullptr;
   ImageDimension image_dim_ = ImageDimension::kUnknown;
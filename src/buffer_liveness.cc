@@ -0,0 +1,201 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/buffer_liveness.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "src/descriptor_set_and_binding_parser.h"
+
+namespace amber {
+namespace {
+
+void AddUnique(Buffer* buffer, std::vector<Buffer*>* buffers) {
+  if (buffer &&
+      std::find(buffers->begin(), buffers->end(), buffer) == buffers->end()) {
+    buffers->push_back(buffer);
+  }
+}
+
+bool IsBufferDescriptor(BufferType type) {
+  return type == BufferType::kStorage || type == BufferType::kStorageDynamic ||
+         type == BufferType::kUniform || type == BufferType::kUniformDynamic ||
+         type == BufferType::kUniformTexelBuffer ||
+         type == BufferType::kStorageTexelBuffer;
+}
+
+/// Returns every buffer |pipeline| references. Buffers bound to buffer
+/// descriptors are left out unless |include_buffer_descriptors| is true.
+std::vector<Buffer*> GetPipelineBuffers(const Pipeline* pipeline,
+                                        bool include_buffer_descriptors) {
+  std::vector<Buffer*> buffers;
+  for (const auto& info : pipeline->GetBuffers()) {
+    if (include_buffer_descriptors || !IsBufferDescriptor(info.type)) {
+      AddUnique(info.buffer, &buffers);
+    }
+  }
+  AddUnique(pipeline->GetPushConstantBuffer().buffer, &buffers);
+
+  // Every pipeline gets a color attachment, but only graphics pipelines use
+  // them.
+  if (!pipeline->IsGraphics()) {
+    return buffers;
+  }
+  for (const auto& info : pipeline->GetColorAttachments()) {
+    AddUnique(info.buffer, &buffers);
+  }
+  for (const auto& info : pipeline->GetResolveTargets()) {
+    AddUnique(info.buffer, &buffers);
+  }
+  for (const auto& info : pipeline->GetVertexBuffers()) {
+    AddUnique(info.buffer, &buffers);
+  }
+  AddUnique(pipeline->GetDepthStencilBuffer().buffer, &buffers);
+  AddUnique(pipeline->GetIndexBuffer(), &buffers);
+  return buffers;
+}
+
+Buffer* FindExtractedBuffer(const Script* script, const BufferInfo& info) {
+  if (info.is_image_buffer) {
+    return script->GetBuffer(info.buffer_name);
+  }
+
+  DescriptorSetAndBindingParser p;
+  if (!p.Parse(info.buffer_name).IsSuccess() ||
+      script->GetPipelines().empty()) {
+    return nullptr;
+  }
+
+  const Pipeline* pipeline = p.HasPipelineName()
+                                 ? script->GetPipeline(p.PipelineName())
+                                 : script->GetPipelines()[0].get();
+  if (!pipeline) {
+    return nullptr;
+  }
+  return pipeline->GetBufferForBinding(p.GetDescriptorSet(), p.GetBinding());
+}
+
+}  // namespace
+
+BufferLiveness::BufferLiveness() = default;
+
+BufferLiveness::~BufferLiveness() = default;
+
+void BufferLiveness::Analyze(const Script* script,
+                             const std::vector<BufferInfo>& extractions) {
+  pipeline_buffers_.clear();
+  all_pipeline_buffers_.clear();
+  pipeline_observations_.clear();
+  observed_.clear();
+  observed_at_exit_.clear();
+
+  AnalyzePipelines(script);
+  for (const auto& cmd : script->GetCommands()) {
+    AnalyzeCommand(cmd.get());
+  }
+
+  // Extractions are done even when a command fails, so they are treated as
+  // observed after whichever command ran last.
+  for (const auto& info : extractions) {
+    AddUnique(FindExtractedBuffer(script, info), &observed_at_exit_);
+  }
+}
+
+const std::vector<Buffer*>& BufferLiveness::GetObservedBuffers(
+    const Command* cmd) const {
+  auto it = observed_.find(cmd);
+  return it == observed_.end() ? no_buffers_ : it->second;
+}
+
+void BufferLiveness::AnalyzePipelines(const Script* script) {
+  std::unordered_map<const Buffer*, const Pipeline*> first_users;
+  std::unordered_set<const Buffer*> shared;
+  std::unordered_set<const Buffer*> per_pipeline;
+  for (const auto& pipeline : script->GetPipelines()) {
+    std::vector<Buffer*>& buffers = pipeline_buffers_[pipeline.get()];
+    buffers = GetPipelineBuffers(pipeline.get(), true);
+    for (Buffer* buffer : buffers) {
+      auto it = first_users.emplace(buffer, pipeline.get()).first;
+      if (it->second != pipeline.get()) {
+        shared.insert(buffer);
+      }
+      AddUnique(buffer, &all_pipeline_buffers_);
+    }
+    for (Buffer* buffer : GetPipelineBuffers(pipeline.get(), false)) {
+      per_pipeline.insert(buffer);
+    }
+  }
+
+  // Vertex, index and push constant data is read from the host whenever the
+  // pipeline runs. A buffer shared with another pipeline may have been
+  // written by it since this pipeline last ran, unless both only bind it to
+  // buffer descriptors: the engine then keeps a single device copy of it.
+  for (const auto& pipeline : script->GetPipelines()) {
+    std::vector<Buffer*>& observed = pipeline_observations_[pipeline.get()];
+    for (const auto& info : pipeline->GetVertexBuffers()) {
+      AddUnique(info.buffer, &observed);
+    }
+    AddUnique(pipeline->GetIndexBuffer(), &observed);
+    AddUnique(pipeline->GetPushConstantBuffer().buffer, &observed);
+    for (Buffer* buffer : GetPipelineBuffers(pipeline.get(), true)) {
+      if (shared.count(buffer) > 0 && per_pipeline.count(buffer) > 0) {
+        AddUnique(buffer, &observed);
+      }
+    }
+  }
+}
+
+void BufferLiveness::AnalyzeCommand(Command* cmd) {
+  if (cmd->IsProbe()) {
+    AddObservation(cmd, cmd->AsProbe()->GetBuffer());
+  } else if (cmd->IsProbeSSBO()) {
+    AddObservation(cmd, cmd->AsProbeSSBO()->GetBuffer());
+  } else if (cmd->IsCompareBuffer()) {
+    AddObservation(cmd, cmd->AsCompareBuffer()->GetBuffer1());
+    AddObservation(cmd, cmd->AsCompareBuffer()->GetBuffer2());
+  } else if (cmd->IsBuffer()) {
+    AddObservation(cmd, cmd->AsBuffer()->GetBuffer());
+  } else if (cmd->IsWait()) {
+    const Pipeline* pipeline = cmd->AsWait()->GetPipeline();
+    auto it = pipeline_buffers_.find(pipeline);
+    const std::vector<Buffer*>& buffers =
+        it != pipeline_buffers_.end() ? it->second : all_pipeline_buffers_;
+    for (Buffer* buffer : buffers) {
+      AddObservation(cmd, buffer);
+    }
+  } else if (cmd->IsRepeat()) {
+    for (const auto& sub_cmd : cmd->AsRepeat()->GetCommands()) {
+      AnalyzeCommand(sub_cmd.get());
+    }
+  } else if (cmd->IsClear() || cmd->IsDrawRect() || cmd->IsDrawGrid() ||
+             cmd->IsDrawArrays() || cmd->IsCompute() || cmd->IsRayTracing()) {
+    const Pipeline* pipeline =
+        static_cast<PipelineCommand*>(cmd)->GetPipeline();
+    auto it = pipeline_observations_.find(pipeline);
+    if (it != pipeline_observations_.end()) {
+      for (Buffer* buffer : it->second) {
+        AddObservation(cmd, buffer);
+      }
+    }
+  }
+}
+
+void BufferLiveness::AddObservation(const Command* cmd, Buffer* buffer) {
+  if (buffer) {
+    AddUnique(buffer, &observed_[cmd]);
+  }
+}
+
+}  // namespace amber
@@ -0,0 +1,77 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_BUFFER_LIVENESS_H_
+#define SRC_BUFFER_LIVENESS_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include "amber/amber.h"
+#include "src/buffer.h"
+#include "src/command.h"
+#include "src/script.h"
+
+namespace amber {
+
+/// Works out where the host looks at the contents of the buffers of a
+/// script. A buffer is observed by EXPECT and COMPARE commands, by BUFFER
+/// commands changing it, by WAIT commands for a pipeline using it, by the
+/// extractions done after the script ran, and by commands of a pipeline
+/// which reads it from the host while another pipeline may have written it.
+/// COPY commands are left to the engine, which may copy the buffers without
+/// involving the host.
+///
+/// An engine only has to copy a buffer written on the device back to the
+/// host before the next command observing it, so buffers which are never
+/// observed are not copied back at all.
+class BufferLiveness {
+ public:
+  BufferLiveness();
+  ~BufferLiveness();
+
+  /// Walks the commands of |script|, including the bodies of REPEAT
+  /// commands. |extractions| are the buffers read once the script finished.
+  void Analyze(const Script* script,
+               const std::vector<BufferInfo>& extractions);
+
+  /// Returns the buffers |cmd| observes, which must hold their latest
+  /// contents on the host before |cmd| runs.
+  const std::vector<Buffer*>& GetObservedBuffers(const Command* cmd) const;
+
+  /// Returns the buffers observed after the last command.
+  const std::vector<Buffer*>& GetBuffersObservedAtExit() const {
+    return observed_at_exit_;
+  }
+
+ private:
+  void AnalyzePipelines(const Script* script);
+  void AnalyzeCommand(Command* cmd);
+  void AddObservation(const Command* cmd, Buffer* buffer);
+
+  /// Buffers each pipeline uses, which a WAIT for it observes.
+  std::unordered_map<const Pipeline*, std::vector<Buffer*>> pipeline_buffers_;
+  /// Buffers any pipeline uses, which a WAIT for all of them observes.
+  std::vector<Buffer*> all_pipeline_buffers_;
+  /// Buffers each pipeline reads from the host whenever it runs.
+  std::unordered_map<const Pipeline*, std::vector<Buffer*>>
+      pipeline_observations_;
+  std::unordered_map<const Command*, std::vector<Buffer*>> observed_;
+  std::vector<Buffer*> observed_at_exit_;
+  std::vector<Buffer*> no_buffers_;
+};
+
+}  // namespace amber
+
+#endif  // SRC_BUFFER_LIVENESS_H_
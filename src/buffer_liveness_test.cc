@@ -0,0 +1,198 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/buffer_liveness.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "src/amberscript/parser.h"
+
+namespace amber {
+namespace {
+
+const char kPipelines[] = R"(
+SHADER compute cs GLSL
+#version 430
+void main() {}
+END
+BUFFER a DATA_TYPE uint32 SIZE 4 FILL 0
+BUFFER b DATA_TYPE uint32 SIZE 4 FILL 0
+BUFFER shared DATA_TYPE uint32 SIZE 4 FILL 0
+BUFFER pc DATA_TYPE uint32 SIZE 1 FILL 0
+PIPELINE compute p1
+  ATTACH cs
+  BIND BUFFER a AS storage DESCRIPTOR_SET 0 BINDING 0
+  BIND BUFFER shared AS storage DESCRIPTOR_SET 0 BINDING 1
+  BIND BUFFER pc AS push_constant
+END
+PIPELINE compute p2
+  ATTACH cs
+  BIND BUFFER b AS storage DESCRIPTOR_SET 0 BINDING 0
+  BIND BUFFER shared AS storage DESCRIPTOR_SET 0 BINDING 1
+END
+PIPELINE compute p3
+  ATTACH cs
+  BIND BUFFER b AS push_constant
+END
+)";
+
+std::unique_ptr<Script> Parse(const std::string& commands) {
+  amberscript::Parser parser;
+  Result r = parser.Parse(std::string(kPipelines) + commands);
+  EXPECT_TRUE(r.IsSuccess()) << r.Error();
+  return parser.GetScript();
+}
+
+}  // namespace
+
+using BufferLivenessTest = testing::Test;
+
+TEST_F(BufferLivenessTest, HostCommandsObserveTheirBuffers) {
+  auto script = Parse(R"(
+RUN p1 1 1 1
+EXPECT a IDX 0 EQ 0
+COPY a TO b
+EXPECT a EQ_BUFFER b
+)");
+  BufferLiveness liveness;
+  liveness.Analyze(script.get(), {});
+
+  Buffer* a = script->GetBuffer("a");
+  Buffer* b = script->GetBuffer("b");
+  const auto& commands = script->GetCommands();
+  ASSERT_EQ(4U, commands.size());
+  EXPECT_EQ(std::vector<Buffer*>({a}),
+            liveness.GetObservedBuffers(commands[1].get()));
+  EXPECT_TRUE(liveness.GetObservedBuffers(commands[2].get()).empty());
+  EXPECT_EQ(std::vector<Buffer*>({a, b}),
+            liveness.GetObservedBuffers(commands[3].get()));
+  EXPECT_TRUE(liveness.GetBuffersObservedAtExit().empty());
+}
+
+TEST_F(BufferLivenessTest, ProbeSSBOObservesItsBuffer) {
+  auto script = Parse(R"(
+RUN p2 1 1 1
+EXPECT shared IDX 0 EQ 0
+)");
+  BufferLiveness liveness;
+  liveness.Analyze(script.get(), {});
+
+  // The dispatch leaves |shared| on the device until the probe reads it.
+  const auto& commands = script->GetCommands();
+  ASSERT_EQ(2U, commands.size());
+  ASSERT_TRUE(commands[1]->IsProbeSSBO());
+  EXPECT_EQ(std::vector<Buffer*>({script->GetBuffer("shared")}),
+            liveness.GetObservedBuffers(commands[1].get()));
+}
+
+TEST_F(BufferLivenessTest, PipelinesObservePushConstantBuffers) {
+  auto script = Parse(R"(
+RUN p1 1 1 1
+RUN p3 1 1 1
+)");
+  BufferLiveness liveness;
+  liveness.Analyze(script.get(), {});
+
+  const auto& commands = script->GetCommands();
+  ASSERT_EQ(2U, commands.size());
+  EXPECT_EQ(std::vector<Buffer*>({script->GetBuffer("pc")}),
+            liveness.GetObservedBuffers(commands[0].get()));
+  EXPECT_EQ(std::vector<Buffer*>({script->GetBuffer("b")}),
+            liveness.GetObservedBuffers(commands[1].get()));
+}
+
+TEST_F(BufferLivenessTest, PipelinesObserveBuffersSharedOutsideDescriptors) {
+  auto script = Parse(R"(
+RUN p1 1 1 1
+RUN p2 1 1 1
+)");
+  BufferLiveness liveness;
+  liveness.Analyze(script.get(), {});
+
+  // |shared| is bound to storage buffers only, so p1 and p2 use the same
+  // device copy of it. p3 reads |b| from the host as push constants.
+  const auto& commands = script->GetCommands();
+  ASSERT_EQ(2U, commands.size());
+  EXPECT_EQ(std::vector<Buffer*>({script->GetBuffer("pc")}),
+            liveness.GetObservedBuffers(commands[0].get()));
+  EXPECT_EQ(std::vector<Buffer*>({script->GetBuffer("b")}),
+            liveness.GetObservedBuffers(commands[1].get()));
+}
+
+TEST_F(BufferLivenessTest, AnalyzesRepeatBodies) {
+  auto script = Parse(R"(
+REPEAT 4
+  RUN p2 1 1 1
+  EXPECT b IDX 0 EQ 0
+END
+)");
+  BufferLiveness liveness;
+  liveness.Analyze(script.get(), {});
+
+  const auto& commands = script->GetCommands();
+  ASSERT_EQ(1U, commands.size());
+  ASSERT_TRUE(commands[0]->IsRepeat());
+  EXPECT_TRUE(liveness.GetObservedBuffers(commands[0].get()).empty());
+
+  const auto& body = commands[0]->AsRepeat()->GetCommands();
+  ASSERT_EQ(2U, body.size());
+  EXPECT_EQ(std::vector<Buffer*>({script->GetBuffer("b")}),
+            liveness.GetObservedBuffers(body[1].get()));
+}
+
+TEST_F(BufferLivenessTest, WaitObservesBuffersOfItsPipelines) {
+  auto script = Parse(R"(
+RUN ASYNC p1 1 1 1
+RUN ASYNC p2 1 1 1
+WAIT p2
+WAIT ALL
+)");
+  BufferLiveness liveness;
+  liveness.Analyze(script.get(), {});
+
+  Buffer* a = script->GetBuffer("a");
+  Buffer* b = script->GetBuffer("b");
+  Buffer* shared = script->GetBuffer("shared");
+  Buffer* pc = script->GetBuffer("pc");
+  const auto& commands = script->GetCommands();
+  ASSERT_EQ(4U, commands.size());
+  EXPECT_EQ(std::vector<Buffer*>({b, shared}),
+            liveness.GetObservedBuffers(commands[2].get()));
+  EXPECT_EQ(std::vector<Buffer*>({a, shared, pc, b}),
+            liveness.GetObservedBuffers(commands[3].get()));
+}
+
+TEST_F(BufferLivenessTest, ExtractionsAreObservedAtExit) {
+  auto script = Parse("RUN p2 1 1 1\n");
+
+  std::vector<BufferInfo> extractions(4);
+  extractions[0].buffer_name = "0:0";
+  extractions[1].buffer_name = "p2:0:0";
+  extractions[2].is_image_buffer = true;
+  extractions[2].buffer_name = "shared";
+  extractions[3].buffer_name = "missing:0:0";
+
+  BufferLiveness liveness;
+  liveness.Analyze(script.get(), extractions);
+
+  EXPECT_EQ(std::vector<Buffer*>({script->GetBuffer("a"),
+                                  script->GetBuffer("b"),
+                                  script->GetBuffer("shared")}),
+            liveness.GetBuffersObservedAtExit());
+}
+
+}  // namespace amber
@@ -80,6 +80,41 @@ TEST_F(BufferTest, SizeFromDataDoesNotOverrideSize) {
   EXPECT_EQ(20u * sizeof(float), b.GetSizeInBytes());
 }
 
+TEST_F(BufferTest, GenerationChangesWithContents) {
+  TypeParser parser;
+  auto type = parser.Parse("R32_SFLOAT");
+  Format fmt(type.get());
+
+  Buffer b;
+  b.SetFormat(&fmt);
+  uint64_t generation = b.GetGeneration();
+
+  b.SetData(std::vector<Value>(4));
+  EXPECT_NE(generation, b.GetGeneration());
+  generation = b.GetGeneration();
+
+  // Reading the contents does not change them.
+  const Buffer& const_b = b;
+  EXPECT_EQ(4u * sizeof(float), const_b.ValuePtr()->size());
+  EXPECT_EQ(4u * sizeof(float), b.GetSizeInBytes());
+  EXPECT_EQ(generation, b.GetGeneration());
+
+  b.ValuePtr()->data()[0] = 1;
+  EXPECT_NE(generation, b.GetGeneration());
+  generation = b.GetGeneration();
+
+  Buffer other;
+  other.SetFormat(&fmt);
+  other.SetData(std::vector<Value>(4));
+  const uint64_t other_generation = other.GetGeneration();
+  ASSERT_TRUE(b.CopyTo(&other).IsSuccess());
+  EXPECT_NE(other_generation, other.GetGeneration());
+  EXPECT_EQ(generation, b.GetGeneration());
+
+  b.SetDataFromBuffer(&other, 0);
+  EXPECT_NE(generation, b.GetGeneration());
+}
+
 TEST_F(BufferTest, SizeMatrixStd430) {
   TypeParser parser;
   auto type = parser.Parse("R16G16_SINT");
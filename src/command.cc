@@ -91,6 +91,10 @@ RepeatCommand* Command::AsRepeat() {
   return static_cast<RepeatCommand*>(this);
 }
 
+WaitCommand* Command::AsWait() {
+  return static_cast<WaitCommand*>(this);
+}
+
 PipelineCommand::PipelineCommand(Type type, Pipeline* pipeline)
     : Command(type), pipeline_(pipeline) {}
 
@@ -189,6 +193,11 @@ RepeatCommand::RepeatCommand(uint32_t count)
 
 RepeatCommand::~RepeatCommand() = default;
 
+WaitCommand::WaitCommand(Pipeline* pipeline)
+    : Command(Type::kWait), pipeline_(pipeline) {}
+
+WaitCommand::~WaitCommand() = default;
+
 TLASCommand::TLASCommand(Pipeline* pipeline)
     : BindableResourceCommand(Type::kTLAS, pipeline) {}
 
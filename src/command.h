@@ -51,6 +51,7 @@ class ProbeSSBOCommand;
 class RayTracingCommand;
 class RepeatCommand;
 class TLASCommand;
+class WaitCommand;
 
 /// Base class for all commands.
 class Command {
@@ -75,7 +76,8 @@ class Command {
     kRepeat,
     kSampler,
     kTLAS,
-    kRayTracing
+    kRayTracing,
+    kWait
   };
 
   virtual ~Command();
@@ -102,6 +104,7 @@ class Command {
   }
   bool IsEntryPoint() const { return command_type_ == Type::kEntryPoint; }
   bool IsRepeat() { return command_type_ == Type::kRepeat; }
+  bool IsWait() const { return command_type_ == Type::kWait; }
 
   ClearCommand* AsClear();
   ClearColorCommand* AsClearColor();
@@ -120,6 +123,7 @@ class Command {
   ProbeSSBOCommand* AsProbeSSBO();
   BufferCommand* AsBuffer();
   RepeatCommand* AsRepeat();
+  WaitCommand* AsWait();
 
   virtual std::string ToString() const = 0;
 
@@ -145,11 +149,21 @@ class PipelineCommand : public Command {
   void SetTimedExecution() { timed_execution_ = true; }
   bool IsTimedExecution() const { return timed_execution_; }
 
+  void SetPipelineStatistics() { pipeline_statistics_ = true; }
+  bool IsPipelineStatistics() const { return pipeline_statistics_; }
+
+  /// Marks a RUN ASYNC command, whose results are only needed once a WAIT,
+  /// an EXPECT or the end of the script looks at them.
+  void SetAsync() { async_ = true; }
+  bool IsAsync() const { return async_; }
+
  protected:
   PipelineCommand(Type type, Pipeline* pipeline);
 
   Pipeline* pipeline_ = nullptr;
   bool timed_execution_ = false;
+  bool pipeline_statistics_ = false;
+  bool async_ = false;
 };
 
 /// Command to draw a rectangle on screen.
@@ -724,6 +738,24 @@ class RepeatCommand : public Command {
   std::vector<std::unique_ptr<Command>> commands_;
 };
 
+/// Command to wait for the commands of a pipeline, or of all pipelines, to
+/// complete and bring their results to the host.
+class WaitCommand : public Command {
+ public:
+  /// Waits for the commands of |pipeline|, or of all pipelines if it is
+  /// nullptr.
+  explicit WaitCommand(Pipeline* pipeline);
+  ~WaitCommand() override;
+
+  /// Returns the pipeline to wait for, or nullptr to wait for all of them.
+  Pipeline* GetPipeline() const { return pipeline_; }
+
+  std::string ToString() const override { return "WaitCommand"; }
+
+ private:
+  Pipeline* pipeline_ = nullptr;
+};
+
 /// Command for setting TLAS parameters and binding.
 class TLASCommand : public BindableResourceCommand {
  public:
@@ -1545,6 +1545,20 @@ Result EngineDawn::DoBuffer(const BufferCommand* command) {
   return {};
 }
 
+Result EngineDawn::DoCopy(const CopyCommand* command) {
+  return command->GetBufferFrom()->CopyTo(command->GetBufferTo());
+}
+
+Result EngineDawn::SyncBufferToHost(Buffer*) {
+  // Every command copies the buffers it wrote back to the host.
+  return {};
+}
+
+Result EngineDawn::Finish() {
+  // Every command waits for its work to complete.
+  return {};
+}
+
 Result EngineDawn::AttachBuffersAndTextures(
     RenderPipelineInfo* render_pipeline) {
   Result result;
@@ -44,6 +44,15 @@ class EngineDawn : public Engine {
                     const std::vector<std::string>& instance_extensions,
                     const std::vector<std::string>& device_extensions) override;
 
+  // Dawn does not check requirements, so any device qualifies.
+  Result CheckRequirements(const std::vector<std::string>&,
+                           const std::vector<std::string>&,
+                           const std::vector<std::string>&,
+                           const std::vector<std::string>&) override {
+    return {};
+  }
+  void ResetPipelines() override { pipeline_map_.clear(); }
+
   // Record info for a pipeline.  The Dawn render pipeline will be created
   // later.  Assumes necessary shader modules have been created.  A compute
   // pipeline requires a compute shader.  A graphics pipeline requires a vertex
@@ -62,6 +71,11 @@ class EngineDawn : public Engine {
   Result DoPatchParameterVertices(
       const PatchParameterVerticesCommand* cmd) override;
   Result DoBuffer(const BufferCommand* cmd) override;
+  Result DoCopy(const CopyCommand* cmd) override;
+  Result SyncBufferToHost(Buffer* buffer) override;
+  bool BeginCapture(const RepeatCommand*) override { return false; }
+  Result EndCapture(uint32_t) override { return {}; }
+  Result Finish() override;
 
  private:
   // Returns the Dawn-specific render pipeline for the given command,
@@ -258,5 +258,27 @@ Result Compile(const std::string& src,
   return success ? Result() : Result("DXC compile failure: " + diagnostics);
 }
 
+std::string GetVersion() {
+  CComPtr<IDxcCompiler> compiler;
+  if (DxcCreateInstance(CLSID_DxcCompiler, __uuidof(IDxcCompiler),
+                        reinterpret_cast<void**>(&compiler)) < 0) {
+    DxcCleanupThreadMalloc();
+    return "";
+  }
+
+  std::string version;
+  CComPtr<IDxcVersionInfo> version_info;
+  if (compiler->QueryInterface(__uuidof(IDxcVersionInfo),
+                               reinterpret_cast<void**>(&version_info)) >= 0) {
+    UINT32 major = 0;
+    UINT32 minor = 0;
+    if (version_info->GetVersion(&major, &minor) >= 0) {
+      version = std::to_string(major) + "." + std::to_string(minor);
+    }
+  }
+  DxcCleanupThreadMalloc();
+  return version;
+}
+
 }  // namespace dxchelper
 }  // namespace amber
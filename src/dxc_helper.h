@@ -37,6 +37,10 @@ Result Compile(const std::string& src,
                const VirtualFileStore* virtual_files,
                std::vector<uint32_t>* generated_binary);
 
+// Returns the version DXC reports through IDxcVersionInfo, or an empty
+// string if it does not report one.
+std::string GetVersion();
+
 }  // namespace dxchelper
 }  // namespace amber
 
@@ -37,6 +37,15 @@ struct EngineData {
   /// The timeout to use for fences, in milliseconds.
   uint32_t fence_timeout_ms = 10000;
   bool pipeline_runtime_layer_enabled = false;
+  /// If true, buffers written by a command may stay on the device until
+  /// Engine::SyncBufferToHost() asks for them, instead of being copied back
+  /// to the host at the end of the command. Buffers shared by pipelines only
+  /// through buffer descriptors are not synced between their commands, so
+  /// an engine deferring readbacks must keep a single device copy of them.
+  bool defer_readbacks = false;
+  /// Where buffers bound to buffer descriptors are kept, unless the buffer
+  /// asks for a placement of its own. Never BufferPlacement::kDefault.
+  BufferPlacement buffer_placement = BufferPlacement::kHostVisible;
 };
 
 /// Abstract class which describes a backing engine for Amber.
@@ -54,8 +63,15 @@ struct EngineData {
 ///     The buffers all may have default values to be loaded into the device.
 ///  4. Engine::Do* is called for each command.
 ///     Note, it is assumed that the amber::Buffers are updated at the end of
-///     each Do* command and can be used immediately for comparisons.
+///     each Do* command and can be used immediately for comparisons, unless
+///     EngineData::defer_readbacks is set. The caller then uses
+///     Engine::SyncBufferToHost before looking at a buffer. Engine::Finish
+///     is called after the last command.
 ///  5. Engine destructor is called.
+///
+/// An engine may also run several scripts, in which case
+/// Engine::CheckRequirements is called before step 3 and
+/// Engine::ResetPipelines after step 4 for each script.
 class Engine {
  public:
   /// Creates a new engine of the requested |type|.
@@ -76,6 +92,20 @@ class Engine {
       const std::vector<std::string>& instance_extensions,
       const std::vector<std::string>& device_extensions) = 0;
 
+  /// Checks that the device the engine was initialized with supports the
+  /// given requirements, in the same way Initialize() does. Used when one
+  /// engine runs several scripts with different requirements.
+  virtual Result CheckRequirements(
+      const std::vector<std::string>& features,
+      const std::vector<std::string>& properties,
+      const std::vector<std::string>& instance_extensions,
+      const std::vector<std::string>& device_extensions) = 0;
+
+  /// Releases the pipelines and all other state created for the current
+  /// script, so the engine can run another script. Must be called before the
+  /// script is destroyed.
+  virtual void ResetPipelines() = 0;
+
   /// Create graphics pipeline.
   virtual Result CreatePipeline(Pipeline* pipeline) = 0;
 
@@ -118,6 +148,30 @@ class Engine {
   /// This covers both Vulkan buffers and images.
   virtual Result DoBuffer(const BufferCommand* cmd) = 0;
 
+  /// Execute the copy command. The engine may copy the buffers on the device
+  /// if the latest contents of both of them are held there.
+  virtual Result DoCopy(const CopyCommand* cmd) = 0;
+
+  /// Copies the contents of |buffer| back to the host if a command left its
+  /// latest contents on the device only. See EngineData::defer_readbacks.
+  virtual Result SyncBufferToHost(Buffer* buffer) = 0;
+
+  /// Starts capturing the device work of the commands executed until
+  /// EndCapture() into a single command buffer, instead of submitting it.
+  /// Returns false, capturing nothing, if the engine cannot capture the
+  /// commands of the body of |cmd| in their current state.
+  virtual bool BeginCapture(const RepeatCommand* cmd) = 0;
+
+  /// Ends the capture started by BeginCapture() and submits the captured
+  /// work |submit_count| times in a row. A count of 0 discards it.
+  virtual Result EndCapture(uint32_t submit_count) = 0;
+
+  /// Blocks until the device completed the work of every command executed
+  /// so far. Commands may return once their work was submitted, so this is
+  /// called by WAIT commands and after the last command of a script to
+  /// report its failures.
+  virtual Result Finish() = 0;
+
   /// Sets the engine data to use.
   void SetEngineData(const EngineData& data) { engine_data_ = data; }
 
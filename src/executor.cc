@@ -15,16 +15,49 @@
 
 #include "src/executor.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <memory>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "src/engine.h"
 #include "src/script.h"
+#include "src/shader_cache.h"
+#include "src/shader_compile_memo.h"
 #include "src/shader_compiler.h"
+#include "src/trace_scope.h"
 
 namespace amber {
+namespace {
+
+/// A single shader compilation performed by Executor::CompileShaders.
+struct CompileJob {
+  static constexpr size_t kNoJob = static_cast<size_t>(-1);
+
+  Pipeline* pipeline = nullptr;
+  Pipeline::ShaderInfo* shader_info = nullptr;
+  std::string target_env;
+  /// Index of an earlier job compiling the exact same shader, whose result
+  /// is used instead of compiling this one.
+  size_t duplicate_of = kNoJob;
+  Result result;
+  std::vector<uint32_t> data;
+};
+
+/// HLSL goes through DXC, which is not known to be thread safe, and OpenCL C
+/// compilation updates the pipeline it belongs to. Both stay on the calling
+/// thread.
+bool CanCompileInParallel(const Shader* shader) {
+  return shader->GetFormat() != kShaderFormatHlsl &&
+         shader->GetFormat() != kShaderFormatOpenCLC;
+}
+
+}  // namespace
 
 Executor::Executor() = default;
 
@@ -32,26 +65,146 @@ Executor::~Executor() = default;
 
 Result Executor::CompileShaders(const amber::Script* script,
                                 const ShaderMap& shader_map,
-                                Options* options) {
+                                Options* options,
+                                Delegate* delegate) {
+  std::vector<CompileJob> jobs;
   for (auto& pipeline : script->GetPipelines()) {
     for (auto& shader_info : pipeline->GetShaders()) {
-      std::string target_env = shader_info.GetShader()->GetTargetEnv();
-      if (target_env.empty()) {
-        target_env = script->GetSpvTargetEnv();
+      CompileJob job;
+      job.pipeline = pipeline.get();
+      job.shader_info = &shader_info;
+      job.target_env = shader_info.GetShader()->GetTargetEnv();
+      if (job.target_env.empty()) {
+        job.target_env = script->GetSpvTargetEnv();
       }
+      jobs.push_back(std::move(job));
+    }
+  }
+
+  std::unique_ptr<ShaderCache> cache;
+  if (!options->shader_cache_dir.empty()) {
+    cache = std::make_unique<ShaderCache>(options->shader_cache_dir);
+  }
+
+  ShaderCompileMemo* memo = nullptr;
+  if (options->compile_memo_entries > 0) {
+    memo = ShaderCompileMemo::GetInstance(options->compile_memo_entries);
+  }
 
-      ShaderCompiler sc(target_env, options->disable_spirv_validation,
+  // The memo only helps across jobs once a result is stored, so identical
+  // jobs within this script are folded here instead of racing each other. A
+  // ShaderMap may override only some of them, so leave those alone.
+  if (memo && shader_map.empty()) {
+    std::unordered_map<std::string, size_t> first_jobs;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+      ShaderCompiler sc(jobs[i].target_env, options->disable_spirv_validation,
                         script->GetVirtualFiles());
+      std::string key = sc.GetCacheKey(jobs[i].shader_info);
+      if (key.empty()) {
+        continue;
+      }
 
-      Result r;
-      std::vector<uint32_t> data;
-      std::tie(r, data) = sc.Compile(pipeline.get(), &shader_info, shader_map);
-      if (!r.IsSuccess()) {
-        return r;
+      auto it = first_jobs.find(key);
+      if (it == first_jobs.end()) {
+        first_jobs.emplace(std::move(key), i);
+      } else {
+        jobs[i].duplicate_of = it->second;
+      }
+    }
+  }
+
+  // Only the first failure in script order is reported, so once a job fails
+  // any job after it can be skipped. Jobs before it always run, which keeps
+  // the reported error independent of the thread count.
+  std::atomic<size_t> first_failure(jobs.size());
+  auto compile = [&](size_t idx) {
+    if (idx > first_failure.load()) {
+      return;
+    }
+
+    CompileJob& job = jobs[idx];
+    const Shader* shader = job.shader_info->GetShader();
+    TraceScope trace(
+        delegate, "compile", [shader]() { return shader->GetName(); },
+        static_cast<uint32_t>(shader->GetLine()));
+    ShaderCompiler sc(job.target_env, options->disable_spirv_validation,
+                      script->GetVirtualFiles());
+    sc.SetShaderCache(cache.get());
+    sc.SetCompileMemo(memo);
+    std::tie(job.result, job.data) =
+        sc.Compile(job.pipeline, job.shader_info, shader_map);
+    if (!job.result.IsSuccess()) {
+      size_t current = first_failure.load();
+      while (idx < current &&
+             !first_failure.compare_exchange_weak(current, idx)) {
       }
+    }
+  };
+
+  std::vector<size_t> parallel_jobs;
+  std::vector<size_t> serial_jobs;
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    if (jobs[i].duplicate_of != CompileJob::kNoJob) {
+      continue;
+    }
+    if (CanCompileInParallel(jobs[i].shader_info->GetShader())) {
+      parallel_jobs.push_back(i);
+    } else {
+      serial_jobs.push_back(i);
+    }
+  }
+
+  uint32_t thread_count = options->compile_threads;
+  if (thread_count == 0) {
+    thread_count = std::max(1U, std::thread::hardware_concurrency());
+  }
+
+  std::atomic<size_t> next_job(0);
+  auto worker = [&]() {
+    for (size_t n = next_job++; n < parallel_jobs.size(); n = next_job++) {
+      compile(parallel_jobs[n]);
+    }
+  };
+
+  // The calling thread works through the serial jobs and then helps with the
+  // parallel ones, so it counts as one of the |thread_count| threads.
+  std::vector<std::thread> threads;
+  size_t extra_threads =
+      std::min(static_cast<size_t>(thread_count), parallel_jobs.size());
+  if (extra_threads > 0 && serial_jobs.empty()) {
+    --extra_threads;
+  }
+  for (size_t i = 0; i < extra_threads; ++i) {
+    threads.emplace_back(worker);
+  }
+
+  for (size_t idx : serial_jobs) {
+    compile(idx);
+  }
+  worker();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  if (cache) {
+    ShaderCacheStats stats = cache->GetStats();
+    options->shader_cache_stats.hits += stats.hits;
+    options->shader_cache_stats.misses += stats.misses;
+    options->shader_cache_stats.bytes_saved += stats.bytes_saved;
+  }
+
+  for (auto& job : jobs) {
+    if (job.duplicate_of != CompileJob::kNoJob) {
+      job.result = jobs[job.duplicate_of].result;
+      job.data = jobs[job.duplicate_of].data;
+    }
+  }
 
-      shader_info.SetData(std::move(data));
+  for (auto& job : jobs) {
+    if (!job.result.IsSuccess()) {
+      return job.result;
     }
+    job.shader_info->SetData(std::move(job.data));
   }
   return {};
 }
@@ -61,10 +214,16 @@ Result Executor::Execute(Engine* engine,
                          const ShaderMap& shader_map,
                          Options* options,
                          Delegate* delegate) {
-  engine->SetEngineData(script->GetEngineData());
+  // Buffers written on the device are only copied back to the host before
+  // the commands which look at them.
+  buffer_liveness_.Analyze(script, options->extractions);
+  repeat_mode_ = options->repeat_mode;
+  EngineData engine_data = script->GetEngineData();
+  engine_data.defer_readbacks = true;
+  engine->SetEngineData(engine_data);
 
   if (!script->GetPipelines().empty()) {
-    Result r = CompileShaders(script, shader_map, options);
+    Result r = CompileShaders(script, shader_map, options, delegate);
     if (!r.IsSuccess()) {
       return r;
     }
@@ -90,6 +249,10 @@ Result Executor::Execute(Engine* engine,
     }
 
     for (auto& pipeline : script->GetPipelines()) {
+      const Pipeline* p = pipeline.get();
+      TraceScope trace(
+          delegate, "pipeline", [p]() { return p->GetName(); },
+          static_cast<uint32_t>(p->GetLine()));
       r = engine->CreatePipeline(pipeline.get());
       if (!r.IsSuccess()) {
         return r;
@@ -102,12 +265,36 @@ Result Executor::Execute(Engine* engine,
   }
 
   // Process Commands
+  Result r;
   for (const auto& cmd : script->GetCommands()) {
     if (delegate && delegate->LogExecuteCalls()) {
       delegate->Log(std::to_string(cmd->GetLine()) + ": " + cmd->ToString());
     }
 
-    Result r = ExecuteCommand(engine, cmd.get());
+    r = ExecuteCommand(engine, cmd.get(), delegate);
+    if (!r.IsSuccess()) {
+      break;
+    }
+  }
+
+  // The extractions are done even if a command failed, so bring their
+  // buffers up to date either way. The first error is the one reported.
+  Result sync_result = SyncBuffersToHost(
+      engine, buffer_liveness_.GetBuffersObservedAtExit());
+  if (r.IsSuccess()) {
+    r = sync_result;
+  }
+  Result finish_result = engine->Finish();
+  if (r.IsSuccess()) {
+    r = finish_result;
+  }
+  return r;
+}
+
+Result Executor::SyncBuffersToHost(Engine* engine,
+                                   const std::vector<Buffer*>& buffers) {
+  for (Buffer* buffer : buffers) {
+    Result r = engine->SyncBufferToHost(buffer);
     if (!r.IsSuccess()) {
       return r;
     }
@@ -115,9 +302,22 @@ Result Executor::Execute(Engine* engine,
   return {};
 }
 
-Result Executor::ExecuteCommand(Engine* engine, Command* cmd) {
+Result Executor::ExecuteCommand(Engine* engine,
+                                Command* cmd,
+                                Delegate* delegate) {
+  TraceScope trace(
+      delegate, "command", [cmd]() { return cmd->ToString(); },
+      static_cast<uint32_t>(cmd->GetLine()));
+
+  Result r =
+      SyncBuffersToHost(engine, buffer_liveness_.GetObservedBuffers(cmd));
+  if (!r.IsSuccess()) {
+    return r;
+  }
+
   if (cmd->IsProbe()) {
-    auto* buffer = cmd->AsProbe()->GetBuffer();
+    // Probes only read the buffer, which must not change its generation.
+    const auto* buffer = cmd->AsProbe()->GetBuffer();
     assert(buffer);
 
     Format* fmt = buffer->GetFormat();
@@ -160,10 +360,7 @@ Result Executor::ExecuteCommand(Engine* engine, Command* cmd) {
     }
   }
   if (cmd->IsCopy()) {
-    auto copy = cmd->AsCopy();
-    auto buffer_from = copy->GetBufferFrom();
-    auto buffer_to = copy->GetBufferTo();
-    return buffer_from->CopyTo(buffer_to);
+    return engine->DoCopy(cmd->AsCopy());
   }
   if (cmd->IsDrawRect()) {
     return engine->DoDrawRect(cmd->AsDrawRect());
@@ -190,18 +387,79 @@ Result Executor::ExecuteCommand(Engine* engine, Command* cmd) {
     return engine->DoBuffer(cmd->AsBuffer());
   }
   if (cmd->IsRepeat()) {
-    for (uint32_t i = 0; i < cmd->AsRepeat()->GetCount(); ++i) {
-      for (const auto& sub_cmd : cmd->AsRepeat()->GetCommands()) {
-        Result r = ExecuteCommand(engine, sub_cmd.get());
-        if (!r.IsSuccess()) {
-          return r;
-        }
-      }
-    }
-    return {};
+    return ExecuteRepeat(engine, cmd->AsRepeat(), delegate);
+  }
+  if (cmd->IsWait()) {
+    // The buffers of the pipelines waited for were synced above. The
+    // engine waits for all submitted work, which reports the timings of the
+    // commands which ran since.
+    return engine->Finish();
   }
   return Result("Unknown command type: " +
                 std::to_string(static_cast<uint32_t>(cmd->GetType())));
 }
 
+Result Executor::ExecuteRepeat(Engine* engine,
+                              RepeatCommand* repeat,
+                              Delegate* delegate) {
+  for (uint32_t i = 0; i < repeat->GetCount(); ++i) {
+    // The first iteration leaves the engine in the state every other one
+    // starts from, so only those are captured.
+    if (i == 1 && repeat_mode_ != RepeatMode::kExecute &&
+        IsCapturable(repeat) && engine->BeginCapture(repeat)) {
+      return ExecuteCapturedRepeat(engine, repeat, delegate);
+    }
+
+    for (const auto& sub_cmd : repeat->GetCommands()) {
+      Result r = ExecuteCommand(engine, sub_cmd.get(), delegate);
+      if (!r.IsSuccess()) {
+        return r;
+      }
+    }
+  }
+  return {};
+}
+
+Result Executor::ExecuteCapturedRepeat(Engine* engine,
+                                       RepeatCommand* repeat,
+                                       Delegate* delegate) {
+  const uint32_t remaining = repeat->GetCount() - 1;
+  const uint32_t recorded =
+      repeat_mode_ == RepeatMode::kUnroll ? remaining : 1;
+  for (uint32_t i = 0; i < recorded; ++i) {
+    for (const auto& sub_cmd : repeat->GetCommands()) {
+      Result r = ExecuteCommand(engine, sub_cmd.get(), delegate);
+      if (!r.IsSuccess()) {
+        engine->EndCapture(0);
+        return r;
+      }
+    }
+  }
+  return engine->EndCapture(remaining / recorded);
+}
+
+bool Executor::IsCapturable(const RepeatCommand* repeat) const {
+  for (const auto& sub_cmd : repeat->GetCommands()) {
+    const Command* cmd = sub_cmd.get();
+    if (!buffer_liveness_.GetObservedBuffers(cmd).empty()) {
+      return false;
+    }
+    if (cmd->IsCopy()) {
+      continue;
+    }
+    if (!cmd->IsClear() && !cmd->IsClearColor() && !cmd->IsClearDepth() &&
+        !cmd->IsClearStencil() && !cmd->IsCompute() && !cmd->IsDrawArrays() &&
+        !cmd->IsDrawRect() && !cmd->IsDrawGrid() && !cmd->IsRayTracing()) {
+      return false;
+    }
+    // Timings and statistics are reported for every command.
+    const auto* pipeline_cmd = static_cast<const PipelineCommand*>(cmd);
+    if (pipeline_cmd->IsTimedExecution() ||
+        pipeline_cmd->IsPipelineStatistics()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 }  // namespace amber
@@ -15,8 +15,11 @@
 #ifndef SRC_EXECUTOR_H_
 #define SRC_EXECUTOR_H_
 
+#include <vector>
+
 #include "amber/amber.h"
 #include "amber/result.h"
+#include "src/buffer_liveness.h"
 #include "src/engine.h"
 #include "src/script.h"
 #include "src/verifier.h"
@@ -42,10 +45,25 @@ class Executor {
  private:
   Result CompileShaders(const Script* script,
                         const ShaderMap& shader_map,
-                        Options* options);
-  Result ExecuteCommand(Engine* engine, Command* cmd);
+                        Options* options,
+                        Delegate* delegate);
+  Result ExecuteCommand(Engine* engine, Command* cmd, Delegate* delegate);
+  Result ExecuteRepeat(Engine* engine,
+                       RepeatCommand* repeat,
+                       Delegate* delegate);
+  /// Runs the iterations of |repeat| after the first one with the engine
+  /// capturing their device work, which BeginCapture() already started.
+  Result ExecuteCapturedRepeat(Engine* engine,
+                               RepeatCommand* repeat,
+                               Delegate* delegate);
+  /// Returns true if the body of |repeat| only does device work which the
+  /// host does not look at, so the engine may record it once.
+  bool IsCapturable(const RepeatCommand* repeat) const;
+  Result SyncBuffersToHost(Engine* engine, const std::vector<Buffer*>& buffers);
 
   Verifier verifier_;
+  BufferLiveness buffer_liveness_;
+  RepeatMode repeat_mode_ = RepeatMode::kExecute;
 };
 
 }  // namespace amber
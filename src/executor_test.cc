@@ -20,6 +20,7 @@
 #include <vector>
 
 #include "gtest/gtest.h"
+#include "src/amberscript/parser.h"
 #include "src/engine.h"
 #include "src/vkscript/parser.h"
 
@@ -46,6 +47,16 @@ class EngineStub : public Engine {
     return {};
   }
 
+  Result CheckRequirements(
+      const std::vector<std::string>& features,
+      const std::vector<std::string>& properties,
+      const std::vector<std::string>& instance_exts,
+      const std::vector<std::string>& device_exts) override {
+    return Initialize(nullptr, nullptr, features, properties, instance_exts,
+                      device_exts);
+  }
+  void ResetPipelines() override {}
+
   const std::vector<std::string>& GetFeatures() const { return features_; }
   const std::vector<std::string>& GetDeviceExtensions() const {
     return device_extensions_;
@@ -136,8 +147,10 @@ class EngineStub : public Engine {
 
   void FailComputeCommand() { fail_compute_command_ = true; }
   bool DidComputeCommand() const { return did_compute_command_; }
+  uint32_t GetComputeCommandCount() const { return compute_command_count_; }
   Result DoCompute(const ComputeCommand*) override {
     did_compute_command_ = true;
+    ++compute_command_count_;
 
     if (fail_compute_command_) {
       return Result("compute command failed");
@@ -179,10 +192,46 @@ class EngineStub : public Engine {
     return {};
   }
 
+  bool DidCopyCommand() const { return did_copy_command_; }
+  Result DoCopy(const CopyCommand* cmd) override {
+    did_copy_command_ = true;
+    return cmd->GetBufferFrom()->CopyTo(cmd->GetBufferTo());
+  }
+
   Result DoTraceRays(const RayTracingCommand*) override {
     return Result("traceray stub not implemented");
   }
 
+  bool DefersReadbacks() const { return GetEngineData().defer_readbacks; }
+  const std::vector<Buffer*>& GetSyncedBuffers() const {
+    return synced_buffers_;
+  }
+  Result SyncBufferToHost(Buffer* buffer) override {
+    synced_buffers_.push_back(buffer);
+    return {};
+  }
+
+  bool DidBeginCapture() const { return did_begin_capture_; }
+  uint32_t GetCaptureSubmitCount() const { return capture_submit_count_; }
+  bool BeginCapture(const RepeatCommand*) override {
+    did_begin_capture_ = true;
+    return true;
+  }
+  Result EndCapture(uint32_t submit_count) override {
+    capture_submit_count_ = submit_count;
+    return {};
+  }
+
+  void FailFinish() { fail_finish_ = true; }
+  bool DidFinish() const { return did_finish_; }
+  Result Finish() override {
+    did_finish_ = true;
+    if (fail_finish_) {
+      return Result("finish command failed");
+    }
+    return {};
+  }
+
  private:
   bool fail_clear_command_ = false;
   bool fail_clear_color_command_ = false;
@@ -195,6 +244,7 @@ class EngineStub : public Engine {
   bool fail_entry_point_command_ = false;
   bool fail_patch_command_ = false;
   bool fail_buffer_command_ = false;
+  bool fail_finish_ = false;
 
   bool did_clear_command_ = false;
   bool did_clear_color_command_ = false;
@@ -207,11 +257,17 @@ class EngineStub : public Engine {
   bool did_entry_point_command_ = false;
   bool did_patch_command_ = false;
   bool did_buffer_command_ = false;
+  bool did_copy_command_ = false;
+  bool did_finish_ = false;
+  bool did_begin_capture_ = false;
+  uint32_t compute_command_count_ = 0;
+  uint32_t capture_submit_count_ = 0;
 
   std::vector<std::string> features_;
   std::vector<std::string> properties_;
   std::vector<std::string> instance_extensions_;
   std::vector<std::string> device_extensions_;
+  std::vector<Buffer*> synced_buffers_;
 
   ClearColorCommand* last_clear_color_ = nullptr;
 };
@@ -860,6 +916,336 @@ ssbo 0 24)";
   EXPECT_EQ("buffer command failed", r.Error());
 }
 
+TEST_F(VkScriptExecutorTest, CompileShadersInParallel) {
+  std::string input;
+  for (int i = 0; i < 8; ++i) {
+    std::string n = std::to_string(i);
+    input += "SHADER compute cs" + n + " SPIRV-HEX\n0" + n +
+             " 00 00 00\nEND\n";
+    input += "PIPELINE compute p" + n + "\n  ATTACH cs" + n + "\nEND\n";
+  }
+
+  amberscript::Parser parser;
+  ASSERT_TRUE(parser.Parse(input).IsSuccess());
+
+  auto engine = MakeEngine();
+  auto script = parser.GetScript();
+
+  Options options;
+  options.disable_spirv_validation = true;
+  options.compile_threads = 4;
+  Executor ex;
+  Result r =
+      ex.Execute(engine.get(), script.get(), ShaderMap(), &options, nullptr);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  const auto& pipelines = script->GetPipelines();
+  ASSERT_EQ(8U, pipelines.size());
+  for (uint32_t i = 0; i < 8; ++i) {
+    const auto& data = pipelines[i]->GetShaders()[0].GetData();
+    ASSERT_EQ(1U, data.size());
+    EXPECT_EQ(i, data[0]);
+  }
+}
+
+TEST_F(VkScriptExecutorTest, CompileShadersReportsFirstErrorInScriptOrder) {
+  std::string input;
+  for (int i = 0; i < 8; ++i) {
+    std::string n = std::to_string(i);
+    if (i == 3 || i == 6) {
+      input += "SHADER compute cs" + n + " GLSL\n#error failure" + n +
+               "\nEND\n";
+    } else {
+      input += "SHADER compute cs" + n + " SPIRV-HEX\n00 00 00 00\nEND\n";
+    }
+    input += "PIPELINE compute p" + n + "\n  ATTACH cs" + n + "\nEND\n";
+  }
+
+  std::string serial_error;
+  for (uint32_t threads : {1U, 8U}) {
+    amberscript::Parser parser;
+    ASSERT_TRUE(parser.Parse(input).IsSuccess());
+
+    auto engine = MakeEngine();
+    auto script = parser.GetScript();
+
+    Options options;
+    options.disable_spirv_validation = true;
+    options.compile_threads = threads;
+    Executor ex;
+    Result r =
+        ex.Execute(engine.get(), script.get(), ShaderMap(), &options, nullptr);
+    ASSERT_FALSE(r.IsSuccess());
+
+    if (threads == 1) {
+      serial_error = r.Error();
+    } else {
+      EXPECT_EQ(serial_error, r.Error());
+    }
+#if AMBER_ENABLE_SHADERC
+    EXPECT_NE(std::string::npos, r.Error().find("failure3")) << r.Error();
+#endif  // AMBER_ENABLE_SHADERC
+  }
+}
+
+TEST_F(VkScriptExecutorTest, CompileShadersSharesIdenticalShaders) {
+  std::string input = R"(
+SHADER compute cs SPIRV-HEX
+2a 00 00 00
+END
+SHADER compute cs_copy SPIRV-HEX
+2a 00 00 00
+END
+PIPELINE compute p0
+  ATTACH cs
+END
+PIPELINE compute p1
+  ATTACH cs
+END
+PIPELINE compute p2
+  ATTACH cs_copy
+END
+)";
+
+  amberscript::Parser parser;
+  ASSERT_TRUE(parser.Parse(input).IsSuccess());
+
+  auto engine = MakeEngine();
+  auto script = parser.GetScript();
+
+  Options options;
+  options.disable_spirv_validation = true;
+  Executor ex;
+  Result r =
+      ex.Execute(engine.get(), script.get(), ShaderMap(), &options, nullptr);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  for (const auto& pipeline : script->GetPipelines()) {
+    EXPECT_EQ(std::vector<uint32_t>({42}), pipeline->GetShaders()[0].GetData());
+  }
+}
+
+TEST_F(VkScriptExecutorTest, SyncsObservedBuffersToHost) {
+  std::string input = R"(
+SHADER compute cs SPIRV-HEX
+03 02 23 07
+END
+BUFFER unobserved DATA_TYPE uint32 SIZE 4 FILL 0
+BUFFER observed DATA_TYPE uint32 SIZE 4 FILL 0
+BUFFER extracted DATA_TYPE uint32 SIZE 4 FILL 0
+PIPELINE compute p
+  ATTACH cs
+  BIND BUFFER unobserved AS storage DESCRIPTOR_SET 0 BINDING 0
+  BIND BUFFER observed AS storage DESCRIPTOR_SET 0 BINDING 1
+  BIND BUFFER extracted AS storage DESCRIPTOR_SET 0 BINDING 2
+END
+REPEAT 3
+  RUN p 1 1 1
+END
+EXPECT observed IDX 0 EQ 0
+)";
+
+  amberscript::Parser parser;
+  ASSERT_TRUE(parser.Parse(input).IsSuccess());
+
+  auto engine = MakeEngine();
+  auto script = parser.GetScript();
+
+  Options options;
+  options.disable_spirv_validation = true;
+  BufferInfo extraction;
+  extraction.buffer_name = "0:2";
+  options.extractions.push_back(extraction);
+
+  Executor ex;
+  Result r =
+      ex.Execute(engine.get(), script.get(), ShaderMap(), &options, nullptr);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+  ASSERT_TRUE(ToStub(engine.get())->DidComputeCommand());
+  EXPECT_TRUE(ToStub(engine.get())->DefersReadbacks());
+
+  const auto& synced = ToStub(engine.get())->GetSyncedBuffers();
+  ASSERT_EQ(2U, synced.size());
+  EXPECT_EQ(script->GetBuffer("observed"), synced[0]);
+  EXPECT_EQ(script->GetBuffer("extracted"), synced[1]);
+}
+
+TEST_F(VkScriptExecutorTest, ProbeKeepsBufferGeneration) {
+  std::string input = R"(
+SHADER vertex vs PASSTHROUGH
+SHADER fragment fs SPIRV-HEX
+00 00 00 00
+END
+BUFFER fb FORMAT B8G8R8A8_UNORM
+PIPELINE graphics p
+  ATTACH vs
+  ATTACH fs
+  FRAMEBUFFER_SIZE 4 4
+  BIND BUFFER fb AS color LOCATION 0
+END
+EXPECT fb IDX 0 0 SIZE 4 4 EQ_RGBA 0 0 0 0
+)";
+
+  amberscript::Parser parser;
+  ASSERT_TRUE(parser.Parse(input).IsSuccess());
+
+  auto engine = MakeEngine();
+  auto script = parser.GetScript();
+
+  // The stub engine renders nothing, so give the probe cleared contents.
+  Buffer* fb = script->GetBuffer("fb");
+  fb->SetSizeInElements(fb->ElementCount());
+  const uint64_t generation = fb->GetGeneration();
+
+  Options options;
+  options.disable_spirv_validation = true;
+  Executor ex;
+  Result r =
+      ex.Execute(engine.get(), script.get(), ShaderMap(), &options, nullptr);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+  EXPECT_EQ(generation, fb->GetGeneration());
+}
+
+TEST_F(VkScriptExecutorTest, CopyCommandIsLeftToEngine) {
+  std::string input = R"(
+BUFFER from DATA_TYPE uint32 SIZE 4 FILL 7
+BUFFER to DATA_TYPE uint32 SIZE 4 FILL 0
+COPY from TO to
+EXPECT to IDX 0 EQ 7
+)";
+
+  amberscript::Parser parser;
+  ASSERT_TRUE(parser.Parse(input).IsSuccess());
+
+  auto engine = MakeEngine();
+  auto script = parser.GetScript();
+
+  Options options;
+  Executor ex;
+  Result r =
+      ex.Execute(engine.get(), script.get(), ShaderMap(), &options, nullptr);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+  EXPECT_TRUE(ToStub(engine.get())->DidCopyCommand());
+
+  // Only the EXPECT looks at a buffer on the host.
+  const auto& synced = ToStub(engine.get())->GetSyncedBuffers();
+  ASSERT_EQ(1U, synced.size());
+  EXPECT_EQ(script->GetBuffer("to"), synced[0]);
+}
+
+TEST_F(VkScriptExecutorTest, FinishesAfterLastCommand) {
+  std::string input = R"(
+BUFFER buf DATA_TYPE uint32 SIZE 4 FILL 0
+EXPECT buf IDX 0 EQ 0
+)";
+
+  amberscript::Parser parser;
+  ASSERT_TRUE(parser.Parse(input).IsSuccess());
+
+  auto engine = MakeEngine();
+  ToStub(engine.get())->FailFinish();
+  auto script = parser.GetScript();
+
+  Options options;
+  Executor ex;
+  Result r =
+      ex.Execute(engine.get(), script.get(), ShaderMap(), &options, nullptr);
+  ASSERT_FALSE(r.IsSuccess());
+  EXPECT_EQ("finish command failed", r.Error());
+  EXPECT_TRUE(ToStub(engine.get())->DidFinish());
+}
+
+const char kRepeatedCompute[] = R"(
+SHADER compute cs SPIRV-HEX
+00 00 00 00
+END
+BUFFER buf DATA_TYPE uint32 SIZE 4 FILL 0
+PIPELINE compute p
+  ATTACH cs
+  BIND BUFFER buf AS storage DESCRIPTOR_SET 0 BINDING 0
+END
+)";
+
+TEST_F(VkScriptExecutorTest, RepeatReplaysCapturedIterations) {
+  std::string input = std::string(kRepeatedCompute) + R"(
+REPEAT 4
+  RUN p 1 1 1
+END
+)";
+
+  amberscript::Parser parser;
+  ASSERT_TRUE(parser.Parse(input).IsSuccess());
+
+  auto engine = MakeEngine();
+  auto script = parser.GetScript();
+
+  Options options;
+  options.disable_spirv_validation = true;
+  options.repeat_mode = RepeatMode::kReplay;
+  Executor ex;
+  Result r =
+      ex.Execute(engine.get(), script.get(), ShaderMap(), &options, nullptr);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  // The first iteration runs, the second one is captured and submitted for
+  // the remaining three.
+  EXPECT_TRUE(ToStub(engine.get())->DidBeginCapture());
+  EXPECT_EQ(2U, ToStub(engine.get())->GetComputeCommandCount());
+  EXPECT_EQ(3U, ToStub(engine.get())->GetCaptureSubmitCount());
+}
+
+TEST_F(VkScriptExecutorTest, RepeatUnrollsCapturedIterations) {
+  std::string input = std::string(kRepeatedCompute) + R"(
+REPEAT 4
+  RUN p 1 1 1
+END
+)";
+
+  amberscript::Parser parser;
+  ASSERT_TRUE(parser.Parse(input).IsSuccess());
+
+  auto engine = MakeEngine();
+  auto script = parser.GetScript();
+
+  Options options;
+  options.disable_spirv_validation = true;
+  options.repeat_mode = RepeatMode::kUnroll;
+  Executor ex;
+  Result r =
+      ex.Execute(engine.get(), script.get(), ShaderMap(), &options, nullptr);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  EXPECT_TRUE(ToStub(engine.get())->DidBeginCapture());
+  EXPECT_EQ(4U, ToStub(engine.get())->GetComputeCommandCount());
+  EXPECT_EQ(1U, ToStub(engine.get())->GetCaptureSubmitCount());
+}
+
+TEST_F(VkScriptExecutorTest, RepeatWithProbesIsNotCaptured) {
+  std::string input = std::string(kRepeatedCompute) + R"(
+REPEAT 4
+  RUN p 1 1 1
+  EXPECT buf IDX 0 EQ 0
+END
+)";
+
+  amberscript::Parser parser;
+  ASSERT_TRUE(parser.Parse(input).IsSuccess());
+
+  auto engine = MakeEngine();
+  auto script = parser.GetScript();
+
+  Options options;
+  options.disable_spirv_validation = true;
+  options.repeat_mode = RepeatMode::kReplay;
+  Executor ex;
+  Result r =
+      ex.Execute(engine.get(), script.get(), ShaderMap(), &options, nullptr);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  EXPECT_FALSE(ToStub(engine.get())->DidBeginCapture());
+  EXPECT_EQ(4U, ToStub(engine.get())->GetComputeCommandCount());
+}
+
 TEST_F(VkScriptExecutorTest, DISABLED_ProbeSSBOCommand) {
   std::string input = R"(
 [test]
@@ -247,6 +247,11 @@ class Pipeline {
   void SetName(const std::string& name) { name_ = name; }
   const std::string& GetName() const { return name_; }
 
+  /// Sets the script line the pipeline is declared on.
+  void SetLine(size_t line) { line_ = line; }
+  /// Returns the script line the pipeline is declared on, or 0 if unknown.
+  size_t GetLine() const { return line_; }
+
   void SetFramebufferWidth(uint32_t fb_width) {
     fb_width_ = fb_width;
     UpdateFramebufferSizes();
@@ -569,6 +574,7 @@ class Pipeline {
 
   PipelineType pipeline_type_ = PipelineType::kCompute;
   std::string name_;
+  size_t line_ = 0;
   std::vector<ShaderInfo> shaders_;
   std::vector<TLASInfo> tlases_;
   std::vector<BufferInfo> color_attachments_;
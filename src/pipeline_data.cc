@@ -14,7 +14,32 @@
 
 #include "src/pipeline_data.h"
 
+#include <cstdint>
+#include <cstring>
+#include <functional>
+
 namespace amber {
+namespace {
+
+template <typename T>
+void HashCombine(size_t* seed, const T& value) {
+  *seed ^= std::hash<T>()(value) + 0x9e3779b9 + (*seed << 6) + (*seed >> 2);
+}
+
+template <typename T>
+void HashCombineEnum(size_t* seed, T value) {
+  HashCombine(seed, static_cast<int64_t>(value));
+}
+
+// Floats are compared and hashed by their bit pattern so that state which
+// was set identically always matches.
+uint32_t FloatBits(float value) {
+  uint32_t bits = 0;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+}  // namespace
 
 PipelineData::PipelineData() = default;
 
@@ -22,4 +47,129 @@ PipelineData::~PipelineData() = default;
 
 PipelineData::PipelineData(const PipelineData&) = default;
 
+bool PipelineData::operator==(const PipelineData& other) const {
+  if (has_viewport_data != other.has_viewport_data) {
+    return false;
+  }
+  if (has_viewport_data &&
+      (FloatBits(vp.x) != FloatBits(other.vp.x) ||
+       FloatBits(vp.y) != FloatBits(other.vp.y) ||
+       FloatBits(vp.w) != FloatBits(other.vp.w) ||
+       FloatBits(vp.h) != FloatBits(other.vp.h) ||
+       FloatBits(vp.mind) != FloatBits(other.vp.mind) ||
+       FloatBits(vp.maxd) != FloatBits(other.vp.maxd))) {
+    return false;
+  }
+
+  return front_fail_op_ == other.front_fail_op_ &&
+         front_pass_op_ == other.front_pass_op_ &&
+         front_depth_fail_op_ == other.front_depth_fail_op_ &&
+         front_compare_op_ == other.front_compare_op_ &&
+         back_fail_op_ == other.back_fail_op_ &&
+         back_pass_op_ == other.back_pass_op_ &&
+         back_depth_fail_op_ == other.back_depth_fail_op_ &&
+         back_compare_op_ == other.back_compare_op_ &&
+         topology_ == other.topology_ &&
+         polygon_mode_ == other.polygon_mode_ &&
+         cull_mode_ == other.cull_mode_ && front_face_ == other.front_face_ &&
+         depth_compare_op_ == other.depth_compare_op_ &&
+         logic_op_ == other.logic_op_ &&
+         src_color_blend_factor_ == other.src_color_blend_factor_ &&
+         dst_color_blend_factor_ == other.dst_color_blend_factor_ &&
+         src_alpha_blend_factor_ == other.src_alpha_blend_factor_ &&
+         dst_alpha_blend_factor_ == other.dst_alpha_blend_factor_ &&
+         color_blend_op_ == other.color_blend_op_ &&
+         alpha_blend_op_ == other.alpha_blend_op_ &&
+         front_compare_mask_ == other.front_compare_mask_ &&
+         front_write_mask_ == other.front_write_mask_ &&
+         front_reference_ == other.front_reference_ &&
+         back_compare_mask_ == other.back_compare_mask_ &&
+         back_write_mask_ == other.back_write_mask_ &&
+         back_reference_ == other.back_reference_ &&
+         color_write_mask_ == other.color_write_mask_ &&
+         enable_blend_ == other.enable_blend_ &&
+         enable_depth_test_ == other.enable_depth_test_ &&
+         enable_depth_write_ == other.enable_depth_write_ &&
+         enable_depth_clamp_ == other.enable_depth_clamp_ &&
+         enable_depth_bias_ == other.enable_depth_bias_ &&
+         enable_depth_bounds_test_ == other.enable_depth_bounds_test_ &&
+         enable_stencil_test_ == other.enable_stencil_test_ &&
+         enable_primitive_restart_ == other.enable_primitive_restart_ &&
+         enable_rasterizer_discard_ == other.enable_rasterizer_discard_ &&
+         enable_logic_op_ == other.enable_logic_op_ &&
+         FloatBits(line_width_) == FloatBits(other.line_width_) &&
+         FloatBits(depth_bias_constant_factor_) ==
+             FloatBits(other.depth_bias_constant_factor_) &&
+         FloatBits(depth_bias_clamp_) == FloatBits(other.depth_bias_clamp_) &&
+         FloatBits(depth_bias_slope_factor_) ==
+             FloatBits(other.depth_bias_slope_factor_) &&
+         FloatBits(min_depth_bounds_) == FloatBits(other.min_depth_bounds_) &&
+         FloatBits(max_depth_bounds_) == FloatBits(other.max_depth_bounds_) &&
+         patch_control_points_ == other.patch_control_points_;
+}
+
+size_t PipelineData::Hash() const {
+  size_t seed = 0;
+
+  HashCombineEnum(&seed, front_fail_op_);
+  HashCombineEnum(&seed, front_pass_op_);
+  HashCombineEnum(&seed, front_depth_fail_op_);
+  HashCombineEnum(&seed, front_compare_op_);
+  HashCombineEnum(&seed, back_fail_op_);
+  HashCombineEnum(&seed, back_pass_op_);
+  HashCombineEnum(&seed, back_depth_fail_op_);
+  HashCombineEnum(&seed, back_compare_op_);
+  HashCombineEnum(&seed, topology_);
+  HashCombineEnum(&seed, polygon_mode_);
+  HashCombineEnum(&seed, cull_mode_);
+  HashCombineEnum(&seed, front_face_);
+  HashCombineEnum(&seed, depth_compare_op_);
+  HashCombineEnum(&seed, logic_op_);
+  HashCombineEnum(&seed, src_color_blend_factor_);
+  HashCombineEnum(&seed, dst_color_blend_factor_);
+  HashCombineEnum(&seed, src_alpha_blend_factor_);
+  HashCombineEnum(&seed, dst_alpha_blend_factor_);
+  HashCombineEnum(&seed, color_blend_op_);
+  HashCombineEnum(&seed, alpha_blend_op_);
+
+  HashCombine(&seed, front_compare_mask_);
+  HashCombine(&seed, front_write_mask_);
+  HashCombine(&seed, front_reference_);
+  HashCombine(&seed, back_compare_mask_);
+  HashCombine(&seed, back_write_mask_);
+  HashCombine(&seed, back_reference_);
+  HashCombine(&seed, color_write_mask_);
+
+  HashCombine(&seed, enable_blend_);
+  HashCombine(&seed, enable_depth_test_);
+  HashCombine(&seed, enable_depth_write_);
+  HashCombine(&seed, enable_depth_clamp_);
+  HashCombine(&seed, enable_depth_bias_);
+  HashCombine(&seed, enable_depth_bounds_test_);
+  HashCombine(&seed, enable_stencil_test_);
+  HashCombine(&seed, enable_primitive_restart_);
+  HashCombine(&seed, enable_rasterizer_discard_);
+  HashCombine(&seed, enable_logic_op_);
+
+  HashCombine(&seed, FloatBits(line_width_));
+  HashCombine(&seed, FloatBits(depth_bias_constant_factor_));
+  HashCombine(&seed, FloatBits(depth_bias_clamp_));
+  HashCombine(&seed, FloatBits(depth_bias_slope_factor_));
+  HashCombine(&seed, FloatBits(min_depth_bounds_));
+  HashCombine(&seed, FloatBits(max_depth_bounds_));
+
+  HashCombine(&seed, has_viewport_data);
+  if (has_viewport_data) {
+    HashCombine(&seed, FloatBits(vp.x));
+    HashCombine(&seed, FloatBits(vp.y));
+    HashCombine(&seed, FloatBits(vp.w));
+    HashCombine(&seed, FloatBits(vp.h));
+    HashCombine(&seed, FloatBits(vp.mind));
+    HashCombine(&seed, FloatBits(vp.maxd));
+  }
+
+  HashCombine(&seed, patch_control_points_);
+  return seed;
+}
+
 }  // namespace amber
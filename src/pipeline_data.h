@@ -15,6 +15,7 @@
 #ifndef SRC_PIPELINE_DATA_H_
 #define SRC_PIPELINE_DATA_H_
 
+#include <cstddef>
 #include <limits>
 
 #include "src/command_data.h"
@@ -39,6 +40,14 @@ class PipelineData {
 
   PipelineData& operator=(const PipelineData&) = default;
 
+  /// Returns true if all of the pipeline state in |other| matches this one.
+  bool operator==(const PipelineData& other) const;
+  bool operator!=(const PipelineData& other) const { return !(*this == other); }
+
+  /// Returns a hash of the pipeline state. Two objects which compare equal
+  /// have the same hash.
+  size_t Hash() const;
+
   void SetTopology(Topology topo) { topology_ = topo; }
   Topology GetTopology() const { return topology_; }
 
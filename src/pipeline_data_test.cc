@@ -0,0 +1,97 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/pipeline_data.h"
+
+#include "gtest/gtest.h"
+
+namespace amber {
+
+using PipelineDataTest = testing::Test;
+
+TEST_F(PipelineDataTest, DefaultsAreEqual) {
+  PipelineData a;
+  PipelineData b;
+  EXPECT_TRUE(a == b);
+  EXPECT_EQ(a.Hash(), b.Hash());
+}
+
+TEST_F(PipelineDataTest, CopyIsEqual) {
+  PipelineData a;
+  a.SetTopology(Topology::kTriangleList);
+  a.SetEnableBlend(true);
+  a.SetLineWidth(2.5f);
+  a.SetViewport({1.f, 2.f, 3.f, 4.f, 0.f, 1.f});
+
+  PipelineData b(a);
+  EXPECT_TRUE(a == b);
+  EXPECT_EQ(a.Hash(), b.Hash());
+}
+
+TEST_F(PipelineDataTest, DifferentTopology) {
+  PipelineData a;
+  PipelineData b;
+  b.SetTopology(Topology::kPointList);
+  EXPECT_TRUE(a != b);
+  EXPECT_NE(a.Hash(), b.Hash());
+}
+
+TEST_F(PipelineDataTest, DifferentDepthStencilState) {
+  PipelineData a;
+  PipelineData b;
+  b.SetEnableDepthTest(true);
+  EXPECT_TRUE(a != b);
+
+  PipelineData c;
+  c.SetBackCompareMask(0xff);
+  EXPECT_TRUE(a != c);
+}
+
+TEST_F(PipelineDataTest, DifferentBlendState) {
+  PipelineData a;
+  PipelineData b;
+  b.SetSrcColorBlendFactor(BlendFactor::kSrcAlpha);
+  EXPECT_TRUE(a != b);
+  EXPECT_NE(a.Hash(), b.Hash());
+}
+
+TEST_F(PipelineDataTest, DifferentPolygonMode) {
+  PipelineData a;
+  PipelineData b;
+  b.SetPolygonMode(PolygonMode::kLine);
+  EXPECT_TRUE(a != b);
+  EXPECT_NE(a.Hash(), b.Hash());
+}
+
+TEST_F(PipelineDataTest, DifferentPatchControlPoints) {
+  PipelineData a;
+  PipelineData b;
+  b.SetPatchControlPoints(4);
+  EXPECT_TRUE(a != b);
+  EXPECT_NE(a.Hash(), b.Hash());
+}
+
+TEST_F(PipelineDataTest, DifferentViewport) {
+  PipelineData a;
+  PipelineData b;
+  b.SetViewport({0.f, 0.f, 1.f, 1.f, 0.f, 1.f});
+  EXPECT_TRUE(a != b);
+
+  PipelineData c;
+  c.SetViewport({0.f, 0.f, 1.f, 2.f, 0.f, 1.f});
+  EXPECT_TRUE(b != c);
+  EXPECT_NE(b.Hash(), c.Hash());
+}
+
+}  // namespace amber
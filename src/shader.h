@@ -33,6 +33,11 @@ class Shader {
   void SetName(const std::string& name) { name_ = name; }
   const std::string& GetName() const { return name_; }
 
+  /// Sets the script line the shader is declared on.
+  void SetLine(size_t line) { line_ = line; }
+  /// Returns the script line the shader is declared on, or 0 if unknown.
+  size_t GetLine() const { return line_; }
+
   void SetFilePath(const std::string& path) { file_path_ = path; }
   const std::string& GetFilePath() const { return file_path_; }
 
@@ -52,6 +57,7 @@ class Shader {
   ShaderFormat shader_format_;
   std::string data_;
   std::string name_;
+  size_t line_ = 0;
   std::string file_path_;
   std::string target_env_;
 };
@@ -0,0 +1,173 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/shader_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+
+namespace amber {
+namespace {
+
+// Every entry starts with this tag, followed by the key size, the key, the
+// SPIR-V word count and the SPIR-V words. Sizes are stored as uint64_t in
+// host byte order.
+const char kEntryTag[] = "AMBERSC1";
+const size_t kEntryTagSize = sizeof(kEntryTag) - 1;
+
+uint64_t Fnv1a64(const std::string& data, uint64_t hash) {
+  for (const char c : data) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+std::string ToHex(uint64_t value) {
+  const char kDigits[] = "0123456789abcdef";
+  std::string ret(16, '0');
+  for (size_t i = 0; i < 16; ++i) {
+    ret[15 - i] = kDigits[value & 0xf];
+    value >>= 4;
+  }
+  return ret;
+}
+
+void AppendUint64(uint64_t value, std::string* out) {
+  char bytes[sizeof(value)];
+  std::memcpy(bytes, &value, sizeof(value));
+  out->append(bytes, sizeof(bytes));
+}
+
+bool ReadUint64(const std::string& data, size_t* pos, uint64_t* value) {
+  if (data.size() - *pos < sizeof(*value)) {
+    return false;
+  }
+  std::memcpy(value, data.data() + *pos, sizeof(*value));
+  *pos += sizeof(*value);
+  return true;
+}
+
+}  // namespace
+
+ShaderCache::ShaderCache(const std::string& directory)
+    : directory_(directory) {
+  if (!directory_.empty() && directory_.back() != '/' &&
+      directory_.back() != '\\') {
+    directory_ += '/';
+  }
+
+  std::random_device rd;
+  temp_file_prefix_ = ToHex((static_cast<uint64_t>(rd()) << 32) | rd());
+}
+
+ShaderCache::~ShaderCache() = default;
+
+std::string ShaderCache::GetFileName(const std::string& key) {
+  // Two FNV-1a hashes with different offset bases make accidental collisions
+  // between the file names of different keys unlikely. Collisions are still
+  // detected when the entry is read.
+  return ToHex(Fnv1a64(key, 0xcbf29ce484222325ULL)) +
+         ToHex(Fnv1a64(key, 0x84222325cbf29ce4ULL)) + ".spvcache";
+}
+
+std::string ShaderCache::GetPath(const std::string& key) const {
+  return directory_ + GetFileName(key);
+}
+
+bool ShaderCache::Find(const std::string& key, std::vector<uint32_t>* spirv) {
+  std::string data;
+  {
+    std::ifstream file(GetPath(key), std::ios::in | std::ios::binary);
+    if (file.is_open()) {
+      data.assign(std::istreambuf_iterator<char>(file),
+                  std::istreambuf_iterator<char>());
+    }
+  }
+
+  bool found = false;
+  size_t pos = kEntryTagSize;
+  uint64_t key_size = 0;
+  uint64_t word_count = 0;
+  if (data.compare(0, kEntryTagSize, kEntryTag) == 0 &&
+      ReadUint64(data, &pos, &key_size) && key_size == key.size() &&
+      data.size() - pos >= key.size() &&
+      data.compare(pos, key.size(), key) == 0) {
+    pos += key.size();
+    if (ReadUint64(data, &pos, &word_count) && word_count > 0 &&
+        (data.size() - pos) / sizeof(uint32_t) == word_count &&
+        (data.size() - pos) % sizeof(uint32_t) == 0) {
+      spirv->resize(static_cast<size_t>(word_count));
+      std::memcpy(spirv->data(), data.data() + pos, data.size() - pos);
+      found = true;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (found) {
+    ++stats_.hits;
+    stats_.bytes_saved += word_count * sizeof(uint32_t);
+  } else {
+    ++stats_.misses;
+  }
+  return found;
+}
+
+void ShaderCache::Add(const std::string& key,
+                      const std::vector<uint32_t>& spirv) {
+  std::string data(kEntryTag, kEntryTagSize);
+  AppendUint64(key.size(), &data);
+  data += key;
+  AppendUint64(spirv.size(), &data);
+  data.append(reinterpret_cast<const char*>(spirv.data()),
+              spirv.size() * sizeof(uint32_t));
+
+  std::string temp_path;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    temp_path = directory_ + temp_file_prefix_ + "-" +
+                std::to_string(temp_file_count_++) + ".tmp";
+  }
+
+  {
+    std::ofstream file(temp_path, std::ios::out | std::ios::binary);
+    if (!file.is_open()) {
+      return;
+    }
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!file.good()) {
+      file.close();
+      std::remove(temp_path.c_str());
+      return;
+    }
+  }
+
+  // Readers only ever see complete entries. If another writer got there first
+  // the rename may fail on some platforms, which is fine as both entries hold
+  // the same data.
+  const std::string path = GetPath(key);
+  if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    std::remove(temp_path.c_str());
+  }
+}
+
+ShaderCacheStats ShaderCache::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+}  // namespace amber
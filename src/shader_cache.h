@@ -0,0 +1,65 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_SHADER_CACHE_H_
+#define SRC_SHADER_CACHE_H_
+
+#include <cstdint>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <vector>
+
+#include "amber/amber.h"
+
+namespace amber {
+
+/// Content addressed on-disk cache of compiled shaders. Each entry is stored
+/// in its own file in the cache directory, named after a hash of the key. The
+/// full key is stored in the file as well, so a hash collision results in a
+/// miss rather than the wrong SPIR-V. The cache may be used from several
+/// threads at once.
+class ShaderCache {
+ public:
+  /// Creates a cache storing its entries in |directory|, which must exist.
+  explicit ShaderCache(const std::string& directory);
+  ~ShaderCache();
+
+  /// Looks up |key|. Returns true and fills |spirv| on a hit.
+  bool Find(const std::string& key, std::vector<uint32_t>* spirv);
+
+  /// Stores |spirv| as the compilation result for |key|. Failing to write the
+  /// entry is not an error, the shader is simply compiled again next time.
+  void Add(const std::string& key, const std::vector<uint32_t>& spirv);
+
+  /// Returns the hits, misses and bytes saved since the cache was created.
+  ShaderCacheStats GetStats() const;
+
+  /// Returns the file name used for the entry with |key|.
+  static std::string GetFileName(const std::string& key);
+
+ private:
+  std::string GetPath(const std::string& key) const;
+
+  std::string directory_;
+  /// Unique per cache object, so concurrent writers of the same entry, even
+  /// from other processes, never share a temporary file.
+  std::string temp_file_prefix_;
+  mutable std::mutex mutex_;
+  ShaderCacheStats stats_;
+  uint32_t temp_file_count_ = 0;
+};
+
+}  // namespace amber
+
+#endif  // SRC_SHADER_CACHE_H_
@@ -0,0 +1,98 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/shader_cache.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace amber {
+namespace {
+
+class ShaderCacheTest : public testing::Test {
+ public:
+  std::string GetDir() const { return testing::TempDir(); }
+
+  // Removes any entry for |key| left over from an earlier run.
+  void RemoveEntry(const std::string& key) const {
+    std::remove((GetDir() + ShaderCache::GetFileName(key)).c_str());
+  }
+};
+
+}  // namespace
+
+TEST_F(ShaderCacheTest, MissThenHit) {
+  const std::string key = "ShaderCacheTest.MissThenHit";
+  RemoveEntry(key);
+
+  ShaderCache cache(GetDir());
+  std::vector<uint32_t> spirv;
+  EXPECT_FALSE(cache.Find(key, &spirv));
+
+  cache.Add(key, {0x07230203, 1, 2, 3});
+  ASSERT_TRUE(cache.Find(key, &spirv));
+  EXPECT_EQ(std::vector<uint32_t>({0x07230203, 1, 2, 3}), spirv);
+
+  ShaderCacheStats stats = cache.GetStats();
+  EXPECT_EQ(1U, stats.hits);
+  EXPECT_EQ(1U, stats.misses);
+  EXPECT_EQ(16U, stats.bytes_saved);
+}
+
+TEST_F(ShaderCacheTest, EntriesPersistAcrossCaches) {
+  const std::string key = "ShaderCacheTest.EntriesPersistAcrossCaches";
+  RemoveEntry(key);
+
+  ShaderCache(GetDir()).Add(key, {4, 5, 6});
+
+  ShaderCache cache(GetDir());
+  std::vector<uint32_t> spirv;
+  ASSERT_TRUE(cache.Find(key, &spirv));
+  EXPECT_EQ(std::vector<uint32_t>({4, 5, 6}), spirv);
+}
+
+TEST_F(ShaderCacheTest, DifferentKeyMisses) {
+  const std::string key = "ShaderCacheTest.DifferentKeyMisses";
+  const std::string other_key = key + ".Other";
+  RemoveEntry(key);
+  RemoveEntry(other_key);
+
+  ShaderCache cache(GetDir());
+  cache.Add(key, {1});
+
+  std::vector<uint32_t> spirv;
+  EXPECT_FALSE(cache.Find(other_key, &spirv));
+  EXPECT_EQ(1U, cache.GetStats().misses);
+}
+
+TEST_F(ShaderCacheTest, CorruptEntryMisses) {
+  const std::string key = "ShaderCacheTest.CorruptEntryMisses";
+  {
+    std::ofstream file(GetDir() + ShaderCache::GetFileName(key),
+                       std::ios::out | std::ios::binary);
+    ASSERT_TRUE(file.is_open());
+    file << "AMBERSC1 not a valid entry";
+  }
+
+  ShaderCache cache(GetDir());
+  std::vector<uint32_t> spirv;
+  EXPECT_FALSE(cache.Find(key, &spirv));
+  EXPECT_EQ(0U, cache.GetStats().hits);
+}
+
+}  // namespace amber
@@ -0,0 +1,82 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/shader_compile_memo.h"
+
+namespace amber {
+
+// static
+ShaderCompileMemo* ShaderCompileMemo::GetInstance(size_t max_entries) {
+  // Intentionally leaked so there is no destructor to run at exit while
+  // other threads may still be compiling.
+  static ShaderCompileMemo* memo = new ShaderCompileMemo(max_entries);
+  return memo;
+}
+
+ShaderCompileMemo::ShaderCompileMemo(size_t max_entries)
+    : max_entries_(max_entries) {}
+
+ShaderCompileMemo::~ShaderCompileMemo() = default;
+
+bool ShaderCompileMemo::Find(const std::string& key,
+                             std::vector<uint32_t>* spirv) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    return false;
+  }
+
+  entries_.splice(entries_.begin(), entries_, it->second);
+  *spirv = it->second->second;
+  return true;
+}
+
+void ShaderCompileMemo::Add(const std::string& key,
+                            const std::vector<uint32_t>& spirv) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (max_entries_ == 0) {
+    return;
+  }
+
+  auto it = index_.find(key);
+  if (it != index_.end()) {
+    it->second->second = spirv;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return;
+  }
+
+  entries_.emplace_front(key, spirv);
+  index_[key] = entries_.begin();
+  EvictIfNeeded();
+}
+
+void ShaderCompileMemo::SetMaxEntries(size_t max_entries) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  max_entries_ = max_entries;
+  EvictIfNeeded();
+}
+
+size_t ShaderCompileMemo::GetEntryCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+void ShaderCompileMemo::EvictIfNeeded() {
+  while (entries_.size() > max_entries_) {
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+}
+
+}  // namespace amber
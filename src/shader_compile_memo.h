@@ -0,0 +1,69 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_SHADER_COMPILE_MEMO_H_
+#define SRC_SHADER_COMPILE_MEMO_H_
+
+#include <cstdint>
+#include <list>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace amber {
+
+/// In-memory cache of compiled shaders, keyed on
+/// ShaderCompiler::GetCacheKey(). Holds at most a fixed number of entries,
+/// evicting the least recently used one when full. The cache may be used
+/// from several threads at once.
+class ShaderCompileMemo {
+ public:
+  /// Returns the instance shared by every execution in the process. The
+  /// first call sets its size to |max_entries|. Later calls ignore the value,
+  /// so executions running at the same time cannot resize it.
+  static ShaderCompileMemo* GetInstance(size_t max_entries);
+
+  explicit ShaderCompileMemo(size_t max_entries);
+  ~ShaderCompileMemo();
+
+  /// Looks up |key|. Returns true and fills |spirv| on a hit.
+  bool Find(const std::string& key, std::vector<uint32_t>* spirv);
+
+  /// Stores |spirv| as the compilation result for |key|.
+  void Add(const std::string& key, const std::vector<uint32_t>& spirv);
+
+  /// Changes the maximum number of entries, evicting entries as needed. A
+  /// value of 0 empties the cache and stops it from storing anything.
+  void SetMaxEntries(size_t max_entries);
+
+  /// Returns the number of entries currently held.
+  size_t GetEntryCount() const;
+
+ private:
+  using Entry = std::pair<std::string, std::vector<uint32_t>>;
+
+  void EvictIfNeeded();
+
+  mutable std::mutex mutex_;
+  size_t max_entries_ = 0;
+  /// Most recently used entries are at the front.
+  std::list<Entry> entries_;
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+};
+
+}  // namespace amber
+
+#endif  // SRC_SHADER_COMPILE_MEMO_H_
@@ -0,0 +1,91 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/shader_compile_memo.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace amber {
+
+using ShaderCompileMemoTest = testing::Test;
+
+TEST_F(ShaderCompileMemoTest, FindReturnsAddedEntry) {
+  ShaderCompileMemo memo(4);
+  std::vector<uint32_t> spirv;
+  EXPECT_FALSE(memo.Find("a", &spirv));
+
+  memo.Add("a", {1, 2, 3});
+  ASSERT_TRUE(memo.Find("a", &spirv));
+  EXPECT_EQ(std::vector<uint32_t>({1, 2, 3}), spirv);
+}
+
+TEST_F(ShaderCompileMemoTest, AddReplacesExistingEntry) {
+  ShaderCompileMemo memo(4);
+  memo.Add("a", {1});
+  memo.Add("a", {2});
+  EXPECT_EQ(1U, memo.GetEntryCount());
+
+  std::vector<uint32_t> spirv;
+  ASSERT_TRUE(memo.Find("a", &spirv));
+  EXPECT_EQ(std::vector<uint32_t>({2}), spirv);
+}
+
+TEST_F(ShaderCompileMemoTest, EvictsLeastRecentlyUsed) {
+  ShaderCompileMemo memo(2);
+  memo.Add("a", {1});
+  memo.Add("b", {2});
+
+  // Using "a" makes "b" the least recently used entry.
+  std::vector<uint32_t> spirv;
+  ASSERT_TRUE(memo.Find("a", &spirv));
+
+  memo.Add("c", {3});
+  EXPECT_EQ(2U, memo.GetEntryCount());
+  EXPECT_TRUE(memo.Find("a", &spirv));
+  EXPECT_FALSE(memo.Find("b", &spirv));
+  EXPECT_TRUE(memo.Find("c", &spirv));
+}
+
+TEST_F(ShaderCompileMemoTest, SetMaxEntriesEvicts) {
+  ShaderCompileMemo memo(3);
+  memo.Add("a", {1});
+  memo.Add("b", {2});
+  memo.Add("c", {3});
+
+  memo.SetMaxEntries(1);
+  EXPECT_EQ(1U, memo.GetEntryCount());
+  std::vector<uint32_t> spirv;
+  EXPECT_TRUE(memo.Find("c", &spirv));
+
+  memo.SetMaxEntries(0);
+  EXPECT_EQ(0U, memo.GetEntryCount());
+  memo.Add("d", {4});
+  EXPECT_EQ(0U, memo.GetEntryCount());
+}
+
+TEST_F(ShaderCompileMemoTest, InstanceKeepsItsFirstSize) {
+  ShaderCompileMemo* memo = ShaderCompileMemo::GetInstance(3);
+  memo->Add("instance-a", {1});
+  memo->Add("instance-b", {2});
+
+  // A later, smaller size must not evict what other executions stored.
+  EXPECT_EQ(memo, ShaderCompileMemo::GetInstance(1));
+  std::vector<uint32_t> spirv;
+  EXPECT_TRUE(memo->Find("instance-a", &spirv));
+  EXPECT_TRUE(memo->Find("instance-b", &spirv));
+}
+
+}  // namespace amber
@@ -18,6 +18,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <iterator>
+#include <map>
 #include <string>
 #include <utility>
 
@@ -44,7 +45,54 @@
 #include "src/clspv_helper.h"
 #endif  // AMBER_ENABLE_CLSPV
 
+#if AMBER_BUILD_VERSIONS
+#include "src/build-versions.h"
+#endif  // AMBER_BUILD_VERSIONS
+
 namespace amber {
+namespace {
+
+// Changing how shaders are compiled, or the layout of the cache key, requires
+// bumping this so stale cache entries are not used.
+const char kCacheKeyVersion[] = "amber-shader-cache-1";
+
+// Returns the versions of the compilers built into Amber. Builds which
+// generate src/build-versions.h add the commits the compilers were built
+// from, which catches upgrades the versions reported at runtime miss.
+std::string ComputeCompilerVersions() {
+  std::string versions;
+#if AMBER_ENABLE_SPIRV_TOOLS
+  versions += std::string("spirv-tools:") + spvSoftwareVersionDetailsString();
+#endif  // AMBER_ENABLE_SPIRV_TOOLS
+#if AMBER_ENABLE_SHADERC
+  unsigned int spv_version = 0;
+  unsigned int spv_revision = 0;
+  shaderc_get_spv_version(&spv_version, &spv_revision);
+  versions += " shaderc-spv:" + std::to_string(spv_version) + "." +
+              std::to_string(spv_revision);
+#endif  // AMBER_ENABLE_SHADERC
+#if AMBER_ENABLE_DXC
+  versions += " dxc:" + dxchelper::GetVersion();
+#endif  // AMBER_ENABLE_DXC
+#if AMBER_ENABLE_CLSPV
+  versions += " clspv";
+#endif  // AMBER_ENABLE_CLSPV
+#if AMBER_BUILD_VERSIONS
+  versions += std::string(" build:") + SPIRV_TOOLS_VERSION + "," +
+              GLSLANG_VERSION + "," + SHADERC_VERSION + "," + DXC_VERSION +
+              "," + CLSPV_VERSION + "," + CLSPV_LLVM_VERSION;
+#endif  // AMBER_BUILD_VERSIONS
+  return versions;
+}
+
+const std::string& GetCompilerVersions() {
+  // Asking DXC for its version creates a compiler instance, so this is only
+  // done once.
+  static const std::string versions = ComputeCompilerVersions();
+  return versions;
+}
+
+}  // namespace
 
 ShaderCompiler::ShaderCompiler() = default;
 
@@ -82,6 +130,23 @@ std::pair<Result, std::vector<uint32_t>> ShaderCompiler::Compile(
     return {{}, it->second};
   }
 
+  std::string cache_key;
+  if (cache_ || memo_) {
+    cache_key = GetCacheKey(shader_info);
+  }
+  if (!cache_key.empty()) {
+    std::vector<uint32_t> cached;
+    if (memo_ && memo_->Find(cache_key, &cached)) {
+      return {{}, cached};
+    }
+    if (cache_ && cache_->Find(cache_key, &cached)) {
+      if (memo_) {
+        memo_->Add(cache_key, cached);
+      }
+      return {{}, cached};
+    }
+  }
+
 #if AMBER_ENABLE_SPIRV_TOOLS
   std::string spv_errors;
 
@@ -193,9 +258,70 @@ std::pair<Result, std::vector<uint32_t>> ShaderCompiler::Compile(
   }
 #endif  // AMBER_ENABLE_SPIRV_TOOLS
 
+  if (!cache_key.empty()) {
+    if (memo_) {
+      memo_->Add(cache_key, results);
+    }
+    if (cache_) {
+      cache_->Add(cache_key, results);
+    }
+  }
   return {{}, results};
 }
 
+std::string ShaderCompiler::GetCacheKey(
+    const Pipeline::ShaderInfo* shader_info) const {
+  const auto shader = shader_info->GetShader();
+  // OpenCL C compilation also fills in pipeline state, which can not be
+  // recovered from the SPIR-V alone.
+  if (shader->GetFormat() == kShaderFormatOpenCLC) {
+    return "";
+  }
+
+  // Every field is prefixed with its length so that no two different sets of
+  // inputs produce the same key.
+  std::string key;
+  auto add = [&key](const std::string& field) {
+    key += std::to_string(field.size()) + ":" + field + "\n";
+  };
+  auto add_list = [&add](const std::vector<std::string>& fields) {
+    add(std::to_string(fields.size()));
+    for (const auto& field : fields) {
+      add(field);
+    }
+  };
+
+  add(kCacheKeyVersion);
+  add(GetCompilerVersions());
+  add(std::to_string(static_cast<int>(shader->GetFormat())));
+  add(std::to_string(static_cast<int>(shader->GetType())));
+  add(shader_info->GetEntryPoint());
+  add(spv_env_);
+  add(disable_spirv_validation_ ? "no-validation" : "validation");
+  add_list(shader_info->GetCompileOptions());
+  add_list(shader_info->GetShaderOptimizations());
+
+  // Only DXC resolves includes through the virtual files. Which files get
+  // included is only known after preprocessing, so all of them are part of
+  // the key.
+  if (shader->GetFormat() == kShaderFormatHlsl) {
+    add(shader->GetFilePath());
+    std::map<std::string, std::string> files;
+    if (virtual_files_) {
+      files.insert(virtual_files_->GetFiles().begin(),
+                   virtual_files_->GetFiles().end());
+    }
+    add(std::to_string(files.size()));
+    for (const auto& file : files) {
+      add(file.first);
+      add(file.second);
+    }
+  }
+
+  add(shader->GetData());
+  return key;
+}
+
 Result ShaderCompiler::ParseHex(const std::string& data,
                                 std::vector<uint32_t>* result) const {
   size_t used = 0;
@@ -205,6 +331,10 @@ Result ShaderCompiler::ParseHex(const std::string& data,
   while (used < data.length()) {
     char* new_pos = nullptr;
     uint64_t v = static_cast<uint64_t>(std::strtol(str, &new_pos, 16));
+    // Only trailing whitespace is left.
+    if (new_pos == str) {
+      break;
+    }
 
     ++converted;
 
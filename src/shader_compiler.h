@@ -26,6 +26,8 @@
 #endif
 #include "src/pipeline.h"
 #include "src/shader.h"
+#include "src/shader_cache.h"
+#include "src/shader_compile_memo.h"
 #include "src/virtual_file_store.h"
 
 namespace amber {
@@ -57,6 +59,19 @@ class ShaderCompiler {
       Pipeline::ShaderInfo* shader_info,
       const ShaderMap& shader_map) const;
 
+  /// Makes Compile() look up and store its results in |cache|. The cache
+  /// must outlive the compiler.
+  void SetShaderCache(ShaderCache* cache) { cache_ = cache; }
+
+  /// Makes Compile() look up and store its results in |memo| before going to
+  /// the shader cache or a compiler. The memo must outlive the compiler.
+  void SetCompileMemo(ShaderCompileMemo* memo) { memo_ = memo; }
+
+  /// Returns a string holding every input which affects the result of
+  /// compiling |shader_info|, for use as a cache key. Returns an empty string
+  /// if the result can not be cached.
+  std::string GetCacheKey(const Pipeline::ShaderInfo* shader_info) const;
+
  private:
   Result ParseHex(const std::string& data, std::vector<uint32_t>* result) const;
   Result CompileGlsl(const Shader* shader, std::vector<uint32_t>* result) const;
@@ -71,6 +86,8 @@ class ShaderCompiler {
   std::string spv_env_;
   bool disable_spirv_validation_ = false;
   VirtualFileStore* virtual_files_ = nullptr;
+  ShaderCache* cache_ = nullptr;
+  ShaderCompileMemo* memo_ = nullptr;
 };
 
 // Parses the SPIR-V environment string, and returns the corresponding
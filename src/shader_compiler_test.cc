@@ -15,6 +15,7 @@
 #include "src/shader_compiler.h"
 
 #include <algorithm>
+#include <cstdio>
 #include <string>
 #include <vector>
 
@@ -24,6 +25,9 @@
 #if AMBER_ENABLE_SHADERC
 #include "shaderc/shaderc.hpp"
 #endif
+#if AMBER_ENABLE_DXC
+#include "src/dxc_helper.h"
+#endif  // AMBER_ENABLE_DXC
 
 namespace amber {
 namespace {
@@ -244,6 +248,110 @@ TEST_F(ShaderCompilerTest, CompilesSpirvHex) {
   EXPECT_EQ(0x07230203u, binary[0]);  // Verify SPIR-V header present.
 }
 
+TEST_F(ShaderCompilerTest, CompilesSpirvHexWithTrailingWhitespace) {
+  Shader shader(kShaderTypeVertex);
+  shader.SetName("TestShader");
+  shader.SetFormat(kShaderFormatSpirvHex);
+  shader.SetData(kHexShader);
+  Shader padded(kShaderTypeVertex);
+  padded.SetName("PaddedShader");
+  padded.SetFormat(kShaderFormatSpirvHex);
+  padded.SetData(std::string(kHexShader) + " \n  \t\n");
+
+  ShaderCompiler sc;
+  Result r;
+  std::vector<uint32_t> binary;
+  std::vector<uint32_t> padded_binary;
+  Pipeline::ShaderInfo shader_info(&shader, kShaderTypeCompute);
+  Pipeline::ShaderInfo padded_info(&padded, kShaderTypeCompute);
+  Pipeline pipeline(PipelineType::kCompute);
+  std::tie(r, binary) = sc.Compile(&pipeline, &shader_info, ShaderMap());
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+  std::tie(r, padded_binary) = sc.Compile(&pipeline, &padded_info, ShaderMap());
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+  EXPECT_EQ(binary, padded_binary);
+}
+
+TEST_F(ShaderCompilerTest, CacheKeyCoversCompileInputs) {
+  Shader shader(kShaderTypeVertex);
+  shader.SetFormat(kShaderFormatSpirvHex);
+  shader.SetData(kHexShader);
+  Pipeline::ShaderInfo shader_info(&shader, kShaderTypeVertex);
+
+  ShaderCompiler sc("spv1.0", false, nullptr);
+  const std::string key = sc.GetCacheKey(&shader_info);
+  ASSERT_FALSE(key.empty());
+  EXPECT_EQ(key, sc.GetCacheKey(&shader_info));
+
+  ShaderCompiler other_env("spv1.3", false, nullptr);
+  EXPECT_NE(key, other_env.GetCacheKey(&shader_info));
+
+  ShaderCompiler no_validation("spv1.0", true, nullptr);
+  EXPECT_NE(key, no_validation.GetCacheKey(&shader_info));
+
+  Pipeline::ShaderInfo other_entry_point(shader_info);
+  other_entry_point.SetEntryPoint("other");
+  EXPECT_NE(key, sc.GetCacheKey(&other_entry_point));
+
+  Pipeline::ShaderInfo optimized(shader_info);
+  optimized.SetShaderOptimizations({"--eliminate-dead-code-aggressive"});
+  EXPECT_NE(key, sc.GetCacheKey(&optimized));
+
+  Shader other_source(kShaderTypeVertex);
+  other_source.SetFormat(kShaderFormatSpirvHex);
+  other_source.SetData(std::string(kHexShader) + " 0x00 0x00 0x00 0x00");
+  Pipeline::ShaderInfo other_source_info(&other_source, kShaderTypeVertex);
+  EXPECT_NE(key, sc.GetCacheKey(&other_source_info));
+}
+
+#if AMBER_ENABLE_DXC
+TEST_F(ShaderCompilerTest, CacheKeyCoversDxcVersion) {
+  const std::string version = dxchelper::GetVersion();
+  ASSERT_FALSE(version.empty());
+
+  Shader shader(kShaderTypeVertex);
+  shader.SetFormat(kShaderFormatSpirvHex);
+  shader.SetData(kHexShader);
+  Pipeline::ShaderInfo shader_info(&shader, kShaderTypeVertex);
+
+  ShaderCompiler sc("spv1.0", false, nullptr);
+  EXPECT_NE(std::string::npos,
+            sc.GetCacheKey(&shader_info).find("dxc:" + version));
+}
+#endif  // AMBER_ENABLE_DXC
+
+TEST_F(ShaderCompilerTest, CompileUsesShaderCache) {
+  Shader shader(kShaderTypeVertex);
+  shader.SetName("CachedShader");
+  shader.SetFormat(kShaderFormatSpirvHex);
+  shader.SetData(kHexShader);
+  Pipeline::ShaderInfo shader_info(&shader, kShaderTypeCompute);
+  Pipeline pipeline(PipelineType::kCompute);
+
+  ShaderCompiler sc;
+  std::remove((testing::TempDir() +
+               ShaderCache::GetFileName(sc.GetCacheKey(&shader_info)))
+                  .c_str());
+
+  ShaderCache cache(testing::TempDir());
+  sc.SetShaderCache(&cache);
+
+  Result r;
+  std::vector<uint32_t> compiled;
+  std::tie(r, compiled) = sc.Compile(&pipeline, &shader_info, ShaderMap());
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  std::vector<uint32_t> cached;
+  std::tie(r, cached) = sc.Compile(&pipeline, &shader_info, ShaderMap());
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+  EXPECT_EQ(compiled, cached);
+
+  ShaderCacheStats stats = cache.GetStats();
+  EXPECT_EQ(1U, stats.hits);
+  EXPECT_EQ(1U, stats.misses);
+  EXPECT_EQ(compiled.size() * sizeof(uint32_t), stats.bytes_saved);
+}
+
 TEST_F(ShaderCompilerTest, FailsOnInvalidShader) {
   std::string contents = "Just Random\nText()\nThat doesn't work.";
 
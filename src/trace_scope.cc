@@ -0,0 +1,47 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/trace_scope.h"
+
+namespace amber {
+
+TraceScope::TraceScope(Delegate* delegate,
+                       const char* category,
+                       const char* name,
+                       uint32_t line) {
+  if (IsEnabled(delegate)) {
+    span_.name = name;
+    Start(delegate, category, line);
+  }
+}
+
+void TraceScope::Start(Delegate* delegate,
+                       const char* category,
+                       uint32_t line) {
+  delegate_ = delegate;
+  span_.category = category;
+  span_.line = line;
+  span_.start_ns = delegate->GetTimestampNs();
+}
+
+TraceScope::~TraceScope() {
+  if (!delegate_) {
+    return;
+  }
+
+  span_.end_ns = delegate_->GetTimestampNs();
+  delegate_->ReportTraceSpan(span_);
+}
+
+}  // namespace amber
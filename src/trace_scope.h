@@ -0,0 +1,67 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_TRACE_SCOPE_H_
+#define SRC_TRACE_SCOPE_H_
+
+#include <cstdint>
+#include <string>
+
+#include "amber/amber.h"
+
+namespace amber {
+
+/// Reports the time from its construction to its destruction as a trace span
+/// through the delegate. Does nothing unless the delegate has tracing
+/// enabled, so it is cheap to place around any phase worth profiling. Names
+/// which have to be built are passed as a function, which is only called
+/// when tracing is enabled.
+class TraceScope {
+ public:
+  /// Starts a span named |name| in |category| for script line |line|, or 0
+  /// if the span belongs to no line. The |delegate| may be null.
+  TraceScope(Delegate* delegate,
+             const char* category,
+             const char* name,
+             uint32_t line);
+  /// Starts a span named by the string |make_name| returns.
+  template <typename MakeName>
+  TraceScope(Delegate* delegate,
+             const char* category,
+             MakeName make_name,
+             uint32_t line) {
+    if (IsEnabled(delegate)) {
+      span_.name = make_name();
+      Start(delegate, category, line);
+    }
+  }
+  ~TraceScope();
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+ private:
+  static bool IsEnabled(Delegate* delegate) {
+    return delegate && delegate->TraceEnabled();
+  }
+  void Start(Delegate* delegate, const char* category, uint32_t line);
+
+  /// Null if tracing is disabled.
+  Delegate* delegate_ = nullptr;
+  TraceSpan span_;
+};
+
+}  // namespace amber
+
+#endif  // SRC_TRACE_SCOPE_H_
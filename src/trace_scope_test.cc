@@ -0,0 +1,113 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/trace_scope.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace amber {
+namespace {
+
+class TraceDelegate : public Delegate {
+ public:
+  TraceDelegate() = default;
+  ~TraceDelegate() override = default;
+
+  void Log(const std::string&) override {}
+  bool LogGraphicsCalls() const override { return false; }
+  bool LogGraphicsCallsTime() const override { return false; }
+  uint64_t GetTimestampNs() const override { return ++timestamp_; }
+  bool LogExecuteCalls() const override { return false; }
+  Result LoadBufferData(const std::string,
+                        BufferDataFileType,
+                        BufferInfo*) const override {
+    return Result("TraceDelegate::LoadBufferData not implemented");
+  }
+  Result LoadFile(const std::string, std::vector<char>*) const override {
+    return Result("TraceDelegate::LoadFile not implemented");
+  }
+
+  bool TraceEnabled() const override { return trace_enabled_; }
+  void SetTraceEnabled(bool trace_enabled) { trace_enabled_ = trace_enabled; }
+  void ReportTraceSpan(const TraceSpan& span) override {
+    spans_.push_back(span);
+  }
+
+  const std::vector<TraceSpan>& GetSpans() const { return spans_; }
+
+ private:
+  mutable uint64_t timestamp_ = 0;
+  bool trace_enabled_ = false;
+  std::vector<TraceSpan> spans_;
+};
+
+}  // namespace
+
+using TraceScopeTest = testing::Test;
+
+TEST_F(TraceScopeTest, ReportsNestedSpans) {
+  TraceDelegate delegate;
+  delegate.SetTraceEnabled(true);
+  {
+    TraceScope outer(&delegate, "command", "RepeatCommand", 3);
+    { TraceScope inner(&delegate, "submit", "vkQueueSubmit", 0); }
+  }
+
+  const auto& spans = delegate.GetSpans();
+  ASSERT_EQ(2U, spans.size());
+  EXPECT_EQ("vkQueueSubmit", spans[0].name);
+  EXPECT_EQ("submit", spans[0].category);
+  EXPECT_EQ(0U, spans[0].line);
+  EXPECT_EQ("RepeatCommand", spans[1].name);
+  EXPECT_EQ("command", spans[1].category);
+  EXPECT_EQ(3U, spans[1].line);
+
+  EXPECT_LT(spans[1].start_ns, spans[0].start_ns);
+  EXPECT_LT(spans[0].start_ns, spans[0].end_ns);
+  EXPECT_LT(spans[0].end_ns, spans[1].end_ns);
+}
+
+TEST_F(TraceScopeTest, DisabledReportsNothing) {
+  TraceDelegate delegate;
+  { TraceScope trace(&delegate, "command", "ComputeCommand", 1); }
+  EXPECT_TRUE(delegate.GetSpans().empty());
+
+  TraceScope trace(nullptr, "command", "ComputeCommand", 1);
+}
+
+TEST_F(TraceScopeTest, BuildsNamesOnlyWhenEnabled) {
+  TraceDelegate delegate;
+  uint32_t built = 0;
+  auto make_name = [&built]() {
+    ++built;
+    return std::string("my_pipeline");
+  };
+
+  { TraceScope trace(&delegate, "pipeline", make_name, 4); }
+  { TraceScope trace(nullptr, "pipeline", make_name, 4); }
+  EXPECT_EQ(0U, built);
+  EXPECT_TRUE(delegate.GetSpans().empty());
+
+  delegate.SetTraceEnabled(true);
+  { TraceScope trace(&delegate, "pipeline", make_name, 4); }
+  EXPECT_EQ(1U, built);
+  ASSERT_EQ(1U, delegate.GetSpans().size());
+  EXPECT_EQ("my_pipeline", delegate.GetSpans()[0].name);
+  EXPECT_EQ(4U, delegate.GetSpans()[0].line);
+}
+
+}  // namespace amber
@@ -66,6 +66,11 @@ class VirtualFileStore {
     return {};
   }
 
+  /// Returns all virtual files, keyed by their canonical path.
+  const std::unordered_map<std::string, std::string>& GetFiles() const {
+    return files_by_path_;
+  }
+
  private:
   std::unordered_map<std::string, std::string> files_by_path_;
 };
@@ -146,6 +146,7 @@ Result Parser::ProcessShaderBlock(const SectionParser::Section& section) {
   auto shader = std::make_unique<Shader>(section.shader_type);
   // Generate a unique name for the shader.
   shader->SetName("vk_shader_" + std::to_string(script_->GetShaders().size()));
+  shader->SetLine(section.starting_line_number);
   shader->SetFormat(section.format);
   shader->SetData(section.contents);
 
@@ -38,7 +38,8 @@ Result BufferBackedDescriptor::RecordCopyBufferDataToTransferResourceIfNeeded(
     CommandBuffer* command_buffer,
     Buffer* buffer,
     Resource* transfer_resource) {
-  transfer_resource->UpdateMemoryWithRawData(*buffer->ValuePtr());
+  const Buffer* host = buffer;
+  transfer_resource->UpdateMemoryWithRawData(*host->ValuePtr());
   // If the resource is read-only, keep the buffer data; Amber won't copy
   // read-only resources back into the host buffers, so it makes sense to
   // leave the buffer intact.
@@ -20,6 +20,7 @@
 
 #include "src/vulkan/command_buffer.h"
 #include "src/vulkan/device.h"
+#include "src/vulkan/resident_buffers.h"
 
 namespace amber {
 namespace vulkan {
@@ -40,10 +41,7 @@ BufferDescriptor::BufferDescriptor(Buffer* buffer,
 BufferDescriptor::~BufferDescriptor() = default;
 
 Result BufferDescriptor::CreateResourceIfNeeded() {
-  auto& transfer_resources = pipeline_->GetDescriptorTransferResources();
-
-  VkBufferUsageFlags flags =
-      VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  VkBufferUsageFlags flags = 0;
   if (IsUniformBuffer() || IsUniformBufferDynamic()) {
     flags |= VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
   } else if (IsStorageBuffer() || IsStorageBufferDynamic()) {
@@ -56,31 +54,12 @@ Result BufferDescriptor::CreateResourceIfNeeded() {
     return Result("Unexpected buffer type when deciding usage flags");
   }
 
+  // The device copies are shared with the other pipelines, which may bind
+  // the same buffers in other ways. They are created by the pipeline once
+  // every descriptor added its flags.
   for (const auto& amber_buffer : GetAmberBuffers()) {
-    // Create (but don't initialize) the transfer buffer if not already created.
-    if (transfer_resources.count(amber_buffer) == 0) {
-      auto size_in_bytes =
-          static_cast<uint32_t>(amber_buffer->ValuePtr()->size());
-      auto transfer_buffer = std::make_unique<TransferBuffer>(
-          device_, size_in_bytes, amber_buffer->GetFormat());
-      transfer_buffer->SetReadOnly(IsReadOnly());
-      transfer_resources[amber_buffer] = std::move(transfer_buffer);
-    } else {
-      // Unset transfer buffer's read only property if needed.
-      if (!IsReadOnly()) {
-        transfer_resources[amber_buffer]->SetReadOnly(false);
-      }
-    }
-
-    // Update the buffer create flags.
-    Result r =
-        transfer_resources[amber_buffer]->AsTransferBuffer()->AddUsageFlags(
-            flags);
-    if (!r.IsSuccess()) {
-      return r;
-    }
+    pipeline_->GetResidentBuffers()->AddUsageFlags(amber_buffer, flags);
   }
-  is_descriptor_set_update_needed_ = true;
 
   descriptor_offsets_.reserve(GetAmberBuffers().size());
   descriptor_ranges_.reserve(GetAmberBuffers().size());
@@ -88,20 +67,21 @@ Result BufferDescriptor::CreateResourceIfNeeded() {
   return {};
 }
 
-void BufferDescriptor::UpdateDescriptorSetIfNeeded(
-    VkDescriptorSet descriptor_set) {
-  if (!is_descriptor_set_update_needed_) {
-    return;
-  }
+bool BufferDescriptor::IsDescriptorSetUpdateNeeded() const {
+  // The descriptor set refers to the device copies, so it only has to be
+  // written again once any of them was recreated.
+  return written_generation_ !=
+         pipeline_->GetResidentBuffers()->GetGeneration();
+}
 
-  std::vector<VkDescriptorBufferInfo> buffer_infos;
-  std::vector<VkBufferView> buffer_views;
+void BufferDescriptor::WriteDescriptorInfos(void* infos) {
+  auto* buffer_infos = static_cast<VkDescriptorBufferInfo*>(infos);
+  auto* buffer_views = static_cast<VkBufferView*>(infos);
 
-  // Create VkDescriptorBufferInfo for every descriptor buffer.
+  // Describe every descriptor buffer.
   for (uint32_t i = 0; i < GetAmberBuffers().size(); i++) {
-    const auto& buffer =
-        pipeline_->GetDescriptorTransferResources()[GetAmberBuffers()[i]]
-            ->AsTransferBuffer();
+    const auto* buffer = pipeline_->GetResidentBuffers()->GetTransferBuffer(
+        GetAmberBuffers()[i]);
     assert(buffer->GetVkBuffer() && "Unexpected descriptor type");
     // Add buffer infos for uniform and storage buffers.
     if (IsUniformBuffer() || IsUniformBufferDynamic() || IsStorageBuffer() ||
@@ -124,27 +104,17 @@ void BufferDescriptor::UpdateDescriptorSetIfNeeded(
       buffer_info.offset = descriptor_offsets_[i];
       buffer_info.range = range;
 
-      buffer_infos.push_back(buffer_info);
+      buffer_infos[i] = buffer_info;
     }
 
     if (IsUniformTexelBuffer() || IsStorageTexelBuffer()) {
-      buffer_views.push_back(*buffer->GetVkBufferView());
+      buffer_views[i] = *buffer->GetVkBufferView();
     }
   }
+}
 
-  VkWriteDescriptorSet write = VkWriteDescriptorSet();
-  write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-  write.dstSet = descriptor_set;
-  write.dstBinding = binding_;
-  write.dstArrayElement = 0;
-  write.descriptorCount = static_cast<uint32_t>(GetAmberBuffers().size());
-  write.descriptorType = GetVkDescriptorType();
-  write.pBufferInfo = buffer_infos.data();
-  write.pTexelBufferView = buffer_views.data();
-
-  device_->GetPtrs()->vkUpdateDescriptorSets(device_->GetVkDevice(), 1, &write,
-                                             0, nullptr);
-  is_descriptor_set_update_needed_ = false;
+void BufferDescriptor::MarkDescriptorSetUpdated() {
+  written_generation_ = pipeline_->GetResidentBuffers()->GetGeneration();
 }
 
 }  // namespace vulkan
@@ -47,7 +47,9 @@ class BufferDescriptor : public BufferBackedDescriptor {
                    vulkan::Pipeline* pipeline);
   ~BufferDescriptor() override;
 
-  void UpdateDescriptorSetIfNeeded(VkDescriptorSet descriptor_set) override;
+  bool IsDescriptorSetUpdateNeeded() const override;
+  void WriteDescriptorInfos(void* infos) override;
+  void MarkDescriptorSetUpdated() override;
   Result CreateResourceIfNeeded() override;
   std::vector<uint32_t> GetDynamicOffsets() override {
     return dynamic_offsets_;
@@ -72,6 +74,8 @@ class BufferDescriptor : public BufferBackedDescriptor {
   std::vector<uint32_t> dynamic_offsets_;
   std::vector<VkDeviceSize> descriptor_offsets_;
   std::vector<VkDeviceSize> descriptor_ranges_;
+  /// The ResidentBuffers generation the descriptor set was last written at.
+  uint64_t written_generation_ = 0;
 };
 
 }  // namespace vulkan
@@ -14,59 +14,108 @@
 
 #include "src/vulkan/command_buffer.h"
 
+#include <algorithm>
 #include <cassert>
-#include <string>
+#include <vector>
 
+#include "src/trace_scope.h"
 #include "src/vulkan/command_pool.h"
 #include "src/vulkan/device.h"
 
 namespace amber {
 namespace vulkan {
 
-CommandBuffer::CommandBuffer(Device* device, CommandPool* pool)
-    : device_(device), pool_(pool) {}
+CommandBuffer::CommandBuffer(Device* device, CommandPool* pool, bool reusable)
+    : reusable_(reusable), device_(device), pool_(pool) {}
 
 CommandBuffer::~CommandBuffer() {
   Reset();
 
-  if (fence_ != VK_NULL_HANDLE) {
-    device_->GetPtrs()->vkDestroyFence(device_->GetVkDevice(), fence_, nullptr);
-  }
+  for (auto& slot : slots_) {
+    // The command buffer and fence must not be in use when they are freed.
+    if (slot.pending) {
+      device_->WaitForFence(slot.fence, slot.timeout_ms);
+    }
 
-  if (command_ != VK_NULL_HANDLE) {
-    device_->GetPtrs()->vkFreeCommandBuffers(
-        device_->GetVkDevice(), pool_->GetVkCommandPool(), 1, &command_);
+    if (slot.fence != VK_NULL_HANDLE) {
+      device_->ForgetSubmission(slot.fence);
+      device_->GetPtrs()->vkDestroyFence(device_->GetVkDevice(), slot.fence,
+                                         nullptr);
+    }
+
+    if (slot.command != VK_NULL_HANDLE) {
+      device_->GetPtrs()->vkFreeCommandBuffers(
+          device_->GetVkDevice(), pool_->GetVkCommandPool(), 1, &slot.command);
+    }
   }
 }
 
 Result CommandBuffer::Initialize() {
-  VkCommandBufferAllocateInfo command_info = VkCommandBufferAllocateInfo();
-  command_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-  command_info.commandPool = pool_->GetVkCommandPool();
-  command_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-  command_info.commandBufferCount = 1;
-
-  if (device_->GetPtrs()->vkAllocateCommandBuffers(
-          device_->GetVkDevice(), &command_info, &command_) != VK_SUCCESS) {
-    return Result("Vulkan::Calling vkAllocateCommandBuffers Fail");
-  }
+  for (auto& slot : slots_) {
+    VkCommandBufferAllocateInfo command_info = VkCommandBufferAllocateInfo();
+    command_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    command_info.commandPool = pool_->GetVkCommandPool();
+    command_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    command_info.commandBufferCount = 1;
+
+    if (device_->GetPtrs()->vkAllocateCommandBuffers(
+            device_->GetVkDevice(), &command_info, &slot.command) !=
+        VK_SUCCESS) {
+      return Result("Vulkan::Calling vkAllocateCommandBuffers Fail");
+    }
 
-  VkFenceCreateInfo fence_info = VkFenceCreateInfo();
-  fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-  if (device_->GetPtrs()->vkCreateFence(device_->GetVkDevice(), &fence_info,
-                                        nullptr, &fence_) != VK_SUCCESS) {
-    return Result("Vulkan::Calling vkCreateFence Fail");
+    VkFenceCreateInfo fence_info = VkFenceCreateInfo();
+    fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    if (device_->GetPtrs()->vkCreateFence(device_->GetVkDevice(), &fence_info,
+                                          nullptr, &slot.fence) != VK_SUCCESS) {
+      return Result("Vulkan::Calling vkCreateFence Fail");
+    }
   }
 
   return {};
 }
 
+VkCommandBuffer CommandBuffer::GetVkCommandBuffer() const {
+  if (IsRedirected()) {
+    return device_->GetCaptureCommandBuffer()->GetVkCommandBuffer();
+  }
+  return slots_[current_slot_].command;
+}
+
+bool CommandBuffer::IsRedirected() const {
+  const CommandBuffer* capture = device_->GetCaptureCommandBuffer();
+  return capture != nullptr && capture != this;
+}
+
 Result CommandBuffer::BeginRecording() {
+  if (IsRedirected()) {
+    // The capturing command buffer is already recording.
+    guarded_ = true;
+    redirected_ = true;
+    return {};
+  }
+
+  Slot& slot = slots_[current_slot_];
+  if (slot.pending) {
+    Result r = device_->WaitForFence(slot.fence, slot.timeout_ms);
+    if (!r.IsSuccess()) {
+      return r;
+    }
+    slot.pending = false;
+
+    if (device_->GetPtrs()->vkResetCommandBuffer(slot.command, 0) !=
+        VK_SUCCESS) {
+      return Result("Vulkan::Calling vkResetCommandBuffer Fail");
+    }
+  }
+
   VkCommandBufferBeginInfo command_begin_info = VkCommandBufferBeginInfo();
   command_begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-  command_begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-  if (device_->GetPtrs()->vkBeginCommandBuffer(command_, &command_begin_info) !=
-      VK_SUCCESS) {
+  command_begin_info.flags = reusable_
+                                 ? VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT
+                                 : VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  if (device_->GetPtrs()->vkBeginCommandBuffer(
+          slot.command, &command_begin_info) != VK_SUCCESS) {
     return Result("Vulkan::Calling vkBeginCommandBuffer Fail");
   }
   guarded_ = true;
@@ -75,55 +124,56 @@ Result CommandBuffer::BeginRecording() {
 }
 
 Result CommandBuffer::SubmitAndReset(uint32_t timeout_ms,
-                                     bool pipeline_runtime_layer_enabled) {
-  if (device_->GetPtrs()->vkEndCommandBuffer(command_) != VK_SUCCESS) {
+                                     bool pipeline_runtime_layer_enabled,
+                                     uint32_t submit_count) {
+  if (redirected_) {
+    // The commands are submitted with the capturing command buffer.
+    guarded_ = false;
+    redirected_ = false;
+    return {};
+  }
+
+  Slot& slot = slots_[current_slot_];
+  if (device_->GetPtrs()->vkEndCommandBuffer(slot.command) != VK_SUCCESS) {
     return Result("Vulkan::Calling vkEndCommandBuffer Fail");
   }
 
-  if (device_->GetPtrs()->vkResetFences(device_->GetVkDevice(), 1, &fence_) !=
-      VK_SUCCESS) {
+  device_->ForgetSubmission(slot.fence);
+  if (device_->GetPtrs()->vkResetFences(device_->GetVkDevice(), 1,
+                                        &slot.fence) != VK_SUCCESS) {
     return Result("Vulkan::Calling vkResetFences Fail");
   }
 
   VkSubmitInfo submit_info = VkSubmitInfo();
   submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
   submit_info.commandBufferCount = 1;
-  submit_info.pCommandBuffers = &command_;
-
-  if (device_->GetPtrs()->vkQueueSubmit(device_->GetVkQueue(), 1, &submit_info,
-                                        fence_) != VK_SUCCESS) {
-    return Result("Vulkan::Calling vkQueueSubmit Fail");
+  submit_info.pCommandBuffers = &slot.command;
+  std::vector<VkSubmitInfo> submit_infos(
+      std::min(submit_count, kMaxSubmitsPerCall), submit_info);
+
+  {
+    TraceScope trace(device_->GetDelegate(), "submit", "vkQueueSubmit", 0);
+    // Only the last call signals the fence. A fence signaled by
+    // vkQueueSubmit also waits for everything submitted before it, so it
+    // still covers all the submissions.
+    uint32_t remaining = submit_count;
+    do {
+      const uint32_t count = std::min(remaining, kMaxSubmitsPerCall);
+      remaining -= count;
+      const VkFence fence = remaining == 0 ? slot.fence : VK_NULL_HANDLE;
+      if (device_->GetPtrs()->vkQueueSubmit(device_->GetVkQueue(), count,
+                                            submit_infos.data(),
+                                            fence) != VK_SUCCESS) {
+        return Result("Vulkan::Calling vkQueueSubmit Fail");
+      }
+    } while (remaining > 0);
   }
 
   guarded_ = false;
-
-  const uint64_t timeout_ns =
-      timeout_ms == static_cast<uint32_t>(~0u)  // honor 32bit infinity
-          ? ~0ull
-          : static_cast<uint64_t>(timeout_ms) * 1000ULL * 1000ULL;
-  VkResult r = device_->GetPtrs()->vkWaitForFences(
-      device_->GetVkDevice(), 1, &fence_, VK_TRUE, timeout_ns);
-  if (r == VK_TIMEOUT) {
-    return Result("Vulkan::Calling vkWaitForFences Timeout");
-  }
-  if (r != VK_SUCCESS) {
-    std::string result_str;
-    switch (r) {
-      case VK_ERROR_OUT_OF_HOST_MEMORY:
-        result_str = "OUT_OF_HOST_MEMORY";
-        break;
-      case VK_ERROR_OUT_OF_DEVICE_MEMORY:
-        result_str = "OUT_OF_DEVICE_MEMORY";
-        break;
-      case VK_ERROR_DEVICE_LOST:
-        result_str = "DEVICE_LOST";
-        break;
-      default:
-        result_str = "<UNEXPECTED RESULT>";
-        break;
-    }
-    return Result("Vulkan::Calling vkWaitForFences Fail (" + result_str + ")");
-  }
+  slot.pending = true;
+  slot.timeout_ms = timeout_ms;
+  device_->SetLastSubmission(slot.fence, timeout_ms);
+  current_slot_ = (current_slot_ + 1) % kSlotCount;
 
   /*
 google/vulkan-performance-layers requires a call to vkDeviceWaitIdle or
@@ -132,21 +182,23 @@ able to use that layer in conjunction with Amber we need to somehow
 communicate that the Amber script has completed.
 */
   if (pipeline_runtime_layer_enabled) {
+    Result r = device_->WaitForSubmissions();
+    if (!r.IsSuccess()) {
+      return r;
+    }
     device_->GetPtrs()->vkQueueWaitIdle(device_->GetVkQueue());
   }
 
-  if (device_->GetPtrs()->vkResetCommandBuffer(command_, 0) != VK_SUCCESS) {
-    return Result("Vulkan::Calling vkResetCommandBuffer Fail");
-  }
-
   return {};
 }
 
 void CommandBuffer::Reset() {
-  if (guarded_) {
-    device_->GetPtrs()->vkResetCommandBuffer(command_, 0);
-    guarded_ = false;
+  if (guarded_ && !redirected_) {
+    device_->GetPtrs()->vkResetCommandBuffer(
+        slots_[current_slot_].command, 0);
   }
+  guarded_ = false;
+  redirected_ = false;
 }
 
 CommandBufferGuard::CommandBufferGuard(CommandBuffer* buffer)
@@ -164,7 +216,17 @@ CommandBufferGuard::~CommandBufferGuard() {
 Result CommandBufferGuard::Submit(uint32_t timeout_ms,
                                   bool pipeline_runtime_layer_enabled) {
   assert(buffer_->guarded_);
-  return buffer_->SubmitAndReset(timeout_ms, pipeline_runtime_layer_enabled);
+  return buffer_->SubmitAndReset(timeout_ms, pipeline_runtime_layer_enabled,
+                                 1);
+}
+
+Result CommandBufferGuard::SubmitRepeatedly(uint32_t timeout_ms,
+                                            bool pipeline_runtime_layer_enabled,
+                                            uint32_t submit_count) {
+  assert(buffer_->guarded_);
+  assert(buffer_->reusable_ || submit_count == 1);
+  return buffer_->SubmitAndReset(timeout_ms, pipeline_runtime_layer_enabled,
+                                 submit_count);
 }
 
 }  // namespace vulkan
@@ -15,6 +15,8 @@
 #ifndef SRC_VULKAN_COMMAND_BUFFER_H_
 #define SRC_VULKAN_COMMAND_BUFFER_H_
 
+#include <array>
+
 #include "amber/result.h"
 #include "amber/vulkan_header.h"
 
@@ -34,30 +36,65 @@ class CommandBufferGuard;
 class CommandPool;
 class Device;
 
-/// Wrapper around a Vulkan command buffer. This is designed to not be used
-/// directly, but should always be used through the `CommandBufferGuard` class.
+/// Wrapper around a ring of Vulkan command buffers. This is designed to not
+/// be used directly, but should always be used through the
+/// `CommandBufferGuard` class.
+///
+/// Submitting does not wait for the work to complete. Recording continues in
+/// the next command buffer of the ring, which is only waited for when the
+/// ring comes back to it. Callers wait with `Device::WaitForSubmissions()`
+/// before the host uses the results.
+///
+/// While the device captures commands, see
+/// `Device::SetCaptureCommandBuffer()`, every other command buffer records
+/// into the capturing one, and submitting them does nothing.
 class CommandBuffer {
  public:
-  CommandBuffer(Device* device, CommandPool* pool);
+  /// A |reusable| command buffer may be submitted more than once, see
+  /// `CommandBufferGuard::SubmitRepeatedly()`.
+  CommandBuffer(Device* device, CommandPool* pool, bool reusable = false);
   ~CommandBuffer();
 
   Result Initialize();
-  VkCommandBuffer GetVkCommandBuffer() const { return command_; }
+  /// Returns the command buffer being recorded.
+  VkCommandBuffer GetVkCommandBuffer() const;
 
  private:
   friend CommandBufferGuard;
 
+  /// The number of command buffers in flight at most.
+  static constexpr size_t kSlotCount = 3;
+  /// The number of submissions passed to one vkQueueSubmit at most.
+  static constexpr uint32_t kMaxSubmitsPerCall = 64;
+
+  struct Slot {
+    VkCommandBuffer command = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+    /// True from the submission of |command| until its fence was waited on.
+    bool pending = false;
+    uint32_t timeout_ms = 0;
+  };
+
+  /// Returns true if the commands are recorded into the capturing command
+  /// buffer of the device instead.
+  bool IsRedirected() const;
+
   Result BeginRecording();
   Result SubmitAndReset(uint32_t timeout_ms,
-                        bool pipeline_runtime_layer_enabled);
+                        bool pipeline_runtime_layer_enabled,
+                        uint32_t submit_count);
   void Reset();
 
   bool guarded_ = false;
+  /// True if |guarded_| was set while the commands were redirected, so
+  /// nothing was begun in the own command buffers.
+  bool redirected_ = false;
+  bool reusable_ = false;
 
   Device* device_ = nullptr;
   CommandPool* pool_ = nullptr;
-  VkCommandBuffer command_ = VK_NULL_HANDLE;
-  VkFence fence_ = VK_NULL_HANDLE;
+  std::array<Slot, kSlotCount> slots_;
+  size_t current_slot_ = 0;
 };
 
 /// Wrapper around a `CommandBuffer`.
@@ -83,8 +120,15 @@ class CommandBufferGuard {
   /// Returns the result object if the command buffer recording failed.
   Result GetResult() { return result_; }
 
-  /// Submits and resets the internal command buffer.
+  /// Submits the internal command buffer without waiting for it, unless
+  /// |pipeline_runtime_layer_enabled| is true.
   Result Submit(uint32_t timeout_ms, bool pipeline_runtime_layer_enabled);
+  /// Submits the internal command buffer |submit_count| times, like
+  /// Submit(). The submissions are split across as many vkQueueSubmit calls
+  /// as needed. The command buffer must be reusable.
+  Result SubmitRepeatedly(uint32_t timeout_ms,
+                          bool pipeline_runtime_layer_enabled,
+                          uint32_t submit_count);
 
  private:
   Result result_;
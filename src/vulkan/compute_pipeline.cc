@@ -13,7 +13,9 @@
 // limitations under the License.
 
 #include "src/vulkan/compute_pipeline.h"
+
 #include <cstdint>
+#include <string>
 
 #include "src/vulkan/command_pool.h"
 #include "src/vulkan/device.h"
@@ -60,31 +62,70 @@ Result ComputePipeline::CreateVkComputePipeline(
   pipeline_info.layout = pipeline_layout;
 
   if (device_->GetPtrs()->vkCreateComputePipelines(
-          device_->GetVkDevice(), VK_NULL_HANDLE, 1, &pipeline_info, nullptr,
-          pipeline) != VK_SUCCESS) {
+          device_->GetVkDevice(), device_->GetVkPipelineCache(), 1,
+          &pipeline_info, nullptr, pipeline) != VK_SUCCESS) {
     return Result("Vulkan::Calling vkCreateComputePipelines Fail");
   }
 
   return {};
 }
 
-Result ComputePipeline::Compute(uint32_t x,
-                                uint32_t y,
-                                uint32_t z,
-                                bool is_timed_execution) {
-  Result r = SendDescriptorDataToDeviceIfNeeded();
+Result ComputePipeline::CreateVkComputePipelineIfNeeded() {
+  bool layout_changed = false;
+  Result r = CreateVkPipelineLayoutIfNeeded(&layout_changed);
   if (!r.IsSuccess()) {
     return r;
   }
 
-  VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
-  r = CreateVkPipelineLayout(&pipeline_layout);
+  const std::string entry_point =
+      GetEntryPointName(VK_SHADER_STAGE_COMPUTE_BIT);
+  if (pipeline_ != VK_NULL_HANDLE && !layout_changed &&
+      entry_point == vk_pipeline_entry_point_) {
+    return {};
+  }
+
+  if (pipeline_ != VK_NULL_HANDLE) {
+    // Submitted dispatches may still use the old pipeline.
+    r = device_->WaitForSubmissions();
+    if (!r.IsSuccess()) {
+      return r;
+    }
+    device_->GetPtrs()->vkDestroyPipeline(device_->GetVkDevice(), pipeline_,
+                                          nullptr);
+    pipeline_ = VK_NULL_HANDLE;
+  }
+
+  VkPipeline pipeline = VK_NULL_HANDLE;
+  r = CreateVkComputePipeline(pipeline_layout_, &pipeline);
   if (!r.IsSuccess()) {
     return r;
   }
+  SetVkPipeline(pipeline);
 
-  VkPipeline pipeline = VK_NULL_HANDLE;
-  r = CreateVkComputePipeline(pipeline_layout, &pipeline);
+  vk_pipeline_entry_point_ = entry_point;
+  ++vk_pipeline_create_count_;
+
+  if (device_->LogExecuteCalls()) {
+    device_->Log("Vulkan: created compute pipeline for entry point '" +
+                 entry_point + "' (pipelines created: " +
+                 std::to_string(vk_pipeline_create_count_) + ")");
+  }
+
+  return {};
+}
+
+Result ComputePipeline::Compute(uint32_t x,
+                                uint32_t y,
+                                uint32_t z,
+                                bool is_timed_execution,
+                                bool is_pipeline_statistics,
+                                bool is_async) {
+  Result r = SendDescriptorDataToDeviceIfNeeded();
+  if (!r.IsSuccess()) {
+    return r;
+  }
+
+  r = CreateVkComputePipelineIfNeeded();
   if (!r.IsSuccess()) {
     return r;
   }
@@ -92,26 +133,40 @@ Result ComputePipeline::Compute(uint32_t x,
   // Note that a command updating a descriptor set and a command using
   // it must be submitted separately, because using a descriptor set
   // while updating it is not safe.
-  UpdateDescriptorSetsIfNeeded();
-  CreateTimingQueryObjectIfNeeded(is_timed_execution);
+  r = UpdateDescriptorSetsIfNeeded();
+  if (!r.IsSuccess()) {
+    return r;
+  }
+  r = AcquireTimingQueryIfNeeded(is_timed_execution);
+  if (!r.IsSuccess()) {
+    return r;
+  }
+  r = CreateStatisticsQueryIfNeeded(is_pipeline_statistics);
+  if (!r.IsSuccess()) {
+    return r;
+  }
+  bool overlaps = false;
   {
     CommandBufferGuard guard(GetCommandBuffer());
     if (!guard.IsRecording()) {
       return guard.GetResult();
     }
 
-    BindVkDescriptorSets(pipeline_layout);
+    overlaps = RecordDescriptorBufferUploads(is_async);
+    BindVkDescriptorSets(pipeline_layout_);
 
-    r = RecordPushConstant(pipeline_layout);
+    r = RecordPushConstant(pipeline_layout_);
     if (!r.IsSuccess()) {
       return r;
     }
 
     device_->GetPtrs()->vkCmdBindPipeline(command_->GetVkCommandBuffer(),
                                           VK_PIPELINE_BIND_POINT_COMPUTE,
-                                          pipeline);
+                                          pipeline_);
     BeginTimerQuery();
+    BeginStatisticsQuery();
     device_->GetPtrs()->vkCmdDispatch(command_->GetVkCommandBuffer(), x, y, z);
+    EndStatisticsQuery();
     EndTimerQuery();
 
     r = guard.Submit(GetFenceTimeout(), GetPipelineRuntimeLayerEnabled());
@@ -119,18 +174,13 @@ Result ComputePipeline::Compute(uint32_t x,
       return r;
     }
   }
-  DestroyTimingQueryObjectIfNeeded();
-  r = ReadbackDescriptorsToHostDataQueue();
+  AddSubmittedCommand(is_async, overlaps);
+  SubmitTimingQueryIfNeeded();
+  r = ReportStatisticsIfNeeded(is_pipeline_statistics);
   if (!r.IsSuccess()) {
     return r;
   }
-
-  device_->GetPtrs()->vkDestroyPipeline(device_->GetVkDevice(), pipeline,
-                                        nullptr);
-  device_->GetPtrs()->vkDestroyPipelineLayout(device_->GetVkDevice(),
-                                              pipeline_layout, nullptr);
-
-  return {};
+  return ReadbackDescriptorsToHostDataQueue();
 }
 
 }  // namespace vulkan
@@ -15,6 +15,7 @@
 #ifndef SRC_VULKAN_COMPUTE_PIPELINE_H_
 #define SRC_VULKAN_COMPUTE_PIPELINE_H_
 
+#include <string>
 #include <vector>
 
 #include "amber/result.h"
@@ -36,11 +37,24 @@ class ComputePipeline : public Pipeline {
 
   Result Initialize(CommandPool* pool);
 
-  Result Compute(uint32_t x, uint32_t y, uint32_t z, bool is_timed_execution);
+  Result Compute(uint32_t x,
+                 uint32_t y,
+                 uint32_t z,
+                 bool is_timed_execution,
+                 bool is_pipeline_statistics,
+                 bool is_async);
 
  private:
   Result CreateVkComputePipeline(const VkPipelineLayout& pipeline_layout,
                                  VkPipeline* pipeline);
+
+  /// Creates |pipeline_| and |pipeline_layout_| unless the existing ones were
+  /// built for the current entry point and push constant range. The shader
+  /// module and specialization constants are fixed for the pipeline lifetime.
+  Result CreateVkComputePipelineIfNeeded();
+
+  std::string vk_pipeline_entry_point_;
+  uint32_t vk_pipeline_create_count_ = 0;
 };
 
 }  // namespace vulkan
@@ -63,5 +63,22 @@ VkDescriptorType Descriptor::GetVkDescriptorType() const {
   }
 }
 
+size_t Descriptor::GetDescriptorInfoSize() const {
+  switch (type_) {
+    case DescriptorType::kStorageBuffer:
+    case DescriptorType::kStorageBufferDynamic:
+    case DescriptorType::kUniformBuffer:
+    case DescriptorType::kUniformBufferDynamic:
+      return sizeof(VkDescriptorBufferInfo);
+    case DescriptorType::kUniformTexelBuffer:
+    case DescriptorType::kStorageTexelBuffer:
+      return sizeof(VkBufferView);
+    case DescriptorType::kTLAS:
+      return sizeof(VkAccelerationStructureKHR);
+    default:
+      return sizeof(VkDescriptorImageInfo);
+  }
+}
+
 }  // namespace vulkan
 }  // namespace amber
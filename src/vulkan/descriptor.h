@@ -59,7 +59,16 @@ class Descriptor {
              uint32_t binding);
   virtual ~Descriptor();
 
-  virtual void UpdateDescriptorSetIfNeeded(VkDescriptorSet descriptor_set) = 0;
+  /// Returns true if the descriptor set no longer holds what
+  /// WriteDescriptorInfos() would write. The set must not be in use by
+  /// submitted work when it is written again.
+  virtual bool IsDescriptorSetUpdateNeeded() const { return true; }
+  /// Writes the GetDescriptorCount() structures describing the descriptors
+  /// to |infos|, each GetDescriptorInfoSize() bytes, as descriptor update
+  /// templates and vkUpdateDescriptorSets read them.
+  virtual void WriteDescriptorInfos(void* infos) = 0;
+  /// Records that the descriptor set was written from WriteDescriptorInfos().
+  virtual void MarkDescriptorSetUpdated() {}
   virtual Result CreateResourceIfNeeded() = 0;
   virtual uint32_t GetDescriptorCount() { return 1; }
   virtual std::vector<uint32_t> GetDynamicOffsets() { return {}; }
@@ -73,6 +82,10 @@ class Descriptor {
   uint32_t GetDescriptorSet() const { return descriptor_set_; }
   uint32_t GetBinding() const { return binding_; }
   VkDescriptorType GetVkDescriptorType() const;
+  /// Returns the size of the structure describing one descriptor of this
+  /// type: a VkDescriptorBufferInfo, VkDescriptorImageInfo, VkBufferView or
+  /// VkAccelerationStructureKHR.
+  size_t GetDescriptorInfoSize() const;
   DescriptorType GetDescriptorType() const { return type_; }
 
   bool IsStorageBuffer() const {
@@ -0,0 +1,171 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/vulkan/descriptor_set_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "src/vulkan/device.h"
+
+namespace amber {
+namespace vulkan {
+namespace {
+
+uint32_t* FindCount(std::vector<VkDescriptorPoolSize>* sizes,
+                    VkDescriptorType type) {
+  for (auto& size : *sizes) {
+    if (size.type == type) {
+      return &size.descriptorCount;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+DescriptorSetPool::DescriptorSetPool(Device* device) : device_(device) {}
+
+DescriptorSetPool::~DescriptorSetPool() {
+  for (auto& pool : pools_) {
+    device_->GetPtrs()->vkDestroyDescriptorPool(device_->GetVkDevice(),
+                                                pool.pool, nullptr);
+  }
+}
+
+bool DescriptorSetPool::HasRoom(
+    const Pool& pool,
+    const std::vector<VkDescriptorPoolSize>& sizes) {
+  if (pool.sets_left == 0) {
+    return false;
+  }
+  for (const auto& size : sizes) {
+    auto left = std::find_if(pool.sizes_left.begin(), pool.sizes_left.end(),
+                             [&size](const VkDescriptorPoolSize& s) {
+                               return s.type == size.type;
+                             });
+    if (left == pool.sizes_left.end() ||
+        left->descriptorCount < size.descriptorCount) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void DescriptorSetPool::Take(Pool* pool,
+                             const std::vector<VkDescriptorPoolSize>& sizes) {
+  --pool->sets_left;
+  for (const auto& size : sizes) {
+    *FindCount(&pool->sizes_left, size.type) -= size.descriptorCount;
+  }
+}
+
+void DescriptorSetPool::GiveBack(
+    Pool* pool,
+    const std::vector<VkDescriptorPoolSize>& sizes) {
+  ++pool->sets_left;
+  for (const auto& size : sizes) {
+    *FindCount(&pool->sizes_left, size.type) += size.descriptorCount;
+  }
+}
+
+Result DescriptorSetPool::CreatePool(
+    const std::vector<VkDescriptorPoolSize>& sizes) {
+  Pool pool;
+  pool.sets_left = kSetsPerPool;
+  for (const auto& size : sizes) {
+    pool.sizes_left.push_back(
+        {size.type, std::max(size.descriptorCount, kDescriptorsPerType)});
+  }
+
+  VkDescriptorPoolCreateInfo pool_info = VkDescriptorPoolCreateInfo();
+  pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+  pool_info.maxSets = pool.sets_left;
+  pool_info.poolSizeCount = static_cast<uint32_t>(pool.sizes_left.size());
+  pool_info.pPoolSizes = pool.sizes_left.data();
+
+  if (device_->GetPtrs()->vkCreateDescriptorPool(device_->GetVkDevice(),
+                                                 &pool_info, nullptr,
+                                                 &pool.pool) != VK_SUCCESS) {
+    return Result("Vulkan::Calling vkCreateDescriptorPool Fail");
+  }
+  pools_.push_back(std::move(pool));
+  return {};
+}
+
+Result DescriptorSetPool::Allocate(
+    VkDescriptorSetLayout layout,
+    const std::vector<VkDescriptorPoolSize>& sizes,
+    Allocation* allocation) {
+  VkDescriptorSetAllocateInfo desc_set_info = VkDescriptorSetAllocateInfo();
+  desc_set_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  desc_set_info.descriptorSetCount = 1;
+  desc_set_info.pSetLayouts = &layout;
+
+  // A pool may still be too fragmented for a set it has room for, in which
+  // case the next one is tried, and a new one as a last resort.
+  for (size_t i = 0; i <= pools_.size(); ++i) {
+    const bool is_new_pool = i == pools_.size();
+    if (is_new_pool) {
+      Result r = CreatePool(sizes);
+      if (!r.IsSuccess()) {
+        return r;
+      }
+    } else if (!HasRoom(pools_[i], sizes)) {
+      continue;
+    }
+
+    Pool& pool = pools_[i];
+    desc_set_info.descriptorPool = pool.pool;
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    if (device_->GetPtrs()->vkAllocateDescriptorSets(
+            device_->GetVkDevice(), &desc_set_info, &set) != VK_SUCCESS) {
+      if (is_new_pool) {
+        break;
+      }
+      continue;
+    }
+
+    Take(&pool, sizes);
+    allocated_[set] = sizes;
+    allocation->pool = pool.pool;
+    allocation->set = set;
+    return {};
+  }
+  return Result("Vulkan::Calling vkAllocateDescriptorSets Fail");
+}
+
+void DescriptorSetPool::Free(const Allocation& allocation) {
+  if (allocation.set == VK_NULL_HANDLE) {
+    return;
+  }
+
+  device_->GetPtrs()->vkFreeDescriptorSets(device_->GetVkDevice(),
+                                           allocation.pool, 1, &allocation.set);
+  auto sizes = allocated_.find(allocation.set);
+  if (sizes == allocated_.end()) {
+    return;
+  }
+  for (auto& pool : pools_) {
+    if (pool.pool == allocation.pool) {
+      GiveBack(&pool, sizes->second);
+      break;
+    }
+  }
+  allocated_.erase(sizes);
+}
+
+}  // namespace vulkan
+}  // namespace amber
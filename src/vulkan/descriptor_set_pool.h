@@ -0,0 +1,96 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_VULKAN_DESCRIPTOR_SET_POOL_H_
+#define SRC_VULKAN_DESCRIPTOR_SET_POOL_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "amber/result.h"
+#include "amber/vulkan_header.h"
+
+namespace amber {
+namespace vulkan {
+
+class Device;
+
+/// Allocates the descriptor sets of all pipelines of a device from a few
+/// shared VkDescriptorPools, instead of one pool per descriptor set.
+///
+/// A new pool has room for kSetsPerPool sets and for kDescriptorsPerType
+/// descriptors of each type the set it is created for uses, or for as many
+/// as that set needs if it needs more. A set goes to the first pool with
+/// enough room left. Freed sets give their room back to their pool, which
+/// is kept until the device goes away.
+class DescriptorSetPool {
+ public:
+  /// The number of sets a new pool has room for.
+  static constexpr uint32_t kSetsPerPool = 64;
+  /// The number of descriptors of each type a new pool has room for.
+  static constexpr uint32_t kDescriptorsPerType = 256;
+
+  /// A descriptor set and the pool it must be freed to.
+  struct Allocation {
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    VkDescriptorSet set = VK_NULL_HANDLE;
+  };
+
+  explicit DescriptorSetPool(Device* device);
+  ~DescriptorSetPool();
+
+  /// Allocates a set of |layout| in |allocation|. |sizes| lists the number of
+  /// descriptors of each type in the layout, with every type at most once.
+  Result Allocate(VkDescriptorSetLayout layout,
+                  const std::vector<VkDescriptorPoolSize>& sizes,
+                  Allocation* allocation);
+  /// Frees the set of |allocation|. The submitted work must not use it
+  /// anymore.
+  void Free(const Allocation& allocation);
+
+  /// Returns the number of VkDescriptorPools created so far.
+  size_t GetPoolCount() const { return pools_.size(); }
+
+ private:
+  struct Pool {
+    VkDescriptorPool pool = VK_NULL_HANDLE;
+    uint32_t sets_left = 0;
+    /// The number of descriptors of each type the pool has room for.
+    std::vector<VkDescriptorPoolSize> sizes_left;
+  };
+
+  /// Returns true if |pool| has room for a set of |sizes|.
+  static bool HasRoom(const Pool& pool,
+                      const std::vector<VkDescriptorPoolSize>& sizes);
+  /// Takes the room of a set of |sizes| from |pool|.
+  static void Take(Pool* pool, const std::vector<VkDescriptorPoolSize>& sizes);
+  /// Gives the room of a set of |sizes| back to |pool|.
+  static void GiveBack(Pool* pool,
+                       const std::vector<VkDescriptorPoolSize>& sizes);
+  /// Creates a pool with room for at least a set of |sizes|.
+  Result CreatePool(const std::vector<VkDescriptorPoolSize>& sizes);
+
+  Device* device_ = nullptr;
+  std::vector<Pool> pools_;
+  /// The descriptor counts of the sets allocated, to give them back when
+  /// they are freed.
+  std::unordered_map<VkDescriptorSet, std::vector<VkDescriptorPoolSize>>
+      allocated_;
+};
+
+}  // namespace vulkan
+}  // namespace amber
+
+#endif  // SRC_VULKAN_DESCRIPTOR_SET_POOL_H_
@@ -0,0 +1,169 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/vulkan/descriptor_set_pool.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "src/vulkan/device.h"
+
+namespace amber {
+namespace vulkan {
+namespace {
+
+class DummyDevice : public Device {
+ public:
+  DummyDevice()
+      : Device(VkInstance(),
+               VkPhysicalDevice(),
+               0u,
+               VkDevice(this),
+               VkQueue(),
+               nullptr) {
+    dummyPtrs_.vkCreateDescriptorPool = vkCreateDescriptorPool;
+    dummyPtrs_.vkDestroyDescriptorPool = vkDestroyDescriptorPool;
+    dummyPtrs_.vkAllocateDescriptorSets = vkAllocateDescriptorSets;
+    dummyPtrs_.vkFreeDescriptorSets = vkFreeDescriptorSets;
+  }
+
+  const VulkanPtrs* GetPtrs() const override { return &dummyPtrs_; }
+
+  uintptr_t GetCreatedPoolCount() const { return created_pool_count_; }
+  uintptr_t GetDestroyedPoolCount() const { return destroyed_pool_count_; }
+  uintptr_t GetFreedSetCount() const { return freed_set_count_; }
+
+ private:
+  VulkanPtrs dummyPtrs_;
+  uintptr_t created_pool_count_ = 0;
+  uintptr_t destroyed_pool_count_ = 0;
+  uintptr_t allocated_set_count_ = 0;
+  uintptr_t freed_set_count_ = 0;
+
+  static VkResult vkCreateDescriptorPool(VkDevice device,
+                                         const VkDescriptorPoolCreateInfo*,
+                                         const VkAllocationCallbacks*,
+                                         VkDescriptorPool* pDescriptorPool) {
+    DummyDevice* devicePtr = reinterpret_cast<DummyDevice*>(device);
+    *pDescriptorPool = VkDescriptorPool(++devicePtr->created_pool_count_);
+    return VK_SUCCESS;
+  }
+  static void vkDestroyDescriptorPool(VkDevice device,
+                                      VkDescriptorPool,
+                                      const VkAllocationCallbacks*) {
+    DummyDevice* devicePtr = reinterpret_cast<DummyDevice*>(device);
+    ++devicePtr->destroyed_pool_count_;
+  }
+  static VkResult vkAllocateDescriptorSets(
+      VkDevice device,
+      const VkDescriptorSetAllocateInfo*,
+      VkDescriptorSet* pDescriptorSets) {
+    DummyDevice* devicePtr = reinterpret_cast<DummyDevice*>(device);
+    *pDescriptorSets = VkDescriptorSet(++devicePtr->allocated_set_count_);
+    return VK_SUCCESS;
+  }
+  static VkResult vkFreeDescriptorSets(VkDevice device,
+                                       VkDescriptorPool,
+                                       uint32_t descriptorSetCount,
+                                       const VkDescriptorSet*) {
+    DummyDevice* devicePtr = reinterpret_cast<DummyDevice*>(device);
+    devicePtr->freed_set_count_ += descriptorSetCount;
+    return VK_SUCCESS;
+  }
+};
+
+}  // namespace
+
+using DescriptorSetPoolTest = testing::Test;
+
+TEST_F(DescriptorSetPoolTest, SetsShareAPool) {
+  DummyDevice device;
+  {
+    DescriptorSetPool pool(&device);
+    const std::vector<VkDescriptorPoolSize> sizes = {
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2}};
+
+    DescriptorSetPool::Allocation first;
+    DescriptorSetPool::Allocation second;
+    ASSERT_TRUE(
+        pool.Allocate(VkDescriptorSetLayout(), sizes, &first).IsSuccess());
+    ASSERT_TRUE(
+        pool.Allocate(VkDescriptorSetLayout(), sizes, &second).IsSuccess());
+    EXPECT_NE(first.set, second.set);
+    EXPECT_EQ(first.pool, second.pool);
+    EXPECT_EQ(1U, pool.GetPoolCount());
+
+    pool.Free(first);
+    pool.Free(second);
+    EXPECT_EQ(2U, device.GetFreedSetCount());
+  }
+  EXPECT_EQ(1U, device.GetDestroyedPoolCount());
+}
+
+TEST_F(DescriptorSetPoolTest, NewPoolOnceSetsRunOut) {
+  DummyDevice device;
+  DescriptorSetPool pool(&device);
+  const std::vector<VkDescriptorPoolSize> sizes = {
+      {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1}};
+
+  std::vector<DescriptorSetPool::Allocation> allocations(
+      DescriptorSetPool::kSetsPerPool);
+  for (auto& allocation : allocations) {
+    ASSERT_TRUE(
+        pool.Allocate(VkDescriptorSetLayout(), sizes, &allocation).IsSuccess());
+  }
+  EXPECT_EQ(1U, pool.GetPoolCount());
+
+  DescriptorSetPool::Allocation extra;
+  ASSERT_TRUE(pool.Allocate(VkDescriptorSetLayout(), sizes, &extra).IsSuccess());
+  EXPECT_EQ(2U, pool.GetPoolCount());
+  EXPECT_NE(allocations[0].pool, extra.pool);
+
+  // A freed set makes room in the first pool again.
+  pool.Free(allocations[0]);
+  DescriptorSetPool::Allocation again;
+  ASSERT_TRUE(pool.Allocate(VkDescriptorSetLayout(), sizes, &again).IsSuccess());
+  EXPECT_EQ(allocations[0].pool, again.pool);
+  EXPECT_EQ(2U, pool.GetPoolCount());
+}
+
+TEST_F(DescriptorSetPoolTest, NewPoolForOtherTypesAndLargeSets) {
+  DummyDevice device;
+  DescriptorSetPool pool(&device);
+
+  DescriptorSetPool::Allocation buffers;
+  ASSERT_TRUE(pool.Allocate(VkDescriptorSetLayout(),
+                            {{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1}}, &buffers)
+                  .IsSuccess());
+
+  DescriptorSetPool::Allocation images;
+  ASSERT_TRUE(pool.Allocate(VkDescriptorSetLayout(),
+                            {{VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1}}, &images)
+                  .IsSuccess());
+  EXPECT_NE(buffers.pool, images.pool);
+
+  DescriptorSetPool::Allocation large;
+  ASSERT_TRUE(pool.Allocate(VkDescriptorSetLayout(),
+                            {{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+                              DescriptorSetPool::kDescriptorsPerType}},
+                            &large)
+                  .IsSuccess());
+  EXPECT_NE(buffers.pool, large.pool);
+  EXPECT_EQ(3U, pool.GetPoolCount());
+  EXPECT_EQ(3U, device.GetCreatedPoolCount());
+}
+
+}  // namespace vulkan
+}  // namespace amber
@@ -25,6 +25,8 @@
 #include <string>
 #include <vector>
 
+#include "src/trace_scope.h"
+
 // The VK_HEADER_VERSION increases monotonically, even through
 // API version bumps.  The first 1.4 header uses header number 303.
 // I tried using VK_HEADER_VERSION_COMPLETE >= VK_MAKE_VERSION(1,4,0)
@@ -492,9 +494,25 @@ Device::Device(VkInstance instance,
       device_(device),
       queue_(queue),
       queue_family_index_(queue_family_index),
-      delegate_(delegate) {}
-
-Device::~Device() = default;
+      delegate_(delegate),
+      memory_allocator_(std::make_unique<MemoryAllocator>(this)),
+      timestamp_query_pool_(std::make_unique<TimestampQueryPool>(this)),
+      staging_pool_(std::make_unique<StagingPool>(this)),
+      descriptor_set_pool_(std::make_unique<DescriptorSetPool>(this)) {}
+
+Device::~Device() {
+  timestamp_query_pool_.reset();
+  staging_pool_.reset();
+  descriptor_set_pool_.reset();
+
+  // Every resource has released its memory by now, so this frees nothing
+  // unless a resource leaked.
+  memory_allocator_.reset();
+
+  if (pipeline_cache_ != VK_NULL_HANDLE) {
+    GetPtrs()->vkDestroyPipelineCache(device_, pipeline_cache_, nullptr);
+  }
+}
 
 Result Device::LoadVulkanPointers(PFN_vkGetInstanceProcAddr getInstanceProcAddr,
                                   Delegate* delegate) {
@@ -511,12 +529,29 @@ Result Device::LoadVulkanPointers(PFN_vkGetInstanceProcAddr getInstanceProcAddr,
                                       &physical_device_properties_);
 
   if (SupportsApiVersion(1, 1, 0)) {
+    descriptor_update_template_supported_ = true;
 #include "vk-wrappers-1-1.inc"
   }
 
   return {};
 }
 
+void Device::EnablePushDescriptors() {
+  if (!descriptor_update_template_supported_ ||
+      !ptrs_.vkCmdPushDescriptorSetWithTemplateKHR) {
+    return;
+  }
+
+  VkPhysicalDevicePushDescriptorPropertiesKHR push_descriptor_properties = {};
+  push_descriptor_properties.sType =
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PUSH_DESCRIPTOR_PROPERTIES_KHR;
+  VkPhysicalDeviceProperties2 properties2 = {};
+  properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+  properties2.pNext = &push_descriptor_properties;
+  ptrs_.vkGetPhysicalDeviceProperties2(physical_device_, &properties2);
+  max_push_descriptors_ = push_descriptor_properties.maxPushDescriptors;
+}
+
 bool Device::SupportsApiVersion(uint32_t major,
                                 uint32_t minor,
                                 uint32_t patch) {
@@ -533,6 +568,168 @@ void Device::ReportExecutionTiming(double time_in_ms) {
   }
 }
 
+void Device::ReportPipelineStatistics(const PipelineStatistics& statistics) {
+  if (delegate_) {
+    delegate_->ReportPipelineStatistics(statistics);
+  }
+}
+
+Result Device::WaitForFence(VkFence fence, uint32_t timeout_ms) {
+  const uint64_t timeout_ns =
+      timeout_ms == static_cast<uint32_t>(~0u)  // honor 32bit infinity
+          ? ~0ull
+          : static_cast<uint64_t>(timeout_ms) * 1000ULL * 1000ULL;
+  VkResult r = VK_SUCCESS;
+  {
+    TraceScope trace(delegate_, "submit", "vkWaitForFences", 0);
+    r = GetPtrs()->vkWaitForFences(device_, 1, &fence, VK_TRUE, timeout_ns);
+  }
+  if (r == VK_TIMEOUT) {
+    return Result("Vulkan::Calling vkWaitForFences Timeout");
+  }
+  if (r != VK_SUCCESS) {
+    std::string result_str;
+    switch (r) {
+      case VK_ERROR_OUT_OF_HOST_MEMORY:
+        result_str = "OUT_OF_HOST_MEMORY";
+        break;
+      case VK_ERROR_OUT_OF_DEVICE_MEMORY:
+        result_str = "OUT_OF_DEVICE_MEMORY";
+        break;
+      case VK_ERROR_DEVICE_LOST:
+        result_str = "DEVICE_LOST";
+        break;
+      default:
+        result_str = "<UNEXPECTED RESULT>";
+        break;
+    }
+    return Result("Vulkan::Calling vkWaitForFences Fail (" + result_str + ")");
+  }
+  return {};
+}
+
+void Device::SetLastSubmission(VkFence fence, uint32_t timeout_ms) {
+  last_submission_fence_ = fence;
+  last_submission_timeout_ms_ = timeout_ms;
+  ++submission_count_;
+}
+
+void Device::ForgetSubmission(VkFence fence) {
+  if (last_submission_fence_ == fence) {
+    last_submission_fence_ = VK_NULL_HANDLE;
+  }
+}
+
+Result Device::WaitForSubmissions() {
+  if (last_submission_fence_ != VK_NULL_HANDLE) {
+    Result r =
+        WaitForFence(last_submission_fence_, last_submission_timeout_ms_);
+    if (!r.IsSuccess()) {
+      return r;
+    }
+    last_submission_fence_ = VK_NULL_HANDLE;
+  }
+
+  // Every timed command completed, so their timestamps are available.
+  if (timestamp_query_pool_->GetSubmittedCount() > 0) {
+    timestamp_query_pool_->ReportResults();
+  }
+  staging_pool_->Recycle();
+  return {};
+}
+
+bool Device::LogExecuteCalls() const {
+  return delegate_ && delegate_->LogExecuteCalls();
+}
+
+bool Device::LogGraphicsCalls() const {
+  return delegate_ && delegate_->LogGraphicsCalls();
+}
+
+void Device::Log(const std::string& message) const {
+  if (delegate_) {
+    delegate_->Log(message);
+  }
+}
+
+void Device::LogMemoryStats(const std::string& when) const {
+  if (LogGraphicsCalls()) {
+    Log("Vulkan: device memory " + when + ": " +
+        memory_allocator_->GetStats().ToString());
+  }
+}
+
+bool Device::IsPipelineCacheDataCompatible(
+    const std::vector<uint8_t>& data) const {
+  // Layout of the header is defined by VK_PIPELINE_CACHE_HEADER_VERSION_ONE:
+  // header size, header version, vendor ID, device ID, then the UUID.
+  const size_t kHeaderSize = 4 * sizeof(uint32_t) + VK_UUID_SIZE;
+  if (data.size() < kHeaderSize) {
+    return false;
+  }
+
+  uint32_t header[4] = {};
+  std::memcpy(header, data.data(), sizeof(header));
+  if (header[0] < kHeaderSize ||
+      header[1] != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+      header[2] != physical_device_properties_.vendorID ||
+      header[3] != physical_device_properties_.deviceID) {
+    return false;
+  }
+
+  return std::memcmp(data.data() + sizeof(header),
+                     physical_device_properties_.pipelineCacheUUID,
+                     VK_UUID_SIZE) == 0;
+}
+
+Result Device::CreateVkPipelineCache(const std::vector<uint8_t>& initial_data) {
+  if (pipeline_cache_ != VK_NULL_HANDLE) {
+    return Result("Vulkan::pipeline cache already exists");
+  }
+
+  VkPipelineCacheCreateInfo info = VkPipelineCacheCreateInfo();
+  info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  if (IsPipelineCacheDataCompatible(initial_data)) {
+    info.initialDataSize = initial_data.size();
+    info.pInitialData = initial_data.data();
+  } else if (!initial_data.empty() && LogExecuteCalls()) {
+    Log("Vulkan: ignoring pipeline cache data from a different device or "
+        "driver");
+  }
+
+  if (GetPtrs()->vkCreatePipelineCache(device_, &info, nullptr,
+                                       &pipeline_cache_) != VK_SUCCESS) {
+    pipeline_cache_ = VK_NULL_HANDLE;
+    return Result("Vulkan::Calling vkCreatePipelineCache Fail");
+  }
+  return {};
+}
+
+Result Device::GetVkPipelineCacheData(std::vector<uint8_t>* data) const {
+  data->clear();
+  if (pipeline_cache_ == VK_NULL_HANDLE) {
+    return {};
+  }
+
+  size_t size = 0;
+  if (GetPtrs()->vkGetPipelineCacheData(device_, pipeline_cache_, &size,
+                                        nullptr) != VK_SUCCESS) {
+    return Result("Vulkan::Calling vkGetPipelineCacheData Fail");
+  }
+
+  data->resize(size);
+  VkResult res = GetPtrs()->vkGetPipelineCacheData(device_, pipeline_cache_,
+                                                   &size, data->data());
+  // The cache may shrink between the two calls; VK_INCOMPLETE only happens
+  // if it grew, in which case the partial data is still a valid cache.
+  if (res != VK_SUCCESS && res != VK_INCOMPLETE) {
+    data->clear();
+    return Result("Vulkan::Calling vkGetPipelineCacheData Fail");
+  }
+  data->resize(size);
+  return {};
+}
+
 Result Device::Initialize(
     PFN_vkGetInstanceProcAddr getInstanceProcAddr,
     const std::vector<std::string>& required_features,
@@ -547,6 +744,27 @@ Result Device::Initialize(
     return r;
   }
 
+  return CheckRequirements(required_features, required_properties,
+                           required_device_extensions, available_features,
+                           available_features2, available_properties2,
+                           available_extensions);
+}
+
+Result Device::CheckRequirements(
+    const std::vector<std::string>& required_features,
+    const std::vector<std::string>& required_properties,
+    const std::vector<std::string>& required_device_extensions,
+    const VkPhysicalDeviceFeatures& available_features,
+    const VkPhysicalDeviceFeatures2KHR& available_features2,
+    const VkPhysicalDeviceProperties2KHR& available_properties2,
+    const std::vector<std::string>& available_extensions) {
+  // A session checks every script against the same device, so this is set
+  // here rather than in Initialize. The checks below fail if the device was
+  // not created with the feature.
+  pipeline_statistics_query_enabled_ =
+      std::find(required_features.begin(), required_features.end(),
+                "pipelineStatisticsQuery") != required_features.end();
+
   // Check for the core features. We don't know if available_features or
   // available_features2 is provided, so check both.
   if (!AreAllRequiredFeaturesSupported(available_features, required_features) &&
@@ -959,7 +1177,7 @@ Result Device::Initialize(
     properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
     properties2.pNext = &rt_pipeline_properties;
 
-    ptrs_.vkGetPhysicalDeviceProperties2(physical_device_, &properties2);
+    GetPtrs()->vkGetPhysicalDeviceProperties2(physical_device_, &properties2);
 
     shader_group_handle_size_ = rt_pipeline_properties.shaderGroupHandleSize;
   }
@@ -1029,8 +1247,8 @@ Result Device::Initialize(
     }
   }
 
-  ptrs_.vkGetPhysicalDeviceMemoryProperties(physical_device_,
-                                            &physical_memory_properties_);
+  GetPtrs()->vkGetPhysicalDeviceMemoryProperties(physical_device_,
+                                                &physical_memory_properties_);
 
   subgroup_size_control_properties_ = {};
   const bool needs_subgroup_size_control =
@@ -1089,7 +1307,7 @@ Result Device::Initialize(
           "Vulkan: Device::Initialize subgroup properties also "
           "requires an API version of 1.1 or higher");
     }
-    ptrs_.vkGetPhysicalDeviceProperties2(physical_device_, &properties2);
+    GetPtrs()->vkGetPhysicalDeviceProperties2(physical_device_, &properties2);
 
     if (needs_subgroup_supported_operations) {
       // Read supported subgroup operations from the correct struct depending on
@@ -26,6 +26,10 @@
 #include "amber/vulkan_header.h"
 #include "src/buffer.h"
 #include "src/format.h"
+#include "src/vulkan/descriptor_set_pool.h"
+#include "src/vulkan/memory_allocator.h"
+#include "src/vulkan/staging_pool.h"
+#include "src/vulkan/timestamp_query_pool.h"
 
 namespace amber {
 namespace vulkan {
@@ -35,6 +39,8 @@ struct VulkanPtrs {
 #include "vk-wrappers-1-1.h"  // NOLINT(build/include_subdir)
 };
 
+class CommandBuffer;
+
 /// Wrapper around a Vulkan Device object.
 class Device {
  public:
@@ -55,6 +61,18 @@ class Device {
                     const VkPhysicalDeviceProperties2KHR& available_properties2,
                     const std::vector<std::string>& available_extensions);
 
+  /// Checks that the device supports the required features, properties and
+  /// extensions, and queries the device properties they depend on. Called by
+  /// Initialize() and again for every script run on an existing device.
+  Result CheckRequirements(
+      const std::vector<std::string>& required_features,
+      const std::vector<std::string>& required_properties,
+      const std::vector<std::string>& required_device_extensions,
+      const VkPhysicalDeviceFeatures& available_features,
+      const VkPhysicalDeviceFeatures2KHR& available_features2,
+      const VkPhysicalDeviceProperties2KHR& available_properties2,
+      const std::vector<std::string>& available_extensions);
+
   /// Returns true if |format| and the |buffer|s buffer type combination is
   /// supported by the physical device.
   bool IsFormatSupportedByPhysicalDevice(const Format& format, BufferType type);
@@ -103,6 +121,93 @@ class Device {
   // Each timed execution reports timing to the device and on to the delegate.
   void ReportExecutionTiming(double time_in_ns);
 
+  /// Returns true if the last script passed to CheckRequirements required
+  /// the pipelineStatisticsQuery feature.
+  bool IsPipelineStatisticsQueryEnabled() const {
+    return pipeline_statistics_query_enabled_;
+  }
+  /// Reports the counts of a command run with pipeline statistics to the
+  /// delegate.
+  void ReportPipelineStatistics(const PipelineStatistics& statistics);
+
+  /// Returns true if the delegate asked for executed commands to be logged.
+  bool LogExecuteCalls() const;
+  /// Returns true if the delegate asked for graphics API calls to be logged.
+  bool LogGraphicsCalls() const;
+  /// Logs |message| through the delegate, if there is one.
+  void Log(const std::string& message) const;
+  /// Returns the delegate, which may be null.
+  Delegate* GetDelegate() const { return delegate_; }
+
+  /// Blocks until |fence| is signaled, for at most |timeout_ms|. A timeout of
+  /// UINT32_MAX waits forever.
+  Result WaitForFence(VkFence fence, uint32_t timeout_ms);
+  /// Records that the latest submission to the queue signals |fence|. A fence
+  /// signal waits for every earlier submission to the queue, so waiting on
+  /// |fence| waits for all of them.
+  void SetLastSubmission(VkFence fence, uint32_t timeout_ms);
+  /// Forgets |fence| if it was the latest submission, before it is reset or
+  /// destroyed.
+  void ForgetSubmission(VkFence fence);
+  /// Returns the number of submissions made so far.
+  uint64_t GetSubmissionCount() const { return submission_count_; }
+  /// Blocks until every submission made so far completed. Submissions do not
+  /// wait for themselves, so this must be called before the host reads their
+  /// results or changes or destroys anything they may still use. Reports the
+  /// execution times of the timed commands submitted since the last call,
+  /// and recycles the staging buffers they used.
+  Result WaitForSubmissions();
+
+  /// Makes every command buffer other than |capture| record into |capture|
+  /// instead, and turns their submissions into no-ops, until it is called
+  /// again with nullptr.
+  void SetCaptureCommandBuffer(CommandBuffer* capture) { capture_ = capture; }
+  /// Returns the command buffer capturing all commands, or nullptr.
+  CommandBuffer* GetCaptureCommandBuffer() const { return capture_; }
+
+  /// Returns the allocator all buffer and image memory comes from.
+  MemoryAllocator* GetMemoryAllocator() { return memory_allocator_.get(); }
+  /// Logs the statistics of the memory allocator, prefixed by |when|, if
+  /// graphics calls are logged.
+  void LogMemoryStats(const std::string& when) const;
+  /// Returns the timestamp queries of timed commands, whose results are
+  /// reported by WaitForSubmissions().
+  TimestampQueryPool* GetTimestampQueryPool() {
+    return timestamp_query_pool_.get();
+  }
+  /// Returns the staging buffers images copy their contents through.
+  StagingPool* GetStagingPool() { return staging_pool_.get(); }
+  /// Returns the pools the descriptor sets of all pipelines come from.
+  DescriptorSetPool* GetDescriptorSetPool() {
+    return descriptor_set_pool_.get();
+  }
+
+  /// Returns true if descriptor sets can be written with update templates,
+  /// which are core in Vulkan 1.1.
+  bool IsDescriptorUpdateTemplateSupported() const {
+    return descriptor_update_template_supported_;
+  }
+  /// Lets pipelines push the descriptors of one of their sets instead of
+  /// allocating it. VK_KHR_push_descriptor must be enabled on the device.
+  /// Does nothing if update templates are not supported or the command to
+  /// push descriptors could not be loaded.
+  void EnablePushDescriptors();
+  /// Returns the number of descriptors a push descriptor set may hold, or 0
+  /// if push descriptors are not enabled.
+  uint32_t GetMaxPushDescriptors() const { return max_push_descriptors_; }
+
+  /// Creates the pipeline cache used for all pipelines on this device. The
+  /// cache is seeded with |initial_data| if it was produced by a matching
+  /// device and driver, otherwise an empty cache is created.
+  Result CreateVkPipelineCache(const std::vector<uint8_t>& initial_data);
+  /// Returns the pipeline cache or VK_NULL_HANDLE if none was created.
+  VkPipelineCache GetVkPipelineCache() const { return pipeline_cache_; }
+  /// Stores the serialized contents of the pipeline cache in |data|.
+  Result GetVkPipelineCacheData(std::vector<uint8_t>* data) const;
+  /// Returns true if |data| starts with a pipeline cache header written by
+  /// this vendor, device and pipeline cache UUID.
+  bool IsPipelineCacheDataCompatible(const std::vector<uint8_t>& data) const;
+
  private:
   Result LoadVulkanPointers(PFN_vkGetInstanceProcAddr, Delegate* delegate);
   bool SupportsApiVersion(uint32_t major, uint32_t minor, uint32_t patch);
@@ -115,12 +220,24 @@ class Device {
       subgroup_size_control_properties_;
   VkDevice device_ = VK_NULL_HANDLE;
   VkQueue queue_ = VK_NULL_HANDLE;
+  VkPipelineCache pipeline_cache_ = VK_NULL_HANDLE;
   uint32_t queue_family_index_ = 0;
   uint32_t shader_group_handle_size_ = 0;
+  VkFence last_submission_fence_ = VK_NULL_HANDLE;
+  uint32_t last_submission_timeout_ms_ = 0;
+  uint64_t submission_count_ = 0;
+  CommandBuffer* capture_ = nullptr;
+  bool pipeline_statistics_query_enabled_ = false;
+  bool descriptor_update_template_supported_ = false;
+  uint32_t max_push_descriptors_ = 0;
 
   VulkanPtrs ptrs_;
 
   Delegate* delegate_ = nullptr;
+  std::unique_ptr<MemoryAllocator> memory_allocator_;
+  std::unique_ptr<TimestampQueryPool> timestamp_query_pool_;
+  std::unique_ptr<StagingPool> staging_pool_;
+  std::unique_ptr<DescriptorSetPool> descriptor_set_pool_;
 };
 
 }  // namespace vulkan
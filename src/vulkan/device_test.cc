@@ -0,0 +1,88 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/vulkan/device.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace amber {
+namespace vulkan {
+namespace {
+
+class DummyDevice : public Device {
+ public:
+  DummyDevice()
+      : Device(VkInstance(),
+               VkPhysicalDevice(),
+               0u,
+               VkDevice(this),
+               VkQueue(),
+               nullptr) {
+    dummyPtrs_.vkGetPhysicalDeviceMemoryProperties =
+        vkGetPhysicalDeviceMemoryProperties;
+  }
+  ~DummyDevice() override {}
+
+  const VulkanPtrs* GetPtrs() const override { return &dummyPtrs_; }
+
+ private:
+  static void vkGetPhysicalDeviceMemoryProperties(
+      VkPhysicalDevice,
+      VkPhysicalDeviceMemoryProperties* properties) {
+    *properties = VkPhysicalDeviceMemoryProperties();
+  }
+
+  VulkanPtrs dummyPtrs_;
+};
+
+Result CheckFeatures(Device* device,
+                     const std::vector<std::string>& required_features) {
+  VkPhysicalDeviceFeatures available_features = VkPhysicalDeviceFeatures();
+  available_features.pipelineStatisticsQuery = VK_TRUE;
+
+  return device->CheckRequirements(
+      required_features, {}, {}, available_features,
+      VkPhysicalDeviceFeatures2KHR(), VkPhysicalDeviceProperties2KHR(), {});
+}
+
+}  // namespace
+
+TEST(DeviceTest, PipelineStatisticsQueryFollowsEachScript) {
+  DummyDevice device;
+  EXPECT_FALSE(device.IsPipelineStatisticsQueryEnabled());
+
+  // A session checks every script against the same device.
+  Result r = CheckFeatures(&device, {"pipelineStatisticsQuery"});
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+  EXPECT_TRUE(device.IsPipelineStatisticsQueryEnabled());
+
+  r = CheckFeatures(&device, {});
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+  EXPECT_FALSE(device.IsPipelineStatisticsQueryEnabled());
+}
+
+TEST(DeviceTest, PipelineStatisticsQueryUnsupported) {
+  DummyDevice device;
+
+  Result r = device.CheckRequirements(
+      {"pipelineStatisticsQuery"}, {}, {}, VkPhysicalDeviceFeatures(),
+      VkPhysicalDeviceFeatures2KHR(), VkPhysicalDeviceProperties2KHR(), {});
+  EXPECT_FALSE(r.IsSuccess());
+}
+
+}  // namespace vulkan
+}  // namespace amber
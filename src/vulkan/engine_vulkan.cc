@@ -31,6 +31,71 @@ namespace {
 
 const uint32_t kTrianglesPerCell = 2;
 const uint32_t kVerticesPerTriangle = 3;
+/// The number of DRAW_RECT and DRAW_GRID vertex buffers kept for later draws.
+const size_t kMaxCachedRectVertexBuffers = 16;
+
+/// Writes the triangle strip of the rectangle at |x|, |y| to |out|, two
+/// floats per vertex.
+void WriteRectVertices(float x,
+                       float y,
+                       float width,
+                       float height,
+                       float* out) {
+  // Bottom left
+  out[0] = x;
+  out[1] = y + height;
+  // Top left
+  out[2] = x;
+  out[3] = y;
+  // Bottom right
+  out[4] = x + width;
+  out[5] = y + height;
+  // Top right
+  out[6] = x + width;
+  out[7] = y;
+}
+
+/// Writes the two triangles of each cell of the rectangle at |x|, |y|, split
+/// into |columns| by |rows| cells, to |out|, two floats per vertex.
+void WriteGridVertices(float x,
+                       float y,
+                       float width,
+                       float height,
+                       uint32_t columns,
+                       uint32_t rows,
+                       float* out) {
+  const float cell_width = width / static_cast<float>(columns);
+  const float cell_height = height / static_cast<float>(rows);
+
+  for (uint32_t i = 0; i < rows; i++) {
+    for (uint32_t j = 0; j < columns; j++, out += 12) {
+      // Calculate corners
+      float x0 = x + cell_width * static_cast<float>(j);
+      float y0 = y + cell_height * static_cast<float>(i);
+      float x1 = x + cell_width * static_cast<float>(j + 1);
+      float y1 = y + cell_height * static_cast<float>(i + 1);
+
+      // Bottom right
+      out[0] = x1;
+      out[1] = y1;
+      // Bottom left
+      out[2] = x0;
+      out[3] = y1;
+      // Top left
+      out[4] = x0;
+      out[5] = y0;
+      // Bottom right
+      out[6] = x1;
+      out[7] = y1;
+      // Top left
+      out[8] = x0;
+      out[9] = y0;
+      // Top right
+      out[10] = x1;
+      out[11] = y0;
+    }
+  }
+}
 
 Result ToVkShaderStage(ShaderType type, VkShaderStageFlagBits* ret) {
   switch (type) {
@@ -101,13 +166,16 @@ EngineVulkan::EngineVulkan() : Engine() {}
 EngineVulkan::~EngineVulkan() {
   auto vk_device = device_->GetVkDevice();
   if (vk_device != VK_NULL_HANDLE) {
-    for (auto shader : shaders_) {
-      device_->GetPtrs()->vkDestroyShaderModule(vk_device, shader.second,
-                                                nullptr);
+    device_->SetCaptureCommandBuffer(nullptr);
+    capture_guard_ = nullptr;
+    ResetPipelines();
+
+    if (pipeline_cache_data_) {
+      Result r = device_->GetVkPipelineCacheData(pipeline_cache_data_);
+      if (!r.IsSuccess()) {
+        device_->Log(r.Error());
+      }
     }
-    pipeline_map_.clear();
-    tlases_.clear();
-    blases_.clear();
   }
 }
 
@@ -123,6 +191,7 @@ Result EngineVulkan::Initialize(
   }
 
   VulkanEngineConfig* vk_config = static_cast<VulkanEngineConfig*>(config);
+  config_ = vk_config;
   if (!vk_config || vk_config->vkGetInstanceProcAddr == VK_NULL_HANDLE) {
     return Result("Vulkan::Initialize vkGetInstanceProcAddr must be provided.");
   }
@@ -155,6 +224,18 @@ Result EngineVulkan::Initialize(
     return r;
   }
 
+  if (vk_config->enable_pipeline_cache) {
+    r = device_->CreateVkPipelineCache(vk_config->pipeline_cache_data);
+    if (!r.IsSuccess()) {
+      return r;
+    }
+    pipeline_cache_data_ = &vk_config->pipeline_cache_data;
+  }
+  device_->GetStagingPool()->SetMaxBytes(vk_config->staging_pool_max_bytes);
+  if (vk_config->push_descriptor_enabled) {
+    device_->EnablePushDescriptors();
+  }
+
   if (!pool_) {
     pool_ = std::make_unique<CommandPool>(device_.get());
     r = pool_->Initialize();
@@ -166,6 +247,46 @@ Result EngineVulkan::Initialize(
   return {};
 }
 
+Result EngineVulkan::CheckRequirements(
+    const std::vector<std::string>& features,
+    const std::vector<std::string>& properties,
+    const std::vector<std::string>& instance_extensions,
+    const std::vector<std::string>& device_extensions) {
+  if (!device_) {
+    return Result("Vulkan::CheckRequirements device is not initialized");
+  }
+
+  if (!AreAllExtensionsSupported(config_->available_instance_extensions,
+                                 instance_extensions)) {
+    return Result(
+        "Vulkan::CheckRequirements not all instance extensions supported");
+  }
+
+  return device_->CheckRequirements(
+      features, properties, device_extensions, config_->available_features,
+      config_->available_features2, config_->available_properties2,
+      config_->available_device_extensions);
+}
+
+void EngineVulkan::ResetPipelines() {
+  // Nothing may be destroyed while submitted work still uses it. A failure
+  // was reported by Finish() already.
+  device_->WaitForSubmissions();
+  device_->LogMemoryStats("before resetting pipelines");
+
+  for (auto shader : shaders_) {
+    device_->GetPtrs()->vkDestroyShaderModule(device_->GetVkDevice(),
+                                              shader.second, nullptr);
+  }
+  shaders_.clear();
+  pipeline_map_.clear();
+  resident_buffers_ = nullptr;
+  buffers_outside_descriptors_.clear();
+  tlases_.clear();
+  blases_.clear();
+  rect_vertices_.clear();
+}
+
 Result EngineVulkan::CreatePipeline(amber::Pipeline* pipeline) {
   // Create the pipeline data early so we can access them as needed.
   pipeline_map_[pipeline] = PipelineInfo();
@@ -242,6 +363,49 @@ Result EngineVulkan::CreatePipeline(amber::Pipeline* pipeline) {
   }
 
   info.vk_pipeline = std::move(vk_pipeline);
+  info.vk_pipeline->SetDeferReadbacks(engine_data.defer_readbacks);
+
+  if (!resident_buffers_) {
+    resident_buffers_ = std::make_unique<ResidentBuffers>(
+        device_.get(), engine_data.fence_timeout_ms,
+        engine_data.pipeline_runtime_layer_enabled,
+        engine_data.buffer_placement);
+    r = resident_buffers_->Initialize(pool_.get());
+    if (!r.IsSuccess()) {
+      return r;
+    }
+  }
+  info.vk_pipeline->SetResidentBuffers(resident_buffers_.get());
+
+  if (info.vk_pipeline->IsGraphics()) {
+    for (const auto& colour_info : pipeline->GetColorAttachments()) {
+      buffers_outside_descriptors_.insert(colour_info.buffer);
+    }
+    for (const auto& resolve_info : pipeline->GetResolveTargets()) {
+      buffers_outside_descriptors_.insert(resolve_info.buffer);
+    }
+  }
+  for (const auto& vtex_info : pipeline->GetVertexBuffers()) {
+    buffers_outside_descriptors_.insert(vtex_info.buffer);
+  }
+  for (const auto& buf_info : pipeline->GetBuffers()) {
+    if (buf_info.type == BufferType::kStorageImage ||
+        buf_info.type == BufferType::kSampledImage ||
+        buf_info.type == BufferType::kCombinedImageSampler) {
+      buffers_outside_descriptors_.insert(buf_info.buffer);
+    }
+  }
+  if (pipeline->GetDepthStencilBuffer().buffer) {
+    buffers_outside_descriptors_.insert(
+        pipeline->GetDepthStencilBuffer().buffer);
+  }
+  if (pipeline->GetIndexBuffer()) {
+    buffers_outside_descriptors_.insert(pipeline->GetIndexBuffer());
+  }
+  if (pipeline->GetPushConstantBuffer().buffer) {
+    buffers_outside_descriptors_.insert(
+        pipeline->GetPushConstantBuffer().buffer);
+  }
 
   // Set the entry point names for the pipeline.
   for (const auto& shader_info : pipeline->GetShaders()) {
@@ -661,67 +825,41 @@ Result EngineVulkan::DoDrawRect(const DrawRectCommand* command) {
 
   auto* graphics = info.vk_pipeline->AsGraphics();
 
-  float x = command->GetX();
-  float y = command->GetY();
-  float width = command->GetWidth();
-  float height = command->GetHeight();
+  RectGeometry geometry;
+  geometry.x = command->GetX();
+  geometry.y = command->GetY();
+  geometry.width = command->GetWidth();
+  geometry.height = command->GetHeight();
 
   if (command->IsOrtho()) {
     const float frame_width = static_cast<float>(graphics->GetWidth());
     const float frame_height = static_cast<float>(graphics->GetHeight());
-    x = ((x / frame_width) * 2.0f) - 1.0f;
-    y = ((y / frame_height) * 2.0f) - 1.0f;
-    width = (width / frame_width) * 2.0f;
-    height = (height / frame_height) * 2.0f;
+    geometry.x = ((geometry.x / frame_width) * 2.0f) - 1.0f;
+    geometry.y = ((geometry.y / frame_height) * 2.0f) - 1.0f;
+    geometry.width = (geometry.width / frame_width) * 2.0f;
+    geometry.height = (geometry.height / frame_height) * 2.0f;
   }
 
-  std::vector<Value> values(8);
-  // Bottom left
-  values[0].SetDoubleValue(static_cast<double>(x));
-  values[1].SetDoubleValue(static_cast<double>(y + height));
-  // Top left
-  values[2].SetDoubleValue(static_cast<double>(x));
-  values[3].SetDoubleValue(static_cast<double>(y));
-  // Bottom right
-  values[4].SetDoubleValue(static_cast<double>(x + width));
-  values[5].SetDoubleValue(static_cast<double>(y + height));
-  // Top right
-  values[6].SetDoubleValue(static_cast<double>(x + width));
-  values[7].SetDoubleValue(static_cast<double>(y));
-
-  // |format| is not Format for frame buffer but for vertex buffer.
-  // Since draw rect command contains its vertex information and it
-  // does not include a format of vertex buffer, we can choose any
-  // one that is suitable. We use VK_FORMAT_R32G32_SFLOAT for it.
-  TypeParser parser;
-  auto type = parser.Parse("R32G32_SFLOAT");
-  Format fmt(type.get());
-
-  auto buf = std::make_unique<Buffer>();
-  buf->SetFormat(&fmt);
-  buf->SetData(std::move(values));
-
-  auto vertex_buffer = std::make_unique<VertexBuffer>(device_.get());
-  vertex_buffer->SetData(0, buf.get(), InputRate::kVertex, buf->GetFormat(), 0,
-                         buf->GetFormat()->SizeInBytes());
+  VertexBuffer* vertex_buffer = nullptr;
+  Result r = GetRectVertexBuffer(geometry, &vertex_buffer);
+  if (!r.IsSuccess()) {
+    return r;
+  }
 
   DrawArraysCommand draw(command->GetPipeline(), *command->GetPipelineData());
   if (command->IsTimedExecution()) {
     draw.SetTimedExecution();
   }
+  if (command->IsPipelineStatistics()) {
+    draw.SetPipelineStatistics();
+  }
   draw.SetTopology(command->IsPatch() ? Topology::kPatchList
                                       : Topology::kTriangleStrip);
   draw.SetFirstVertexIndex(0);
   draw.SetVertexCount(4);
   draw.SetInstanceCount(1);
 
-  Result r =
-      graphics->Draw(&draw, vertex_buffer.get(), command->IsTimedExecution());
-  if (!r.IsSuccess()) {
-    return r;
-  }
-
-  return {};
+  return graphics->Draw(&draw, vertex_buffer, command->IsTimedExecution());
 }
 
 Result EngineVulkan::DoDrawGrid(const DrawGridCommand* command) {
@@ -732,88 +870,93 @@ Result EngineVulkan::DoDrawGrid(const DrawGridCommand* command) {
 
   auto* graphics = info.vk_pipeline->AsGraphics();
 
-  float x = command->GetX();
-  float y = command->GetY();
-  float width = command->GetWidth();
-  float height = command->GetHeight();
-  const uint32_t columns = command->GetColumns();
-  const uint32_t rows = command->GetRows();
-  const uint32_t vertices =
-      columns * rows * kVerticesPerTriangle * kTrianglesPerCell;
-
   // Ortho calculation
   const float frame_width = static_cast<float>(graphics->GetWidth());
   const float frame_height = static_cast<float>(graphics->GetHeight());
-  x = ((x / frame_width) * 2.0f) - 1.0f;
-  y = ((y / frame_height) * 2.0f) - 1.0f;
-  width = (width / frame_width) * 2.0f;
-  height = (height / frame_height) * 2.0f;
-
-  std::vector<Value> values(vertices * 2);
-
-  const float cell_width = width / static_cast<float>(columns);
-  const float cell_height = height / static_cast<float>(rows);
-
-  for (uint32_t i = 0, c = 0; i < rows; i++) {
-    for (uint32_t j = 0; j < columns; j++, c += 12) {
-      // Calculate corners
-      float x0 = x + cell_width * static_cast<float>(j);
-      float y0 = y + cell_height * static_cast<float>(i);
-      float x1 = x + cell_width * static_cast<float>(j + 1);
-      float y1 = y + cell_height * static_cast<float>(i + 1);
-
-      // Bottom right
-      values[c + 0].SetDoubleValue(static_cast<double>(x1));
-      values[c + 1].SetDoubleValue(static_cast<double>(y1));
-      // Bottom left
-      values[c + 2].SetDoubleValue(static_cast<double>(x0));
-      values[c + 3].SetDoubleValue(static_cast<double>(y1));
-      // Top left
-      values[c + 4].SetDoubleValue(static_cast<double>(x0));
-      values[c + 5].SetDoubleValue(static_cast<double>(y0));
-      // Bottom right
-      values[c + 6].SetDoubleValue(static_cast<double>(x1));
-      values[c + 7].SetDoubleValue(static_cast<double>(y1));
-      // Top left
-      values[c + 8].SetDoubleValue(static_cast<double>(x0));
-      values[c + 9].SetDoubleValue(static_cast<double>(y0));
-      // Top right
-      values[c + 10].SetDoubleValue(static_cast<double>(x1));
-      values[c + 11].SetDoubleValue(static_cast<double>(y0));
-    }
+  RectGeometry geometry;
+  geometry.x = ((command->GetX() / frame_width) * 2.0f) - 1.0f;
+  geometry.y = ((command->GetY() / frame_height) * 2.0f) - 1.0f;
+  geometry.width = (command->GetWidth() / frame_width) * 2.0f;
+  geometry.height = (command->GetHeight() / frame_height) * 2.0f;
+  geometry.columns = command->GetColumns();
+  geometry.rows = command->GetRows();
+
+  VertexBuffer* vertex_buffer = nullptr;
+  Result r = GetRectVertexBuffer(geometry, &vertex_buffer);
+  if (!r.IsSuccess()) {
+    return r;
   }
 
-  // |format| is not Format for frame buffer but for vertex buffer.
-  // Since draw rect command contains its vertex information and it
-  // does not include a format of vertex buffer, we can choose any
-  // one that is suitable. We use VK_FORMAT_R32G32_SFLOAT for it.
-  TypeParser parser;
-  auto type = parser.Parse("R32G32_SFLOAT");
-  Format fmt(type.get());
-
-  auto buf = std::make_unique<Buffer>();
-  buf->SetFormat(&fmt);
-  buf->SetData(std::move(values));
-
-  auto vertex_buffer = std::make_unique<VertexBuffer>(device_.get());
-  vertex_buffer->SetData(0, buf.get(), InputRate::kVertex, buf->GetFormat(), 0,
-                         buf->GetFormat()->SizeInBytes());
-
   DrawArraysCommand draw(command->GetPipeline(), *command->GetPipelineData());
   if (command->IsTimedExecution()) {
     draw.SetTimedExecution();
   }
+  if (command->IsPipelineStatistics()) {
+    draw.SetPipelineStatistics();
+  }
   draw.SetTopology(Topology::kTriangleList);
   draw.SetFirstVertexIndex(0);
-  draw.SetVertexCount(vertices);
+  draw.SetVertexCount(geometry.columns * geometry.rows *
+                      kVerticesPerTriangle * kTrianglesPerCell);
   draw.SetInstanceCount(1);
 
-  Result r =
-      graphics->Draw(&draw, vertex_buffer.get(), command->IsTimedExecution());
-  if (!r.IsSuccess()) {
-    return r;
+  return graphics->Draw(&draw, vertex_buffer, command->IsTimedExecution());
+}
+
+Result EngineVulkan::GetRectVertexBuffer(const RectGeometry& geometry,
+                                         VertexBuffer** out) {
+  auto it = rect_vertices_.find(geometry);
+  if (it != rect_vertices_.end()) {
+    *out = it->second.vertex_buffer.get();
+    return {};
+  }
+
+  if (rect_vertices_.size() >= kMaxCachedRectVertexBuffers) {
+    // The evicted vertex buffers may still be read by submitted draws.
+    Result r = device_->WaitForSubmissions();
+    if (!r.IsSuccess()) {
+      return r;
+    }
+    rect_vertices_.clear();
   }
 
+  if (!rect_vertex_format_) {
+    // |format| is not Format for frame buffer but for vertex buffer.
+    // Since draw rect command contains its vertex information and it
+    // does not include a format of vertex buffer, we can choose any
+    // one that is suitable. We use VK_FORMAT_R32G32_SFLOAT for it.
+    TypeParser parser;
+    rect_vertex_type_ = parser.Parse("R32G32_SFLOAT");
+    rect_vertex_format_ = std::make_unique<Format>(rect_vertex_type_.get());
+  }
+
+  const bool is_grid = geometry.columns != 0 && geometry.rows != 0;
+  const uint32_t vertex_count =
+      is_grid ? geometry.columns * geometry.rows * kVerticesPerTriangle *
+                    kTrianglesPerCell
+              : 4;
+
+  RectVertices vertices;
+  vertices.buffer = std::make_unique<Buffer>();
+  vertices.buffer->SetFormat(rect_vertex_format_.get());
+  vertices.buffer->SetElementCount(vertex_count);
+  vertices.buffer->ValuePtr()->resize(vertices.buffer->GetSizeInBytes());
+  float* data = reinterpret_cast<float*>(vertices.buffer->ValuePtr()->data());
+  if (is_grid) {
+    WriteGridVertices(geometry.x, geometry.y, geometry.width, geometry.height,
+                      geometry.columns, geometry.rows, data);
+  } else {
+    WriteRectVertices(geometry.x, geometry.y, geometry.width, geometry.height,
+                      data);
+  }
+
+  vertices.vertex_buffer = std::make_unique<VertexBuffer>(device_.get());
+  vertices.vertex_buffer->SetData(0, vertices.buffer.get(), InputRate::kVertex,
+                                  vertices.buffer->GetFormat(), 0,
+                                  vertices.buffer->GetFormat()->SizeInBytes());
+
+  *out = vertices.vertex_buffer.get();
+  rect_vertices_[geometry] = std::move(vertices);
   return {};
 }
 
@@ -835,7 +978,8 @@ Result EngineVulkan::DoCompute(const ComputeCommand* command) {
 
   return info.vk_pipeline->AsCompute()->Compute(
       command->GetX(), command->GetY(), command->GetZ(),
-      command->IsTimedExecution());
+      command->IsTimedExecution(), command->IsPipelineStatistics(),
+      command->IsAsync());
 }
 
 Result EngineVulkan::InitDependendLibraries(amber::Pipeline* pipeline,
@@ -899,7 +1043,7 @@ Result EngineVulkan::DoTraceRays(const RayTracingCommand* command) {
       pipeline->GetMaxPipelineRayPayloadSize(),
       pipeline->GetMaxPipelineRayHitAttributeSize(),
       pipeline->GetMaxPipelineRayRecursionDepth(), libs,
-      command->IsTimedExecution());
+      command->IsTimedExecution(), command->IsPipelineStatistics());
 }
 
 Result EngineVulkan::DoEntryPoint(const EntryPointCommand* command) {
@@ -941,7 +1085,11 @@ Result EngineVulkan::DoBuffer(const BufferCommand* cmd) {
   } else {
     cmd->GetBuffer()->SetDataWithOffset(cmd->GetValues(), cmd->GetOffset());
   }
+  if (resident_buffers_) {
+    resident_buffers_->MarkHostNewer(cmd->GetBuffer());
+  }
   if (cmd->IsPushConstant()) {
+    buffers_outside_descriptors_.insert(cmd->GetBuffer());
     auto& info = pipeline_map_[cmd->GetPipeline()];
     return info.vk_pipeline->AddPushConstantBuffer(cmd->GetBuffer(),
                                                    cmd->GetOffset());
@@ -949,5 +1097,171 @@ Result EngineVulkan::DoBuffer(const BufferCommand* cmd) {
   return {};
 }
 
+Result EngineVulkan::DoCopy(const CopyCommand* cmd) {
+  Buffer* from = cmd->GetBufferFrom();
+  Buffer* to = cmd->GetBufferTo();
+  if (from == to) {
+    return {};
+  }
+
+  if (CopiesOnDevice(from, to)) {
+    Result r = from->CanCopyTo(to);
+    if (!r.IsSuccess()) {
+      return r;
+    }
+    return resident_buffers_->Copy(from, to);
+  }
+
+  // |to| is synced as well, so no stale copy of it stays on the device.
+  Result r = SyncBufferToHost(from);
+  if (!r.IsSuccess()) {
+    return r;
+  }
+  r = SyncBufferToHost(to);
+  if (!r.IsSuccess()) {
+    return r;
+  }
+  return from->CopyTo(to);
+}
+
+bool EngineVulkan::CopiesOnDevice(const Buffer* from, const Buffer* to) const {
+  // Copy on the device if the latest contents of |from| are there, and no
+  // pipeline reads either buffer from the host.
+  return resident_buffers_ && resident_buffers_->IsCurrentOnDevice(from) &&
+         resident_buffers_->IsResident(to) &&
+         buffers_outside_descriptors_.count(from) == 0 &&
+         buffers_outside_descriptors_.count(to) == 0 &&
+         from->GetSizeInBytes() == to->GetSizeInBytes();
+}
+
+Result EngineVulkan::SyncBufferToHost(Buffer* buffer) {
+  if (resident_buffers_) {
+    Result r = resident_buffers_->SyncToHost({buffer});
+    if (!r.IsSuccess()) {
+      return r;
+    }
+  }
+
+  // At most one of the shared device copy and the pipelines holds newer
+  // contents than the host, as a buffer shared between pipelines in any
+  // other role is synced before any of them runs.
+  for (auto& it : pipeline_map_) {
+    if (!it.second.vk_pipeline) {
+      continue;
+    }
+    Result r = it.second.vk_pipeline->ReadbackBuffer(buffer);
+    if (!r.IsSuccess()) {
+      return r;
+    }
+  }
+  return {};
+}
+
+bool EngineVulkan::IsCapturable(const Command* cmd) const {
+  if (cmd->IsClearColor() || cmd->IsClearDepth() || cmd->IsClearStencil()) {
+    // These only set the values used by the next CLEAR.
+    return true;
+  }
+  if (cmd->IsCopy()) {
+    const auto* copy = static_cast<const CopyCommand*>(cmd);
+    const Buffer* from = copy->GetBufferFrom();
+    const Buffer* to = copy->GetBufferTo();
+    return from == to || (CopiesOnDevice(from, to) &&
+                          resident_buffers_->CopiesInPlace(from, to));
+  }
+  // DRAW_RECT and DRAW_GRID may evict the vertex buffers recorded draws
+  // use, and ray tracing builds its acceleration structures for every
+  // command.
+  if (!cmd->IsClear() && !cmd->IsDrawArrays() && !cmd->IsCompute()) {
+    return false;
+  }
+
+  auto it = pipeline_map_.find(
+      static_cast<const PipelineCommand*>(cmd)->GetPipeline());
+  if (it == pipeline_map_.end() || !it->second.vk_pipeline) {
+    return false;
+  }
+  Pipeline* pipeline = it->second.vk_pipeline.get();
+  // Other descriptors are written for every command, which invalidates the
+  // recorded commands binding them.
+  if (!pipeline->HasOnlyBufferDescriptors()) {
+    return false;
+  }
+  if (cmd->IsCompute()) {
+    return pipeline->IsCompute();
+  }
+  // Otherwise the attachments are uploaded from the host by every command.
+  return pipeline->IsGraphics() &&
+         pipeline->AsGraphics()->IsFrameLeftOnDevice();
+}
+
+bool EngineVulkan::BeginCapture(const RepeatCommand* cmd) {
+  const auto& engine_data = GetEngineData();
+  if (!resident_buffers_ || !engine_data.defer_readbacks ||
+      engine_data.pipeline_runtime_layer_enabled) {
+    return false;
+  }
+  for (const auto& sub_cmd : cmd->GetCommands()) {
+    if (!IsCapturable(sub_cmd.get())) {
+      return false;
+    }
+  }
+  // A clear left for the next render pass would only be recorded once, by
+  // the first draw of the body.
+  for (const auto& it : pipeline_map_) {
+    if (it.second.vk_pipeline && it.second.vk_pipeline->IsGraphics() &&
+        !it.second.vk_pipeline->AsGraphics()->FlushPendingClear().IsSuccess()) {
+      return false;
+    }
+  }
+
+  if (!capture_command_) {
+    auto command = std::make_unique<CommandBuffer>(device_.get(), pool_.get(),
+                                                   true);
+    if (!command->Initialize().IsSuccess()) {
+      return false;
+    }
+    capture_command_ = std::move(command);
+  }
+  auto guard = std::make_unique<CommandBufferGuard>(capture_command_.get());
+  if (!guard->IsRecording()) {
+    return false;
+  }
+  capture_guard_ = std::move(guard);
+  device_->SetCaptureCommandBuffer(capture_command_.get());
+  return true;
+}
+
+Result EngineVulkan::EndCapture(uint32_t submit_count) {
+  device_->SetCaptureCommandBuffer(nullptr);
+  std::unique_ptr<CommandBufferGuard> guard = std::move(capture_guard_);
+  if (!guard || submit_count == 0) {
+    return {};
+  }
+
+  // Each submission must see the writes of the previous one.
+  VkMemoryBarrier barrier = VkMemoryBarrier();
+  barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  barrier.srcAccessMask =
+      VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+  barrier.dstAccessMask = barrier.srcAccessMask;
+  device_->GetPtrs()->vkCmdPipelineBarrier(
+      capture_command_->GetVkCommandBuffer(),
+      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+      1, &barrier, 0, nullptr, 0, nullptr);
+
+  const auto& engine_data = GetEngineData();
+  return guard->SubmitRepeatedly(engine_data.fence_timeout_ms,
+                                 engine_data.pipeline_runtime_layer_enabled,
+                                 submit_count);
+}
+
+Result EngineVulkan::Finish() {
+  if (resident_buffers_) {
+    resident_buffers_->EndAsyncCommands();
+  }
+  return device_->WaitForSubmissions();
+}
+
 }  // namespace vulkan
 }  // namespace amber
@@ -19,20 +19,25 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <tuple>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "amber/amber_vulkan.h"
 #include "amber/vulkan_header.h"
 #include "src/acceleration_structure.h"
 #include "src/cast_hash.h"
 #include "src/engine.h"
+#include "src/format.h"
 #include "src/pipeline.h"
 #include "src/vulkan/blas.h"
 #include "src/vulkan/buffer_descriptor.h"
 #include "src/vulkan/command_pool.h"
 #include "src/vulkan/device.h"
 #include "src/vulkan/pipeline.h"
+#include "src/vulkan/resident_buffers.h"
 #include "src/vulkan/tlas.h"
 #include "src/vulkan/tlas_descriptor.h"
 #include "src/vulkan/vertex_buffer.h"
@@ -53,6 +58,12 @@ class EngineVulkan : public Engine {
                     const std::vector<std::string>& properties,
                     const std::vector<std::string>& instance_extensions,
                     const std::vector<std::string>& device_extensions) override;
+  Result CheckRequirements(
+      const std::vector<std::string>& features,
+      const std::vector<std::string>& properties,
+      const std::vector<std::string>& instance_extensions,
+      const std::vector<std::string>& device_extensions) override;
+  void ResetPipelines() override;
   Result CreatePipeline(amber::Pipeline* type) override;
 
   Result DoClearColor(const ClearColorCommand* cmd) override;
@@ -68,6 +79,11 @@ class EngineVulkan : public Engine {
   Result DoPatchParameterVertices(
       const PatchParameterVerticesCommand* cmd) override;
   Result DoBuffer(const BufferCommand* cmd) override;
+  Result DoCopy(const CopyCommand* cmd) override;
+  Result SyncBufferToHost(Buffer* buffer) override;
+  bool BeginCapture(const RepeatCommand* cmd) override;
+  Result EndCapture(uint32_t submit_count) override;
+  Result Finish() override;
 
  private:
   struct PipelineInfo {
@@ -88,6 +104,27 @@ class EngineVulkan : public Engine {
     std::vector<PipelineInfo::ShaderInfo> shader_info_rt;
   };
 
+  /// The vertices drawn by a DRAW_GRID, or by a DRAW_RECT when |columns| and
+  /// |rows| are 0, in normalized device coordinates.
+  struct RectGeometry {
+    float x = 0.0f;
+    float y = 0.0f;
+    float width = 0.0f;
+    float height = 0.0f;
+    uint32_t columns = 0;
+    uint32_t rows = 0;
+
+    bool operator<(const RectGeometry& other) const {
+      return std::tie(x, y, width, height, columns, rows) <
+             std::tie(other.x, other.y, other.width, other.height,
+                      other.columns, other.rows);
+    }
+  };
+  struct RectVertices {
+    std::unique_ptr<Buffer> buffer;
+    std::unique_ptr<VertexBuffer> vertex_buffer;
+  };
+
   Result GetVkShaderStageInfo(ShaderType shader_type,
                               const PipelineInfo::ShaderInfo& shader_info,
                               VkPipelineShaderStageCreateInfo* stage_ci);
@@ -107,16 +144,48 @@ class EngineVulkan : public Engine {
   Result InitDependendLibraries(amber::Pipeline* pipeline,
                                 std::vector<VkPipeline>* libs);
 
+  /// Returns true if DoCopy() copies |from| to |to| on the device.
+  bool CopiesOnDevice(const Buffer* from, const Buffer* to) const;
+  /// Returns true if |cmd| only records commands, which stay valid when
+  /// submitted again, into its command buffer.
+  bool IsCapturable(const Command* cmd) const;
+
+  /// Returns in |out| the vertex buffer holding |geometry|, which is written
+  /// on first use and kept for the following draws.
+  Result GetRectVertexBuffer(const RectGeometry& geometry, VertexBuffer** out);
+
+  /// Borrowed from the caller, who keeps it alive while the engine exists.
+  VulkanEngineConfig* config_ = nullptr;
   std::unique_ptr<Device> device_;
   std::unique_ptr<CommandPool> pool_;
+  /// Records the commands of a REPEAT body between BeginCapture() and
+  /// EndCapture().
+  std::unique_ptr<CommandBuffer> capture_command_;
+  std::unique_ptr<CommandBufferGuard> capture_guard_;
 
   std::map<amber::Pipeline*, PipelineInfo> pipeline_map_;
 
+  /// Device copies of the buffers bound to buffer descriptors, shared by all
+  /// pipelines.
+  std::unique_ptr<ResidentBuffers> resident_buffers_;
+  /// Buffers a pipeline also uses in another role, e.g. as an attachment or
+  /// a vertex buffer. Those roles don't use the device copies above.
+  std::unordered_set<const Buffer*> buffers_outside_descriptors_;
+
   std::map<std::string, VkShaderModule> shaders_;
 
   BlasesMap blases_;
 
   TlasesMap tlases_;
+
+  /// The R32G32_SFLOAT format of the DRAW_RECT and DRAW_GRID vertices.
+  std::unique_ptr<type::Type> rect_vertex_type_;
+  std::unique_ptr<Format> rect_vertex_format_;
+  std::map<RectGeometry, RectVertices> rect_vertices_;
+
+  /// Caller owned storage the pipeline cache is written back to on
+  /// destruction, or nullptr if the pipeline cache is disabled.
+  std::vector<uint8_t>* pipeline_cache_data_ = nullptr;
 };
 
 }  // namespace vulkan
@@ -19,6 +19,7 @@
 #include <limits>
 #include <vector>
 
+#include "src/trace_scope.h"
 #include "src/vulkan/command_buffer.h"
 #include "src/vulkan/device.h"
 
@@ -63,6 +64,7 @@ Result FrameBuffer::Initialize(VkRenderPass render_pass) {
     }
 
     attachments.resize(color_attachments_.size());
+    color_states_.resize(color_attachments_.size());
     for (auto* info : color_attachments_) {
       const VkImageUsageFlags usage_flags = VK_IMAGE_USAGE_TRANSFER_SRC_BIT |
                                             VK_IMAGE_USAGE_TRANSFER_DST_BIT |
@@ -163,6 +165,11 @@ void FrameBuffer::ChangeFrameLayout(CommandBuffer* command,
 }
 
 void FrameBuffer::ChangeFrameToDrawLayout(CommandBuffer* command) {
+  for (auto& state : color_states_) {
+    state.holds_buffer_contents = false;
+  }
+  depth_stencil_state_.holds_buffer_contents = false;
+
   ChangeFrameLayout(command,
                     // Color attachments
                     VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
@@ -181,30 +188,39 @@ void FrameBuffer::ChangeFrameToProbeLayout(CommandBuffer* command) {
       VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT);
 }
 
-void FrameBuffer::ChangeFrameToWriteLayout(CommandBuffer* command) {
-  ChangeFrameLayout(
-      command,
-      // Color attachments
-      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT,
-      // Depth attachments
-      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT);
-}
+Result FrameBuffer::TransferImagesToHost(CommandBuffer* command) {
+  ChangeFrameToProbeLayout(command);
 
-void FrameBuffer::TransferImagesToHost(CommandBuffer* command) {
   for (auto& img : color_images_) {
+    Result r = img->AcquireStagingBuffer();
+    if (!r.IsSuccess()) {
+      return r;
+    }
     img->CopyToHost(command);
   }
 
   for (auto& img : resolve_images_) {
+    Result r = img->AcquireStagingBuffer();
+    if (!r.IsSuccess()) {
+      return r;
+    }
     img->CopyToHost(command);
   }
 
   if (depth_stencil_image_) {
+    Result r = depth_stencil_image_->AcquireStagingBuffer();
+    if (!r.IsSuccess()) {
+      return r;
+    }
     depth_stencil_image_->CopyToHost(command);
   }
+  return {};
 }
 
 void FrameBuffer::CopyImagesToBuffers() {
+  TraceScope trace(device_->GetDelegate(), "readback", "ReadbackFrameBuffer",
+                   0);
+
   for (size_t i = 0; i < color_images_.size(); ++i) {
     auto& img = color_images_[i];
     auto* info = color_attachments_[i];
@@ -212,6 +228,9 @@ void FrameBuffer::CopyImagesToBuffers() {
     values->resize(info->buffer->GetSizeInBytes());
     std::memcpy(values->data(), img->HostAccessibleMemoryPtr(),
                 info->buffer->GetSizeInBytes());
+    img->ReleaseStagingBuffer();
+    color_states_[i].holds_buffer_contents = true;
+    color_states_[i].buffer_generation = info->buffer->GetGeneration();
   }
 
   for (size_t i = 0; i < resolve_images_.size(); ++i) {
@@ -221,6 +240,7 @@ void FrameBuffer::CopyImagesToBuffers() {
     values->resize(info->buffer->GetSizeInBytes());
     std::memcpy(values->data(), img->HostAccessibleMemoryPtr(),
                 info->buffer->GetSizeInBytes());
+    img->ReleaseStagingBuffer();
   }
 
   if (depth_stencil_image_) {
@@ -228,55 +248,91 @@ void FrameBuffer::CopyImagesToBuffers() {
     values->resize(depth_stencil_attachment_.buffer->GetSizeInBytes());
     std::memcpy(values->data(), depth_stencil_image_->HostAccessibleMemoryPtr(),
                 depth_stencil_attachment_.buffer->GetSizeInBytes());
+    depth_stencil_image_->ReleaseStagingBuffer();
+    depth_stencil_state_.holds_buffer_contents = true;
+    depth_stencil_state_.buffer_generation =
+        depth_stencil_attachment_.buffer->GetGeneration();
   }
 }
 
 void FrameBuffer::TransferImagesToDevice(CommandBuffer* command) {
-  for (auto& img : color_images_) {
-    img->CopyToDevice(command);
+  for (size_t i = 0; i < color_images_.size(); ++i) {
+    TransferImageToDevice(command, color_images_[i].get(), &color_states_[i]);
   }
 
   if (depth_stencil_image_) {
-    depth_stencil_image_->CopyToDevice(command);
+    TransferImageToDevice(command, depth_stencil_image_.get(),
+                          &depth_stencil_state_);
+  }
+}
+
+void FrameBuffer::TransferImageToDevice(CommandBuffer* command,
+                                        TransferImage* image,
+                                        ImageState* state) {
+  if (!state->upload_pending) {
+    return;
   }
+
+  image->ImageBarrier(command, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                      VK_PIPELINE_STAGE_TRANSFER_BIT);
+  image->CopyToDevice(command);
+  image->ReleaseStagingBuffer();
+  state->upload_pending = false;
+  state->holds_buffer_contents = true;
 }
 
-void FrameBuffer::CopyBuffersToImages() {
+bool FrameBuffer::IsUploadNeeded() const {
   for (size_t i = 0; i < color_images_.size(); ++i) {
-    auto& img = color_images_[i];
-    auto* info = color_attachments_[i];
-    auto* values = info->buffer->ValuePtr();
-    // Nothing to do if our local buffer is empty
-    if (values->empty()) {
-      continue;
+    if (!color_states_[i].HoldsContentsOf(*color_attachments_[i]->buffer)) {
+      return true;
     }
-
-    std::memcpy(img->HostAccessibleMemoryPtr(), values->data(),
-                info->buffer->GetSizeInBytes());
   }
+  return depth_stencil_image_ &&
+         !depth_stencil_state_.HoldsContentsOf(
+             *depth_stencil_attachment_.buffer);
+}
 
-  for (size_t i = 0; i < resolve_images_.size(); ++i) {
-    auto& img = resolve_images_[i];
-    auto* info = resolve_targets_[i];
-    auto* values = info->buffer->ValuePtr();
-    // Nothing to do if our local buffer is empty
-    if (values->empty()) {
-      continue;
+Result FrameBuffer::CopyBuffersToImages() {
+  // Resolve targets are only written by the device, so they are never
+  // uploaded.
+  for (size_t i = 0; i < color_images_.size(); ++i) {
+    Result r = CopyBufferToImage(*color_attachments_[i]->buffer,
+                                 color_images_[i].get(), &color_states_[i]);
+    if (!r.IsSuccess()) {
+      return r;
     }
-
-    std::memcpy(img->HostAccessibleMemoryPtr(), values->data(),
-                info->buffer->GetSizeInBytes());
   }
 
   if (depth_stencil_image_) {
-    auto* values = depth_stencil_attachment_.buffer->ValuePtr();
-    // Nothing to do if our local buffer is empty
-    if (!values->empty()) {
-      std::memcpy(depth_stencil_image_->HostAccessibleMemoryPtr(),
-                  values->data(),
-                  depth_stencil_attachment_.buffer->GetSizeInBytes());
-    }
+    return CopyBufferToImage(*depth_stencil_attachment_.buffer,
+                             depth_stencil_image_.get(),
+                             &depth_stencil_state_);
+  }
+  return {};
+}
+
+Result FrameBuffer::CopyBufferToImage(const Buffer& buffer,
+                                      TransferImage* image,
+                                      ImageState* state) {
+  if (state->HoldsContentsOf(buffer)) {
+    return {};
+  }
+
+  const auto* values = buffer.ValuePtr();
+  // Nothing to do if our local buffer is empty
+  if (values->empty()) {
+    return {};
   }
+
+  Result r = image->AcquireStagingBuffer();
+  if (!r.IsSuccess()) {
+    return r;
+  }
+  std::memcpy(image->HostAccessibleMemoryPtr(), values->data(),
+              buffer.GetSizeInBytes());
+  state->upload_pending = true;
+  state->buffer_generation = buffer.GetGeneration();
+  return {};
 }
 
 }  // namespace vulkan
@@ -41,28 +41,55 @@ class FrameBuffer {
 
   Result Initialize(VkRenderPass render_pass);
 
+  /// Records the transition of the images to the attachment layouts, after
+  /// which they are considered written by the device.
   void ChangeFrameToDrawLayout(CommandBuffer* command);
-  void ChangeFrameToProbeLayout(CommandBuffer* command);
-  void ChangeFrameToWriteLayout(CommandBuffer* command);
 
   VkFramebuffer GetVkFrameBuffer() const { return frame_; }
-  const void* GetColorBufferPtr(size_t idx) const {
-    return color_images_[idx]->HostAccessibleMemoryPtr();
-  }
 
   // Only record the command for copying the image that backs this
   // framebuffer to the host accessible buffer. The actual submission
-  // of the command must be done later.
-  void TransferImagesToHost(CommandBuffer* command);
+  // of the command must be done later. Every image borrows a staging buffer
+  // until CopyImagesToBuffers().
+  Result TransferImagesToHost(CommandBuffer* command);
+  /// Records the upload of the images CopyBuffersToImages() wrote the host
+  /// accessible buffers of. Their staging buffers are given back, so the
+  /// commands must be submitted next.
   void TransferImagesToDevice(CommandBuffer* command);
 
   void CopyImagesToBuffers();
-  void CopyBuffersToImages();
+  /// Writes the attachment buffers which changed since the images last held
+  /// their contents to staging buffers borrowed for the upload.
+  Result CopyBuffersToImages();
+  /// Returns true if any image lacks the current contents of its attachment
+  /// buffer, so CopyBuffersToImages() has something to upload.
+  bool IsUploadNeeded() const;
 
   uint32_t GetWidth() const { return width_; }
   uint32_t GetHeight() const { return height_; }
 
  private:
+  /// Whether an image holds the contents of its attachment buffer.
+  struct ImageState {
+    bool HoldsContentsOf(const Buffer& buffer) const {
+      return holds_buffer_contents &&
+             buffer_generation == buffer.GetGeneration();
+    }
+
+    bool holds_buffer_contents = false;
+    /// The generation of the attachment buffer the image holds, or will
+    /// hold once uploaded.
+    uint64_t buffer_generation = 0;
+    bool upload_pending = false;
+  };
+
+  Result CopyBufferToImage(const Buffer& buffer,
+                           TransferImage* image,
+                           ImageState* state);
+  void TransferImageToDevice(CommandBuffer* command,
+                             TransferImage* image,
+                             ImageState* state);
+  void ChangeFrameToProbeLayout(CommandBuffer* command);
   void ChangeFrameLayout(CommandBuffer* command,
                          VkImageLayout color_layout,
                          VkPipelineStageFlags color_stage,
@@ -77,6 +104,8 @@ class FrameBuffer {
   std::vector<std::unique_ptr<TransferImage>> color_images_;
   std::vector<std::unique_ptr<TransferImage>> resolve_images_;
   std::unique_ptr<TransferImage> depth_stencil_image_;
+  std::vector<ImageState> color_states_;
+  ImageState depth_stencil_state_;
   uint32_t width_ = 0;
   uint32_t height_ = 0;
   uint32_t depth_ = 1;
@@ -16,6 +16,9 @@
 
 #include <cassert>
 #include <cmath>
+#include <functional>
+#include <string>
+#include <utility>
 
 #include "src/command.h"
 #include "src/vulkan/command_pool.h"
@@ -39,6 +42,9 @@ const VkAttachmentDescription kDefaultAttachmentDesc = {
 
 const VkSampleMask kSampleMask = ~0U;
 
+/// The number of VkPipelines kept for the draw states of one pipeline.
+const size_t kMaxCachedVkGraphicsPipelines = 64;
+
 VkPrimitiveTopology ToVkTopology(Topology topology) {
   switch (topology) {
     case Topology::kPointList:
@@ -353,17 +359,25 @@ VkBlendOp ToVkBlendOp(BlendOp op) {
 
 class RenderPassGuard {
  public:
-  explicit RenderPassGuard(GraphicsPipeline* pipeline) : pipeline_(pipeline) {
+  /// Clears the attachments to |clear_values| on load, unless it is empty.
+  RenderPassGuard(GraphicsPipeline* pipeline,
+                  const std::vector<VkClearValue>& clear_values)
+      : pipeline_(pipeline) {
     auto* frame = pipeline_->GetFrameBuffer();
     auto* cmd = pipeline_->GetCommandBuffer();
     frame->ChangeFrameToDrawLayout(cmd);
 
     VkRenderPassBeginInfo render_begin_info = VkRenderPassBeginInfo();
     render_begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    render_begin_info.renderPass = pipeline_->GetVkRenderPass();
+    render_begin_info.renderPass = clear_values.empty()
+                                       ? pipeline_->GetVkRenderPass()
+                                       : pipeline_->GetVkClearRenderPass();
     render_begin_info.framebuffer = frame->GetVkFrameBuffer();
     render_begin_info.renderArea = {{0, 0},
                                     {frame->GetWidth(), frame->GetHeight()}};
+    render_begin_info.clearValueCount =
+        static_cast<uint32_t>(clear_values.size());
+    render_begin_info.pClearValues = clear_values.data();
     pipeline_->GetDevice()->GetPtrs()->vkCmdBeginRenderPass(
         cmd->GetVkCommandBuffer(), &render_begin_info,
         VK_SUBPASS_CONTENTS_INLINE);
@@ -372,11 +386,10 @@ class RenderPassGuard {
   ~RenderPassGuard() {
     auto* cmd = pipeline_->GetCommandBuffer();
 
+    // The images stay in the attachment layouts, so the next render pass
+    // needs no transition. TransferImagesToHost() changes them for reading.
     pipeline_->GetDevice()->GetPtrs()->vkCmdEndRenderPass(
         cmd->GetVkCommandBuffer());
-
-    auto* frame = pipeline_->GetFrameBuffer();
-    frame->ChangeFrameToProbeLayout(cmd);
   }
 
  private:
@@ -408,13 +421,23 @@ GraphicsPipeline::GraphicsPipeline(
 }
 
 GraphicsPipeline::~GraphicsPipeline() {
+  // The command buffers wait for their submissions, which may use the
+  // pipelines and the render pass.
+  command_ = nullptr;
+  DestroyCachedVkGraphicsPipelines();
+
   if (render_pass_) {
     device_->GetPtrs()->vkDestroyRenderPass(device_->GetVkDevice(),
                                             render_pass_, nullptr);
   }
+  if (clear_render_pass_) {
+    device_->GetPtrs()->vkDestroyRenderPass(device_->GetVkDevice(),
+                                            clear_render_pass_, nullptr);
+  }
 }
 
-Result GraphicsPipeline::CreateRenderPass() {
+Result GraphicsPipeline::CreateRenderPass(VkAttachmentLoadOp load_op,
+                                          VkRenderPass* render_pass) {
   VkSubpassDescription subpass_desc = VkSubpassDescription();
   subpass_desc.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
 
@@ -434,6 +457,7 @@ Result GraphicsPipeline::CreateRenderPass() {
         VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
     attachment_desc.back().samples =
         static_cast<VkSampleCountFlagBits>(info->buffer->GetSamples());
+    attachment_desc.back().loadOp = load_op;
 
     VkAttachmentReference ref = VkAttachmentReference();
     ref.attachment = static_cast<uint32_t>(attachment_desc.size() - 1);
@@ -452,6 +476,8 @@ Result GraphicsPipeline::CreateRenderPass() {
         VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
     attachment_desc.back().finalLayout =
         VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    attachment_desc.back().loadOp = load_op;
+    attachment_desc.back().stencilLoadOp = load_op;
 
     depth_refer.attachment = static_cast<uint32_t>(attachment_desc.size() - 1);
     depth_refer.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
@@ -476,6 +502,24 @@ Result GraphicsPipeline::CreateRenderPass() {
 
   subpass_desc.pResolveAttachments = resolve_refer.data();
 
+  // Consecutive render passes use the attachments without a layout
+  // transition in between, so this orders their accesses instead.
+  const VkPipelineStageFlags attachment_stages =
+      VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+      VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+  VkSubpassDependency dependency = VkSubpassDependency();
+  dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+  dependency.dstSubpass = 0;
+  dependency.srcStageMask = attachment_stages;
+  dependency.dstStageMask = attachment_stages;
+  dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                             VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
+                             VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                             VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                             VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
   VkRenderPassCreateInfo render_pass_info = VkRenderPassCreateInfo();
   render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
   render_pass_info.attachmentCount =
@@ -483,10 +527,12 @@ Result GraphicsPipeline::CreateRenderPass() {
   render_pass_info.pAttachments = attachment_desc.data();
   render_pass_info.subpassCount = 1;
   render_pass_info.pSubpasses = &subpass_desc;
+  render_pass_info.dependencyCount = 1;
+  render_pass_info.pDependencies = &dependency;
 
   if (device_->GetPtrs()->vkCreateRenderPass(device_->GetVkDevice(),
                                              &render_pass_info, nullptr,
-                                             &render_pass_) != VK_SUCCESS) {
+                                             render_pass) != VK_SUCCESS) {
     return Result("Vulkan::Calling vkCreateRenderPass Fail");
   }
 
@@ -725,14 +771,112 @@ Result GraphicsPipeline::CreateVkGraphicsPipeline(
   pipeline_info.subpass = 0;
 
   if (device_->GetPtrs()->vkCreateGraphicsPipelines(
-          device_->GetVkDevice(), VK_NULL_HANDLE, 1, &pipeline_info, nullptr,
-          pipeline) != VK_SUCCESS) {
+          device_->GetVkDevice(), device_->GetVkPipelineCache(), 1,
+          &pipeline_info, nullptr, pipeline) != VK_SUCCESS) {
     return Result("Vulkan::Calling vkCreateGraphicsPipelines Fail");
   }
 
   return {};
 }
 
+Result GraphicsPipeline::GetVkGraphicsPipeline(
+    const PipelineData* pipeline_data,
+    VkPrimitiveTopology topology,
+    const VertexBuffer* vertex_buffer,
+    VkPipeline* pipeline) {
+  if (!pipeline_data) {
+    return Result(
+        "Vulkan: GraphicsPipeline::GetVkGraphicsPipeline PipelineData is null");
+  }
+
+  VkPipelineCacheEntry key;
+  key.pipeline_data = *pipeline_data;
+  key.topology = topology;
+  key.patch_control_points = patch_control_points_;
+  for (const auto& info : GetVkShaderStageInfo()) {
+    key.entry_points.push_back(GetEntryPointName(info.stage));
+  }
+  if (vertex_buffer != nullptr) {
+    for (const auto& binding : vertex_buffer->GetVkVertexInputBinding()) {
+      key.vertex_input.push_back(binding.binding);
+      key.vertex_input.push_back(binding.stride);
+      key.vertex_input.push_back(static_cast<uint32_t>(binding.inputRate));
+    }
+    for (const auto& attr : vertex_buffer->GetVkVertexInputAttr()) {
+      key.vertex_input.push_back(attr.location);
+      key.vertex_input.push_back(attr.binding);
+      key.vertex_input.push_back(static_cast<uint32_t>(attr.format));
+      key.vertex_input.push_back(attr.offset);
+    }
+  }
+
+  size_t hash = pipeline_data->Hash();
+  hash = hash * 31 + static_cast<uint32_t>(topology);
+  hash = hash * 31 + patch_control_points_;
+  for (const auto& name : key.entry_points) {
+    hash = hash * 31 + std::hash<std::string>()(name);
+  }
+  for (const auto& value : key.vertex_input) {
+    hash = hash * 31 + value;
+  }
+
+  auto range = vk_pipeline_cache_.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    const VkPipelineCacheEntry& entry = it->second;
+    if (entry.topology == key.topology &&
+        entry.patch_control_points == key.patch_control_points &&
+        entry.entry_points == key.entry_points &&
+        entry.vertex_input == key.vertex_input &&
+        entry.pipeline_data == key.pipeline_data) {
+      ++vk_pipeline_cache_hits_;
+      if (device_->LogGraphicsCalls()) {
+        device_->Log("Vulkan: graphics pipeline cache hit (hits: " +
+                     std::to_string(vk_pipeline_cache_hits_) + ", misses: " +
+                     std::to_string(vk_pipeline_cache_misses_) + ")");
+      }
+      *pipeline = entry.pipeline;
+      return {};
+    }
+  }
+
+  // A REPEAT being captured still has to submit the draws using the cached
+  // pipelines, so they are only evicted outside of one.
+  if (vk_pipeline_cache_.size() >= kMaxCachedVkGraphicsPipelines &&
+      !device_->GetCaptureCommandBuffer()) {
+    // The evicted pipelines may still be used by submitted draws.
+    Result r = device_->WaitForSubmissions();
+    if (!r.IsSuccess()) {
+      return r;
+    }
+    DestroyCachedVkGraphicsPipelines();
+  }
+
+  Result r = CreateVkGraphicsPipeline(pipeline_data, topology, vertex_buffer,
+                                      pipeline_layout_, &key.pipeline);
+  if (!r.IsSuccess()) {
+    return r;
+  }
+
+  ++vk_pipeline_cache_misses_;
+  if (device_->LogGraphicsCalls()) {
+    device_->Log("Vulkan: graphics pipeline cache miss (hits: " +
+                 std::to_string(vk_pipeline_cache_hits_) + ", misses: " +
+                 std::to_string(vk_pipeline_cache_misses_) + ")");
+  }
+
+  *pipeline = key.pipeline;
+  vk_pipeline_cache_.emplace(hash, std::move(key));
+  return {};
+}
+
+void GraphicsPipeline::DestroyCachedVkGraphicsPipelines() {
+  for (auto& entry : vk_pipeline_cache_) {
+    device_->GetPtrs()->vkDestroyPipeline(device_->GetVkDevice(),
+                                          entry.second.pipeline, nullptr);
+  }
+  vk_pipeline_cache_.clear();
+}
+
 Result GraphicsPipeline::Initialize(uint32_t width,
                                     uint32_t height,
                                     CommandPool* pool) {
@@ -741,7 +885,7 @@ Result GraphicsPipeline::Initialize(uint32_t width,
     return r;
   }
 
-  r = CreateRenderPass();
+  r = CreateRenderPass(VK_ATTACHMENT_LOAD_OP_LOAD, &render_pass_);
   if (!r.IsSuccess()) {
     return r;
   }
@@ -823,37 +967,79 @@ Result GraphicsPipeline::SetClearDepth(float depth) {
 }
 
 Result GraphicsPipeline::Clear() {
+  // A REPEAT body recorded once must clear every time it is submitted.
+  if (!IsDeferringReadbacks() || device_->GetCaptureCommandBuffer()) {
+    return ClearAttachments(GetClearValues());
+  }
+
+  if (!clear_render_pass_) {
+    Result r =
+        CreateRenderPass(VK_ATTACHMENT_LOAD_OP_CLEAR, &clear_render_pass_);
+    if (!r.IsSuccess()) {
+      return r;
+    }
+  }
+  pending_clear_values_ = GetClearValues();
+  return {};
+}
+
+Result GraphicsPipeline::FlushPendingClear() {
+  if (pending_clear_values_.empty()) {
+    return {};
+  }
+  Result r = ClearAttachments(pending_clear_values_);
+  if (r.IsSuccess()) {
+    pending_clear_values_.clear();
+  }
+  return r;
+}
+
+std::vector<VkClearValue> GraphicsPipeline::GetClearValues() const {
   VkClearValue colour_clear;
   colour_clear.color = {
       {clear_color_r_, clear_color_g_, clear_color_b_, clear_color_a_}};
+  std::vector<VkClearValue> clear_values(color_buffers_.size(), colour_clear);
 
+  if (depth_stencil_buffer_.buffer &&
+      depth_stencil_buffer_.buffer->GetFormat()->IsFormatKnown()) {
+    VkClearValue depth_stencil_clear;
+    depth_stencil_clear.depthStencil = {clear_depth_, clear_stencil_};
+    clear_values.push_back(depth_stencil_clear);
+  }
+  return clear_values;
+}
+
+Result GraphicsPipeline::ClearAttachments(
+    const std::vector<VkClearValue>& clear_values) {
   CommandBufferGuard cmd_buf_guard(GetCommandBuffer());
   if (!cmd_buf_guard.IsRecording()) {
     return cmd_buf_guard.GetResult();
   }
 
-  frame_->ChangeFrameToWriteLayout(GetCommandBuffer());
-  frame_->CopyBuffersToImages();
-  frame_->TransferImagesToDevice(GetCommandBuffer());
+  // Attachments whose host contents did not change since the images held
+  // them are not uploaded again.
+  if (!frame_left_on_device_ && frame_->IsUploadNeeded()) {
+    Result r = frame_->CopyBuffersToImages();
+    if (!r.IsSuccess()) {
+      return r;
+    }
+    frame_->TransferImagesToDevice(GetCommandBuffer());
+  }
 
   {
-    RenderPassGuard render_pass_guard(this);
+    RenderPassGuard render_pass_guard(this, {});
 
     std::vector<VkClearAttachment> clears;
     for (size_t i = 0; i < color_buffers_.size(); ++i) {
       VkClearAttachment clear_attachment = VkClearAttachment();
       clear_attachment.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
       clear_attachment.colorAttachment = static_cast<uint32_t>(i);
-      clear_attachment.clearValue = colour_clear;
+      clear_attachment.clearValue = clear_values[i];
 
       clears.push_back(clear_attachment);
     }
 
-    if (depth_stencil_buffer_.buffer &&
-        depth_stencil_buffer_.buffer->GetFormat()->IsFormatKnown()) {
-      VkClearValue depth_stencil_clear;
-      depth_stencil_clear.depthStencil = {clear_depth_, clear_stencil_};
-
+    if (clear_values.size() > color_buffers_.size()) {
       VkImageAspectFlags aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
       if (depth_stencil_buffer_.buffer->GetFormat()->HasStencilComponent()) {
         aspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
@@ -863,7 +1049,7 @@ Result GraphicsPipeline::Clear() {
       clear_attachment.aspectMask = aspect;
       clear_attachment.colorAttachment =
           static_cast<uint32_t>(color_buffers_.size());
-      clear_attachment.clearValue = depth_stencil_clear;
+      clear_attachment.clearValue = clear_values.back();
 
       clears.push_back(clear_attachment);
     }
@@ -878,7 +1064,12 @@ Result GraphicsPipeline::Clear() {
         clears.data(), 1, &clear_rect);
   }
 
-  frame_->TransferImagesToHost(command_.get());
+  if (!IsDeferringReadbacks()) {
+    Result r = frame_->TransferImagesToHost(command_.get());
+    if (!r.IsSuccess()) {
+      return r;
+    }
+  }
 
   Result r =
       cmd_buf_guard.Submit(GetFenceTimeout(), GetPipelineRuntimeLayerEnabled());
@@ -886,6 +1077,15 @@ Result GraphicsPipeline::Clear() {
     return r;
   }
 
+  if (IsDeferringReadbacks()) {
+    frame_left_on_device_ = true;
+    return {};
+  }
+
+  r = device_->WaitForSubmissions();
+  if (!r.IsSuccess()) {
+    return r;
+  }
   frame_->CopyImagesToBuffers();
   return {};
 }
@@ -898,16 +1098,19 @@ Result GraphicsPipeline::Draw(const DrawArraysCommand* command,
     return r;
   }
 
-  VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
-  r = CreateVkPipelineLayout(&pipeline_layout);
+  bool layout_changed = false;
+  r = CreateVkPipelineLayoutIfNeeded(&layout_changed);
   if (!r.IsSuccess()) {
     return r;
   }
+  if (layout_changed) {
+    DestroyCachedVkGraphicsPipelines();
+  }
 
   VkPipeline pipeline = VK_NULL_HANDLE;
-  r = CreateVkGraphicsPipeline(command->GetPipelineData(),
-                               ToVkTopology(command->GetTopology()),
-                               vertex_buffer, pipeline_layout, &pipeline);
+  r = GetVkGraphicsPipeline(command->GetPipelineData(),
+                            ToVkTopology(command->GetTopology()),
+                            vertex_buffer, &pipeline);
   if (!r.IsSuccess()) {
     return r;
   }
@@ -915,33 +1118,51 @@ Result GraphicsPipeline::Draw(const DrawArraysCommand* command,
   // Note that a command updating a descriptor set and a command using
   // it must be submitted separately, because using a descriptor set
   // while updating it is not safe.
-  UpdateDescriptorSetsIfNeeded();
-  CreateTimingQueryObjectIfNeeded(is_timed_execution);
+  r = UpdateDescriptorSetsIfNeeded();
+  if (!r.IsSuccess()) {
+    return r;
+  }
+  r = AcquireTimingQueryIfNeeded(is_timed_execution);
+  if (!r.IsSuccess()) {
+    return r;
+  }
+  r = CreateStatisticsQueryIfNeeded(command->IsPipelineStatistics());
+  if (!r.IsSuccess()) {
+    return r;
+  }
   {
     CommandBufferGuard cmd_buf_guard(GetCommandBuffer());
     if (!cmd_buf_guard.IsRecording()) {
       return cmd_buf_guard.GetResult();
     }
 
+    RecordDescriptorBufferUploads(false);
     r = SendVertexBufferDataIfNeeded(vertex_buffer);
     if (!r.IsSuccess()) {
       return r;
     }
 
-    frame_->ChangeFrameToWriteLayout(GetCommandBuffer());
-    frame_->CopyBuffersToImages();
-    frame_->TransferImagesToDevice(GetCommandBuffer());
+    // Attachments whose host contents did not change since the images held
+    // them are not uploaded again.
+    if (!frame_left_on_device_ && frame_->IsUploadNeeded()) {
+      r = frame_->CopyBuffersToImages();
+      if (!r.IsSuccess()) {
+        return r;
+      }
+      frame_->TransferImagesToDevice(GetCommandBuffer());
+    }
 
     // Timing must be place outside the render pass scope. The full pipeline
     // barrier used by our specific implementation cannot be within a
     // renderpass.
     BeginTimerQuery();
+    BeginStatisticsQuery();
     {
-      RenderPassGuard render_pass_guard(this);
+      RenderPassGuard render_pass_guard(this, pending_clear_values_);
 
-      BindVkDescriptorSets(pipeline_layout);
+      BindVkDescriptorSets(pipeline_layout_);
 
-      r = RecordPushConstant(pipeline_layout);
+      r = RecordPushConstant(pipeline_layout_);
       if (!r.IsSuccess()) {
         return r;
       }
@@ -983,8 +1204,14 @@ Result GraphicsPipeline::Draw(const DrawArraysCommand* command,
             command->GetFirstInstance());
       }
     }
+    EndStatisticsQuery();
     EndTimerQuery();
-    frame_->TransferImagesToHost(command_.get());
+    if (!IsDeferringReadbacks()) {
+      r = frame_->TransferImagesToHost(command_.get());
+      if (!r.IsSuccess()) {
+        return r;
+      }
+    }
 
     r = cmd_buf_guard.Submit(GetFenceTimeout(),
                              GetPipelineRuntimeLayerEnabled());
@@ -992,20 +1219,77 @@ Result GraphicsPipeline::Draw(const DrawArraysCommand* command,
       return r;
     }
   }
-  DestroyTimingQueryObjectIfNeeded();
+  pending_clear_values_.clear();
+  SubmitTimingQueryIfNeeded();
+  r = ReportStatisticsIfNeeded(command->IsPipelineStatistics());
+  if (!r.IsSuccess()) {
+    return r;
+  }
   r = ReadbackDescriptorsToHostDataQueue();
   if (!r.IsSuccess()) {
     return r;
   }
 
-  frame_->CopyImagesToBuffers();
+  if (IsDeferringReadbacks()) {
+    frame_left_on_device_ = true;
+    return {};
+  }
 
-  device_->GetPtrs()->vkDestroyPipeline(device_->GetVkDevice(), pipeline,
-                                        nullptr);
-  device_->GetPtrs()->vkDestroyPipelineLayout(device_->GetVkDevice(),
-                                              pipeline_layout, nullptr);
+  r = device_->WaitForSubmissions();
+  if (!r.IsSuccess()) {
+    return r;
+  }
+  frame_->CopyImagesToBuffers();
   return {};
 }
 
+Result GraphicsPipeline::ReadbackBuffer(Buffer* buffer) {
+  if (IsAttachment(buffer)) {
+    Result r = FlushPendingClear();
+    if (!r.IsSuccess()) {
+      return r;
+    }
+  }
+  if (frame_left_on_device_ && IsAttachment(buffer)) {
+    CommandBufferGuard cmd_buf_guard(GetCommandBuffer());
+    if (!cmd_buf_guard.IsRecording()) {
+      return cmd_buf_guard.GetResult();
+    }
+
+    Result r = frame_->TransferImagesToHost(command_.get());
+    if (!r.IsSuccess()) {
+      return r;
+    }
+
+    r = cmd_buf_guard.Submit(GetFenceTimeout(),
+                             GetPipelineRuntimeLayerEnabled());
+    if (!r.IsSuccess()) {
+      return r;
+    }
+
+    r = device_->WaitForSubmissions();
+    if (!r.IsSuccess()) {
+      return r;
+    }
+    frame_->CopyImagesToBuffers();
+    frame_left_on_device_ = false;
+  }
+  return Pipeline::ReadbackBuffer(buffer);
+}
+
+bool GraphicsPipeline::IsAttachment(const Buffer* buffer) const {
+  for (const auto* info : color_buffers_) {
+    if (info->buffer == buffer) {
+      return true;
+    }
+  }
+  for (const auto* info : resolve_targets_) {
+    if (info->buffer == buffer) {
+      return true;
+    }
+  }
+  return depth_stencil_buffer_.buffer == buffer;
+}
+
 }  // namespace vulkan
 }  // namespace amber
@@ -16,6 +16,8 @@
 #define SRC_VULKAN_GRAPHICS_PIPELINE_H_
 
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "amber/result.h"
@@ -23,6 +25,7 @@
 #include "amber/vulkan_header.h"
 #include "src/format.h"
 #include "src/pipeline.h"
+#include "src/pipeline_data.h"
 #include "src/vulkan/frame_buffer.h"
 #include "src/vulkan/index_buffer.h"
 #include "src/vulkan/pipeline.h"
@@ -53,7 +56,12 @@ class GraphicsPipeline : public Pipeline {
 
   Result SetIndexBuffer(Buffer* buffer);
 
+  /// Clears the attachments. When readbacks are deferred, the clear is
+  /// instead done by the load operations of the next render pass, unless
+  /// the attachments are read back before.
   Result Clear();
+  /// Clears the attachments now if a deferred clear is still pending.
+  Result FlushPendingClear();
 
   Result SetClearColor(float r, float g, float b, float a);
   Result SetClearStencil(uint32_t stencil);
@@ -63,8 +71,18 @@ class GraphicsPipeline : public Pipeline {
               VertexBuffer* vertex_buffer,
               bool is_timed_execution);
 
+  /// Also copies the attachments back to the host if |buffer| is one of
+  /// them and a command left them on the device.
+  Result ReadbackBuffer(Buffer* buffer) override;
+
   VkRenderPass GetVkRenderPass() const { return render_pass_; }
+  /// Returns the render pass clearing the attachments on load. It is
+  /// compatible with GetVkRenderPass().
+  VkRenderPass GetVkClearRenderPass() const { return clear_render_pass_; }
   FrameBuffer* GetFrameBuffer() const { return frame_.get(); }
+  /// Returns true if the attachments hold older contents than the images of
+  /// the frame, which are then not uploaded again by the next command.
+  bool IsFrameLeftOnDevice() const { return frame_left_on_device_; }
 
   uint32_t GetWidth() const { return frame_width_; }
   uint32_t GetHeight() const { return frame_height_; }
@@ -74,13 +92,41 @@ class GraphicsPipeline : public Pipeline {
   }
 
  private:
+  /// A VkPipeline together with the state it was built from. The pipeline
+  /// layout and render pass are shared by all entries.
+  struct VkPipelineCacheEntry {
+    PipelineData pipeline_data;
+    VkPrimitiveTopology topology = VK_PRIMITIVE_TOPOLOGY_MAX_ENUM;
+    uint32_t patch_control_points = 0;
+    std::vector<std::string> entry_points;
+    std::vector<uint32_t> vertex_input;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+  };
+
+  /// Returns a VkPipeline for the given state in |pipeline|, creating it if
+  /// no pipeline was created for the same state before.
+  Result GetVkGraphicsPipeline(const PipelineData* pipeline_data,
+                               VkPrimitiveTopology topology,
+                               const VertexBuffer* vertex_buffer,
+                               VkPipeline* pipeline);
+  void DestroyCachedVkGraphicsPipelines();
+
   Result CreateVkGraphicsPipeline(const PipelineData* pipeline_data,
                                   VkPrimitiveTopology topology,
                                   const VertexBuffer* vertex_buffer,
                                   const VkPipelineLayout& pipeline_layout,
                                   VkPipeline* pipeline);
-  Result CreateRenderPass();
+  /// Creates in |render_pass| a render pass loading the color and depth
+  /// stencil attachments with |load_op|.
+  Result CreateRenderPass(VkAttachmentLoadOp load_op,
+                          VkRenderPass* render_pass);
+  /// Returns the values the attachments are cleared to, in attachment order.
+  std::vector<VkClearValue> GetClearValues() const;
+  /// Records and submits a render pass clearing the attachments to
+  /// |clear_values|.
+  Result ClearAttachments(const std::vector<VkClearValue>& clear_values);
   Result SendVertexBufferDataIfNeeded(VertexBuffer* vertex_buffer);
+  bool IsAttachment(const Buffer* buffer) const;
 
   VkPipelineDepthStencilStateCreateInfo GetVkPipelineDepthStencilInfo(
       const PipelineData* pipeline_data);
@@ -88,7 +134,14 @@ class GraphicsPipeline : public Pipeline {
   GetVkPipelineColorBlendAttachmentState(const PipelineData* pipeline_data);
 
   VkRenderPass render_pass_ = VK_NULL_HANDLE;
+  VkRenderPass clear_render_pass_ = VK_NULL_HANDLE;
+  /// The values of a deferred CLEAR, which the next render pass uses, or
+  /// empty if there is none.
+  std::vector<VkClearValue> pending_clear_values_;
   std::unique_ptr<FrameBuffer> frame_;
+  /// True if the images of |frame_| hold newer contents than the attachment
+  /// buffers, because copying them back was deferred.
+  bool frame_left_on_device_ = false;
 
   // color buffers and resolve targets are owned by the amber::Pipeline.
   std::vector<const amber::Pipeline::BufferInfo*> color_buffers_;
@@ -106,6 +159,11 @@ class GraphicsPipeline : public Pipeline {
   uint32_t clear_stencil_ = 0;
   float clear_depth_ = 1.0f;
   uint32_t patch_control_points_ = 3;
+
+  /// Created pipelines, keyed on the hash of the state they were built from.
+  std::unordered_multimap<size_t, VkPipelineCacheEntry> vk_pipeline_cache_;
+  uint32_t vk_pipeline_cache_hits_ = 0;
+  uint32_t vk_pipeline_cache_misses_ = 0;
 };
 
 }  // namespace vulkan
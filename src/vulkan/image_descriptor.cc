@@ -41,7 +41,9 @@ Result ImageDescriptor::CreateResourceIfNeeded() {
   auto& transfer_resources = pipeline_->GetDescriptorTransferResources();
 
   for (const auto& amber_buffer : GetAmberBuffers()) {
-    if (amber_buffer->ValuePtr()->empty()) {
+    // Only reads the contents, which must not change the generation.
+    const Buffer* host = amber_buffer;
+    if (host->ValuePtr()->empty()) {
       continue;
     }
 
@@ -96,53 +98,33 @@ Result ImageDescriptor::CreateResourceIfNeeded() {
 
     // Store the transfer image to the pipeline's map of transfer images.
     transfer_resources[amber_buffer] = std::move(transfer_image);
+    is_descriptor_set_update_needed_ = true;
   }
 
-  if (amber_sampler_) {
+  if (amber_sampler_ && vulkan_sampler_.GetVkSampler() == VK_NULL_HANDLE) {
     Result r = vulkan_sampler_.CreateSampler(amber_sampler_);
     if (!r.IsSuccess()) {
       return r;
     }
+    is_descriptor_set_update_needed_ = true;
   }
-
-  is_descriptor_set_update_needed_ = true;
   return {};
 }
 
-void ImageDescriptor::UpdateDescriptorSetIfNeeded(
-    VkDescriptorSet descriptor_set) {
-  if (!is_descriptor_set_update_needed_) {
-    return;
-  }
+void ImageDescriptor::WriteDescriptorInfos(void* infos) {
+  auto* image_infos = static_cast<VkDescriptorImageInfo*>(infos);
 
   // Always use general layout.
   VkImageLayout layout = VK_IMAGE_LAYOUT_GENERAL;
 
-  std::vector<VkDescriptorImageInfo> image_infos;
-
-  // Create VkDescriptorImageInfo for every descriptor image.
+  // Describe every descriptor image.
   for (const auto& amber_buffer : GetAmberBuffers()) {
     const auto& image =
         pipeline_->GetDescriptorTransferResources()[amber_buffer]
             ->AsTransferImage();
-    VkDescriptorImageInfo image_info = {vulkan_sampler_.GetVkSampler(),
-                                        image->GetVkImageView(), layout};
-    image_infos.push_back(image_info);
+    *image_infos++ = {vulkan_sampler_.GetVkSampler(), image->GetVkImageView(),
+                      layout};
   }
-
-  VkWriteDescriptorSet write = VkWriteDescriptorSet();
-  write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-  write.dstSet = descriptor_set;
-  write.dstBinding = binding_;
-  write.dstArrayElement = 0;
-  write.descriptorCount = static_cast<uint32_t>(image_infos.size());
-  write.descriptorType = GetVkDescriptorType();
-  write.pImageInfo = image_infos.data();
-
-  device_->GetPtrs()->vkUpdateDescriptorSets(device_->GetVkDevice(), 1, &write,
-                                             0, nullptr);
-
-  is_descriptor_set_update_needed_ = false;
 }
 
 }  // namespace vulkan
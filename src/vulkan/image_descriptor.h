@@ -39,7 +39,13 @@ class ImageDescriptor : public BufferBackedDescriptor {
                   Pipeline* pipeline);
   ~ImageDescriptor() override;
 
-  void UpdateDescriptorSetIfNeeded(VkDescriptorSet descriptor_set) override;
+  bool IsDescriptorSetUpdateNeeded() const override {
+    return is_descriptor_set_update_needed_;
+  }
+  void WriteDescriptorInfos(void* infos) override;
+  void MarkDescriptorSetUpdated() override {
+    is_descriptor_set_update_needed_ = false;
+  }
   Result CreateResourceIfNeeded() override;
   void SetAmberSampler(amber::Sampler* sampler) { amber_sampler_ = sampler; }
 
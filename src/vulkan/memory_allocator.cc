@@ -0,0 +1,278 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/vulkan/memory_allocator.h"
+
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+#include <utility>
+
+#include "src/vulkan/device.h"
+
+namespace amber {
+namespace vulkan {
+namespace {
+
+// Size of the blocks small allocations are carved out of. Requests larger
+// than half a block get a block of their own.
+const VkDeviceSize kBlockSize = 32 * 1024 * 1024;
+
+VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+}  // namespace
+
+MemoryRangeAllocator::MemoryRangeAllocator(VkDeviceSize size) : size_(size) {
+  free_ranges_[0] = size;
+}
+
+MemoryRangeAllocator::~MemoryRangeAllocator() = default;
+
+bool MemoryRangeAllocator::Allocate(VkDeviceSize size,
+                                    VkDeviceSize alignment,
+                                    VkDeviceSize* offset) {
+  for (auto it = free_ranges_.begin(); it != free_ranges_.end(); ++it) {
+    const VkDeviceSize range_start = it->first;
+    const VkDeviceSize range_end = it->first + it->second;
+    const VkDeviceSize start = AlignUp(range_start, alignment);
+    if (start >= range_end || range_end - start < size) {
+      continue;
+    }
+
+    // Keep the padding in front of |start| and anything after the new range
+    // free.
+    free_ranges_.erase(it);
+    if (start > range_start) {
+      free_ranges_[range_start] = start - range_start;
+    }
+    if (start + size < range_end) {
+      free_ranges_[start + size] = range_end - (start + size);
+    }
+
+    used_bytes_ += size;
+    *offset = start;
+    return true;
+  }
+  return false;
+}
+
+void MemoryRangeAllocator::Free(VkDeviceSize offset, VkDeviceSize size) {
+  used_bytes_ -= size;
+
+  auto it = free_ranges_.emplace(offset, size).first;
+
+  auto next = std::next(it);
+  if (next != free_ranges_.end() && it->first + it->second == next->first) {
+    it->second += next->second;
+    free_ranges_.erase(next);
+  }
+
+  if (it != free_ranges_.begin()) {
+    auto prev = std::prev(it);
+    if (prev->first + prev->second == it->first) {
+      prev->second += it->second;
+      free_ranges_.erase(it);
+    }
+  }
+}
+
+VkDeviceSize MemoryRangeAllocator::GetLargestFreeRange() const {
+  VkDeviceSize largest = 0;
+  for (const auto& range : free_ranges_) {
+    largest = std::max(largest, range.second);
+  }
+  return largest;
+}
+
+struct MemoryAllocator::Block {
+  explicit Block(VkDeviceSize size) : ranges(size) {}
+
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  void* host_ptr = nullptr;
+  uint32_t memory_type_index = 0;
+  VkMemoryAllocateFlags allocate_flags = 0;
+  bool is_linear = true;
+  /// True if the block holds a single large allocation.
+  bool dedicated = false;
+  MemoryRangeAllocator ranges;
+};
+
+MemoryAllocator::MemoryAllocator(Device* device) : device_(device) {}
+
+MemoryAllocator::~MemoryAllocator() {
+  while (!blocks_.empty()) {
+    DestroyBlock(blocks_.begin()->first);
+  }
+}
+
+Result MemoryAllocator::Allocate(const VkMemoryRequirements& requirements,
+                                 uint32_t memory_type_index,
+                                 VkMemoryAllocateFlags allocate_flags,
+                                 bool is_linear,
+                                 MemoryAllocation* allocation) {
+  const VkDeviceSize size = std::max<VkDeviceSize>(requirements.size, 1);
+  const VkDeviceSize alignment =
+      std::max<VkDeviceSize>(requirements.alignment, 1);
+  const bool dedicated = size > kBlockSize / 2;
+
+  Block* block = nullptr;
+  uint64_t block_id = 0;
+  VkDeviceSize offset = 0;
+  if (!dedicated) {
+    for (auto& it : blocks_) {
+      Block* candidate = it.second.get();
+      if (candidate->dedicated ||
+          candidate->memory_type_index != memory_type_index ||
+          candidate->allocate_flags != allocate_flags ||
+          candidate->is_linear != is_linear) {
+        continue;
+      }
+      if (candidate->ranges.Allocate(size, alignment, &offset)) {
+        block = candidate;
+        block_id = it.first;
+        break;
+      }
+    }
+  }
+
+  if (!block) {
+    block_id = next_block_id_;
+    Result r = CreateBlock(dedicated ? size : kBlockSize, memory_type_index,
+                           allocate_flags, is_linear, &block);
+    if (!r.IsSuccess()) {
+      return r;
+    }
+    block->dedicated = dedicated;
+
+    // A new block is empty and at least |size| bytes, so this can't fail.
+    block->ranges.Allocate(size, alignment, &offset);
+  }
+
+  allocation->memory = block->memory;
+  allocation->offset = offset;
+  allocation->size = size;
+  allocation->host_ptr =
+      block->host_ptr ? static_cast<uint8_t*>(block->host_ptr) + offset
+                      : nullptr;
+  allocation->block_id = block_id;
+  ++allocation_count_;
+  return {};
+}
+
+void MemoryAllocator::Free(const MemoryAllocation& allocation) {
+  auto it = blocks_.find(allocation.block_id);
+  if (it == blocks_.end()) {
+    return;
+  }
+
+  it->second->ranges.Free(allocation.offset, allocation.size);
+  --allocation_count_;
+  if (it->second->ranges.IsEmpty()) {
+    DestroyBlock(allocation.block_id);
+  }
+}
+
+std::string MemoryAllocatorStats::ToString() const {
+  std::ostringstream out;
+  out << block_count << " blocks, " << bytes_reserved << " bytes reserved, "
+      << bytes_in_use << " bytes in use by " << allocation_count
+      << " allocations, fragmentation " << fragmentation;
+  return out.str();
+}
+
+MemoryAllocatorStats MemoryAllocator::GetStats() const {
+  MemoryAllocatorStats stats;
+  VkDeviceSize free_bytes = 0;
+  VkDeviceSize largest_free_bytes = 0;
+  for (const auto& it : blocks_) {
+    const MemoryRangeAllocator& ranges = it.second->ranges;
+    ++stats.block_count;
+    stats.bytes_reserved += ranges.GetSize();
+    stats.bytes_in_use += ranges.GetUsedBytes();
+    free_bytes += ranges.GetSize() - ranges.GetUsedBytes();
+    largest_free_bytes += ranges.GetLargestFreeRange();
+  }
+  stats.allocation_count = allocation_count_;
+  if (free_bytes > 0) {
+    stats.fragmentation = 1.0 - static_cast<double>(largest_free_bytes) /
+                                    static_cast<double>(free_bytes);
+  }
+  return stats;
+}
+
+Result MemoryAllocator::CreateBlock(VkDeviceSize size,
+                                    uint32_t memory_type_index,
+                                    VkMemoryAllocateFlags allocate_flags,
+                                    bool is_linear,
+                                    Block** block) {
+  VkMemoryAllocateInfo alloc_info = VkMemoryAllocateInfo();
+  alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  alloc_info.allocationSize = size;
+  alloc_info.memoryTypeIndex = memory_type_index;
+
+  VkMemoryAllocateFlagsInfo alloc_flags_info = VkMemoryAllocateFlagsInfo();
+  if (allocate_flags != 0) {
+    alloc_flags_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+    alloc_flags_info.pNext = nullptr;
+    alloc_flags_info.flags = allocate_flags;
+    alloc_flags_info.deviceMask = 0u;
+
+    alloc_info.pNext = &alloc_flags_info;
+  }
+
+  auto new_block = std::make_unique<Block>(size);
+  new_block->memory_type_index = memory_type_index;
+  new_block->allocate_flags = allocate_flags;
+  new_block->is_linear = is_linear;
+
+  if (device_->GetPtrs()->vkAllocateMemory(device_->GetVkDevice(), &alloc_info,
+                                           nullptr, &new_block->memory) !=
+      VK_SUCCESS) {
+    return Result("Vulkan::Calling vkAllocateMemory Fail");
+  }
+
+  // A memory object can only be mapped once, so the whole block is mapped
+  // here and shared by all of its allocations.
+  if (device_->HasMemoryFlags(memory_type_index,
+                              VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) {
+    if (device_->GetPtrs()->vkMapMemory(device_->GetVkDevice(),
+                                        new_block->memory, 0, VK_WHOLE_SIZE, 0,
+                                        &new_block->host_ptr) != VK_SUCCESS) {
+      device_->GetPtrs()->vkFreeMemory(device_->GetVkDevice(),
+                                       new_block->memory, nullptr);
+      return Result("Vulkan::Calling vkMapMemory Fail");
+    }
+  }
+
+  *block = new_block.get();
+  blocks_[next_block_id_++] = std::move(new_block);
+  return {};
+}
+
+void MemoryAllocator::DestroyBlock(uint64_t block_id) {
+  auto it = blocks_.find(block_id);
+  if (it == blocks_.end()) {
+    return;
+  }
+
+  // Freeing the memory also unmaps it.
+  device_->GetPtrs()->vkFreeMemory(device_->GetVkDevice(), it->second->memory,
+                                   nullptr);
+  blocks_.erase(it);
+}
+
+}  // namespace vulkan
+}  // namespace amber
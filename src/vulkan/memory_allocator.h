@@ -0,0 +1,132 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_VULKAN_MEMORY_ALLOCATOR_H_
+#define SRC_VULKAN_MEMORY_ALLOCATOR_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "amber/result.h"
+#include "amber/vulkan_header.h"
+
+namespace amber {
+namespace vulkan {
+
+class Device;
+
+/// Hands out aligned ranges of a fixed size region. Free ranges are kept
+/// sorted by offset and merged with their neighbours when released.
+class MemoryRangeAllocator {
+ public:
+  explicit MemoryRangeAllocator(VkDeviceSize size);
+  ~MemoryRangeAllocator();
+
+  /// Finds the first free range which can hold |size| bytes at an offset
+  /// aligned to |alignment|. Returns false if there is none.
+  bool Allocate(VkDeviceSize size,
+                VkDeviceSize alignment,
+                VkDeviceSize* offset);
+  /// Releases the range previously returned by Allocate().
+  void Free(VkDeviceSize offset, VkDeviceSize size);
+
+  VkDeviceSize GetSize() const { return size_; }
+  VkDeviceSize GetUsedBytes() const { return used_bytes_; }
+  VkDeviceSize GetLargestFreeRange() const;
+  bool IsEmpty() const { return used_bytes_ == 0; }
+
+ private:
+  VkDeviceSize size_ = 0;
+  VkDeviceSize used_bytes_ = 0;
+  /// Maps the offset of each free range to its size.
+  std::map<VkDeviceSize, VkDeviceSize> free_ranges_;
+};
+
+/// A range of device memory handed out by MemoryAllocator.
+struct MemoryAllocation {
+  VkDeviceMemory memory = VK_NULL_HANDLE;
+  VkDeviceSize offset = 0;
+  VkDeviceSize size = 0;
+  /// Host address of |offset| if the memory is host visible, else nullptr.
+  void* host_ptr = nullptr;
+  /// Identifies the block the range was carved from.
+  uint64_t block_id = 0;
+};
+
+/// Statistics describing the memory held by a MemoryAllocator.
+struct MemoryAllocatorStats {
+  /// Number of VkDeviceMemory objects currently allocated.
+  uint64_t block_count = 0;
+  /// Number of live allocations.
+  uint64_t allocation_count = 0;
+  /// Total size of all blocks.
+  VkDeviceSize bytes_reserved = 0;
+  /// Bytes handed out to live allocations, excluding alignment padding.
+  VkDeviceSize bytes_in_use = 0;
+  /// Share of the free bytes which are not part of the largest free range of
+  /// their block. 0 when each block's free space is contiguous.
+  double fragmentation = 0.0;
+
+  /// Returns the statistics as a single line for logs.
+  std::string ToString() const;
+};
+
+/// Carves buffers and images out of large VkDeviceMemory blocks, so a script
+/// with many small resources needs only a few vkAllocateMemory calls.
+///
+/// Blocks are kept per memory type and allocate flags. Linear resources
+/// (buffers and linear images) and optimal tiling images never share a
+/// block, which keeps them apart by more than bufferImageGranularity.
+/// Host visible blocks are mapped once when created. Large requests get a
+/// block of their own, and blocks are freed as soon as they become empty.
+class MemoryAllocator {
+ public:
+  explicit MemoryAllocator(Device* device);
+  ~MemoryAllocator();
+
+  /// Allocates memory of type |memory_type_index| satisfying |requirements|.
+  /// |is_linear| must be false for images with optimal tiling.
+  Result Allocate(const VkMemoryRequirements& requirements,
+                  uint32_t memory_type_index,
+                  VkMemoryAllocateFlags allocate_flags,
+                  bool is_linear,
+                  MemoryAllocation* allocation);
+  /// Releases |allocation|. Does nothing for an empty allocation.
+  void Free(const MemoryAllocation& allocation);
+
+  /// Returns the statistics of the memory currently held.
+  MemoryAllocatorStats GetStats() const;
+
+ private:
+  struct Block;
+
+  Result CreateBlock(VkDeviceSize size,
+                     uint32_t memory_type_index,
+                     VkMemoryAllocateFlags allocate_flags,
+                     bool is_linear,
+                     Block** block);
+  void DestroyBlock(uint64_t block_id);
+
+  Device* device_ = nullptr;
+  uint64_t next_block_id_ = 1;
+  uint64_t allocation_count_ = 0;
+  std::map<uint64_t, std::unique_ptr<Block>> blocks_;
+};
+
+}  // namespace vulkan
+}  // namespace amber
+
+#endif  // SRC_VULKAN_MEMORY_ALLOCATOR_H_
@@ -0,0 +1,242 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/vulkan/memory_allocator.h"
+
+#include <cstdint>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "src/vulkan/device.h"
+
+namespace amber {
+namespace vulkan {
+namespace {
+
+class DummyDevice : public Device {
+ public:
+  DummyDevice()
+      : Device(VkInstance(),
+               VkPhysicalDevice(),
+               0u,
+               VkDevice(this),
+               VkQueue(),
+               nullptr) {
+    dummyPtrs_.vkAllocateMemory = vkAllocateMemory;
+    dummyPtrs_.vkMapMemory = vkMapMemory;
+    dummyPtrs_.vkFreeMemory = vkFreeMemory;
+  }
+  ~DummyDevice() override {}
+
+  const VulkanPtrs* GetPtrs() const override { return &dummyPtrs_; }
+
+  bool HasMemoryFlags(uint32_t, const VkMemoryPropertyFlags) const override {
+    return false;
+  }
+
+  uint32_t GetLiveMemoryCount() const { return live_memory_count_; }
+
+ private:
+  static VkResult vkAllocateMemory(VkDevice device,
+                                   const VkMemoryAllocateInfo*,
+                                   const VkAllocationCallbacks*,
+                                   VkDeviceMemory* pMemory) {
+    DummyDevice* devicePtr = reinterpret_cast<DummyDevice*>(device);
+    ++devicePtr->live_memory_count_;
+    *pMemory = VkDeviceMemory(++devicePtr->next_memory_);
+    return VK_SUCCESS;
+  }
+  static VkResult vkMapMemory(VkDevice,
+                              VkDeviceMemory,
+                              VkDeviceSize,
+                              VkDeviceSize,
+                              VkMemoryMapFlags,
+                              void**) {
+    return VK_ERROR_MEMORY_MAP_FAILED;
+  }
+  static void vkFreeMemory(VkDevice device,
+                           VkDeviceMemory,
+                           const VkAllocationCallbacks*) {
+    DummyDevice* devicePtr = reinterpret_cast<DummyDevice*>(device);
+    --devicePtr->live_memory_count_;
+  }
+
+  VulkanPtrs dummyPtrs_;
+  uint32_t live_memory_count_ = 0;
+  uintptr_t next_memory_ = 0;
+};
+
+VkMemoryRequirements MakeRequirements(VkDeviceSize size,
+                                      VkDeviceSize alignment) {
+  VkMemoryRequirements requirements = VkMemoryRequirements();
+  requirements.size = size;
+  requirements.alignment = alignment;
+  requirements.memoryTypeBits = 0xffffffff;
+  return requirements;
+}
+
+}  // namespace
+
+using MemoryRangeAllocatorTest = testing::Test;
+
+TEST_F(MemoryRangeAllocatorTest, AllocateRespectsAlignment) {
+  MemoryRangeAllocator ranges(1024);
+
+  VkDeviceSize offset = 0;
+  ASSERT_TRUE(ranges.Allocate(10, 1, &offset));
+  EXPECT_EQ(0U, offset);
+  ASSERT_TRUE(ranges.Allocate(16, 256, &offset));
+  EXPECT_EQ(256U, offset);
+
+  // The padding in front of the aligned range is still available.
+  ASSERT_TRUE(ranges.Allocate(100, 4, &offset));
+  EXPECT_EQ(12U, offset);
+  EXPECT_EQ(126U, ranges.GetUsedBytes());
+}
+
+TEST_F(MemoryRangeAllocatorTest, AllocateFailsWhenFull) {
+  MemoryRangeAllocator ranges(64);
+
+  VkDeviceSize offset = 0;
+  ASSERT_TRUE(ranges.Allocate(64, 1, &offset));
+  EXPECT_FALSE(ranges.Allocate(1, 1, &offset));
+  EXPECT_EQ(0U, ranges.GetLargestFreeRange());
+}
+
+TEST_F(MemoryRangeAllocatorTest, FreeMergesNeighbours) {
+  MemoryRangeAllocator ranges(96);
+
+  VkDeviceSize a = 0;
+  VkDeviceSize b = 0;
+  VkDeviceSize c = 0;
+  ASSERT_TRUE(ranges.Allocate(32, 1, &a));
+  ASSERT_TRUE(ranges.Allocate(32, 1, &b));
+  ASSERT_TRUE(ranges.Allocate(32, 1, &c));
+
+  ranges.Free(a, 32);
+  ranges.Free(c, 32);
+  EXPECT_EQ(32U, ranges.GetLargestFreeRange());
+
+  ranges.Free(b, 32);
+  EXPECT_TRUE(ranges.IsEmpty());
+  EXPECT_EQ(96U, ranges.GetLargestFreeRange());
+
+  VkDeviceSize offset = 0;
+  ASSERT_TRUE(ranges.Allocate(96, 1, &offset));
+  EXPECT_EQ(0U, offset);
+}
+
+using MemoryAllocatorTest = testing::Test;
+
+TEST_F(MemoryAllocatorTest, SmallAllocationsShareABlock) {
+  DummyDevice device;
+  MemoryAllocator allocator(&device);
+
+  MemoryAllocation first;
+  MemoryAllocation second;
+  Result r = allocator.Allocate(MakeRequirements(100, 64), 0, 0, true, &first);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+  r = allocator.Allocate(MakeRequirements(100, 64), 0, 0, true, &second);
+  ASSERT_TRUE(r.IsSuccess()) << r.Error();
+
+  EXPECT_EQ(1U, device.GetLiveMemoryCount());
+  EXPECT_EQ(first.memory, second.memory);
+  EXPECT_EQ(0U, first.offset);
+  EXPECT_EQ(128U, second.offset);
+  EXPECT_EQ(nullptr, first.host_ptr);
+
+  MemoryAllocatorStats stats = allocator.GetStats();
+  EXPECT_EQ(1U, stats.block_count);
+  EXPECT_EQ(2U, stats.allocation_count);
+  EXPECT_EQ(200U, stats.bytes_in_use);
+  EXPECT_EQ("1 blocks, " + std::to_string(stats.bytes_reserved) +
+                " bytes reserved, 200 bytes in use by 2 allocations, "
+                "fragmentation 0",
+            stats.ToString());
+
+  allocator.Free(first);
+  allocator.Free(second);
+  EXPECT_EQ(0U, device.GetLiveMemoryCount());
+  EXPECT_EQ(0U, allocator.GetStats().block_count);
+}
+
+TEST_F(MemoryAllocatorTest, SeparatesMemoryTypesAndTiling) {
+  DummyDevice device;
+  MemoryAllocator allocator(&device);
+
+  MemoryAllocation buffer;
+  MemoryAllocation other_type;
+  MemoryAllocation optimal_image;
+  ASSERT_TRUE(
+      allocator.Allocate(MakeRequirements(16, 16), 0, 0, true, &buffer)
+          .IsSuccess());
+  ASSERT_TRUE(
+      allocator.Allocate(MakeRequirements(16, 16), 1, 0, true, &other_type)
+          .IsSuccess());
+  ASSERT_TRUE(
+      allocator.Allocate(MakeRequirements(16, 16), 0, 0, false, &optimal_image)
+          .IsSuccess());
+
+  EXPECT_EQ(3U, device.GetLiveMemoryCount());
+  EXPECT_NE(buffer.memory, other_type.memory);
+  EXPECT_NE(buffer.memory, optimal_image.memory);
+}
+
+TEST_F(MemoryAllocatorTest, LargeAllocationGetsOwnBlock) {
+  DummyDevice device;
+  MemoryAllocator allocator(&device);
+
+  MemoryAllocation small;
+  MemoryAllocation large;
+  ASSERT_TRUE(allocator.Allocate(MakeRequirements(16, 16), 0, 0, true, &small)
+                  .IsSuccess());
+  ASSERT_TRUE(allocator
+                  .Allocate(MakeRequirements(64 * 1024 * 1024, 16), 0, 0, true,
+                            &large)
+                  .IsSuccess());
+
+  EXPECT_NE(small.memory, large.memory);
+  EXPECT_EQ(0U, large.offset);
+
+  MemoryAllocatorStats stats = allocator.GetStats();
+  EXPECT_EQ(2U, stats.block_count);
+
+  allocator.Free(large);
+  EXPECT_EQ(1U, device.GetLiveMemoryCount());
+}
+
+TEST_F(MemoryAllocatorTest, ReportsFragmentation) {
+  DummyDevice device;
+  MemoryAllocator allocator(&device);
+
+  MemoryAllocation allocations[3];
+  for (auto& allocation : allocations) {
+    ASSERT_TRUE(
+        allocator.Allocate(MakeRequirements(1024, 1024), 0, 0, true,
+                           &allocation)
+            .IsSuccess());
+  }
+  EXPECT_DOUBLE_EQ(0.0, allocator.GetStats().fragmentation);
+
+  // Freeing the first range leaves a hole in front of the used ranges.
+  allocator.Free(allocations[0]);
+  EXPECT_GT(allocator.GetStats().fragmentation, 0.0);
+
+  allocator.Free(allocations[1]);
+  allocator.Free(allocations[2]);
+  EXPECT_EQ(0U, device.GetLiveMemoryCount());
+}
+
+}  // namespace vulkan
+}  // namespace amber
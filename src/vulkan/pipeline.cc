@@ -22,12 +22,14 @@
 
 #include "src/command.h"
 #include "src/engine.h"
+#include "src/trace_scope.h"
 #include "src/vulkan/buffer_descriptor.h"
 #include "src/vulkan/compute_pipeline.h"
 #include "src/vulkan/device.h"
 #include "src/vulkan/graphics_pipeline.h"
 #include "src/vulkan/image_descriptor.h"
 #include "src/vulkan/raytracing_pipeline.h"
+#include "src/vulkan/resident_buffers.h"
 #include "src/vulkan/sampler_descriptor.h"
 #include "src/vulkan/tlas_descriptor.h"
 
@@ -44,6 +46,19 @@ constexpr VkMemoryBarrier kMemoryBarrierFull = {
 
 constexpr uint32_t kNumQueryObjects = 2;
 
+/// The counts reported as PipelineStatistics, in the order of their bits.
+/// Geometry and tessellation counts are left out, as they need features of
+/// their own.
+constexpr VkQueryPipelineStatisticFlags kPipelineStatistics =
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+constexpr uint32_t kNumPipelineStatistics = 7;
+
 }  // namespace
 
 Pipeline::Pipeline(
@@ -65,19 +80,36 @@ Pipeline::~Pipeline() {
   // error.
   command_ = nullptr;
 
+  if (statistics_query_pool_ != VK_NULL_HANDLE) {
+    device_->GetPtrs()->vkDestroyQueryPool(device_->GetVkDevice(),
+                                           statistics_query_pool_, nullptr);
+  }
+
+  DestroyVkPipelineAndLayout();
+
   for (auto& info : descriptor_set_info_) {
+    if (info.update_template != VK_NULL_HANDLE) {
+      device_->GetPtrs()->vkDestroyDescriptorUpdateTemplate(
+          device_->GetVkDevice(), info.update_template, nullptr);
+    }
+
     if (info.layout != VK_NULL_HANDLE) {
       device_->GetPtrs()->vkDestroyDescriptorSetLayout(device_->GetVkDevice(),
                                                        info.layout, nullptr);
     }
 
-    if (info.empty) {
-      continue;
+    if (info.allocation.set != VK_NULL_HANDLE) {
+      device_->GetDescriptorSetPool()->Free(info.allocation);
     }
+  }
+}
 
-    if (info.pool != VK_NULL_HANDLE) {
-      device_->GetPtrs()->vkDestroyDescriptorPool(device_->GetVkDevice(),
-                                                  info.pool, nullptr);
+void Pipeline::DestroyVkPipelineAndLayout() {
+  for (auto& info : descriptor_set_info_) {
+    if (info.push && info.update_template != VK_NULL_HANDLE) {
+      device_->GetPtrs()->vkDestroyDescriptorUpdateTemplate(
+          device_->GetVkDevice(), info.update_template, nullptr);
+      info.update_template = VK_NULL_HANDLE;
     }
   }
 
@@ -113,12 +145,41 @@ Result Pipeline::Initialize(CommandPool* pool) {
   return command_->Initialize();
 }
 
+bool Pipeline::CanPushDescriptorSet(const DescriptorSetInfo& info) const {
+  if (info.empty) {
+    return false;
+  }
+
+  uint32_t count = 0;
+  for (const auto& desc : info.descriptors) {
+    // Dynamic offsets can only be given for bound sets.
+    if (desc->IsUniformBufferDynamic() || desc->IsStorageBufferDynamic()) {
+      return false;
+    }
+    count += desc->GetDescriptorCount();
+  }
+  return count <= device_->GetMaxPushDescriptors();
+}
+
 Result Pipeline::CreateDescriptorSetLayouts() {
+  // A pipeline layout may hold one pushed set. Ray tracing pipelines keep
+  // allocating all of theirs, as their layout is shared with their
+  // libraries.
+  bool push_set_chosen =
+      IsRayTracing() || device_->GetMaxPushDescriptors() == 0;
+
   for (auto& info : descriptor_set_info_) {
     VkDescriptorSetLayoutCreateInfo desc_info =
         VkDescriptorSetLayoutCreateInfo();
     desc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 
+    if (!push_set_chosen && CanPushDescriptorSet(info)) {
+      desc_info.flags =
+          VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR;
+      info.push = true;
+      push_set_chosen = true;
+    }
+
     // If there are no descriptors for this descriptor set we only
     // need to create its layout and there will be no bindings.
     std::vector<VkDescriptorSetLayoutBinding> bindings;
@@ -137,14 +198,24 @@ Result Pipeline::CreateDescriptorSetLayouts() {
         VK_SUCCESS) {
       return Result("Vulkan::Calling vkCreateDescriptorSetLayout Fail");
     }
+
+    // The structures of each descriptor start 8-byte aligned, which is
+    // enough for all of them.
+    size_t infos_size = 0;
+    for (auto& desc : info.descriptors) {
+      info.info_offsets.push_back(infos_size);
+      infos_size += desc->GetDescriptorInfoSize() * desc->GetDescriptorCount();
+      infos_size = (infos_size + 7) / 8 * 8;
+    }
+    info.infos.resize(infos_size);
   }
 
   return {};
 }
 
-Result Pipeline::CreateDescriptorPools() {
+Result Pipeline::CreateDescriptorSets() {
   for (auto& info : descriptor_set_info_) {
-    if (info.empty) {
+    if (info.empty || info.push) {
       continue;
     }
 
@@ -165,40 +236,83 @@ Result Pipeline::CreateDescriptorPools() {
       pool_sizes.back().descriptorCount = desc->GetDescriptorCount();
     }
 
-    VkDescriptorPoolCreateInfo pool_info = VkDescriptorPoolCreateInfo();
-    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    pool_info.maxSets = 1;
-    pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
-    pool_info.pPoolSizes = pool_sizes.data();
-
-    if (device_->GetPtrs()->vkCreateDescriptorPool(device_->GetVkDevice(),
-                                                   &pool_info, nullptr,
-                                                   &info.pool) != VK_SUCCESS) {
-      return Result("Vulkan::Calling vkCreateDescriptorPool Fail");
+    Result r = device_->GetDescriptorSetPool()->Allocate(
+        info.layout, pool_sizes, &info.allocation);
+    if (!r.IsSuccess()) {
+      return r;
     }
   }
 
   return {};
 }
 
-Result Pipeline::CreateDescriptorSets() {
-  for (size_t i = 0; i < descriptor_set_info_.size(); ++i) {
-    if (descriptor_set_info_[i].empty) {
+Result Pipeline::CreateDescriptorUpdateTemplates() {
+  if (!device_->IsDescriptorUpdateTemplateSupported()) {
+    return {};
+  }
+
+  for (uint32_t i = 0; i < descriptor_set_info_.size(); ++i) {
+    if (descriptor_set_info_[i].empty || descriptor_set_info_[i].push) {
       continue;
     }
+    Result r = CreateDescriptorUpdateTemplate(i);
+    if (!r.IsSuccess()) {
+      return r;
+    }
+  }
 
-    VkDescriptorSetAllocateInfo desc_set_info = VkDescriptorSetAllocateInfo();
-    desc_set_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    desc_set_info.descriptorPool = descriptor_set_info_[i].pool;
-    desc_set_info.descriptorSetCount = 1;
-    desc_set_info.pSetLayouts = &descriptor_set_info_[i].layout;
+  return {};
+}
 
-    VkDescriptorSet desc_set = VK_NULL_HANDLE;
-    if (device_->GetPtrs()->vkAllocateDescriptorSets(
-            device_->GetVkDevice(), &desc_set_info, &desc_set) != VK_SUCCESS) {
-      return Result("Vulkan::Calling vkAllocateDescriptorSets Fail");
+Result Pipeline::CreatePushDescriptorUpdateTemplateIfNeeded() {
+  for (uint32_t i = 0; i < descriptor_set_info_.size(); ++i) {
+    if (descriptor_set_info_[i].push &&
+        descriptor_set_info_[i].update_template == VK_NULL_HANDLE) {
+      return CreateDescriptorUpdateTemplate(i);
     }
-    descriptor_set_info_[i].vk_desc_set = desc_set;
+  }
+
+  return {};
+}
+
+Result Pipeline::CreateDescriptorUpdateTemplate(uint32_t desc_set) {
+  auto& info = descriptor_set_info_[desc_set];
+
+  std::vector<VkDescriptorUpdateTemplateEntry> entries;
+  for (size_t k = 0; k < info.descriptors.size(); ++k) {
+    const auto& desc = info.descriptors[k];
+    entries.emplace_back();
+    entries.back().dstBinding = desc->GetBinding();
+    entries.back().dstArrayElement = 0;
+    entries.back().descriptorCount = desc->GetDescriptorCount();
+    entries.back().descriptorType = desc->GetVkDescriptorType();
+    entries.back().offset = info.info_offsets[k];
+    entries.back().stride = desc->GetDescriptorInfoSize();
+  }
+
+  VkDescriptorUpdateTemplateCreateInfo template_info =
+      VkDescriptorUpdateTemplateCreateInfo();
+  template_info.sType =
+      VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+  template_info.descriptorUpdateEntryCount =
+      static_cast<uint32_t>(entries.size());
+  template_info.pDescriptorUpdateEntries = entries.data();
+  if (info.push) {
+    template_info.templateType =
+        VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_PUSH_DESCRIPTORS_KHR;
+    template_info.pipelineBindPoint = GetVkPipelineBindPoint();
+    template_info.pipelineLayout = pipeline_layout_;
+    template_info.set = desc_set;
+  } else {
+    template_info.templateType =
+        VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+    template_info.descriptorSetLayout = info.layout;
+  }
+
+  if (device_->GetPtrs()->vkCreateDescriptorUpdateTemplate(
+          device_->GetVkDevice(), &template_info, nullptr,
+          &info.update_template) != VK_SUCCESS) {
+    return Result("Vulkan::Calling vkCreateDescriptorUpdateTemplate Fail");
   }
 
   return {};
@@ -238,6 +352,36 @@ Result Pipeline::CreateVkPipelineLayout(VkPipelineLayout* pipeline_layout) {
   return {};
 }
 
+Result Pipeline::CreateVkPipelineLayoutIfNeeded(bool* layout_changed) {
+  *layout_changed = false;
+
+  VkPushConstantRange push_const_range =
+      push_constant_->GetVkPushConstantRange();
+  if (pipeline_layout_ != VK_NULL_HANDLE &&
+      push_const_range.offset == pipeline_layout_push_constant_range_.offset &&
+      push_const_range.size == pipeline_layout_push_constant_range_.size) {
+    return {};
+  }
+
+  // Submitted work may still use the old pipeline and layout.
+  Result r = device_->WaitForSubmissions();
+  if (!r.IsSuccess()) {
+    return r;
+  }
+  DestroyVkPipelineAndLayout();
+
+  VkPipelineLayout pipeline_layout = VK_NULL_HANDLE;
+  r = CreateVkPipelineLayout(&pipeline_layout);
+  if (!r.IsSuccess()) {
+    return r;
+  }
+
+  SetVkPipelineLayout(pipeline_layout);
+  pipeline_layout_push_constant_range_ = push_const_range;
+  *layout_changed = true;
+  return CreatePushDescriptorUpdateTemplateIfNeeded();
+}
+
 Result Pipeline::CreateVkDescriptorRelatedObjectsIfNeeded() {
   if (descriptor_related_objects_already_created_) {
     return {};
@@ -248,12 +392,12 @@ Result Pipeline::CreateVkDescriptorRelatedObjectsIfNeeded() {
     return r;
   }
 
-  r = CreateDescriptorPools();
+  r = CreateDescriptorSets();
   if (!r.IsSuccess()) {
     return r;
   }
 
-  r = CreateDescriptorSets();
+  r = CreateDescriptorUpdateTemplates();
   if (!r.IsSuccess()) {
     return r;
   }
@@ -262,53 +406,132 @@ Result Pipeline::CreateVkDescriptorRelatedObjectsIfNeeded() {
   return {};
 }
 
-void Pipeline::UpdateDescriptorSetsIfNeeded() {
+bool Pipeline::HasOnlyBufferDescriptors() const {
+  for (const auto& info : descriptor_set_info_) {
+    for (const auto& desc : info.descriptors) {
+      if (desc->AsBufferDescriptor() == nullptr) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void Pipeline::WriteDescriptorInfos(DescriptorSetInfo* info) {
+  for (size_t i = 0; i < info->descriptors.size(); ++i) {
+    info->descriptors[i]->WriteDescriptorInfos(info->infos.data() +
+                                               info->info_offsets[i]);
+  }
+}
+
+void Pipeline::UpdateDescriptorSetWithoutTemplate(
+    const DescriptorSetInfo& info) {
+  std::vector<VkWriteDescriptorSet> writes;
+  std::vector<VkWriteDescriptorSetAccelerationStructureKHR> tlas_writes;
+  tlas_writes.reserve(info.descriptors.size());
+  for (size_t i = 0; i < info.descriptors.size(); ++i) {
+    const auto& desc = info.descriptors[i];
+    const uint8_t* infos = info.infos.data() + info.info_offsets[i];
+
+    VkWriteDescriptorSet write = VkWriteDescriptorSet();
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = info.allocation.set;
+    write.dstBinding = desc->GetBinding();
+    write.dstArrayElement = 0;
+    write.descriptorCount = desc->GetDescriptorCount();
+    write.descriptorType = desc->GetVkDescriptorType();
+    switch (desc->GetVkDescriptorType()) {
+      case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+      case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+      case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+      case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+        write.pBufferInfo =
+            reinterpret_cast<const VkDescriptorBufferInfo*>(infos);
+        break;
+      case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+      case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+        write.pTexelBufferView = reinterpret_cast<const VkBufferView*>(infos);
+        break;
+      case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR: {
+        VkWriteDescriptorSetAccelerationStructureKHR tlas_write =
+            VkWriteDescriptorSetAccelerationStructureKHR();
+        tlas_write.sType =
+            VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR;
+        tlas_write.accelerationStructureCount = desc->GetDescriptorCount();
+        tlas_write.pAccelerationStructures =
+            reinterpret_cast<const VkAccelerationStructureKHR*>(infos);
+        tlas_writes.push_back(tlas_write);
+        write.pNext = &tlas_writes.back();
+        break;
+      }
+      default:
+        write.pImageInfo =
+            reinterpret_cast<const VkDescriptorImageInfo*>(infos);
+        break;
+    }
+    writes.push_back(write);
+  }
+
+  device_->GetPtrs()->vkUpdateDescriptorSets(
+      device_->GetVkDevice(), static_cast<uint32_t>(writes.size()),
+      writes.data(), 0, nullptr);
+}
+
+Result Pipeline::UpdateDescriptorSetsIfNeeded() {
+  bool waited = false;
   for (auto& info : descriptor_set_info_) {
+    if (info.empty || info.push) {
+      continue;
+    }
+
+    bool update_needed = false;
+    for (auto& desc : info.descriptors) {
+      update_needed = update_needed || desc->IsDescriptorSetUpdateNeeded();
+    }
+    if (!update_needed) {
+      continue;
+    }
+
+    if (!waited) {
+      Result r = device_->WaitForSubmissions();
+      if (!r.IsSuccess()) {
+        return r;
+      }
+      waited = true;
+    }
+
+    WriteDescriptorInfos(&info);
+    if (info.update_template != VK_NULL_HANDLE) {
+      device_->GetPtrs()->vkUpdateDescriptorSetWithTemplate(
+          device_->GetVkDevice(), info.allocation.set, info.update_template,
+          info.infos.data());
+    } else {
+      UpdateDescriptorSetWithoutTemplate(info);
+    }
     for (auto& desc : info.descriptors) {
-      desc->UpdateDescriptorSetIfNeeded(info.vk_desc_set);
+      desc->MarkDescriptorSetUpdated();
     }
   }
+  return {};
 }
 
-void Pipeline::CreateTimingQueryObjectIfNeeded(bool is_timed_execution) {
-  if (!is_timed_execution ||
-      !device_->IsTimestampComputeAndGraphicsSupported()) {
-    return;
+Result Pipeline::AcquireTimingQueryIfNeeded(bool is_timed_execution) {
+  in_timed_execution_ =
+      is_timed_execution && device_->IsTimestampComputeAndGraphicsSupported();
+  // A command which failed before its submission leaves its query behind.
+  if (!in_timed_execution_ || timer_query_.pool != VK_NULL_HANDLE) {
+    return {};
   }
-  in_timed_execution_ = true;
-  VkQueryPoolCreateInfo pool_create_info{
-      VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
-      nullptr,
-      0,
-      VK_QUERY_TYPE_TIMESTAMP,
-      kNumQueryObjects,
-      0};
-  device_->GetPtrs()->vkCreateQueryPool(
-      device_->GetVkDevice(), &pool_create_info, nullptr, &query_pool_);
+  return device_->GetTimestampQueryPool()->Acquire(&timer_query_);
 }
 
-void Pipeline::DestroyTimingQueryObjectIfNeeded() {
+void Pipeline::SubmitTimingQueryIfNeeded() {
   if (!in_timed_execution_) {
     return;
   }
 
-  // Flags set so we may/will wait on the CPU for the availiblity of our
-  // queries.
-  const VkQueryResultFlags flags =
-      VK_QUERY_RESULT_WAIT_BIT | VK_QUERY_RESULT_64_BIT;
-  std::array<uint64_t, kNumQueryObjects> time_stamps = {};
-  constexpr VkDeviceSize kStrideBytes = sizeof(uint64_t);
-
-  device_->GetPtrs()->vkGetQueryPoolResults(
-      device_->GetVkDevice(), query_pool_, 0, kNumQueryObjects,
-      sizeof(time_stamps), time_stamps.data(), kStrideBytes, flags);
-  double time_in_ns = static_cast<double>(time_stamps[1] - time_stamps[0]) *
-                      static_cast<double>(device_->GetTimestampPeriod());
-
-  constexpr double kNsToMsTime = 1.0 / 1000000.0;
-  device_->ReportExecutionTiming(time_in_ns * kNsToMsTime);
-  device_->GetPtrs()->vkDestroyQueryPool(device_->GetVkDevice(), query_pool_,
-                                         nullptr);
+  device_->GetTimestampQueryPool()->Submitted(timer_query_);
+  timer_query_ = TimestampQuery();
   in_timed_execution_ = false;
 }
 
@@ -317,8 +540,9 @@ void Pipeline::BeginTimerQuery() {
     return;
   }
 
-  device_->GetPtrs()->vkCmdResetQueryPool(command_->GetVkCommandBuffer(),
-                                          query_pool_, 0, kNumQueryObjects);
+  device_->GetPtrs()->vkCmdResetQueryPool(
+      command_->GetVkCommandBuffer(), timer_query_.pool,
+      timer_query_.first_query, kNumQueryObjects);
   // Full barrier prevents any work from before the point being still in the
   // pipeline.
   device_->GetPtrs()->vkCmdPipelineBarrier(
@@ -326,9 +550,9 @@ void Pipeline::BeginTimerQuery() {
       VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &kMemoryBarrierFull, 0, nullptr,
       0, nullptr);
   constexpr uint32_t kBeginQueryIndexOffset = 0;
-  device_->GetPtrs()->vkCmdWriteTimestamp(command_->GetVkCommandBuffer(),
-                                          VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                                          query_pool_, kBeginQueryIndexOffset);
+  device_->GetPtrs()->vkCmdWriteTimestamp(
+      command_->GetVkCommandBuffer(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+      timer_query_.pool, timer_query_.first_query + kBeginQueryIndexOffset);
 }
 
 void Pipeline::EndTimerQuery() {
@@ -336,16 +560,88 @@ void Pipeline::EndTimerQuery() {
     return;
   }
 
-  // Full barrier ensures that work including in our timing is executed before
-  // the timestamp.
-  device_->GetPtrs()->vkCmdPipelineBarrier(
-      command_->GetVkCommandBuffer(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &kMemoryBarrierFull, 0, nullptr,
-      0, nullptr);
+  // No barrier is needed here: a timestamp written at the bottom of the pipe
+  // waits for all previous commands to complete.
   constexpr uint32_t kEndQueryIndexOffset = 1;
-  device_->GetPtrs()->vkCmdWriteTimestamp(command_->GetVkCommandBuffer(),
-                                          VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-                                          query_pool_, kEndQueryIndexOffset);
+  device_->GetPtrs()->vkCmdWriteTimestamp(
+      command_->GetVkCommandBuffer(), VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+      timer_query_.pool, timer_query_.first_query + kEndQueryIndexOffset);
+}
+
+Result Pipeline::CreateStatisticsQueryIfNeeded(bool is_pipeline_statistics) {
+  in_statistics_execution_ =
+      is_pipeline_statistics && device_->IsPipelineStatisticsQueryEnabled();
+  if (!in_statistics_execution_ || statistics_query_pool_ != VK_NULL_HANDLE) {
+    return {};
+  }
+
+  VkQueryPoolCreateInfo pool_create_info = VkQueryPoolCreateInfo();
+  pool_create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  pool_create_info.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+  pool_create_info.queryCount = 1;
+  pool_create_info.pipelineStatistics = kPipelineStatistics;
+  if (device_->GetPtrs()->vkCreateQueryPool(device_->GetVkDevice(),
+                                            &pool_create_info, nullptr,
+                                            &statistics_query_pool_) !=
+      VK_SUCCESS) {
+    return Result("Vulkan::Calling vkCreateQueryPool Fail");
+  }
+  return {};
+}
+
+void Pipeline::BeginStatisticsQuery() {
+  if (!in_statistics_execution_) {
+    return;
+  }
+
+  device_->GetPtrs()->vkCmdResetQueryPool(command_->GetVkCommandBuffer(),
+                                          statistics_query_pool_, 0, 1);
+  device_->GetPtrs()->vkCmdBeginQuery(command_->GetVkCommandBuffer(),
+                                      statistics_query_pool_, 0, 0);
+}
+
+void Pipeline::EndStatisticsQuery() {
+  if (!in_statistics_execution_) {
+    return;
+  }
+
+  device_->GetPtrs()->vkCmdEndQuery(command_->GetVkCommandBuffer(),
+                                    statistics_query_pool_, 0);
+}
+
+Result Pipeline::ReportStatisticsIfNeeded(bool is_pipeline_statistics) {
+  if (!is_pipeline_statistics) {
+    return {};
+  }
+
+  PipelineStatistics statistics;
+  if (in_statistics_execution_) {
+    // The single query of the pipeline is written by the next command again.
+    Result r = device_->WaitForSubmissions();
+    if (!r.IsSuccess()) {
+      return r;
+    }
+
+    std::array<uint64_t, kNumPipelineStatistics> counts = {};
+    if (device_->GetPtrs()->vkGetQueryPoolResults(
+            device_->GetVkDevice(), statistics_query_pool_, 0, 1,
+            sizeof(counts), counts.data(), sizeof(counts),
+            VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+      return Result("Vulkan::Calling vkGetQueryPoolResults Fail");
+    }
+    in_statistics_execution_ = false;
+
+    statistics.supported = true;
+    statistics.input_assembly_vertices = counts[0];
+    statistics.input_assembly_primitives = counts[1];
+    statistics.vertex_shader_invocations = counts[2];
+    statistics.clipping_invocations = counts[3];
+    statistics.clipping_primitives = counts[4];
+    statistics.fragment_shader_invocations = counts[5];
+    statistics.compute_shader_invocations = counts[6];
+  }
+  device_->ReportPipelineStatistics(statistics);
+  return {};
 }
 
 Result Pipeline::RecordPushConstant(const VkPipelineLayout& pipeline_layout) {
@@ -393,15 +689,17 @@ Result Pipeline::GetDescriptorSlot(uint32_t desc_set,
   return {};
 }
 
-Result Pipeline::AddDescriptorBuffer(Buffer* amber_buffer) {
+Result Pipeline::AddDescriptorBuffer(Buffer* amber_buffer, bool is_image) {
+  auto& buffers =
+      is_image ? image_descriptor_buffers_ : buffer_descriptor_buffers_;
   // Don't add the buffer if it's already added.
   const auto& buffer =
-      std::find_if(descriptor_buffers_.begin(), descriptor_buffers_.end(),
+      std::find_if(buffers.begin(), buffers.end(),
                    [&](const Buffer* buf) { return buf == amber_buffer; });
-  if (buffer != descriptor_buffers_.end()) {
+  if (buffer != buffers.end()) {
     return {};
   }
-  descriptor_buffers_.push_back(amber_buffer);
+  buffers.push_back(amber_buffer);
   return {};
 }
 
@@ -465,7 +763,7 @@ Result Pipeline::AddBufferDescriptor(const BufferCommand* cmd) {
           cmd->GetBinding(), this);
       descriptors.push_back(std::move(buffer_desc));
     }
-    AddDescriptorBuffer(cmd->GetBuffer());
+    AddDescriptorBuffer(cmd->GetBuffer(), is_image);
     desc = descriptors.back().get();
   } else {
     if (desc->GetDescriptorType() != desc_type) {
@@ -474,7 +772,7 @@ Result Pipeline::AddBufferDescriptor(const BufferCommand* cmd) {
           "descriptor types");
     }
     desc->AsBufferBackedDescriptor()->AddAmberBuffer(cmd->GetBuffer());
-    AddDescriptorBuffer(cmd->GetBuffer());
+    AddDescriptorBuffer(cmd->GetBuffer(), is_image);
   }
 
   if (cmd->IsUniformDynamic() || cmd->IsSSBODynamic()) {
@@ -567,45 +865,79 @@ Result Pipeline::AddTLASDescriptor(const TLASCommand* cmd) {
 }
 
 Result Pipeline::SendDescriptorDataToDeviceIfNeeded() {
-  {
-    CommandBufferGuard guard(GetCommandBuffer());
-    if (!guard.IsRecording()) {
-      return guard.GetResult();
+  TraceScope trace(device_->GetDelegate(), "descriptor", "UploadDescriptors",
+                   0);
+
+  // Read-only transfer images are kept from one command to the next as long
+  // as the host contents of their buffers stay the same. Stale ones are
+  // created again below.
+  for (auto buffer : image_descriptor_buffers_) {
+    auto it = image_descriptor_generations_.find(buffer);
+    if (it == image_descriptor_generations_.end() ||
+        it->second == buffer->GetGeneration()) {
+      continue;
     }
-
-    for (auto& info : descriptor_set_info_) {
-      for (auto& desc : info.descriptors) {
-        Result r = desc->CreateResourceIfNeeded();
-        if (!r.IsSuccess()) {
-          return r;
-        }
-      }
+    // Submitted work may still sample the image.
+    Result r = device_->WaitForSubmissions();
+    if (!r.IsSuccess()) {
+      return r;
     }
+    descriptor_transfer_resources_.erase(buffer);
+    image_descriptor_generations_.erase(it);
+  }
 
-    // Initialize transfer buffers / images.
-    for (auto buffer : descriptor_buffers_) {
-      if (descriptor_transfer_resources_.count(buffer) == 0) {
-        return Result(
-            "Vulkan: Pipeline::SendDescriptorDataToDeviceIfNeeded() "
-            "descriptor's transfer resource is not found");
-      }
-      Result r = descriptor_transfer_resources_[buffer]->Initialize();
+  for (auto& info : descriptor_set_info_) {
+    for (auto& desc : info.descriptors) {
+      Result r = desc->CreateResourceIfNeeded();
       if (!r.IsSuccess()) {
         return r;
       }
     }
+  }
 
-    // Note that if a buffer for a descriptor is host accessible and
-    // does not need to record a command to copy data to device, it
-    // directly writes data to the buffer. The direct write must be
-    // done after resizing backed buffer i.e., copying data to the new
-    // buffer from the old one. Thus, we must submit commands here to
-    // guarantee this.
-    Result r =
-        guard.Submit(GetFenceTimeout(), GetPipelineRuntimeLayerEnabled());
+  // Create or update the device copies of the buffers. Only the buffers
+  // whose host contents changed since they were last synced are written.
+  // Nothing is recorded for them yet, see RecordDescriptorBufferUploads().
+  for (auto buffer : buffer_descriptor_buffers_) {
+    Result r = resident_buffers_->Prepare(buffer);
+    if (!r.IsSuccess()) {
+      return r;
+    }
+  }
+
+  // Initialize transfer images which do not hold the latest contents yet,
+  // and borrow the staging buffers their contents are uploaded from.
+  std::vector<Buffer*> images_to_upload;
+  for (auto buffer : image_descriptor_buffers_) {
+    if (descriptor_transfer_resources_.count(buffer) == 0) {
+      return Result(
+          "Vulkan: Pipeline::SendDescriptorDataToDeviceIfNeeded() "
+          "descriptor's transfer resource is not found");
+    }
+    if (buffers_left_on_device_.count(buffer) > 0 ||
+        image_descriptor_generations_.count(buffer) > 0) {
+      continue;
+    }
+    auto* transfer_image =
+        descriptor_transfer_resources_[buffer]->AsTransferImage();
+    if (!transfer_image) {
+      return Result(
+          "Vulkan: Pipeline::SendDescriptorDataToDeviceIfNeeded() "
+          "this should be unreachable");
+    }
+    Result r = transfer_image->Initialize();
+    if (!r.IsSuccess()) {
+      return r;
+    }
+    r = transfer_image->AcquireStagingBuffer();
     if (!r.IsSuccess()) {
       return r;
     }
+    images_to_upload.push_back(buffer);
+  }
+
+  if (images_to_upload.empty()) {
+    return {};
   }
 
   CommandBufferGuard guard(GetCommandBuffer());
@@ -613,35 +945,76 @@ Result Pipeline::SendDescriptorDataToDeviceIfNeeded() {
     return guard.GetResult();
   }
 
-  // Copy descriptor data to transfer resources.
-  for (auto& buffer : descriptor_buffers_) {
-    if (auto transfer_buffer =
-            descriptor_transfer_resources_[buffer]->AsTransferBuffer()) {
-      BufferBackedDescriptor::RecordCopyBufferDataToTransferResourceIfNeeded(
-          GetCommandBuffer(), buffer, transfer_buffer);
-    } else if (auto transfer_image =
-                   descriptor_transfer_resources_[buffer]->AsTransferImage()) {
-      transfer_image->ImageBarrier(GetCommandBuffer(),
-                                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                                   VK_PIPELINE_STAGE_TRANSFER_BIT);
-
-      BufferBackedDescriptor::RecordCopyBufferDataToTransferResourceIfNeeded(
-          GetCommandBuffer(), buffer, transfer_image);
-
-      transfer_image->ImageBarrier(GetCommandBuffer(), VK_IMAGE_LAYOUT_GENERAL,
-                                   VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
-    } else {
-      return Result(
-          "Vulkan: Pipeline::SendDescriptorDataToDeviceIfNeeded() "
-          "this should be unreachable");
+  // Copy descriptor data to transfer images.
+  for (auto& buffer : images_to_upload) {
+    auto* transfer_image =
+        descriptor_transfer_resources_[buffer]->AsTransferImage();
+    transfer_image->ImageBarrier(GetCommandBuffer(),
+                                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                 VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+    BufferBackedDescriptor::RecordCopyBufferDataToTransferResourceIfNeeded(
+        GetCommandBuffer(), buffer, transfer_image);
+    transfer_image->ReleaseStagingBuffer();
+
+    transfer_image->ImageBarrier(GetCommandBuffer(), VK_IMAGE_LAYOUT_GENERAL,
+                                 VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+
+    // The host keeps the contents of read-only images, see
+    // RecordCopyBufferDataToTransferResourceIfNeeded().
+    if (transfer_image->IsReadOnly()) {
+      image_descriptor_generations_[buffer] = buffer->GetGeneration();
     }
   }
   return guard.Submit(GetFenceTimeout(), GetPipelineRuntimeLayerEnabled());
 }
 
+std::vector<Buffer*> Pipeline::GetDescriptorBuffers() const {
+  std::vector<Buffer*> buffers = buffer_descriptor_buffers_;
+  buffers.insert(buffers.end(), image_descriptor_buffers_.begin(),
+                 image_descriptor_buffers_.end());
+  return buffers;
+}
+
+bool Pipeline::RecordDescriptorBufferUploads(bool is_async) {
+  const bool overlaps =
+      is_async &&
+      resident_buffers_->CanOverlapAsyncCommands(GetDescriptorBuffers());
+  for (auto& buffer : buffer_descriptor_buffers_) {
+    resident_buffers_->RecordUpload(buffer, GetCommandBuffer(), !overlaps);
+  }
+  return overlaps;
+}
+
+void Pipeline::AddSubmittedCommand(bool is_async, bool overlaps) {
+  resident_buffers_->AddSubmittedCommand(GetDescriptorBuffers(), is_async,
+                                         overlaps);
+}
+
+VkPipelineBindPoint Pipeline::GetVkPipelineBindPoint() const {
+  return IsGraphics()     ? VK_PIPELINE_BIND_POINT_GRAPHICS
+         : IsCompute()    ? VK_PIPELINE_BIND_POINT_COMPUTE
+         : IsRayTracing() ? VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR
+                          : VK_PIPELINE_BIND_POINT_MAX_ENUM;
+}
+
 void Pipeline::BindVkDescriptorSets(const VkPipelineLayout& pipeline_layout) {
   for (size_t i = 0; i < descriptor_set_info_.size(); ++i) {
-    if (descriptor_set_info_[i].empty) {
+    auto& info = descriptor_set_info_[i];
+    if (info.empty) {
+      continue;
+    }
+
+    // The descriptors are recorded into the command buffer, so the pushed
+    // set never has to wait for submitted work.
+    if (info.push) {
+      WriteDescriptorInfos(&info);
+      device_->GetPtrs()->vkCmdPushDescriptorSetWithTemplateKHR(
+          command_->GetVkCommandBuffer(), info.update_template,
+          pipeline_layout, static_cast<uint32_t>(i), info.infos.data());
+      for (auto& desc : info.descriptors) {
+        desc->MarkDescriptorSetUpdated();
+      }
       continue;
     }
 
@@ -649,7 +1022,7 @@ void Pipeline::BindVkDescriptorSets(const VkPipelineLayout& pipeline_layout) {
     // offsets.
     typedef std::pair<uint32_t, std::vector<uint32_t>> binding_offsets_pair;
     std::vector<binding_offsets_pair> binding_offsets;
-    for (const auto& desc : descriptor_set_info_[i].descriptors) {
+    for (const auto& desc : info.descriptors) {
       binding_offsets.push_back(
           {desc->GetBinding(), desc->GetDynamicOffsets()});
     }
@@ -668,22 +1041,75 @@ void Pipeline::BindVkDescriptorSets(const VkPipelineLayout& pipeline_layout) {
     }
 
     device_->GetPtrs()->vkCmdBindDescriptorSets(
-        command_->GetVkCommandBuffer(),
-        IsGraphics()     ? VK_PIPELINE_BIND_POINT_GRAPHICS
-        : IsCompute()    ? VK_PIPELINE_BIND_POINT_COMPUTE
-        : IsRayTracing() ? VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR
-                         : VK_PIPELINE_BIND_POINT_MAX_ENUM,
-        pipeline_layout, static_cast<uint32_t>(i), 1,
-        &descriptor_set_info_[i].vk_desc_set,
+        command_->GetVkCommandBuffer(), GetVkPipelineBindPoint(),
+        pipeline_layout, static_cast<uint32_t>(i), 1, &info.allocation.set,
         static_cast<uint32_t>(dynamic_offsets.size()), dynamic_offsets.data());
   }
 }
 
 Result Pipeline::ReadbackDescriptorsToHostDataQueue() {
-  if (descriptor_buffers_.empty()) {
-    return Result{};
+  // The device copies of buffers bound to writable descriptors are newer
+  // than the host now.
+  std::vector<Buffer*> written_buffers;
+  for (auto& info : descriptor_set_info_) {
+    for (auto& desc : info.descriptors) {
+      BufferDescriptor* buffer_desc = desc->AsBufferDescriptor();
+      if (!buffer_desc || buffer_desc->IsReadOnly()) {
+        continue;
+      }
+      for (auto* buffer : buffer_desc->GetAmberBuffers()) {
+        resident_buffers_->MarkWrittenOnDevice(buffer);
+        written_buffers.push_back(buffer);
+      }
+    }
   }
 
+  if (!defer_readbacks_) {
+    Result r = resident_buffers_->SyncToHost(written_buffers);
+    if (!r.IsSuccess()) {
+      return r;
+    }
+    // Read-only resources are never copied back.
+    std::vector<Buffer*> writable_image_buffers;
+    for (auto& buffer : image_descriptor_buffers_) {
+      if (image_descriptor_generations_.count(buffer) == 0) {
+        writable_image_buffers.push_back(buffer);
+      }
+    }
+    if (writable_image_buffers.empty()) {
+      return {};
+    }
+    return ReadbackTransferResources(writable_image_buffers);
+  }
+
+  // Read-only resources are never copied back, and stay around until their
+  // host contents change.
+  for (auto& buffer : image_descriptor_buffers_) {
+    auto it = descriptor_transfer_resources_.find(buffer);
+    if (it == descriptor_transfer_resources_.end()) {
+      return Result(
+          "Vulkan: Pipeline::ReadbackDescriptorsToHostDataQueue() "
+          "descriptor's transfer resource is not found");
+    }
+    if (!it->second->IsReadOnly()) {
+      buffers_left_on_device_.insert(buffer);
+    }
+  }
+  return {};
+}
+
+Result Pipeline::ReadbackBuffer(Buffer* buffer) {
+  if (buffers_left_on_device_.count(buffer) == 0) {
+    return {};
+  }
+  return ReadbackTransferResources({buffer});
+}
+
+Result Pipeline::ReadbackTransferResources(
+    const std::vector<Buffer*>& buffers) {
+  TraceScope trace(device_->GetDelegate(), "readback", "ReadbackDescriptors",
+                   0);
+
   // Record required commands to copy the data to a host visible buffer.
   {
     CommandBufferGuard guard(GetCommandBuffer());
@@ -691,7 +1117,7 @@ Result Pipeline::ReadbackDescriptorsToHostDataQueue() {
       return guard.GetResult();
     }
 
-    for (auto& buffer : descriptor_buffers_) {
+    for (auto& buffer : buffers) {
       if (descriptor_transfer_resources_.count(buffer) == 0) {
         return Result(
             "Vulkan: Pipeline::ReadbackDescriptorsToHostDataQueue() "
@@ -706,6 +1132,13 @@ Result Pipeline::ReadbackDescriptorsToHostDataQueue() {
         }
       } else if (auto transfer_image = descriptor_transfer_resources_[buffer]
                                            ->AsTransferImage()) {
+        // The staging buffer goes back to the pool with the image.
+        if (!transfer_image->IsReadOnly()) {
+          Result r = transfer_image->AcquireStagingBuffer();
+          if (!r.IsSuccess()) {
+            return r;
+          }
+        }
         transfer_image->ImageBarrier(GetCommandBuffer(),
                                      VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
                                      VK_PIPELINE_STAGE_TRANSFER_BIT);
@@ -728,16 +1161,26 @@ Result Pipeline::ReadbackDescriptorsToHostDataQueue() {
     }
   }
 
+  Result r = device_->WaitForSubmissions();
+  if (!r.IsSuccess()) {
+    return r;
+  }
+
   // Move data from transfer buffers to output buffers.
-  for (auto& buffer : descriptor_buffers_) {
+  for (auto& buffer : buffers) {
     auto& transfer_resource = descriptor_transfer_resources_[buffer];
-    Result r = BufferBackedDescriptor::MoveTransferResourceToBufferOutput(
+    r = BufferBackedDescriptor::MoveTransferResourceToBufferOutput(
         transfer_resource.get(), buffer);
     if (!r.IsSuccess()) {
       return r;
     }
   }
-  descriptor_transfer_resources_.clear();
+  for (auto& buffer : buffers) {
+    if (image_descriptor_generations_.count(buffer) == 0) {
+      descriptor_transfer_resources_.erase(buffer);
+    }
+    buffers_left_on_device_.erase(buffer);
+  }
   return {};
 }
 
@@ -19,6 +19,7 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "amber/result.h"
@@ -27,8 +28,10 @@
 #include "src/engine.h"
 #include "src/vulkan/buffer_backed_descriptor.h"
 #include "src/vulkan/command_buffer.h"
+#include "src/vulkan/descriptor_set_pool.h"
 #include "src/vulkan/push_constant.h"
 #include "src/vulkan/resource.h"
+#include "src/vulkan/timestamp_query_pool.h"
 
 namespace amber {
 
@@ -40,6 +43,7 @@ class ComputePipeline;
 class Device;
 class GraphicsPipeline;
 class RayTracingPipeline;
+class ResidentBuffers;
 
 /// Base class for a pipeline in Vulkan.
 class Pipeline {
@@ -63,10 +67,35 @@ class Pipeline {
   /// Add |buffer| data to the push constants at |offset|.
   Result AddPushConstantBuffer(const Buffer* buf, uint32_t offset);
 
+  /// Returns true if all descriptors of the pipeline are buffer descriptors,
+  /// whose descriptor sets stay valid as long as the device copies of their
+  /// buffers are not replaced.
+  bool HasOnlyBufferDescriptors() const;
+
   /// Reads back the contents of resources of all descriptors to a
-  /// buffer data object and put it into buffer data queue in host.
+  /// buffer data object and put it into buffer data queue in host. If
+  /// readbacks are deferred, writable resources are left on the device
+  /// instead, until ReadbackBuffer() or ResidentBuffers::SyncToHost() asks
+  /// for them.
   Result ReadbackDescriptorsToHostDataQueue();
 
+  /// Sets the device copies of the buffers bound to buffer descriptors,
+  /// which are shared with the other pipelines of the engine. Must be set
+  /// before the first command.
+  void SetResidentBuffers(ResidentBuffers* resident_buffers) {
+    resident_buffers_ = resident_buffers;
+  }
+  ResidentBuffers* GetResidentBuffers() const { return resident_buffers_; }
+
+  /// Leave the buffers written by a command on the device instead of copying
+  /// them back to the host. See EngineData::defer_readbacks.
+  void SetDeferReadbacks(bool defer) { defer_readbacks_ = defer; }
+  bool IsDeferringReadbacks() const { return defer_readbacks_; }
+
+  /// Copies |buffer| back to the host if this pipeline left its latest
+  /// contents in one of its own resources. Does nothing otherwise.
+  virtual Result ReadbackBuffer(Buffer* buffer);
+
   std::unordered_map<Buffer*, std::unique_ptr<Resource>>&
   GetDescriptorTransferResources() {
     return descriptor_transfer_resources_;
@@ -99,16 +128,45 @@ class Pipeline {
   Result GetDescriptorSlot(uint32_t desc_set,
                            uint32_t binding,
                            Descriptor** desc);
-  void UpdateDescriptorSetsIfNeeded();
+  /// Writes the descriptor sets in which any descriptor changed, with one
+  /// call per set. Waits for the submitted work first, which may still use
+  /// the descriptor sets. Pushed descriptors are left to
+  /// BindVkDescriptorSets().
+  Result UpdateDescriptorSetsIfNeeded();
 
   // This functions are used in benchmarking when 'TIMED_EXECUTION' option is
-  // specifed.
-  void CreateTimingQueryObjectIfNeeded(bool is_timed_execution);
-  void DestroyTimingQueryObjectIfNeeded();
+  // specifed. The timestamps are read once the device's submitted work was
+  // waited for, see TimestampQueryPool.
+  Result AcquireTimingQueryIfNeeded(bool is_timed_execution);
+  void SubmitTimingQueryIfNeeded();
   void BeginTimerQuery();
   void EndTimerQuery();
 
+  // These functions are used when the 'STATISTICS' option is specified. The
+  // statistics query is placed inside the timer queries, and its counts are
+  // read as soon as the command completed.
+  Result CreateStatisticsQueryIfNeeded(bool is_pipeline_statistics);
+  void BeginStatisticsQuery();
+  void EndStatisticsQuery();
+  /// Reports the counts of the command to the delegate, or that they are
+  /// unsupported.
+  Result ReportStatisticsIfNeeded(bool is_pipeline_statistics);
+
+  /// Makes the device copies of the descriptor buffers current. Buffers whose
+  /// host contents did not change since the last command are left alone, and
+  /// nothing is submitted unless a transfer image has to be uploaded.
   Result SendDescriptorDataToDeviceIfNeeded();
+  /// Records the uploads SendDescriptorDataToDeviceIfNeeded() prepared for
+  /// buffer descriptors, and the barriers which make their device copies
+  /// visible to the commands recorded next. The barriers are left out for a
+  /// RUN ASYNC command, |is_async|, which may overlap with the ones
+  /// submitted right before it, in which case true is returned.
+  bool RecordDescriptorBufferUploads(bool is_async);
+  /// Records in the resident buffers that a command bound to the descriptor
+  /// buffers was just submitted, see ResidentBuffers::AddSubmittedCommand().
+  void AddSubmittedCommand(bool is_async, bool overlaps);
+  /// Records the binding of the descriptor sets, and the push of the
+  /// descriptors of the pushed set if there is one.
   void BindVkDescriptorSets(const VkPipelineLayout& pipeline_layout);
 
   /// Records a Vulkan command for push contant.
@@ -127,6 +185,16 @@ class Pipeline {
 
   Result CreateVkPipelineLayout(VkPipelineLayout* pipeline_layout);
 
+  /// Creates |pipeline_layout_| unless it already exists and was built for
+  /// the current push constant range. |layout_changed| is set to true when a
+  /// new layout was created, in which case pipelines built with the old one
+  /// must not be used anymore.
+  Result CreateVkPipelineLayoutIfNeeded(bool* layout_changed);
+
+  /// Destroys |pipeline_| and |pipeline_layout_| if they exist, and the
+  /// update template of the pushed set, which is created for the layout.
+  void DestroyVkPipelineAndLayout();
+
   void SetVkPipelineLayout(VkPipelineLayout pipeline_layout) {
     assert(pipeline_layout_ == VK_NULL_HANDLE);
     pipeline_layout_ = pipeline_layout;
@@ -137,7 +205,8 @@ class Pipeline {
     pipeline_ = pipeline;
   }
 
-  VkQueryPool query_pool_ = VK_NULL_HANDLE;
+  TimestampQuery timer_query_;
+  VkQueryPool statistics_query_pool_ = VK_NULL_HANDLE;
   VkPipeline pipeline_ = VK_NULL_HANDLE;
   VkPipelineLayout pipeline_layout_ = VK_NULL_HANDLE;
 
@@ -148,28 +217,72 @@ class Pipeline {
  private:
   struct DescriptorSetInfo {
     bool empty = true;
+    /// True if the descriptors are pushed while recording commands instead
+    /// of written to an allocated set.
+    bool push = false;
     VkDescriptorSetLayout layout = VK_NULL_HANDLE;
-    VkDescriptorPool pool = VK_NULL_HANDLE;
-    VkDescriptorSet vk_desc_set = VK_NULL_HANDLE;
+    DescriptorSetPool::Allocation allocation;
+    /// Writes or pushes all descriptors of the set from |infos| at once.
+    /// The template of a pushed set is created for |pipeline_layout_|.
+    VkDescriptorUpdateTemplate update_template = VK_NULL_HANDLE;
+    /// The structures describing the descriptors, see
+    /// Descriptor::WriteDescriptorInfos(). Those of |descriptors[i]| start
+    /// at |info_offsets[i]|.
+    std::vector<uint8_t> infos;
+    std::vector<size_t> info_offsets;
     std::vector<std::unique_ptr<Descriptor>> descriptors;
   };
 
   /// Creates Vulkan descriptor related objects.
   Result CreateVkDescriptorRelatedObjectsIfNeeded();
   Result CreateDescriptorSetLayouts();
-  Result CreateDescriptorPools();
+  /// Allocates the sets which are not pushed from the device's
+  /// DescriptorSetPool.
   Result CreateDescriptorSets();
+  /// Creates the update templates of the sets which are not pushed, if
+  /// the device supports them.
+  Result CreateDescriptorUpdateTemplates();
+  /// Creates the update template of the pushed set for |pipeline_layout_|.
+  Result CreatePushDescriptorUpdateTemplateIfNeeded();
+  /// Creates the update template of the set |desc_set|.
+  Result CreateDescriptorUpdateTemplate(uint32_t desc_set);
+  /// Returns true if the descriptors of |info| may be pushed.
+  bool CanPushDescriptorSet(const DescriptorSetInfo& info) const;
+  /// Fills |info.infos| from the descriptors of |info|.
+  static void WriteDescriptorInfos(DescriptorSetInfo* info);
+  /// Writes the descriptors of |info| to its set without a template.
+  void UpdateDescriptorSetWithoutTemplate(const DescriptorSetInfo& info);
+  VkPipelineBindPoint GetVkPipelineBindPoint() const;
   /// Adds a buffer used by a descriptor. The added buffers are be stored in
-  /// |descriptor_buffers_| vector in the order they are added.
-  Result AddDescriptorBuffer(Buffer* amber_buffer);
+  /// |image_descriptor_buffers_| or |buffer_descriptor_buffers_| in the
+  /// order they are added.
+  Result AddDescriptorBuffer(Buffer* amber_buffer, bool is_image);
+  /// Returns the buffers used by buffer and image descriptors.
+  std::vector<Buffer*> GetDescriptorBuffers() const;
+  /// Copies the contents of the transfer resources of |buffers| back to the
+  /// host and releases the resources.
+  Result ReadbackTransferResources(const std::vector<Buffer*>& buffers);
 
   PipelineType pipeline_type_;
   std::vector<DescriptorSetInfo> descriptor_set_info_;
   std::vector<VkPipelineShaderStageCreateInfo> shader_stage_info_;
+  /// Transfer images of the buffers used by image descriptors.
   std::unordered_map<Buffer*, std::unique_ptr<Resource>>
       descriptor_transfer_resources_;
-  /// Buffers used by descriptors (buffer descriptors and image descriptors).
-  std::vector<Buffer*> descriptor_buffers_;
+  /// Buffers used by image descriptors.
+  std::vector<Buffer*> image_descriptor_buffers_;
+  /// Buffers used by buffer descriptors. Their device copies are owned by
+  /// |resident_buffers_|.
+  std::vector<Buffer*> buffer_descriptor_buffers_;
+  /// Image descriptor buffers whose transfer images hold newer contents
+  /// than the host. Their images are kept from one command to the next.
+  std::unordered_set<Buffer*> buffers_left_on_device_;
+  /// Generations of the image descriptor buffers whose read-only transfer
+  /// images hold their host contents. These images are kept from one command
+  /// to the next until the generation changes.
+  std::unordered_map<Buffer*, uint64_t> image_descriptor_generations_;
+  ResidentBuffers* resident_buffers_ = nullptr;
+  bool defer_readbacks_ = false;
 
   uint32_t fence_timeout_ms_ = 1000;
   bool pipeline_runtime_layer_enabled_ = false;
@@ -180,7 +293,11 @@ class Pipeline {
       entry_points_;
 
   std::unique_ptr<PushConstant> push_constant_;
+  /// The push constant range |pipeline_layout_| was created with.
+  VkPushConstantRange pipeline_layout_push_constant_range_ =
+      VkPushConstantRange();
   bool in_timed_execution_ = false;
+  bool in_statistics_execution_ = false;
 };
 
 }  // namespace vulkan
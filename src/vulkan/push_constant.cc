@@ -29,7 +29,7 @@ PushConstant::PushConstant(Device* device)
 
 PushConstant::~PushConstant() = default;
 
-VkPushConstantRange PushConstant::GetVkPushConstantRange() {
+VkPushConstantRange PushConstant::GetVkPushConstantRange() const {
   if (push_constant_data_.empty()) {
     return VkPushConstantRange();
   }
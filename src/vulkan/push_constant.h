@@ -36,7 +36,7 @@ class PushConstant {
 
   /// Retrieves a `VkPushConstantRange` class describing our push constant
   /// requirements.
-  VkPushConstantRange GetVkPushConstantRange();
+  VkPushConstantRange GetVkPushConstantRange() const;
 
   Result RecordPushConstantVkCommand(CommandBuffer* command,
                                      VkPipelineLayout pipeline_layout);
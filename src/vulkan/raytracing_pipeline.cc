@@ -117,8 +117,8 @@ Result RayTracingPipeline::CreateVkRayTracingPipeline(
   };
 
   VkResult r = device_->GetPtrs()->vkCreateRayTracingPipelinesKHR(
-      device_->GetVkDevice(), VK_NULL_HANDLE, VK_NULL_HANDLE, 1u,
-      &pipelineCreateInfo, nullptr, pipeline);
+      device_->GetVkDevice(), VK_NULL_HANDLE, device_->GetVkPipelineCache(),
+      1u, &pipelineCreateInfo, nullptr, pipeline);
   if (r != VK_SUCCESS) {
     return Result("Vulkan::Calling vkCreateRayTracingPipelinesKHR Fail");
   }
@@ -192,8 +192,16 @@ Result RayTracingPipeline::TraceRays(amber::SBT* rSBT,
                                      uint32_t maxPipelineRayHitAttributeSize,
                                      uint32_t maxPipelineRayRecursionDepth,
                                      const std::vector<VkPipeline>& libs,
-                                     bool is_timed_execution) {
-  Result r = SendDescriptorDataToDeviceIfNeeded();
+                                     bool is_timed_execution,
+                                     bool is_pipeline_statistics) {
+  // The acceleration structures are built again by every trace, so the
+  // previous one must have completed.
+  Result r = device_->WaitForSubmissions();
+  if (!r.IsSuccess()) {
+    return r;
+  }
+
+  r = SendDescriptorDataToDeviceIfNeeded();
   if (!r.IsSuccess()) {
     return r;
   }
@@ -207,14 +215,26 @@ Result RayTracingPipeline::TraceRays(amber::SBT* rSBT,
   // Note that a command updating a descriptor set and a command using
   // it must be submitted separately, because using a descriptor set
   // while updating it is not safe.
-  UpdateDescriptorSetsIfNeeded();
-  CreateTimingQueryObjectIfNeeded(is_timed_execution);
+  r = UpdateDescriptorSetsIfNeeded();
+  if (!r.IsSuccess()) {
+    return r;
+  }
+  r = AcquireTimingQueryIfNeeded(is_timed_execution);
+  if (!r.IsSuccess()) {
+    return r;
+  }
+  r = CreateStatisticsQueryIfNeeded(is_pipeline_statistics);
+  if (!r.IsSuccess()) {
+    return r;
+  }
   {
     CommandBufferGuard guard(GetCommandBuffer());
     if (!guard.IsRecording()) {
       return guard.GetResult();
     }
 
+    // TLAS builds rely on the barriers, so commands stay ordered.
+    RecordDescriptorBufferUploads(false);
     for (auto& i : *blases_) {
       i.second->BuildBLAS(GetCommandBuffer());
     }
@@ -258,17 +278,23 @@ Result RayTracingPipeline::TraceRays(amber::SBT* rSBT,
       return r;
     }
 
+    BeginTimerQuery();
+    BeginStatisticsQuery();
     device_->GetPtrs()->vkCmdTraceRaysKHR(command_->GetVkCommandBuffer(),
                                           &rSBTRegion, &mSBTRegion, &hSBTRegion,
                                           &cSBTRegion, x, y, z);
-    BeginTimerQuery();
-    r = guard.Submit(GetFenceTimeout(), GetPipelineRuntimeLayerEnabled());
+    EndStatisticsQuery();
     EndTimerQuery();
+    r = guard.Submit(GetFenceTimeout(), GetPipelineRuntimeLayerEnabled());
     if (!r.IsSuccess()) {
       return r;
     }
   }
-  DestroyTimingQueryObjectIfNeeded();
+  SubmitTimingQueryIfNeeded();
+  r = ReportStatisticsIfNeeded(is_pipeline_statistics);
+  if (!r.IsSuccess()) {
+    return r;
+  }
   r = ReadbackDescriptorsToHostDataQueue();
   if (!r.IsSuccess()) {
     return r;
@@ -65,7 +65,8 @@ class RayTracingPipeline : public Pipeline {
                    uint32_t maxPipelineRayHitAttributeSize,
                    uint32_t maxPipelineRayRecursionDepth,
                    const std::vector<VkPipeline>& lib,
-                   bool is_timed_execution);
+                   bool is_timed_execution,
+                   bool is_pipeline_statistics);
 
   BlasesMap* GetBlases() override { return blases_; }
   TlasesMap* GetTlases() override { return tlases_; }
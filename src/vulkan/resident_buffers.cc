@@ -0,0 +1,351 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/vulkan/resident_buffers.h"
+
+#include <cstring>
+#include <utility>
+
+#include "src/trace_scope.h"
+#include "src/vulkan/command_pool.h"
+#include "src/vulkan/device.h"
+
+namespace amber {
+namespace vulkan {
+
+ResidentBuffers::ResidentBuffers(Device* device,
+                                 uint32_t fence_timeout_ms,
+                                 bool pipeline_runtime_layer_enabled,
+                                 BufferPlacement default_placement)
+    : device_(device),
+      fence_timeout_ms_(fence_timeout_ms),
+      pipeline_runtime_layer_enabled_(pipeline_runtime_layer_enabled),
+      default_placement_(default_placement) {}
+
+ResidentBuffers::~ResidentBuffers() {
+  // The command buffer must go before the buffers it may reference.
+  command_ = nullptr;
+}
+
+Result ResidentBuffers::Initialize(CommandPool* pool) {
+  command_ = std::make_unique<CommandBuffer>(device_, pool);
+  return command_->Initialize();
+}
+
+void ResidentBuffers::AddUsageFlags(Buffer* buffer, VkBufferUsageFlags flags) {
+  entries_[buffer].usage_flags |= flags;
+}
+
+Result ResidentBuffers::Prepare(Buffer* buffer) {
+  auto it = entries_.find(buffer);
+  if (it == entries_.end()) {
+    return Result(
+        "Vulkan: ResidentBuffers::Prepare() buffer has no usage flags");
+  }
+  Entry& entry = it->second;
+
+  const Buffer* host = buffer;
+  if (IsHostNewer(host, entry)) {
+    entry.state = State::kHost;
+  }
+  const auto host_size = static_cast<uint32_t>(host->ValuePtr()->size());
+  const bool flags_changed = entry.created_usage_flags != entry.usage_flags;
+  // Nothing is written while the device copy is current and fits.
+  if (entry.transfer_buffer && entry.state != State::kHost && !flags_changed) {
+    return {};
+  }
+
+  TraceScope trace(device_->GetDelegate(), "descriptor", "UploadBuffer", 0);
+  if (entry.transfer_buffer &&
+      (entry.state == State::kHost || flags_changed)) {
+    // The device copy is written through its host mapping or replaced below,
+    // and submitted work may still use it.
+    Result r = device_->WaitForSubmissions();
+    if (!r.IsSuccess()) {
+      return r;
+    }
+  }
+
+  if (!entry.transfer_buffer) {
+    Result r = CreateTransferBuffer(buffer, host_size, &entry);
+    if (!r.IsSuccess()) {
+      return r;
+    }
+    entry.state = State::kHost;
+  } else if (entry.state == State::kHost &&
+             (flags_changed ||
+              entry.transfer_buffer->GetSizeInBytes() != host_size)) {
+    // The contents are uploaded below anyway.
+    Result r = CreateTransferBuffer(buffer, host_size, &entry);
+    if (!r.IsSuccess()) {
+      return r;
+    }
+  } else if (flags_changed) {
+    // Another pipeline binds the buffer in a new way. Keep the contents of
+    // the old copy, which may be newer than the host ones.
+    std::unique_ptr<TransferBuffer> old = std::move(entry.transfer_buffer);
+    Result r = CreateTransferBuffer(buffer, old->GetSizeInBytes(), &entry);
+    if (!r.IsSuccess()) {
+      return r;
+    }
+    if (!old->HasStagingBuffer() &&
+        !entry.transfer_buffer->HasStagingBuffer()) {
+      std::memcpy(entry.transfer_buffer->HostAccessibleMemoryPtr(),
+                  old->HostAccessibleMemoryPtr(), old->GetSizeInBytes());
+    } else {
+      // The old copy must outlive the transfer.
+      r = CopyOnDevice(old.get(), entry.transfer_buffer.get());
+      if (!r.IsSuccess()) {
+        return r;
+      }
+      r = device_->WaitForSubmissions();
+      if (!r.IsSuccess()) {
+        return r;
+      }
+    }
+  }
+
+  if (entry.state == State::kHost) {
+    entry.transfer_buffer->UpdateMemoryWithRawData(*host->ValuePtr());
+    entry.upload_pending = entry.transfer_buffer->HasStagingBuffer();
+    entry.state = State::kSynced;
+    entry.host_generation = host->GetGeneration();
+  }
+  return {};
+}
+
+void ResidentBuffers::RecordUpload(const Buffer* buffer,
+                                   CommandBuffer* command_buffer,
+                                   bool record_barrier) {
+  auto it = entries_.find(buffer);
+  if (it == entries_.end() || !it->second.transfer_buffer) {
+    return;
+  }
+  Entry& entry = it->second;
+  if (entry.upload_pending) {
+    TraceScope trace(device_->GetDelegate(), "descriptor", "RecordBufferUpload",
+                     0);
+    entry.transfer_buffer->CopyToDevice(command_buffer);
+    entry.upload_pending = false;
+  } else if (record_barrier) {
+    entry.transfer_buffer->RecordBarrier(command_buffer);
+  }
+}
+
+bool ResidentBuffers::CanOverlapAsyncCommands(
+    const std::vector<Buffer*>& buffers) const {
+  if (!async_commands_open_ ||
+      async_commands_submission_count_ != device_->GetSubmissionCount() ||
+      device_->GetCaptureCommandBuffer() != nullptr) {
+    return false;
+  }
+  for (const auto* buffer : buffers) {
+    if (async_commands_buffers_.count(buffer) > 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ResidentBuffers::AddSubmittedCommand(const std::vector<Buffer*>& buffers,
+                                          bool is_async,
+                                          bool overlaps) {
+  if (!is_async || device_->GetCaptureCommandBuffer() != nullptr) {
+    EndAsyncCommands();
+    return;
+  }
+  if (!overlaps) {
+    async_commands_buffers_.clear();
+  }
+  // The command was submitted already, so the count includes it.
+  async_commands_open_ = true;
+  async_commands_submission_count_ = device_->GetSubmissionCount();
+  async_commands_buffers_.insert(buffers.begin(), buffers.end());
+}
+
+void ResidentBuffers::EndAsyncCommands() {
+  async_commands_open_ = false;
+  async_commands_buffers_.clear();
+}
+
+TransferBuffer* ResidentBuffers::GetTransferBuffer(const Buffer* buffer) const {
+  auto it = entries_.find(buffer);
+  return it == entries_.end() ? nullptr : it->second.transfer_buffer.get();
+}
+
+void ResidentBuffers::MarkWrittenOnDevice(const Buffer* buffer) {
+  auto it = entries_.find(buffer);
+  if (it != entries_.end() && it->second.transfer_buffer) {
+    it->second.state = State::kDevice;
+  }
+}
+
+void ResidentBuffers::MarkHostNewer(const Buffer* buffer) {
+  auto it = entries_.find(buffer);
+  if (it != entries_.end()) {
+    it->second.state = State::kHost;
+  }
+}
+
+bool ResidentBuffers::IsCurrentOnDevice(const Buffer* buffer) const {
+  auto it = entries_.find(buffer);
+  return it != entries_.end() && it->second.transfer_buffer &&
+         !IsHostNewer(buffer, it->second);
+}
+
+Result ResidentBuffers::SyncToHost(const std::vector<Buffer*>& buffers) {
+  std::vector<Buffer*> device_newer;
+  for (auto* buffer : buffers) {
+    auto it = entries_.find(buffer);
+    if (it != entries_.end() && it->second.state == State::kDevice) {
+      device_newer.push_back(buffer);
+    }
+  }
+
+  if (device_newer.empty()) {
+    return {};
+  }
+
+  TraceScope trace(device_->GetDelegate(), "readback", "ReadbackBuffers", 0);
+  {
+    CommandBufferGuard guard(command_.get());
+    if (!guard.IsRecording()) {
+      return guard.GetResult();
+    }
+    for (auto* buffer : device_newer) {
+      entries_[buffer].transfer_buffer->CopyToHost(command_.get());
+    }
+    Result r = guard.Submit(fence_timeout_ms_, pipeline_runtime_layer_enabled_);
+    if (!r.IsSuccess()) {
+      return r;
+    }
+    r = device_->WaitForSubmissions();
+    if (!r.IsSuccess()) {
+      return r;
+    }
+  }
+
+  for (auto* buffer : device_newer) {
+    const TransferBuffer* transfer_buffer =
+        entries_[buffer].transfer_buffer.get();
+    const uint32_t size_in_bytes = transfer_buffer->GetSizeInBytes();
+    buffer->SetElementCount(size_in_bytes / buffer->GetFormat()->SizeInBytes());
+    buffer->ValuePtr()->resize(size_in_bytes);
+    std::memcpy(buffer->ValuePtr()->data(),
+                transfer_buffer->HostAccessibleMemoryPtr(), size_in_bytes);
+
+    // Any later change of the host contents changes the generation.
+    Entry& entry = entries_[buffer];
+    entry.state = State::kSynced;
+    entry.host_generation = buffer->GetGeneration();
+  }
+  return {};
+}
+
+Result ResidentBuffers::Copy(Buffer* from, Buffer* to) {
+  if (!IsCurrentOnDevice(from) || !IsResident(to)) {
+    return Result(
+        "Vulkan: ResidentBuffers::Copy() buffers are not on the device");
+  }
+
+  TransferBuffer* src = entries_[from].transfer_buffer.get();
+  Entry& dst_entry = entries_[to];
+  if (!dst_entry.transfer_buffer ||
+      dst_entry.created_usage_flags != dst_entry.usage_flags ||
+      dst_entry.transfer_buffer->GetSizeInBytes() != src->GetSizeInBytes()) {
+    // Submitted work may still use the copy being replaced.
+    Result r = device_->WaitForSubmissions();
+    if (!r.IsSuccess()) {
+      return r;
+    }
+    r = CreateTransferBuffer(to, src->GetSizeInBytes(), &dst_entry);
+    if (!r.IsSuccess()) {
+      return r;
+    }
+  }
+
+  Result r = CopyOnDevice(src, dst_entry.transfer_buffer.get());
+  if (!r.IsSuccess()) {
+    return r;
+  }
+
+  dst_entry.state = State::kDevice;
+  dst_entry.upload_pending = false;
+  return {};
+}
+
+bool ResidentBuffers::CopiesInPlace(const Buffer* from,
+                                    const Buffer* to) const {
+  auto from_it = entries_.find(from);
+  auto to_it = entries_.find(to);
+  if (from_it == entries_.end() || to_it == entries_.end() ||
+      !from_it->second.transfer_buffer || !to_it->second.transfer_buffer) {
+    return false;
+  }
+  const Entry& dst_entry = to_it->second;
+  return dst_entry.created_usage_flags == dst_entry.usage_flags &&
+         dst_entry.transfer_buffer->GetSizeInBytes() ==
+             from_it->second.transfer_buffer->GetSizeInBytes();
+}
+
+Result ResidentBuffers::CreateTransferBuffer(Buffer* buffer,
+                                             uint32_t size_in_bytes,
+                                             Entry* entry) {
+  auto transfer_buffer = std::make_unique<TransferBuffer>(
+      device_, size_in_bytes, buffer->GetFormat());
+  const BufferPlacement placement =
+      buffer->GetPlacement() == BufferPlacement::kDefault
+          ? default_placement_
+          : buffer->GetPlacement();
+  if (placement == BufferPlacement::kDeviceLocal) {
+    transfer_buffer->SetMemoryPropertiesFlags(
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+  }
+  Result r = transfer_buffer->AddUsageFlags(entry->usage_flags |
+                                            VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                            VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+  if (!r.IsSuccess()) {
+    return r;
+  }
+  r = transfer_buffer->Initialize();
+  if (!r.IsSuccess()) {
+    return r;
+  }
+
+  entry->transfer_buffer = std::move(transfer_buffer);
+  entry->created_usage_flags = entry->usage_flags;
+  entry->upload_pending = false;
+  ++generation_;
+  return {};
+}
+
+Result ResidentBuffers::CopyOnDevice(TransferBuffer* src, TransferBuffer* dst) {
+  CommandBufferGuard guard(command_.get());
+  if (!guard.IsRecording()) {
+    return guard.GetResult();
+  }
+
+  src->RecordBarrier(command_.get());
+  VkBufferCopy region = VkBufferCopy();
+  region.size = src->GetSizeInBytes();
+  device_->GetPtrs()->vkCmdCopyBuffer(command_->GetVkCommandBuffer(),
+                                      src->GetVkBuffer(), dst->GetVkBuffer(), 1,
+                                      &region);
+  dst->RecordBarrier(command_.get());
+
+  return guard.Submit(fence_timeout_ms_, pipeline_runtime_layer_enabled_);
+}
+
+}  // namespace vulkan
+}  // namespace amber
@@ -0,0 +1,184 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_VULKAN_RESIDENT_BUFFERS_H_
+#define SRC_VULKAN_RESIDENT_BUFFERS_H_
+
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "amber/result.h"
+#include "amber/vulkan_header.h"
+#include "src/buffer.h"
+#include "src/vulkan/command_buffer.h"
+#include "src/vulkan/transfer_buffer.h"
+
+namespace amber {
+namespace vulkan {
+
+class CommandPool;
+class Device;
+
+/// Device copies of the buffers bound to buffer descriptors, shared by all
+/// pipelines of an engine. A buffer written by one pipeline is read by the
+/// next one straight from the device, and is only copied back to the host
+/// when SyncToHost() asks for it.
+///
+/// A copy placed in device local memory the host cannot map is written and
+/// read through a staging buffer, see TransferBuffer::HasStagingBuffer().
+class ResidentBuffers {
+ public:
+  /// Buffers which ask for BufferPlacement::kDefault are placed according to
+  /// |default_placement|.
+  ResidentBuffers(Device* device,
+                  uint32_t fence_timeout_ms,
+                  bool pipeline_runtime_layer_enabled,
+                  BufferPlacement default_placement);
+  ~ResidentBuffers();
+
+  Result Initialize(CommandPool* pool);
+
+  /// Adds |flags| to the usage flags the device copy of |buffer| is created
+  /// with. The copy is recreated by Prepare() if it lacks any of them.
+  void AddUsageFlags(Buffer* buffer, VkBufferUsageFlags flags);
+
+  /// Returns true if |buffer| was registered with AddUsageFlags().
+  bool IsResident(const Buffer* buffer) const {
+    return entries_.count(buffer) > 0;
+  }
+
+  /// Creates the device copy of |buffer| if needed and uploads the host
+  /// contents to it if they are newer, which is the case when the generation
+  /// of |buffer| changed since the copy was last synced with the host.
+  /// Nothing is recorded, the copy or its staging buffer is written through
+  /// its host mapping once the submitted work completed. Does nothing when
+  /// the device copy is current.
+  Result Prepare(Buffer* buffer);
+  /// Records the commands which make the device copy of |buffer| ready for
+  /// the next command on |command_buffer|: the copy of the contents Prepare()
+  /// left in the staging buffer, if any, and a memory barrier. The barrier is
+  /// left out if |record_barrier| is false and there is nothing to copy.
+  void RecordUpload(const Buffer* buffer,
+                    CommandBuffer* command_buffer,
+                    bool record_barrier);
+
+  /// Returns true if a RUN ASYNC command bound to |buffers| may skip the
+  /// barriers of RecordUpload() and overlap on the device with the RUN ASYNC
+  /// commands submitted right before it. That is the case when nothing else
+  /// was submitted since, no REPEAT body is being captured, and none of
+  /// those commands was bound to any of |buffers|.
+  bool CanOverlapAsyncCommands(const std::vector<Buffer*>& buffers) const;
+  /// Records that a command bound to |buffers| was just submitted. A RUN
+  /// ASYNC command joins the commands submitted right before it if it
+  /// |overlaps| with them, as CanOverlapAsyncCommands() allowed before it was
+  /// recorded, or starts a new group. Any other command ends the group.
+  void AddSubmittedCommand(const std::vector<Buffer*>& buffers,
+                           bool is_async,
+                           bool overlaps);
+  /// Ends the group of RUN ASYNC commands, once the host waited for them.
+  void EndAsyncCommands();
+
+  /// Returns the device copy of |buffer|, or nullptr if Prepare() was never
+  /// called for it.
+  TransferBuffer* GetTransferBuffer(const Buffer* buffer) const;
+
+  /// Records that a command may have written the device copy of |buffer|.
+  void MarkWrittenOnDevice(const Buffer* buffer);
+  /// Records that the host contents of |buffer| changed, so they have to be
+  /// uploaded before the next use of the device copy.
+  void MarkHostNewer(const Buffer* buffer);
+  /// Returns true if the device copy of |buffer| holds its latest contents.
+  bool IsCurrentOnDevice(const Buffer* buffer) const;
+
+  /// Returns a number which changes whenever a device copy is created, and
+  /// with it the VkBuffer descriptor sets have to refer to. Never 0 once a
+  /// device copy exists.
+  uint64_t GetGeneration() const { return generation_; }
+
+  /// Copies the device copies of |buffers| which are newer than the host
+  /// back to the host. Both hold the same contents afterwards, until the
+  /// caller changes the generation of a buffer.
+  Result SyncToHost(const std::vector<Buffer*>& buffers);
+
+  /// Copies the device copy of |from| to the device copy of |to| with a
+  /// single transfer command. |from| must be current on the device and |to|
+  /// must be resident.
+  Result Copy(Buffer* from, Buffer* to);
+  /// Returns true if Copy() would write the existing device copy of |to|
+  /// instead of creating a new one.
+  bool CopiesInPlace(const Buffer* from, const Buffer* to) const;
+
+ private:
+  enum class State : uint8_t {
+    /// The host holds newer contents than the device copy.
+    kHost = 0,
+    /// The host and the device copy hold the same contents.
+    kSynced,
+    /// The device copy holds newer contents than the host.
+    kDevice,
+  };
+
+  struct Entry {
+    std::unique_ptr<TransferBuffer> transfer_buffer;
+    /// The usage flags requested for the buffer.
+    VkBufferUsageFlags usage_flags = 0;
+    /// The usage flags |transfer_buffer| was created with.
+    VkBufferUsageFlags created_usage_flags = 0;
+    State state = State::kHost;
+    /// True if the staging buffer of |transfer_buffer| holds contents which
+    /// RecordUpload() has yet to copy to the device.
+    bool upload_pending = false;
+    /// The generation of the buffer when the host and the device copy last
+    /// held the same contents. Only meaningful in State::kSynced.
+    uint64_t host_generation = 0;
+  };
+
+  /// Returns true if the host contents of |buffer| are newer than the device
+  /// copy described by |entry|.
+  static bool IsHostNewer(const Buffer* buffer, const Entry& entry) {
+    return entry.state == State::kHost ||
+           (entry.state == State::kSynced &&
+            entry.host_generation != buffer->GetGeneration());
+  }
+
+  /// Replaces the device copy of |buffer| with a new one of
+  /// |size_in_bytes| bytes. The contents of the old copy are lost.
+  Result CreateTransferBuffer(Buffer* buffer,
+                              uint32_t size_in_bytes,
+                              Entry* entry);
+  /// Copies |src| to |dst| with a single transfer command.
+  Result CopyOnDevice(TransferBuffer* src, TransferBuffer* dst);
+
+  Device* device_ = nullptr;
+  std::unique_ptr<CommandBuffer> command_;
+  uint32_t fence_timeout_ms_ = 1000;
+  bool pipeline_runtime_layer_enabled_ = false;
+  BufferPlacement default_placement_ = BufferPlacement::kHostVisible;
+  std::unordered_map<const Buffer*, Entry> entries_;
+  uint64_t generation_ = 0;
+
+  /// True while the last command submitted was a RUN ASYNC command.
+  bool async_commands_open_ = false;
+  /// The submission count of the device after the last RUN ASYNC command.
+  uint64_t async_commands_submission_count_ = 0;
+  /// The buffers bound to the RUN ASYNC commands submitted last in a row.
+  std::unordered_set<const Buffer*> async_commands_buffers_;
+};
+
+}  // namespace vulkan
+}  // namespace amber
+
+#endif  // SRC_VULKAN_RESIDENT_BUFFERS_H_
@@ -102,7 +102,7 @@ uint32_t Resource::ChooseMemory(uint32_t memory_type_bits,
   return first_non_zero;
 }
 Result Resource::AllocateAndBindMemoryToVkBuffer(VkBuffer buffer,
-                                                 VkDeviceMemory* memory,
+                                                 MemoryAllocation* memory,
                                                  VkMemoryPropertyFlags flags,
                                                  bool require_flags_found,
                                                  uint32_t* memory_type_index) {
@@ -118,7 +118,7 @@ Result Resource::AllocateAndBindMemoryToVkBuffer(VkBuffer buffer,
     return Result("Vulkan::Given VkBuffer is VK_NULL_HANDLE");
   }
   if (memory == nullptr) {
-    return Result("Vulkan::Given VkDeviceMemory pointer is nullptr");
+    return Result("Vulkan::Given MemoryAllocation pointer is nullptr");
   }
 
   VkMemoryRequirements requirement;
@@ -131,60 +131,48 @@ Result Resource::AllocateAndBindMemoryToVkBuffer(VkBuffer buffer,
     return Result("Vulkan::Find Proper Memory Fail");
   }
 
-  Result r = AllocateMemory(memory, requirement.size, *memory_type_index);
+  Result r = AllocateMemory(memory, requirement, *memory_type_index, true);
   if (!r.IsSuccess()) {
     return r;
   }
 
   if (device_->GetPtrs()->vkBindBufferMemory(device_->GetVkDevice(), buffer,
-                                             *memory, 0) != VK_SUCCESS) {
+                                             memory->memory,
+                                             memory->offset) != VK_SUCCESS) {
     return Result("Vulkan::Calling vkBindBufferMemory Fail");
   }
 
   return {};
 }
 
-Result Resource::AllocateMemory(VkDeviceMemory* memory,
-                                VkDeviceSize size,
-                                uint32_t memory_type_index) {
-  VkMemoryAllocateInfo alloc_info = VkMemoryAllocateInfo();
-  VkMemoryAllocateFlagsInfo allocFlagsInfo = VkMemoryAllocateFlagsInfo();
-
-  alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  alloc_info.allocationSize = size;
-  alloc_info.memoryTypeIndex = memory_type_index;
-
-  if (memory_allocate_flags_ != 0) {
-    allocFlagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
-    allocFlagsInfo.pNext = nullptr;
-    allocFlagsInfo.flags = memory_allocate_flags_;
-    allocFlagsInfo.deviceMask = 0u;
-
-    alloc_info.pNext = &allocFlagsInfo;
-  }
+Result Resource::AllocateMemory(MemoryAllocation* memory,
+                                const VkMemoryRequirements& requirements,
+                                uint32_t memory_type_index,
+                                bool is_linear) {
+  return device_->GetMemoryAllocator()->Allocate(
+      requirements, memory_type_index, memory_allocate_flags_, is_linear,
+      memory);
+}
 
-  if (device_->GetPtrs()->vkAllocateMemory(device_->GetVkDevice(), &alloc_info,
-                                           nullptr, memory) != VK_SUCCESS) {
-    return Result("Vulkan::Calling vkAllocateMemory Fail");
+void Resource::FreeMemory(MemoryAllocation* memory) {
+  if (memory->block_id == 0) {
+    return;
   }
 
-  return {};
+  device_->GetMemoryAllocator()->Free(*memory);
+  *memory = MemoryAllocation();
 }
 
-Result Resource::MapMemory(VkDeviceMemory memory) {
-  if (device_->GetPtrs()->vkMapMemory(device_->GetVkDevice(), memory, 0,
-                                      VK_WHOLE_SIZE, 0,
-                                      &memory_ptr_) != VK_SUCCESS) {
+Result Resource::MapMemory(const MemoryAllocation& memory) {
+  // The allocator maps host visible blocks when it creates them.
+  if (memory.host_ptr == nullptr) {
     return Result("Vulkan::Calling vkMapMemory Fail");
   }
 
+  memory_ptr_ = memory.host_ptr;
   return {};
 }
 
-void Resource::UnMapMemory(VkDeviceMemory memory) {
-  device_->GetPtrs()->vkUnmapMemory(device_->GetVkDevice(), memory);
-}
-
 void Resource::UpdateMemoryWithRawData(const std::vector<uint8_t>& raw_data) {
   size_t effective_size =
       raw_data.size() > GetSizeInBytes() ? GetSizeInBytes() : raw_data.size();
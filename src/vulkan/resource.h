@@ -23,6 +23,7 @@
 #include "amber/result.h"
 #include "amber/value.h"
 #include "amber/vulkan_header.h"
+#include "src/vulkan/memory_allocator.h"
 
 namespace amber {
 
@@ -81,13 +82,14 @@ class Resource {
   Result CreateVkBuffer(VkBuffer* buffer, VkBufferUsageFlags usage);
 
   Result AllocateAndBindMemoryToVkBuffer(VkBuffer buffer,
-                                         VkDeviceMemory* memory,
+                                         MemoryAllocation* memory,
                                          VkMemoryPropertyFlags flags,
                                          bool force_flags,
                                          uint32_t* memory_type_index);
 
-  Result MapMemory(VkDeviceMemory memory);
-  void UnMapMemory(VkDeviceMemory memory);
+  /// Makes the host address of |memory| the memory pointer of this resource.
+  /// |memory| must have been allocated from host visible memory.
+  Result MapMemory(const MemoryAllocation& memory);
   void SetMemoryPtr(void* ptr) { memory_ptr_ = ptr; }
 
   /// Records a memory barrier on |command_buffer|, to ensure prior writes to
@@ -103,9 +105,14 @@ class Resource {
   uint32_t ChooseMemory(uint32_t memory_type_bits,
                         VkMemoryPropertyFlags flags,
                         bool require_flags_found);
-  Result AllocateMemory(VkDeviceMemory* memory,
-                        VkDeviceSize size,
-                        uint32_t memory_type_index);
+  /// Allocates memory satisfying |requirements| from the device allocator.
+  /// |is_linear| must be false for images with optimal tiling.
+  Result AllocateMemory(MemoryAllocation* memory,
+                        const VkMemoryRequirements& requirements,
+                        uint32_t memory_type_index,
+                        bool is_linear);
+  /// Returns |memory| to the device allocator and resets it.
+  void FreeMemory(MemoryAllocation* memory);
 
   Device* device_ = nullptr;
 
@@ -32,6 +32,11 @@ SamplerDescriptor::SamplerDescriptor(amber::Sampler* sampler,
 SamplerDescriptor::~SamplerDescriptor() = default;
 
 Result SamplerDescriptor::CreateResourceIfNeeded() {
+  if (!vulkan_samplers_.empty()) {
+    return {};
+  }
+
+  is_descriptor_set_update_needed_ = true;
   vulkan_samplers_.reserve(amber_samplers_.size());
   for (const auto& sampler : amber_samplers_) {
     vulkan_samplers_.emplace_back(std::make_unique<Sampler>(device_));
@@ -44,27 +49,13 @@ Result SamplerDescriptor::CreateResourceIfNeeded() {
   return {};
 }
 
-void SamplerDescriptor::UpdateDescriptorSetIfNeeded(
-    VkDescriptorSet descriptor_set) {
-  std::vector<VkDescriptorImageInfo> image_infos;
+void SamplerDescriptor::WriteDescriptorInfos(void* infos) {
+  auto* image_infos = static_cast<VkDescriptorImageInfo*>(infos);
 
   for (auto& sampler : vulkan_samplers_) {
-    VkDescriptorImageInfo image_info = {sampler->GetVkSampler(), VK_NULL_HANDLE,
-                                        VK_IMAGE_LAYOUT_GENERAL};
-    image_infos.push_back(image_info);
+    *image_infos++ = {sampler->GetVkSampler(), VK_NULL_HANDLE,
+                      VK_IMAGE_LAYOUT_GENERAL};
   }
-
-  VkWriteDescriptorSet write = VkWriteDescriptorSet();
-  write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-  write.dstSet = descriptor_set;
-  write.dstBinding = binding_;
-  write.dstArrayElement = 0;
-  write.descriptorCount = static_cast<uint32_t>(image_infos.size());
-  write.descriptorType = GetVkDescriptorType();
-  write.pImageInfo = image_infos.data();
-
-  device_->GetPtrs()->vkUpdateDescriptorSets(device_->GetVkDevice(), 1, &write,
-                                             0, nullptr);
 }
 
 }  // namespace vulkan
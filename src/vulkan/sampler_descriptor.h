@@ -34,7 +34,13 @@ class SamplerDescriptor : public Descriptor {
                     uint32_t binding);
   ~SamplerDescriptor() override;
 
-  void UpdateDescriptorSetIfNeeded(VkDescriptorSet descriptor_set) override;
+  bool IsDescriptorSetUpdateNeeded() const override {
+    return is_descriptor_set_update_needed_;
+  }
+  void WriteDescriptorInfos(void* infos) override;
+  void MarkDescriptorSetUpdated() override {
+    is_descriptor_set_update_needed_ = false;
+  }
   Result CreateResourceIfNeeded() override;
   void AddAmberSampler(amber::Sampler* sampler) {
     amber_samplers_.push_back(sampler);
@@ -0,0 +1,140 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/vulkan/staging_pool.h"
+
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <utility>
+
+#include "src/vulkan/device.h"
+
+namespace amber {
+namespace vulkan {
+
+StagingPool::StagingPool(Device* device) : device_(device) {}
+
+StagingPool::~StagingPool() = default;
+
+uint32_t StagingPool::GetBucketSize(uint32_t size_in_bytes) {
+  if (size_in_bytes <= kMinBufferSize) {
+    return kMinBufferSize;
+  }
+
+  // Above each power of two the buckets are a quarter of it apart, so less
+  // than a fifth of a buffer goes unused.
+  uint64_t power = kMinBufferSize;
+  while (power * 2 < size_in_bytes) {
+    power *= 2;
+  }
+  const uint64_t step = power / 4;
+  const uint64_t bucket_size = (size_in_bytes + step - 1) / step * step;
+  if (bucket_size > std::numeric_limits<uint32_t>::max()) {
+    return size_in_bytes;
+  }
+  return static_cast<uint32_t>(bucket_size);
+}
+
+Result StagingPool::Acquire(uint32_t size_in_bytes,
+                            std::unique_ptr<TransferBuffer>* buffer) {
+  const uint32_t bucket_size = GetBucketSize(size_in_bytes);
+  if (TakeIdle(bucket_size, buffer)) {
+    return {};
+  }
+
+  // Rather than going over the cap, wait for the buffers given back earlier
+  // to become idle.
+  if (!retired_.empty() && pooled_bytes_ + bucket_size > max_bytes_) {
+    Result r = device_->WaitForSubmissions();
+    if (!r.IsSuccess()) {
+      return r;
+    }
+    if (TakeIdle(bucket_size, buffer)) {
+      return {};
+    }
+  }
+  Trim(bucket_size);
+
+  auto staging =
+      std::make_unique<TransferBuffer>(device_, bucket_size, nullptr);
+  Result r = staging->AddUsageFlags(VK_BUFFER_USAGE_TRANSFER_SRC_BIT |
+                                    VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+  if (!r.IsSuccess()) {
+    return r;
+  }
+  r = staging->Initialize();
+  if (!r.IsSuccess()) {
+    return r;
+  }
+
+  pooled_bytes_ += bucket_size;
+  *buffer = std::move(staging);
+  return {};
+}
+
+void StagingPool::Release(std::unique_ptr<TransferBuffer> buffer) {
+  if (!buffer) {
+    return;
+  }
+
+  Retired retired;
+  retired.buffer = std::move(buffer);
+  retired.submission = device_->GetSubmissionCount();
+  retired_.push_back(std::move(retired));
+}
+
+void StagingPool::Recycle() {
+  // A buffer given back since the latest submission may be used by commands
+  // which are still being recorded.
+  const uint64_t submission = device_->GetSubmissionCount();
+  size_t kept = 0;
+  for (auto& retired : retired_) {
+    if (retired.submission < submission) {
+      idle_.push_back(std::move(retired.buffer));
+    } else {
+      retired_[kept++] = std::move(retired);
+    }
+  }
+  retired_.resize(kept);
+  Trim(0);
+}
+
+bool StagingPool::TakeIdle(uint32_t bucket_size,
+                           std::unique_ptr<TransferBuffer>* buffer) {
+  // The most recently used buffer of the bucket is taken first.
+  for (auto it = idle_.rbegin(); it != idle_.rend(); ++it) {
+    if ((*it)->GetSizeInBytes() == bucket_size) {
+      *buffer = std::move(*it);
+      idle_.erase(std::next(it).base());
+      return true;
+    }
+  }
+  return false;
+}
+
+void StagingPool::Trim(uint64_t extra_bytes) {
+  // The least recently used buffers go first.
+  size_t freed = 0;
+  while (freed < idle_.size() && pooled_bytes_ + extra_bytes > max_bytes_) {
+    pooled_bytes_ -= idle_[freed]->GetSizeInBytes();
+    idle_[freed] = nullptr;
+    ++freed;
+  }
+  idle_.erase(idle_.begin(),
+              idle_.begin() + static_cast<std::ptrdiff_t>(freed));
+}
+
+}  // namespace vulkan
+}  // namespace amber
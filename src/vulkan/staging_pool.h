@@ -0,0 +1,100 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_VULKAN_STAGING_POOL_H_
+#define SRC_VULKAN_STAGING_POOL_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "amber/result.h"
+#include "src/vulkan/transfer_buffer.h"
+
+namespace amber {
+namespace vulkan {
+
+class Device;
+
+/// Lends host visible buffers to the resources which copy their contents
+/// through one, for the duration of an upload or a readback.
+///
+/// Buffer sizes are rounded up to a few buckets, so a buffer given back can
+/// serve the next copy of a similar size. A buffer given back is lent again
+/// once the commands recorded with it completed, see Recycle(). The pool
+/// keeps idle buffers as long as all its buffers fit in the cap. A copy
+/// larger than what is left still gets a buffer, which is freed once it is
+/// no longer used.
+class StagingPool {
+ public:
+  /// The size of the smallest bucket.
+  static constexpr uint32_t kMinBufferSize = 64 * 1024;
+  /// The default for the cap, see SetMaxBytes().
+  static constexpr uint64_t kDefaultMaxBytes = 256 * 1024 * 1024;
+
+  explicit StagingPool(Device* device);
+  ~StagingPool();
+
+  /// Sets the number of bytes the buffers of the pool may take together
+  /// before idle buffers are freed. A cap of 0 frees every buffer once it is
+  /// no longer used.
+  void SetMaxBytes(uint64_t max_bytes) { max_bytes_ = max_bytes; }
+  /// Returns the cap set with SetMaxBytes().
+  uint64_t GetMaxBytes() const { return max_bytes_; }
+
+  /// Lends a mapped buffer of at least |size_in_bytes| bytes in |buffer|.
+  /// If a new buffer would not fit under the cap, first waits for the
+  /// submitted work so the buffers given back become idle.
+  Result Acquire(uint32_t size_in_bytes,
+                 std::unique_ptr<TransferBuffer>* buffer);
+  /// Takes |buffer| back. The commands recorded with it so far must be part
+  /// of the next submission, or of an earlier one.
+  void Release(std::unique_ptr<TransferBuffer> buffer);
+  /// Makes the buffers given back before the latest submission available
+  /// again and frees idle buffers above the cap. All submitted work must
+  /// have completed.
+  void Recycle();
+
+  /// Returns the size of the bucket a copy of |size_in_bytes| bytes uses.
+  static uint32_t GetBucketSize(uint32_t size_in_bytes);
+
+  /// Returns the number of bytes taken by the buffers of the pool, lent or
+  /// not.
+  uint64_t GetPooledBytes() const { return pooled_bytes_; }
+  /// Returns the number of buffers ready to be lent without waiting.
+  size_t GetIdleCount() const { return idle_.size(); }
+
+ private:
+  struct Retired {
+    std::unique_ptr<TransferBuffer> buffer;
+    /// The submission count of the device when the buffer was given back.
+    uint64_t submission = 0;
+  };
+
+  /// Moves an idle buffer of |bucket_size| bytes to |buffer|, if any.
+  bool TakeIdle(uint32_t bucket_size, std::unique_ptr<TransferBuffer>* buffer);
+  /// Frees idle buffers until |extra_bytes| more fit under the cap.
+  void Trim(uint64_t extra_bytes);
+
+  Device* device_ = nullptr;
+  uint64_t max_bytes_ = kDefaultMaxBytes;
+  uint64_t pooled_bytes_ = 0;
+  std::vector<std::unique_ptr<TransferBuffer>> idle_;
+  std::vector<Retired> retired_;
+};
+
+}  // namespace vulkan
+}  // namespace amber
+
+#endif  // SRC_VULKAN_STAGING_POOL_H_
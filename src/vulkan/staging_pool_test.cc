@@ -0,0 +1,226 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/vulkan/staging_pool.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "src/vulkan/device.h"
+
+namespace amber {
+namespace vulkan {
+namespace {
+
+class DummyDevice : public Device {
+ public:
+  DummyDevice()
+      : Device(VkInstance(),
+               VkPhysicalDevice(),
+               0u,
+               VkDevice(this),
+               VkQueue(),
+               nullptr) {
+    memory_.resize(64);
+    dummyPtrs_.vkCreateBuffer = vkCreateBuffer;
+    dummyPtrs_.vkGetBufferMemoryRequirements = vkGetBufferMemoryRequirements;
+    dummyPtrs_.vkAllocateMemory = vkAllocateMemory;
+    dummyPtrs_.vkBindBufferMemory = vkBindBufferMemory;
+    dummyPtrs_.vkMapMemory = vkMapMemory;
+    dummyPtrs_.vkDestroyBufferView = vkDestroyBufferView;
+    dummyPtrs_.vkFreeMemory = vkFreeMemory;
+    dummyPtrs_.vkDestroyBuffer = vkDestroyBuffer;
+  }
+  ~DummyDevice() override {
+    // The pool must be empty before the dummy functions go away.
+    SetLastSubmission(VkFence(), 0);
+    GetStagingPool()->SetMaxBytes(0);
+    GetStagingPool()->Recycle();
+  }
+
+  const VulkanPtrs* GetPtrs() const override { return &dummyPtrs_; }
+
+  bool HasMemoryFlags(uint32_t, const VkMemoryPropertyFlags) const override {
+    return true;
+  }
+
+  void* GetMemoryPtr() { return memory_.data(); }
+  uintptr_t GetCreatedBufferCount() const { return created_buffer_count_; }
+
+ private:
+  VulkanPtrs dummyPtrs_;
+  std::vector<uint8_t> memory_;
+  uintptr_t created_buffer_count_ = 0;
+
+  static VkResult vkCreateBuffer(VkDevice device,
+                                 const VkBufferCreateInfo*,
+                                 const VkAllocationCallbacks*,
+                                 VkBuffer* pBuffer) {
+    DummyDevice* devicePtr = reinterpret_cast<DummyDevice*>(device);
+    *pBuffer = VkBuffer(++devicePtr->created_buffer_count_);
+    return VK_SUCCESS;
+  }
+  static void vkGetBufferMemoryRequirements(
+      VkDevice,
+      VkBuffer,
+      VkMemoryRequirements* pMemoryRequirements) {
+    pMemoryRequirements->alignment = 0;
+    pMemoryRequirements->size = 0;
+    pMemoryRequirements->memoryTypeBits = 0xffffffff;
+  }
+  static VkResult vkAllocateMemory(VkDevice,
+                                   const VkMemoryAllocateInfo*,
+                                   const VkAllocationCallbacks*,
+                                   VkDeviceMemory*) {
+    return VK_SUCCESS;
+  }
+  static VkResult vkBindBufferMemory(VkDevice,
+                                     VkBuffer,
+                                     VkDeviceMemory,
+                                     VkDeviceSize) {
+    return VK_SUCCESS;
+  }
+  static VkResult vkMapMemory(VkDevice device,
+                              VkDeviceMemory,
+                              VkDeviceSize,
+                              VkDeviceSize,
+                              VkMemoryMapFlags,
+                              void** ppData) {
+    DummyDevice* devicePtr = reinterpret_cast<DummyDevice*>(device);
+    *ppData = devicePtr->GetMemoryPtr();
+    return VK_SUCCESS;
+  }
+  static void vkDestroyBufferView(VkDevice,
+                                  VkBufferView,
+                                  const VkAllocationCallbacks*) {}
+  static void vkFreeMemory(VkDevice,
+                           VkDeviceMemory,
+                           const VkAllocationCallbacks*) {}
+  static void vkDestroyBuffer(VkDevice,
+                              VkBuffer,
+                              const VkAllocationCallbacks*) {}
+};
+
+}  // namespace
+
+using StagingPoolTest = testing::Test;
+
+TEST_F(StagingPoolTest, GetBucketSize) {
+  const uint32_t kMin = StagingPool::kMinBufferSize;
+  EXPECT_EQ(kMin, StagingPool::GetBucketSize(0));
+  EXPECT_EQ(kMin, StagingPool::GetBucketSize(kMin));
+  EXPECT_EQ(kMin + kMin / 4, StagingPool::GetBucketSize(kMin + 1));
+  EXPECT_EQ(2 * kMin, StagingPool::GetBucketSize(2 * kMin));
+  EXPECT_EQ(2 * kMin + kMin / 2, StagingPool::GetBucketSize(2 * kMin + 1));
+  EXPECT_EQ(1024U * 1024U, StagingPool::GetBucketSize(1000U * 1024U + 7U));
+  EXPECT_EQ(UINT32_MAX, StagingPool::GetBucketSize(UINT32_MAX));
+}
+
+TEST_F(StagingPoolTest, ReusesBufferAfterSubmission) {
+  DummyDevice device;
+  StagingPool* pool = device.GetStagingPool();
+
+  std::unique_ptr<TransferBuffer> buffer;
+  ASSERT_TRUE(pool->Acquire(100, &buffer).IsSuccess());
+  ASSERT_TRUE(buffer != nullptr);
+  EXPECT_EQ(StagingPool::kMinBufferSize, buffer->GetSizeInBytes());
+  EXPECT_TRUE(buffer->HostAccessibleMemoryPtr() != nullptr);
+  TransferBuffer* first = buffer.get();
+  pool->Release(std::move(buffer));
+
+  // Commands recorded with the buffer may not have been submitted yet.
+  pool->Recycle();
+  EXPECT_EQ(0U, pool->GetIdleCount());
+
+  device.SetLastSubmission(VkFence(), 0);
+  ASSERT_TRUE(device.WaitForSubmissions().IsSuccess());
+  EXPECT_EQ(1U, pool->GetIdleCount());
+
+  // A copy of a size in the same bucket takes the idle buffer.
+  ASSERT_TRUE(pool->Acquire(StagingPool::kMinBufferSize, &buffer).IsSuccess());
+  EXPECT_EQ(first, buffer.get());
+  EXPECT_EQ(1U, device.GetCreatedBufferCount());
+  EXPECT_EQ(0U, pool->GetIdleCount());
+  pool->Release(std::move(buffer));
+}
+
+TEST_F(StagingPoolTest, DifferentBucketCreatesBuffer) {
+  DummyDevice device;
+  StagingPool* pool = device.GetStagingPool();
+
+  std::unique_ptr<TransferBuffer> small;
+  ASSERT_TRUE(pool->Acquire(100, &small).IsSuccess());
+  pool->Release(std::move(small));
+  device.SetLastSubmission(VkFence(), 0);
+  ASSERT_TRUE(device.WaitForSubmissions().IsSuccess());
+
+  std::unique_ptr<TransferBuffer> large;
+  ASSERT_TRUE(
+      pool->Acquire(4 * StagingPool::kMinBufferSize, &large).IsSuccess());
+  EXPECT_EQ(4 * StagingPool::kMinBufferSize, large->GetSizeInBytes());
+  EXPECT_EQ(2U, device.GetCreatedBufferCount());
+  EXPECT_EQ(1U, pool->GetIdleCount());
+  EXPECT_EQ(5U * StagingPool::kMinBufferSize, pool->GetPooledBytes());
+  pool->Release(std::move(large));
+}
+
+TEST_F(StagingPoolTest, CapFreesIdleBuffers) {
+  DummyDevice device;
+  StagingPool* pool = device.GetStagingPool();
+  pool->SetMaxBytes(StagingPool::kMinBufferSize);
+
+  std::unique_ptr<TransferBuffer> first;
+  std::unique_ptr<TransferBuffer> second;
+  ASSERT_TRUE(pool->Acquire(100, &first).IsSuccess());
+  // Buffers in use are not limited by the cap.
+  ASSERT_TRUE(pool->Acquire(100, &second).IsSuccess());
+  EXPECT_EQ(2U * StagingPool::kMinBufferSize, pool->GetPooledBytes());
+
+  pool->Release(std::move(first));
+  pool->Release(std::move(second));
+  device.SetLastSubmission(VkFence(), 0);
+  ASSERT_TRUE(device.WaitForSubmissions().IsSuccess());
+  EXPECT_EQ(1U, pool->GetIdleCount());
+  EXPECT_EQ(StagingPool::kMinBufferSize, pool->GetPooledBytes());
+
+  pool->SetMaxBytes(0);
+  pool->Recycle();
+  EXPECT_EQ(0U, pool->GetIdleCount());
+  EXPECT_EQ(0U, pool->GetPooledBytes());
+}
+
+TEST_F(StagingPoolTest, AcquireWaitsForGivenBackBuffersOverCap) {
+  DummyDevice device;
+  StagingPool* pool = device.GetStagingPool();
+  pool->SetMaxBytes(StagingPool::kMinBufferSize);
+
+  std::unique_ptr<TransferBuffer> buffer;
+  ASSERT_TRUE(pool->Acquire(100, &buffer).IsSuccess());
+  TransferBuffer* first = buffer.get();
+  pool->Release(std::move(buffer));
+  device.SetLastSubmission(VkFence(), 0);
+
+  // A new buffer would go over the cap, so the submitted work is waited for
+  // and the buffer given back is lent again.
+  ASSERT_TRUE(pool->Acquire(100, &buffer).IsSuccess());
+  EXPECT_EQ(first, buffer.get());
+  EXPECT_EQ(1U, device.GetCreatedBufferCount());
+  pool->Release(std::move(buffer));
+}
+
+}  // namespace vulkan
+}  // namespace amber
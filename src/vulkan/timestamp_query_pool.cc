@@ -0,0 +1,117 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/vulkan/timestamp_query_pool.h"
+
+#include "src/vulkan/device.h"
+
+namespace amber {
+namespace vulkan {
+
+TimestampQueryPool::TimestampQueryPool(Device* device) : device_(device) {}
+
+TimestampQueryPool::~TimestampQueryPool() {
+  for (VkQueryPool pool : pools_) {
+    device_->GetPtrs()->vkDestroyQueryPool(device_->GetVkDevice(), pool,
+                                           nullptr);
+  }
+}
+
+Result TimestampQueryPool::Acquire(TimestampQuery* query) {
+  if (free_.empty()) {
+    Result r = pools_.size() < kMaxPools ? CreateVkQueryPool()
+                                         : device_->WaitForSubmissions();
+    if (!r.IsSuccess()) {
+      return r;
+    }
+    if (free_.empty()) {
+      return Result("Vulkan: all timestamp queries are in use");
+    }
+  }
+
+  *query = free_.back();
+  free_.pop_back();
+  return {};
+}
+
+void TimestampQueryPool::Submitted(const TimestampQuery& query) {
+  submitted_.push_back(query);
+}
+
+void TimestampQueryPool::ReportResults() {
+  constexpr double kNsToMsTime = 1.0 / 1000000.0;
+  const double timestamp_period =
+      static_cast<double>(device_->GetTimestampPeriod());
+  std::vector<uint64_t> time_stamps;
+
+  // Pairs handed out one after the other usually sit next to each other in
+  // the same VkQueryPool, and are read with a single call.
+  size_t begin = 0;
+  while (begin < submitted_.size()) {
+    const TimestampQuery& first = submitted_[begin];
+    size_t end = begin + 1;
+    while (end < submitted_.size() && submitted_[end].pool == first.pool &&
+           submitted_[end].first_query ==
+               first.first_query + 2 * static_cast<uint32_t>(end - begin)) {
+      ++end;
+    }
+
+    const auto query_count = static_cast<uint32_t>(2 * (end - begin));
+    time_stamps.assign(query_count, 0);
+    VkResult r = device_->GetPtrs()->vkGetQueryPoolResults(
+        device_->GetVkDevice(), first.pool, first.first_query, query_count,
+        time_stamps.size() * sizeof(uint64_t), time_stamps.data(),
+        sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (r == VK_SUCCESS) {
+      for (size_t i = 0; i < time_stamps.size(); i += 2) {
+        double time_in_ns =
+            static_cast<double>(time_stamps[i + 1] - time_stamps[i]) *
+            timestamp_period;
+        device_->ReportExecutionTiming(time_in_ns * kNsToMsTime);
+      }
+    }
+    begin = end;
+  }
+
+  // Handed out again in the order they were used.
+  free_.insert(free_.end(), submitted_.rbegin(), submitted_.rend());
+  submitted_.clear();
+}
+
+Result TimestampQueryPool::CreateVkQueryPool() {
+  VkQueryPoolCreateInfo pool_create_info = VkQueryPoolCreateInfo();
+  pool_create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  pool_create_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+  pool_create_info.queryCount = kQueriesPerPool;
+
+  VkQueryPool pool = VK_NULL_HANDLE;
+  if (device_->GetPtrs()->vkCreateQueryPool(device_->GetVkDevice(),
+                                            &pool_create_info, nullptr,
+                                            &pool) != VK_SUCCESS) {
+    return Result("Vulkan::Calling vkCreateQueryPool Fail");
+  }
+  pools_.push_back(pool);
+
+  // The first pair is handed out first.
+  for (uint32_t query = kQueriesPerPool; query >= 2; query -= 2) {
+    TimestampQuery pair;
+    pair.pool = pool;
+    pair.first_query = query - 2;
+    free_.push_back(pair);
+  }
+  return {};
+}
+
+}  // namespace vulkan
+}  // namespace amber
@@ -0,0 +1,81 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SRC_VULKAN_TIMESTAMP_QUERY_POOL_H_
+#define SRC_VULKAN_TIMESTAMP_QUERY_POOL_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "amber/result.h"
+#include "amber/vulkan_header.h"
+
+namespace amber {
+namespace vulkan {
+
+class Device;
+
+/// Two timestamp queries, written before and after a timed command.
+struct TimestampQuery {
+  VkQueryPool pool = VK_NULL_HANDLE;
+  uint32_t first_query = 0;
+};
+
+/// Hands out timestamp queries from a few VkQueryPool objects, which are
+/// created as needed and kept until the device goes away.
+///
+/// Timed commands do not wait for their results. Those are read after the
+/// next Device::WaitForSubmissions(), which completes every submitted
+/// command at once, and reported in submission order.
+class TimestampQueryPool {
+ public:
+  /// The number of queries in each VkQueryPool.
+  static constexpr uint32_t kQueriesPerPool = 128;
+
+  explicit TimestampQueryPool(Device* device);
+  ~TimestampQueryPool();
+
+  /// Returns an unused pair of queries in |query|. Adds a VkQueryPool if all
+  /// queries are in use, unless there are too many already, in which case
+  /// this waits for the submitted work to release some.
+  Result Acquire(TimestampQuery* query);
+  /// Records that the commands writing |query| were submitted. Its result is
+  /// reported once they completed.
+  void Submitted(const TimestampQuery& query);
+  /// Reports the execution time of every submitted pair of queries through
+  /// the delegate, and makes them available again. All submitted work must
+  /// have completed.
+  void ReportResults();
+
+  /// Returns the number of VkQueryPool objects created.
+  size_t GetVkQueryPoolCount() const { return pools_.size(); }
+  /// Returns the number of pairs of queries waiting for ReportResults().
+  size_t GetSubmittedCount() const { return submitted_.size(); }
+
+ private:
+  /// The number of VkQueryPool objects created before Acquire() waits.
+  static constexpr size_t kMaxPools = 16;
+
+  Result CreateVkQueryPool();
+
+  Device* device_ = nullptr;
+  std::vector<VkQueryPool> pools_;
+  std::vector<TimestampQuery> free_;
+  std::vector<TimestampQuery> submitted_;
+};
+
+}  // namespace vulkan
+}  // namespace amber
+
+#endif  // SRC_VULKAN_TIMESTAMP_QUERY_POOL_H_
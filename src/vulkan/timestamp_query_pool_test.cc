@@ -0,0 +1,156 @@
+// Copyright 2026 The Amber Authors.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "src/vulkan/timestamp_query_pool.h"
+
+#include <cstdint>
+
+#include "gtest/gtest.h"
+#include "src/vulkan/device.h"
+
+namespace amber {
+namespace vulkan {
+namespace {
+
+class DummyDevice : public Device {
+ public:
+  DummyDevice()
+      : Device(VkInstance(),
+               VkPhysicalDevice(),
+               0u,
+               VkDevice(this),
+               VkQueue(),
+               nullptr) {
+    dummyPtrs_.vkCreateQueryPool = vkCreateQueryPool;
+    dummyPtrs_.vkDestroyQueryPool = vkDestroyQueryPool;
+    dummyPtrs_.vkGetQueryPoolResults = vkGetQueryPoolResults;
+  }
+  ~DummyDevice() override {}
+
+  const VulkanPtrs* GetPtrs() const override { return &dummyPtrs_; }
+
+  uint32_t GetLiveQueryPoolCount() const { return live_query_pool_count_; }
+  uint32_t GetResultsCallCount() const { return results_call_count_; }
+
+ private:
+  static VkResult vkCreateQueryPool(VkDevice device,
+                                    const VkQueryPoolCreateInfo*,
+                                    const VkAllocationCallbacks*,
+                                    VkQueryPool* pQueryPool) {
+    DummyDevice* devicePtr = reinterpret_cast<DummyDevice*>(device);
+    ++devicePtr->live_query_pool_count_;
+    *pQueryPool = VkQueryPool(++devicePtr->next_query_pool_);
+    return VK_SUCCESS;
+  }
+  static void vkDestroyQueryPool(VkDevice device,
+                                 VkQueryPool,
+                                 const VkAllocationCallbacks*) {
+    DummyDevice* devicePtr = reinterpret_cast<DummyDevice*>(device);
+    --devicePtr->live_query_pool_count_;
+  }
+  static VkResult vkGetQueryPoolResults(VkDevice device,
+                                        VkQueryPool,
+                                        uint32_t,
+                                        uint32_t,
+                                        size_t,
+                                        void*,
+                                        VkDeviceSize,
+                                        VkQueryResultFlags) {
+    DummyDevice* devicePtr = reinterpret_cast<DummyDevice*>(device);
+    ++devicePtr->results_call_count_;
+    return VK_SUCCESS;
+  }
+
+  VulkanPtrs dummyPtrs_;
+  uint32_t live_query_pool_count_ = 0;
+  uint32_t results_call_count_ = 0;
+  uintptr_t next_query_pool_ = 0;
+};
+
+}  // namespace
+
+using TimestampQueryPoolTest = testing::Test;
+
+TEST_F(TimestampQueryPoolTest, AcquireAddsPoolsWhenFull) {
+  DummyDevice device;
+  {
+    TimestampQueryPool pool(&device);
+
+    TimestampQuery first;
+    ASSERT_TRUE(pool.Acquire(&first).IsSuccess());
+    EXPECT_EQ(0U, first.first_query);
+    for (uint32_t i = 1; i < TimestampQueryPool::kQueriesPerPool / 2; ++i) {
+      TimestampQuery query;
+      ASSERT_TRUE(pool.Acquire(&query).IsSuccess());
+      EXPECT_EQ(first.pool, query.pool);
+      EXPECT_EQ(2 * i, query.first_query);
+    }
+    EXPECT_EQ(1U, pool.GetVkQueryPoolCount());
+
+    TimestampQuery query;
+    ASSERT_TRUE(pool.Acquire(&query).IsSuccess());
+    EXPECT_NE(first.pool, query.pool);
+    EXPECT_EQ(2U, pool.GetVkQueryPoolCount());
+    EXPECT_EQ(2U, device.GetLiveQueryPoolCount());
+  }
+  EXPECT_EQ(0U, device.GetLiveQueryPoolCount());
+}
+
+TEST_F(TimestampQueryPoolTest, ReportResultsReadsNeighboursTogether) {
+  DummyDevice device;
+  TimestampQueryPool pool(&device);
+
+  TimestampQuery queries[3];
+  for (auto& query : queries) {
+    ASSERT_TRUE(pool.Acquire(&query).IsSuccess());
+  }
+  // The first and last pairs are not next to each other.
+  pool.Submitted(queries[0]);
+  pool.Submitted(queries[2]);
+  pool.Submitted(queries[1]);
+  EXPECT_EQ(3U, pool.GetSubmittedCount());
+
+  pool.ReportResults();
+  EXPECT_EQ(0U, pool.GetSubmittedCount());
+  EXPECT_EQ(3U, device.GetResultsCallCount());
+
+  // The pairs are handed out again in the order they were used.
+  TimestampQuery query;
+  ASSERT_TRUE(pool.Acquire(&query).IsSuccess());
+  EXPECT_EQ(queries[0].first_query, query.first_query);
+  pool.Submitted(query);
+  ASSERT_TRUE(pool.Acquire(&query).IsSuccess());
+  EXPECT_EQ(queries[2].first_query, query.first_query);
+  pool.Submitted(query);
+
+  pool.ReportResults();
+  EXPECT_EQ(5U, device.GetResultsCallCount());
+  EXPECT_EQ(1U, pool.GetVkQueryPoolCount());
+}
+
+TEST_F(TimestampQueryPoolTest, ReportResultsBatchesConsecutivePairs) {
+  DummyDevice device;
+  TimestampQueryPool pool(&device);
+
+  for (uint32_t i = 0; i < 4; ++i) {
+    TimestampQuery query;
+    ASSERT_TRUE(pool.Acquire(&query).IsSuccess());
+    pool.Submitted(query);
+  }
+  pool.ReportResults();
+  EXPECT_EQ(1U, device.GetResultsCallCount());
+}
+
+}  // namespace vulkan
+}  // namespace amber
@@ -53,35 +53,14 @@ Result TLASDescriptor::CreateResourceIfNeeded() {
   return {};
 }
 
-void TLASDescriptor::UpdateDescriptorSetIfNeeded(
-    VkDescriptorSet descriptor_set) {
-  std::vector<VkAccelerationStructureKHR> as;
+void TLASDescriptor::WriteDescriptorInfos(void* infos) {
+  auto* as = static_cast<VkAccelerationStructureKHR*>(infos);
 
   for (auto& amber_tlas : amber_tlases_) {
     auto vulkan_tlas = tlases_->find(amber_tlas);
     assert(vulkan_tlas != tlases_->end());
-    as.push_back(vulkan_tlas->second->GetVkTLAS());
+    *as++ = vulkan_tlas->second->GetVkTLAS();
   }
-
-  VkWriteDescriptorSetAccelerationStructureKHR writeDescriptorTlas;
-  writeDescriptorTlas.sType =
-      VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR;
-  writeDescriptorTlas.pNext = nullptr;
-  writeDescriptorTlas.accelerationStructureCount =
-      static_cast<uint32_t>(as.size());
-  writeDescriptorTlas.pAccelerationStructures = as.data();
-
-  VkWriteDescriptorSet write = VkWriteDescriptorSet();
-  write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-  write.pNext = &writeDescriptorTlas;
-  write.dstSet = descriptor_set;
-  write.dstBinding = binding_;
-  write.dstArrayElement = 0;
-  write.descriptorCount = static_cast<uint32_t>(as.size());
-  write.descriptorType = GetVkDescriptorType();
-
-  device_->GetPtrs()->vkUpdateDescriptorSets(device_->GetVkDevice(), 1, &write,
-                                             0, nullptr);
 }
 
 }  // namespace vulkan
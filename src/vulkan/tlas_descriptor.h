@@ -37,7 +37,7 @@ class TLASDescriptor : public Descriptor {
                  uint32_t binding);
   ~TLASDescriptor() override;
 
-  void UpdateDescriptorSetIfNeeded(VkDescriptorSet descriptor_set) override;
+  void WriteDescriptorInfos(void* infos) override;
 
   Result CreateResourceIfNeeded() override;
 
@@ -35,14 +35,15 @@ TransferBuffer::~TransferBuffer() {
     device_->GetPtrs()->vkDestroyBufferView(device_->GetVkDevice(), view_,
                                             nullptr);
 
-    if (memory_ != VK_NULL_HANDLE) {
-      UnMapMemory(memory_);
-      device_->GetPtrs()->vkFreeMemory(device_->GetVkDevice(), memory_,
-                                       nullptr);
-    }
-
     device_->GetPtrs()->vkDestroyBuffer(device_->GetVkDevice(), buffer_,
                                         nullptr);
+
+    FreeMemory(&memory_);
+
+    device_->GetPtrs()->vkDestroyBuffer(device_->GetVkDevice(),
+                                        staging_buffer_, nullptr);
+
+    FreeMemory(&staging_memory_);
   }
 }
 
@@ -58,9 +59,21 @@ Result TransferBuffer::Initialize() {
     return r;
   }
 
+  const VkMemoryPropertyFlags host_flags =
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+      VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
   uint32_t memory_type_index = 0;
   r = AllocateAndBindMemoryToVkBuffer(
       buffer_, &memory_, GetMemoryPropertiesFlags(), true, &memory_type_index);
+  if (!r.IsSuccess() &&
+      (GetMemoryPropertiesFlags() & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
+    // Host visible memory is the fallback when device local memory is
+    // missing or full.
+    FreeMemory(&memory_);
+    SetMemoryPropertiesFlags(host_flags);
+    r = AllocateAndBindMemoryToVkBuffer(buffer_, &memory_, host_flags, true,
+                                        &memory_type_index);
+  }
   if (!r.IsSuccess()) {
     return r;
   }
@@ -82,16 +95,48 @@ Result TransferBuffer::Initialize() {
     }
   }
 
+  // Device local memory may also be host visible, as on integrated GPUs, in
+  // which case it needs no staging buffer.
   if (!device_->IsMemoryHostAccessible(memory_type_index) ||
       !device_->IsMemoryHostCoherent(memory_type_index)) {
-    return Result(
-        "Vulkan: TransferBuffer::Initialize() buffer is not host accessible or"
-        " not host coherent.");
+    if (!(GetMemoryPropertiesFlags() & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
+      return Result(
+          "Vulkan: TransferBuffer::Initialize() buffer is not host accessible "
+          "or not host coherent.");
+    }
+    return CreateStagingBuffer();
   }
 
   return MapMemory(memory_);
 }
 
+Result TransferBuffer::CreateStagingBuffer() {
+  if ((usage_flags_ & VK_BUFFER_USAGE_TRANSFER_SRC_BIT) == 0 ||
+      (usage_flags_ & VK_BUFFER_USAGE_TRANSFER_DST_BIT) == 0) {
+    return Result(
+        "Vulkan: TransferBuffer::Initialize() device local buffer is not a "
+        "transfer source and destination.");
+  }
+
+  Result r = CreateVkBuffer(
+      &staging_buffer_,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+  if (!r.IsSuccess()) {
+    return r;
+  }
+
+  uint32_t memory_type_index = 0;
+  r = AllocateAndBindMemoryToVkBuffer(staging_buffer_, &staging_memory_,
+                                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                      true, &memory_type_index);
+  if (!r.IsSuccess()) {
+    return r;
+  }
+
+  return MapMemory(staging_memory_);
+}
+
 VkDeviceAddress TransferBuffer::getBufferDeviceAddress() {
   const VkBufferDeviceAddressInfo bufferDeviceAddressInfo = {
       VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO_KHR,
@@ -104,15 +149,32 @@ VkDeviceAddress TransferBuffer::getBufferDeviceAddress() {
 }
 
 void TransferBuffer::CopyToDevice(CommandBuffer* command_buffer) {
-  // This is redundant because this buffer is always host visible
-  // and coherent and vkQueueSubmit will make writes from host
+  // Without a staging buffer this is redundant because the buffer is host
+  // visible and coherent and vkQueueSubmit will make writes from host
   // available (See chapter 6.9. "Host Write Ordering Guarantees" in
   // Vulkan spec), but we prefer to keep it to simplify our own code.
   MemoryBarrier(command_buffer);
+  if (HasStagingBuffer()) {
+    RecordCopy(command_buffer, staging_buffer_, buffer_);
+    MemoryBarrier(command_buffer);
+  }
 }
 
 void TransferBuffer::CopyToHost(CommandBuffer* command_buffer) {
   MemoryBarrier(command_buffer);
+  if (HasStagingBuffer()) {
+    RecordCopy(command_buffer, buffer_, staging_buffer_);
+    MemoryBarrier(command_buffer);
+  }
+}
+
+void TransferBuffer::RecordCopy(CommandBuffer* command_buffer,
+                                VkBuffer src,
+                                VkBuffer dst) {
+  VkBufferCopy region = VkBufferCopy();
+  region.size = GetSizeInBytes();
+  device_->GetPtrs()->vkCmdCopyBuffer(command_buffer->GetVkCommandBuffer(),
+                                      src, dst, 1, &region);
 }
 
 }  // namespace vulkan
@@ -51,17 +51,35 @@ class TransferBuffer : public Resource {
   VkBuffer GetVkBuffer() const { return buffer_; }
   VkDeviceAddress getBufferDeviceAddress();
 
+  /// Returns true if the buffer lives in memory the host cannot map. The
+  /// host memory pointer then refers to a staging buffer, which
+  /// CopyToDevice() and CopyToHost() copy from and to.
+  bool HasStagingBuffer() const { return staging_buffer_ != VK_NULL_HANDLE; }
+
   /// Records a command on |command_buffer| to copy the buffer contents from the
   /// host to the device.
   void CopyToDevice(CommandBuffer* command_buffer) override;
   /// Records a command on |command_buffer| to copy the buffer contents from the
   /// device to the host.
   void CopyToHost(CommandBuffer* command_buffer) override;
+  /// Records a memory barrier on |command_buffer|, to make prior writes to
+  /// the buffer on the device visible to subsequent commands. Unlike
+  /// CopyToDevice(), this never copies the staging buffer.
+  void RecordBarrier(CommandBuffer* command_buffer) {
+    MemoryBarrier(command_buffer);
+  }
 
  private:
+  /// Creates the host visible staging buffer and maps it.
+  Result CreateStagingBuffer();
+  /// Records a copy of the whole buffer from |src| to |dst|.
+  void RecordCopy(CommandBuffer* command_buffer, VkBuffer src, VkBuffer dst);
+
   VkBufferUsageFlags usage_flags_ = 0;
   VkBuffer buffer_ = VK_NULL_HANDLE;
-  VkDeviceMemory memory_ = VK_NULL_HANDLE;
+  MemoryAllocation memory_;
+  VkBuffer staging_buffer_ = VK_NULL_HANDLE;
+  MemoryAllocation staging_memory_;
   VkBufferView view_ = VK_NULL_HANDLE;
   VkFormat format_ = VK_FORMAT_UNDEFINED;
 };
@@ -16,6 +16,7 @@
 
 #include <cstring>
 #include <limits>
+#include <utility>
 #include <vector>
 
 #include "src/vulkan/command_buffer.h"
@@ -110,20 +111,9 @@ TransferImage::~TransferImage() {
     device_->GetPtrs()->vkDestroyImage(device_->GetVkDevice(), image_, nullptr);
   }
 
-  if (memory_ != VK_NULL_HANDLE) {
-    device_->GetPtrs()->vkFreeMemory(device_->GetVkDevice(), memory_, nullptr);
-  }
-
-  if (host_accessible_memory_ != VK_NULL_HANDLE) {
-    UnMapMemory(host_accessible_memory_);
-    device_->GetPtrs()->vkFreeMemory(device_->GetVkDevice(),
-                                     host_accessible_memory_, nullptr);
-  }
+  FreeMemory(&memory_);
 
-  if (host_accessible_buffer_ != VK_NULL_HANDLE) {
-    device_->GetPtrs()->vkDestroyBuffer(device_->GetVkDevice(),
-                                        host_accessible_buffer_, nullptr);
-  }
+  ReleaseStagingBuffer();
 }
 
 Result TransferImage::Initialize() {
@@ -153,32 +143,30 @@ Result TransferImage::Initialize() {
     r = CreateVkImageView(aspect_);
   }
 
-  if (!r.IsSuccess()) {
-    return r;
+  return r;
+}
+
+Result TransferImage::AcquireStagingBuffer() {
+  if (staging_buffer_) {
+    return {};
   }
 
-  // For images, we always make a secondary buffer. When the tiling of an image
-  // is optimal, read/write data from CPU does not show correct values. We need
-  // a secondary buffer to convert the GPU-optimal data to CPU-readable data
-  // and vice versa.
-  r = CreateVkBuffer(
-      &host_accessible_buffer_,
-      VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+  Result r = device_->GetStagingPool()->Acquire(GetSizeInBytes(),
+                                                &staging_buffer_);
   if (!r.IsSuccess()) {
     return r;
   }
+  SetMemoryPtr(staging_buffer_->HostAccessibleMemoryPtr());
+  return {};
+}
 
-  memory_type_index = 0;
-  r = AllocateAndBindMemoryToVkBuffer(host_accessible_buffer_,
-                                      &host_accessible_memory_,
-                                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                          VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                                      true, &memory_type_index);
-  if (!r.IsSuccess()) {
-    return r;
+void TransferImage::ReleaseStagingBuffer() {
+  if (!staging_buffer_) {
+    return;
   }
 
-  return MapMemory(host_accessible_memory_);
+  SetMemoryPtr(nullptr);
+  device_->GetStagingPool()->Release(std::move(staging_buffer_));
 }
 
 VkImageViewType TransferImage::GetImageViewType() const {
@@ -261,7 +249,7 @@ void TransferImage::CopyToHost(CommandBuffer* command_buffer) {
                                            VK_IMAGE_ASPECT_DEPTH_BIT,
                                            VK_IMAGE_ASPECT_STENCIL_BIT};
   // Copy operations don't support multisample images.
-  if (samples_ > 1) {
+  if (samples_ > 1 || !staging_buffer_) {
     return;
   }
 
@@ -279,7 +267,7 @@ void TransferImage::CopyToHost(CommandBuffer* command_buffer) {
 
   device_->GetPtrs()->vkCmdCopyImageToBuffer(
       command_buffer->GetVkCommandBuffer(), image_,
-      VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, host_accessible_buffer_,
+      VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, staging_buffer_->GetVkBuffer(),
       static_cast<uint32_t>(copy_regions.size()), copy_regions.data());
 
   MemoryBarrier(command_buffer);
@@ -287,7 +275,7 @@ void TransferImage::CopyToHost(CommandBuffer* command_buffer) {
 
 void TransferImage::CopyToDevice(CommandBuffer* command_buffer) {
   // Copy operations don't support multisample images.
-  if (samples_ > 1) {
+  if (samples_ > 1 || !staging_buffer_) {
     return;
   }
 
@@ -307,8 +295,8 @@ void TransferImage::CopyToDevice(CommandBuffer* command_buffer) {
   }
 
   device_->GetPtrs()->vkCmdCopyBufferToImage(
-      command_buffer->GetVkCommandBuffer(), host_accessible_buffer_, image_,
-      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      command_buffer->GetVkCommandBuffer(), staging_buffer_->GetVkBuffer(),
+      image_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
       static_cast<uint32_t>(copy_regions.size()), copy_regions.data());
 
   MemoryBarrier(command_buffer);
@@ -393,7 +381,7 @@ void TransferImage::ImageBarrier(CommandBuffer* command_buffer,
 
 Result TransferImage::AllocateAndBindMemoryToVkImage(
     VkImage image,
-    VkDeviceMemory* memory,
+    MemoryAllocation* memory,
     VkMemoryPropertyFlags flags,
     bool force_flags,
     uint32_t* memory_type_index) {
@@ -410,7 +398,7 @@ Result TransferImage::AllocateAndBindMemoryToVkImage(
     return Result("Vulkan::Given VkImage is VK_NULL_HANDLE");
   }
   if (memory == nullptr) {
-    return Result("Vulkan::Given VkDeviceMemory pointer is nullptr");
+    return Result("Vulkan::Given MemoryAllocation pointer is nullptr");
   }
 
   VkMemoryRequirements requirement;
@@ -423,13 +411,15 @@ Result TransferImage::AllocateAndBindMemoryToVkImage(
     return Result("Vulkan::Find Proper Memory Fail");
   }
 
-  Result r = AllocateMemory(memory, requirement.size, *memory_type_index);
+  Result r = AllocateMemory(memory, requirement, *memory_type_index,
+                            image_info_.tiling == VK_IMAGE_TILING_LINEAR);
   if (!r.IsSuccess()) {
     return r;
   }
 
   if (device_->GetPtrs()->vkBindImageMemory(device_->GetVkDevice(), image,
-                                            *memory, 0) != VK_SUCCESS) {
+                                            memory->memory,
+                                            memory->offset) != VK_SUCCESS) {
     return Result("Vulkan::Calling vkBindImageMemory Fail");
   }
 
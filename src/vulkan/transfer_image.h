@@ -15,10 +15,13 @@
 #ifndef SRC_VULKAN_TRANSFER_IMAGE_H_
 #define SRC_VULKAN_TRANSFER_IMAGE_H_
 
+#include <memory>
+
 #include "amber/result.h"
 #include "amber/vulkan_header.h"
 #include "src/format.h"
 #include "src/vulkan/resource.h"
+#include "src/vulkan/transfer_buffer.h"
 
 namespace amber {
 namespace vulkan {
@@ -51,17 +54,28 @@ class TransferImage : public Resource {
                     VkImageLayout to_layout,
                     VkPipelineStageFlags to_stage);
 
+  /// Borrows a buffer from the staging pool of the device, through which the
+  /// contents of the image are copied. HostAccessibleMemoryPtr() points at
+  /// it until ReleaseStagingBuffer(). Does nothing if one is borrowed
+  /// already.
+  Result AcquireStagingBuffer();
+  /// Gives the staging buffer back to the pool. The commands recorded with
+  /// it must be part of the next submission, or of an earlier one.
+  void ReleaseStagingBuffer();
+  /// Returns true if a staging buffer is borrowed.
+  bool HasStagingBuffer() const { return staging_buffer_ != nullptr; }
+
   /// Records a command on |command_buffer| to copy the buffer contents from the
-  /// host to the device.
+  /// host to the device. A staging buffer must be borrowed.
   void CopyToDevice(CommandBuffer* command_buffer) override;
   /// Records a command on |command_buffer| to copy the buffer contents from the
-  /// device to the host.
+  /// device to the host. A staging buffer must be borrowed.
   void CopyToHost(CommandBuffer* command_buffer) override;
 
  private:
   Result CreateVkImageView(VkImageAspectFlags aspect);
   Result AllocateAndBindMemoryToVkImage(VkImage image,
-                                        VkDeviceMemory* memory,
+                                        MemoryAllocation* memory,
                                         VkMemoryPropertyFlags flags,
                                         bool force_flags,
                                         uint32_t* memory_type_index);
@@ -70,17 +84,17 @@ class TransferImage : public Resource {
 
   VkImageViewType GetImageViewType() const;
 
-  /// An extra `VkBuffer` is used to facilitate the transfer of data from the
-  /// host into the `VkImage` on the device.
-  VkBuffer host_accessible_buffer_ = VK_NULL_HANDLE;
-  VkDeviceMemory host_accessible_memory_ = VK_NULL_HANDLE;
+  /// When the tiling of an image is optimal, the host cannot read or write
+  /// its data directly. The contents are copied through this buffer, which
+  /// is only borrowed for an upload or a readback.
+  std::unique_ptr<TransferBuffer> staging_buffer_;
 
   VkImageCreateInfo image_info_;
   VkImageAspectFlags aspect_;
 
   VkImage image_ = VK_NULL_HANDLE;
   VkImageView view_ = VK_NULL_HANDLE;
-  VkDeviceMemory memory_ = VK_NULL_HANDLE;
+  MemoryAllocation memory_;
 
   VkImageLayout layout_ = VK_IMAGE_LAYOUT_UNDEFINED;
   VkPipelineStageFlags stage_ = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
@@ -16,7 +16,7 @@
 
 # Generates build-versions.h in the src/ directory.
 #
-# Args:  <output_dir> <amber-dir> <spirv-tools-dir> <spirv-headers> <glslang-dir> <shaderc-dir>
+# Args:  <output_dir> <amber-dir> <third_party-dir>
 
 from __future__ import print_function
 
@@ -62,7 +62,8 @@ def main():
   outdir = sys.argv[1]
   srcdir = sys.argv[3]
 
-  projects = ['spirv-tools', 'spirv-headers', 'glslang', 'shaderc']
+  projects = ['spirv-tools', 'spirv-headers', 'glslang', 'shaderc', 'dxc',
+              'clspv', 'clspv-llvm']
   new_content = get_version_string('amber', sys.argv[2]) + "\n"
   new_content = new_content + ''.join([
     '{}\n'.format(get_version_string(p, os.path.join(srcdir, p)))
@@ -43,11 +43,16 @@ def read_inc(file):
 
 def read_vk(file):
   methods = {}
+  aliases = {}
   tree = ET.parse(file)
   root = tree.getroot();
   for command in root.iter("command"):
     proto = command.find('proto')
     if proto == None:
+      # Extension commands promoted to core are only listed as an alias of
+      # the core command.
+      if command.get('alias') != None:
+        aliases[command.get('name')] = command.get('alias')
       continue
 
     return_type = proto.find('type').text
@@ -68,6 +73,10 @@ def read_vk(file):
       'params': param_list
     }
 
+  for name, alias in aliases.items():
+    if alias in methods:
+      methods[name] = dict(methods[alias], name=name)
+
   return methods
 
 
@@ -96,8 +105,7 @@ def gen_wrappers(methods, xml):
       call_prefix = return_type + ' ' + return_variable + ' = '
     nullptr_check = ''
     if optional:
-      nullptr_check = '''ptrs_.{} = nullptr;
-    return Result();'''.format(method)
+      nullptr_check = 'ptrs_.{} = nullptr;'.format(method)
     else:
       nullptr_check = 'return Result("Vulkan: Unable to load {} pointer");'.format(method)
       
@@ -105,8 +113,7 @@ def gen_wrappers(methods, xml):
   PFN_${method} ptr = reinterpret_cast<PFN_${method}>(getInstanceProcAddr(instance_, "${method}"));
   if (!ptr) {
     ${nullptr_check}
-  }
-  if (delegate && delegate->LogGraphicsCalls()) {
+  } else if (delegate && delegate->LogGraphicsCalls()) {
     ptrs_.${method} = [ptr, delegate](${signature}) -> ${return_type} {
       delegate->Log("${method}");
       uint64_t timestamp_start = 0;